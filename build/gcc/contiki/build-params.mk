@@ -13,6 +13,10 @@ WARNING = -Wpacked -Wall
 # Add aditional CFLAGS if any 
 ADDITIONAL_CFLAGS = -mcpu=m16c -falign-functions=2 -nostartfiles -DROMSTART
 
+# The String representation used: ASCII (ASCII_stringManipulate.c)
+# or UTF8 (UTF8_stringManipulate.c)
+STRING_MANIPULATE ?= ASCII
+
 # Whether to include the grammar generation module in the build
 INCLUDE_GRAMMAR_GENERATION = false
 
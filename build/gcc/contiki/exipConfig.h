@@ -45,10 +45,16 @@
 #define EXIP_REALLOC d_realloc
 #define EXIP_MFREE d_free
 
+// The chunks of the managed memory (AllocList)
+#define ALLOCATION_CHUNK_SIZE 256
+#define ALLOCATION_CHUNK_MAX_SIZE 2048
+
 #define HASH_TABLE_USE OFF
-#define INITIAL_HASH_TABLE_SIZE 53
+#define INITIAL_HASH_TABLE_SIZE 64
 #define MAX_HASH_TABLE_SIZE 3000
 #define DYN_ARRAY_USE ON
+// The arrays grow by their chunk of entries
+#define DYN_ARRAY_GEOMETRIC_GROWTH OFF
 
 
 // Some types in procTypes.h
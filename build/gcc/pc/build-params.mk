@@ -13,6 +13,30 @@ WARNING = -Wpacked -Wall
 # Add aditional CFLAGS if any 
 ADDITIONAL_CFLAGS = 
 
+# The String representation used: ASCII (ASCII_stringManipulate.c)
+# or UTF8 (UTF8_stringManipulate.c)
+STRING_MANIPULATE ?= ASCII
+
+# Whether to support double-buffered output written by a background
+# thread, see enableAsyncOutput() (ON/OFF). Requires POSIX threads
+ASYNC_OUTPUT ?= OFF
+
+# Whether to support reading the parsed input ahead by a background
+# thread, see enableReadAhead() (ON/OFF). Requires POSIX threads
+READ_AHEAD ?= OFF
+
+# Whether to support passing the parsed events to the ContentHandler
+# from a consumer thread, see enablePipeline() (ON/OFF). Requires POSIX threads
+PIPELINE ?= OFF
+
+# Whether to support parsing the self-contained elements of a stream
+# by worker threads, see parseSelfContainedParallel() (ON/OFF). Requires POSIX threads
+PARALLEL_SC ?= OFF
+
+# Whether to support the EXI compression alignment option, see
+# http://www.w3.org/TR/exi/#compression (ON/OFF). Requires zlib
+COMPRESSION ?= OFF
+
 # Whether to include the grammar generation module in the build
 INCLUDE_GRAMMAR_GENERATION = true
 
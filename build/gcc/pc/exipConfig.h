@@ -75,17 +75,29 @@
 
 /** @def HASH_TABLE_USE
  * 		Whether to use hash table for value partition table when in encoding mode
+ * 		and for the URI, local names and local value tables with more than STRING_TABLE_INDEX_THRESHOLD entries
  * 	@def INITIAL_HASH_TABLE_SIZE
- * 		The initial capacity of the hash tables
+ * 		The initial capacity of the hash tables; rounded up to a power of two
  * 	@def MAX_HASH_TABLE_SIZE
- * 		The maximum capacity of the hash tables
+ * 		The maximum initial capacity of the hash tables; as the entries are stored in
+ * 		the table itself, it grows past this capacity when needed
  */
 #define HASH_TABLE_USE ON
 #define INITIAL_HASH_TABLE_SIZE 6151
 #define MAX_HASH_TABLE_SIZE 32000
 
-/** Whether to use dynamic arrays */
+/** @def DYN_ARRAY_USE
+ * 		Whether to use dynamic arrays
+ * 	@def DYN_ARRAY_GEOMETRIC_GROWTH
+ * 		When ON a full dynamic array doubles its size, growing by at least its chunk
+ * 		of entries; when OFF it grows by its chunk of entries, which wastes less
+ * 		memory on small targets but copies the array on every expansion
+ * 	@def DYN_ARRAY_MAX_GROWTH
+ * 		The maximum number of entries added by a geometric expansion; 0 for no limit
+ */
 #define DYN_ARRAY_USE ON
+#define DYN_ARRAY_GEOMETRIC_GROWTH ON
+#define DYN_ARRAY_MAX_GROWTH 0
 
 // NOTE: The GR_VOID_NON_TERMINAL should be set to the maximum 24 bit unsigned value in case the
 // SMALL_INDEX_MAX is 32 bits or bigger
@@ -31,6 +31,23 @@ struct Parser
 	/** Function pointers for document events. */
 	ContentHandler handler;
 	void* app_data;
+#if EXIP_PIPELINE == ON
+	/**
+	 * The consumer thread that invokes the handler;
+	 * NULL when the handler is invoked by parseNext()
+	 */
+	EventPipeline* pipeline;
+#endif
+	/**
+	 * The checkpoints of the decoder state written while parsing;
+	 * NULL when no checkpoints are written
+	 */
+	Checkpoints* checkpoints;
+	/**
+	 * TRUE until the element of the self-contained fragment
+	 * positioned by seekSelfContained() is parsed
+	 */
+	boolean fragmentPending;
 };
 
 typedef struct Parser Parser;
@@ -38,6 +55,7 @@ typedef struct Parser Parser;
 struct EXIParser
 {
 	errorCode (*initParser)(Parser* parser, BinaryBuffer buffer, void* app_data);
+	errorCode (*initParserMapped)(Parser* parser, const char* data, Index size, void* app_data);
 	errorCode (*parseHeader)(Parser* parser, boolean outOfBandOpts);
 	errorCode (*setSchema)(Parser* parser, EXIPSchema* schema);
 	errorCode (*parseNext)(Parser* parser);
@@ -61,6 +79,107 @@ extern const EXIParser parse;
  */
 errorCode initParser(Parser* parser, BinaryBuffer buffer, void* app_data);
 
+/**
+ * @brief Initialize a parser object whose memory comes from an allocator
+ * All memory of the parser, including the string tables and the schema created by
+ * setSchema(parser, NULL), is taken from the allocator and given back to it by
+ * destroyParser(). The allocator must remain valid until then.
+ * @param[out] parser the parser object
+ * @param[in] buffer an input buffer holding (part of) the representation of EXI stream
+ * @param[in] app_data Application data to be passed to the content handler callbacks
+ * @param[in] allocator the allocator of the parser; NULL is the same as initParser()
+ * @return Error handling code
+ */
+errorCode initParserAllocator(Parser* parser, BinaryBuffer buffer, void* app_data, const EXIPAllocator* allocator);
+
+/**
+ * @brief Initialize a parser object that does not use the heap
+ * All memory of the parser is carved from the caller-owned region: the string
+ * tables, the value table, the grammar stack, the built-in grammars and the
+ * decoded strings. When the region is exhausted the parsing fails with
+ * EXIP_MEMORY_ALLOCATION_ERROR; there is no fallback to EXIP_MALLOC.
+ * The region is set up again by the next initParserRegion().
+ * The region is used as a stack: the memory released is reused once all the
+ * memory allocated after it is released too. A table that grows while other
+ * memory is allocated after it is moved to a block of twice its size and its
+ * old space is reused only in this way, so the growing tables (e.g. the value
+ * table) can take up to four times the size of their entries.
+ * Use getParserRegionPeak() on a typical stream to size the region.
+ * @remark With a schema given to setSchema(), the string table entries and the
+ * built-in grammars added to it during the parsing are allocated as for the schema.
+ * enableReadAhead() and enablePipeline() are refused for such parsers.
+ * @param[out] parser the parser object
+ * @param[in] buffer an input buffer holding (part of) the representation of EXI stream
+ * @param[in] app_data Application data to be passed to the content handler callbacks
+ * @param[in, out] region the memory of the parser; it must remain valid until destroyParser() is called
+ * @param[in] regionSize the size in bytes of region
+ * @return Error handling code
+ */
+errorCode initParserRegion(Parser* parser, BinaryBuffer buffer, void* app_data, void* region, size_t regionSize);
+
+/**
+ * @brief Gets the size of the region that would have been enough for the parser so far
+ * Meant for sizing the region given to initParserRegion().
+ * @param[in] parser the parser object initialized with initParserRegion()
+ * @param[out] peak size in bytes
+ * @return EXIP_INVALID_EXIP_CONFIGURATION if the parser does not use a region
+ */
+errorCode getParserRegionPeak(Parser* parser, size_t* peak);
+
+/**
+ * @brief Initialize a parser object for an EXI stream that is entirely in memory
+ * The region (e.g. a file mapped with mmap()) is used directly as the parsing buffer:
+ * it is never copied, refilled or written to, and pushEXIData() cannot be used.
+ * Decoded ASCII strings and binary values may point into the region, so it
+ * must remain valid until destroyParser() is called.
+ * @param[out] parser the parser object
+ * @param[in] data the whole EXI stream
+ * @param[in] size the size in bytes of data
+ * @param[in] app_data Application data to be passed to the content handler callbacks
+ * @return Error handling code
+ */
+errorCode initParserMapped(Parser* parser, const char* data, Index size, void* app_data);
+
+#if EXIP_READ_AHEAD == ON
+/**
+ * @brief Reads the input of the parser ahead of the parsing
+ * A background thread fills up to blockCount blocks of buffer.bufLen bytes using
+ * buffer.ioStrm.readWriteToStream while the previous ones are being parsed.
+ * Call it after initParser() and before parseHeader(). The content already
+ * in the buffer is parsed first; the buffer itself is not refilled afterwards.
+ * pushEXIData() cannot be used in this mode.
+ *
+ * @remark Requires POSIX threads (build with READ_AHEAD = ON).
+ * The readWriteToStream callback is invoked from the reader thread.
+ * Values decoded without a copy (e.g. binary data) point into a block
+ * that is reused once the parsing has moved two blocks further.
+ *
+ * @param[in, out] parser the parser object with an input stream
+ * @param[in] blockCount number of blocks; at least 2
+ * @return Error handling code
+ */
+errorCode enableReadAhead(Parser* parser, unsigned int blockCount);
+#endif
+
+#if EXIP_PIPELINE == ON
+/**
+ * @brief Passes the parsed events to the handler from a consumer thread
+ * parseNext() records the events in batches of copied values and decodes
+ * further while the consumer thread invokes the handler callbacks for the
+ * previous batches. Call it after initParser() and before the first parseNext().
+ * @remark Requires POSIX threads (build with PIPELINE = ON).
+ * The callbacks of the body events are invoked from the consumer thread, one at
+ * a time and in the order of parsing. An error returned by a callback stops the
+ * dispatching and is returned by a later parseNext() call. When parseNext()
+ * returns anything else than EXIP_OK all callbacks of the events parsed so far
+ * are completed.
+ * @param[in, out] parser the parser object
+ * @param[in] batchCount number of batches of events; at least 2
+ * @return Error handling code
+ */
+errorCode enablePipeline(Parser* parser, unsigned int batchCount);
+#endif
+
 
 /**
  * @brief Parse the header on the EXI stream contained in the parser object
@@ -94,6 +213,7 @@ errorCode setSchema(Parser* parser, EXIPSchema* schema);
  * EXIP_BUFFER_END_REACHED when the whole content of the buffer is parsed but there is more
  * events in the EXI stream. In case of EXIP_BUFFER_END_REACHED, pushEXIData() must be used
  * to fill the buffer with the next chunk of the EXI stream before calling parseNext() again.
+ * For parsers initialized with initParserMapped() a truncated stream results in EXIP_INVALID_EXI_INPUT.
  */
 errorCode parseNext(Parser* parser);
 
@@ -117,6 +237,119 @@ errorCode parseNext(Parser* parser);
  */
 errorCode pushEXIData(char* inBuf, unsigned int bufSize, Parser* parser);
 
+/**
+ * @brief Writes checkpoints of the decoder state while the body is parsed
+ * A checkpoint is written before the next content item once byteInterval bytes
+ * or elementInterval elements have been parsed since the previous one. It holds
+ * the position in the stream, the stream context, the grammar stack and all
+ * entries added to the string tables and the built-in grammars since the start
+ * of the body. Each checkpoint is written to sideCar as its size in 4 bytes
+ * (big-endian) followed by the checkpoint. Call it after setSchema() and before
+ * the first parseNext().
+ * Each checkpoint can be restored on its own, so it repeats the entries of the
+ * previous ones and the side-car grows with the square of the body for tables
+ * that keep growing; a bounded valuePartitionCapacity bounds the value table.
+ * parseNext() returns EXIP_OUT_OF_BOUND_BUFFER for a checkpoint larger than
+ * CHECKPOINT_MAX_SIZE (0xFFFFFFFF by default).
+ * @remark Not available for streams in compression or pre-compression mode
+ * (EXIP_NOT_IMPLEMENTED_YET).
+ * @param[in, out] parser the parser object
+ * @param[in] byteInterval number of bytes between two checkpoints; 0 for none
+ * @param[in] elementInterval number of elements between two checkpoints; 0 for none
+ * @param[in] sideCar output stream of the checkpoints; readWriteToStream
+ * returns the number of bytes written
+ * @return Error handling code
+ */
+errorCode enableCheckpoints(Parser* parser, Index byteInterval, Index elementInterval, IOStream sideCar);
+
+/**
+ * @brief Resumes the decoding from a checkpoint written by enableCheckpoints()
+ * Call it after parseHeader() and setSchema() and before the first parseNext().
+ * The options, the schema and the out-of-band information must be the same as the
+ * ones of the parser that wrote the checkpoint. For parsers initialized with
+ * initParserMapped() the parsing continues from the position of the checkpoint.
+ * Otherwise the content of the buffer is dropped and the input must continue
+ * from the byte at the offset returned by getCheckpointPosition(): the input
+ * stream is read once before returning, or the data is given with pushEXIData().
+ * Read-ahead can be enabled after the checkpoint is restored.
+ * @param[in, out] parser the parser object
+ * @param[in] checkpoint the checkpoint without the size preceding it in the side-car
+ * @param[in] size the size in bytes of checkpoint
+ * @return Error handling code; EXIP_HEADER_OPTIONS_MISMATCH if the checkpoint is
+ * of a stream with other options. On errors other than EXIP_HEADER_OPTIONS_MISMATCH
+ * and EXIP_INCONSISTENT_PROC_STATE the parser can only be destroyed.
+ */
+errorCode restoreCheckpoint(Parser* parser, const char* checkpoint, Index size);
+
+/**
+ * @brief Gets the position in the EXI stream of a checkpoint
+ * @param[in] checkpoint the checkpoint without the size preceding it in the side-car
+ * @param[in] size the size in bytes of checkpoint
+ * @param[out] byteOffset the offset in the EXI stream of the byte from which the parsing continues
+ * @param[out] elementCount the number of elements parsed before the checkpoint
+ * @return Error handling code
+ */
+errorCode getCheckpointPosition(const char* checkpoint, Index size, Index* byteOffset, Index* elementCount);
+
+/**
+ * @brief Gets the position in the EXI stream of the content of a self-contained element
+ * The content of an element with the SC event starts at a byte boundary and
+ * can be parsed on its own with seekSelfContained(). Call it from the
+ * selfContained callback of the handler; it is invoked after the SE and the
+ * SC events of the element and before any of its attributes.
+ * @remark The callbacks of a pipelined parser (see enablePipeline()) are
+ * invoked too late for the offset to be known.
+ * @param[in] parser the parser object
+ * @param[out] byteOffset the offset of the first byte of the content
+ * @return EXIP_INCONSISTENT_PROC_STATE outside of self-contained elements
+ */
+errorCode getSelfContainedOffset(Parser* parser, Index* byteOffset);
+
+/**
+ * @brief Positions the parser at the content of a self-contained element
+ * parseNext() then passes the events of the element alone to the handler, from
+ * its SE to its EE, with the string tables and the grammars in their state at
+ * the start of the body, and returns EXIP_PARSING_COMPLETE after its EE.
+ * Call it after parseHeader() and setSchema() and before the first parseNext().
+ * The input is positioned the same way as by restoreCheckpoint().
+ * @remark Requires the selfContained option; not available with schema-informed grammars.
+ * @param[in, out] parser the parser object
+ * @param[in] byteOffset the offset of the content given by getSelfContainedOffset()
+ * @return Error handling code
+ */
+errorCode seekSelfContained(Parser* parser, Index byteOffset);
+
+#if EXIP_PARALLEL_SC == ON
+/**
+ * @brief Parses self-contained elements of an EXI stream in parallel
+ * Each element is parsed from its offset (see getSelfContainedOffset()) by one of
+ * threadCount worker threads with a parser of its own over the same stream.
+ * The header is decoded once by the calling thread and copied to the parsers.
+ * The events of an element are recorded by the worker and passed to the handler
+ * by the calling thread once the element is parsed: in the order of offsets when
+ * ordered is TRUE, otherwise in the order the elements are completed. The events
+ * of different elements are never interleaved.
+ * @remark Requires POSIX threads (build with PARALLEL_SC = ON).
+ * At most 2*threadCount elements are parsed ahead of the ones passed to the handler.
+ * Only for streams without schema-informed grammars: the stream is parsed schema-less,
+ * or with the built-in types when its schemaId is empty. Streams whose header names a
+ * schema are refused with EXIP_NOT_IMPLEMENTED_YET; out-of-band schemas cannot be given.
+ * All the memory is taken with EXIP_MALLOC, as the workers allocate concurrently.
+ * @param[in] data the whole EXI stream including its header
+ * @param[in] size the size in bytes of data
+ * @param[in] offsets the offsets of the content of the self-contained elements
+ * @param[in] count number of offsets
+ * @param[in] threadCount number of worker threads; at least 1
+ * @param[in] ordered whether the elements are passed to the handler in the order of offsets
+ * @param[in] handler the application's handler
+ * @param[in] app_data app_data[i] is passed to the callbacks of the events of the element
+ * at offsets[i]; NULL is passed to all callbacks if app_data is NULL
+ * @return Error handling code; the first error of a parser or a callback
+ */
+errorCode parseSelfContainedParallel(const char* data, Index size, const Index* offsets, Index count,
+		unsigned int threadCount, boolean ordered, ContentHandler* handler, void** app_data);
+#endif
+
 /**
  * @brief Free any memroy allocated by parser object
  * @param[in] parser the parser object
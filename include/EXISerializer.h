@@ -53,7 +53,7 @@ struct EXISerializer
 	void (*initHeader)(EXIStream* strm);
 	errorCode (*initStream)(EXIStream* strm, BinaryBuffer buffer, EXIPSchema* schema);
 	errorCode (*closeEXIStream)(EXIStream* strm);
-	errorCode (*flushEXIData)(EXIStream* strm);
+	errorCode (*flushEXIData)(EXIStream* strm, char* outBuf, unsigned int bufSize, unsigned int* bytesFlush);
 };
 
 typedef struct EXISerializer EXISerializer;
@@ -240,10 +240,13 @@ errorCode namespaceDeclaration(EXIStream* strm, const String ns, const String pr
 
 /**
  * @brief Encode a self Contained event used for indexing independent elements for random access
+ * Must be called right after the startElement() of the element. Its content starts at a byte
+ * boundary and is encoded with the string tables and the built-in element grammars in their
+ * initial state. The matching endElement() ends the fragment of the element and restores them.
+ * Requires the selfContained option; not available with schema-informed grammars.
  *
  * @param[in, out] strm EXI stream object
  * @return Error handling code
- * @todo define the parameters!
  */
 errorCode selfContained(EXIStream* strm);
 
@@ -267,6 +270,57 @@ void initHeader(EXIStream* strm);
  */
 errorCode initStream(EXIStream* strm, BinaryBuffer buffer, EXIPSchema *schema);
 
+/**
+ * @brief Initialize EXI stream object whose memory comes from an allocator
+ * All memory of the stream, including the string tables and the schema used when
+ * schema is NULL, is taken from the allocator and given back to it by
+ * closeEXIStream(). The allocator must remain valid until then.
+ *
+ * @param[in, out] strm EXI stream
+ * @param[in, out] buffer output buffer for storing the encoded EXI stream
+ * @param[in] schema a compiled schema information to be used for schema enabled processing, NULL if no schema is available
+ * @param[in] allocator the allocator of the stream; NULL is the same as initStream()
+ * @return Error handling code
+ */
+errorCode initStreamAllocator(EXIStream* strm, BinaryBuffer buffer, EXIPSchema *schema, const EXIPAllocator* allocator);
+
+/**
+ * @brief Initialize EXI stream object that does not use the heap
+ * All memory of the stream is carved from the caller-owned region: the string
+ * tables, the value table, the grammar stack, the built-in grammars and the
+ * temporary strings. When the region is exhausted the serialization fails with
+ * EXIP_MEMORY_ALLOCATION_ERROR; there is no fallback to EXIP_MALLOC.
+ * The region is set up again by the next initStreamRegion().
+ * The region is used as a stack: the memory released is reused once all the
+ * memory allocated after it is released too. A table that grows while other
+ * memory is allocated after it is moved to a block of twice its size and its
+ * old space is reused only in this way, so the growing tables (e.g. the value
+ * table) can take up to four times the size of their entries.
+ * Use getStreamRegionPeak() on a typical stream to size the region.
+ *
+ * @remark When schema is not NULL, the string table entries and the built-in
+ * grammars added to it during the serialization are allocated as for the schema.
+ * enableAsyncOutput() is refused for such streams.
+ *
+ * @param[in, out] strm EXI stream
+ * @param[in, out] buffer output buffer for storing the encoded EXI stream
+ * @param[in] schema a compiled schema information to be used for schema enabled processing, NULL if no schema is available
+ * @param[in, out] region the memory of the stream; it must remain valid until closeEXIStream() is called
+ * @param[in] regionSize the size in bytes of region
+ * @return Error handling code
+ */
+errorCode initStreamRegion(EXIStream* strm, BinaryBuffer buffer, EXIPSchema *schema, void* region, size_t regionSize);
+
+/**
+ * @brief Gets the size of the region that would have been enough for the stream so far
+ * Meant for sizing the region given to initStreamRegion().
+ *
+ * @param[in] strm EXI stream initialized with initStreamRegion()
+ * @param[out] peak size in bytes
+ * @return EXIP_INVALID_EXIP_CONFIGURATION if the stream does not use a region
+ */
+errorCode getStreamRegionPeak(EXIStream* strm, size_t* peak);
+
 /**
  * @brief Destroy an EXI stream object releasing all the allocated memory for it
  *
@@ -303,6 +357,27 @@ errorCode closeEXIStream(EXIStream* strm);
  */
 errorCode flushEXIData(EXIStream* strm, char* outBuf, unsigned int bufSize, unsigned int* bytesFlush);
 
+#if EXIP_ASYNC_OUTPUT == ON
+/**
+ * @brief Writes the EXI stream through bufCount buffers: a full buffer is
+ * passed to strm->buffer.ioStrm.readWriteToStream by a background thread
+ * while the encoding continues in the next one.
+ * Call it after initStream(); closeEXIStream() waits for the pending writes.
+ * The buffer of the application is one of the bufCount buffers,
+ * the others (of the same size) are allocated by EXIP.
+ *
+ * @remark Requires POSIX threads (build with ASYNC_OUTPUT = ON).
+ * The readWriteToStream callback is invoked from the writer thread.
+ * A write error is reported by the next serialize.*() call that
+ * fills a buffer or by closeEXIStream()
+ *
+ * @param[in, out] strm EXI stream object with an output stream
+ * @param[in] bufCount number of buffers; at least 2
+ * @return Error handling code
+ */
+errorCode enableAsyncOutput(EXIStream* strm, unsigned int bufCount);
+#endif
+
 /****  END: Serializer API implementation  ****/
 
 
@@ -39,7 +39,7 @@ struct ContentHandler
 	errorCode (*booleanData)(boolean bool_val, void* app_data);
 	errorCode (*stringData)(const String str_val, void* app_data);
 	errorCode (*floatData)(Float float_val, void* app_data);
-	errorCode (*binaryData)(const char* binary_val, Index nbytes, void* app_data);
+	errorCode (*binaryData)(const char* binary_val, Index nbytes, void* app_data); // binary_val is valid only during the call
 	errorCode (*dateTimeData)(EXIPDateTime dt_val, void* app_data);
 	errorCode (*decimalData)(Decimal dec_val, void* app_data);
 	errorCode (*listData)(EXITypeClass exiType, unsigned int itemCount, void* app_data);
@@ -77,6 +77,8 @@ typedef struct stackNode GenericStack;
 #define WITH_STRICT(p)         (((p) & STRICT) != 0)
 #define WITH_FRAGMENT(p)       (((p) & FRAGMENT) != 0)
 #define WITH_SELF_CONTAINED(p) (((p) & SELF_CONTAINED) != 0)
+/** The body is split in structure and value channels (compression or pre-compression) */
+#define WITH_CHANNELS(p)       (WITH_COMPRESSION(p) || GET_ALIGNMENT(p) == PRE_COMPRESSION)
 
 #define SET_ALIGNMENT(p, align_const) ((p) = (p) | align_const)
 #define SET_COMPRESSION(p)            ((p) = (p) | COMPRESSION)
@@ -304,6 +306,15 @@ typedef EXIP_SMALL_INDEX SmallIndex;
 
 typedef CHAR_TYPE CharType;
 
+/**
+ * The maximum number of CharType units used to store a single UCS character.
+ * It is dependent on the implementation of the stringManipulate.h functions:
+ * 1 for ASCII_stringManipulate.c and 4 for UTF8_stringManipulate.c
+ */
+#ifndef CHAR_TYPE_MAX_UNITS
+# define CHAR_TYPE_MAX_UNITS 1
+#endif
+
 
 #ifndef EXIP_STRTOLL
 /** strtoll() function */
@@ -361,22 +372,69 @@ typedef struct QNameID QNameID;
  */
 /**@{*/
 
-/** @note Should not be bigger than SMALL_INDEX_MAX - 1 */
-#define ALLOCATION_ARRAY_SIZE 100
+/**
+ * The memory allocation functions of a stream or a schema. The memory
+ * allocated with allocate or reallocate is passed back to reallocate or
+ * release, always with the same context. The streams and schemas without
+ * an allocator (NULL) use EXIP_MALLOC, EXIP_REALLOC and EXIP_MFREE.
+ *
+ * An allocator is used by one thread at a time, so the memory shared with
+ * background threads is left on the default allocator: the buffers of
+ * enableAsyncOutput(), enableReadAhead() and enablePipeline(), and all
+ * the memory of parseSelfContainedParallel(), whose worker parsers
+ * allocate concurrently.
+ */
+struct EXIPAllocator
+{
+	/** Returns size bytes aligned for any type or NULL if out of memory */
+	void* (*allocate)(void* context, size_t size);
+	/** Resizes ptr (NULL for a new block) to size bytes or returns NULL leaving ptr as it is */
+	void* (*reallocate)(void* context, void* ptr, size_t size);
+	/** Frees ptr; called only with memory of this allocator */
+	void (*release)(void* context, void* ptr);
+	/** The allocator state passed to the functions, e.g. an arena */
+	void* context;
+};
+
+typedef struct EXIPAllocator EXIPAllocator;
+
+/**
+ * The size of the first chunk of an AllocList. Each next chunk is twice
+ * as large up to ALLOCATION_CHUNK_MAX_SIZE. Allocations larger than a
+ * quarter of the chunk size get a chunk of their own.
+ */
+#ifndef ALLOCATION_CHUNK_SIZE
+# define ALLOCATION_CHUNK_SIZE 1024
+#endif
+
+#ifndef ALLOCATION_CHUNK_MAX_SIZE
+# define ALLOCATION_CHUNK_MAX_SIZE 65536
+#endif
 
-/** An array of allocation pointers */
-struct allocBlock {
-	void* allocation[ALLOCATION_ARRAY_SIZE];
-	struct allocBlock* nextBlock;
+/** The alignment of the memory returned by memManagedAllocate() */
+#ifndef ALLOCATION_ALIGNMENT
+# define ALLOCATION_ALIGNMENT 8
+#endif
+
+/** A chunk of memory; the allocations are carved from the bytes following it */
+struct allocChunk {
+	/** The previous chunk of the list */
+	struct allocChunk* nextChunk;
+	/** The number of bytes following the chunk header */
+	size_t size;
+	/** The number of bytes carved from the chunk */
+	size_t used;
 };
 
-/** A list of allocation blocks.
+/** A list of memory chunks freed all at once.
  * Pass to initAllocList() before use. */
 struct allocList {
-	struct allocBlock* firstBlock;
-	struct allocBlock* lastBlock;
-	/** The next allocation slot in the allocation array of the lastBlock */
-	SmallIndex currAllocSlot;
+	/** The chunk the allocations are carved from; NULL until the first allocation */
+	struct allocChunk* currChunk;
+	/** The size of the next chunk */
+	size_t chunkSize;
+	/** The allocator of the chunks; NULL for EXIP_MALLOC */
+	const EXIPAllocator* allocator;
 };
 
 typedef struct allocList AllocList;
@@ -409,6 +467,11 @@ struct dynArray {
 	 * The total number of entries in the array
 	 */
 	Index arrayEntries;
+
+	/**
+	 * The allocator of the entries; NULL for EXIP_MALLOC (e.g. static arrays)
+	 */
+	const EXIPAllocator* allocator;
 };
 
 typedef struct dynArray DynArray;
@@ -792,6 +855,29 @@ struct GrammarStackNode
 
 typedef struct GrammarStackNode EXIGrammarStack;
 
+/** A block of grammar stack nodes; the nodes follow the block */
+struct GrammarStackBlock
+{
+	struct GrammarStackBlock* nextBlock;
+	/** The number of nodes in the block */
+	Index count;
+};
+
+/**
+ * The nodes of the grammar stack of a stream. They are taken from blocks
+ * of consecutive nodes and the popped nodes are reused first so the
+ * elements that are open occupy consecutive nodes.
+ */
+struct GrammarStackPool
+{
+	/** The unused nodes linked through nextInStack */
+	EXIGrammarStack* freeNode;
+	/** The blocks of nodes, the largest first; NULL before the first push */
+	struct GrammarStackBlock* block;
+};
+
+typedef struct GrammarStackPool GrammarStackPool;
+
 /**@}*/ // End Grammar Types
 
 
@@ -811,6 +897,23 @@ struct ValueEntry {
 
 typedef struct ValueEntry ValueEntry;
 
+/**
+ * A chunk of the memory of the value strings; the strings are carved
+ * from the bytes following the header in the order they are added
+ * to the value table.
+ */
+struct ValueChunk {
+	struct ValueChunk* next;
+	/** The size of the chunk in bytes, excluding the header */
+	Index size;
+	/** The number of bytes carved from the chunk */
+	Index used;
+	/** The number of strings in the chunk that are not evicted yet */
+	Index live;
+};
+
+typedef struct ValueChunk ValueChunk;
+
 struct ValueTable {
 #if DYN_ARRAY_USE == ON
 	DynArray dynArray;
@@ -830,6 +933,20 @@ struct ValueTable {
 #endif
 	/** @see http://www.w3.org/TR/2011/REC-exi-20110310/#key-globalID */
 	Index globalId;
+	/**
+	 * The chunks holding the value strings, from the oldest to the newest.
+	 * The entries are replaced in the order they were added when
+	 * valuePartitionCapacity is reached so the chunks are emptied in
+	 * FIFO order and then reused for the new strings.
+	 */
+	ValueChunk* oldestChunk;
+	ValueChunk* newestChunk;
+	/** Emptied chunks of chunkSize bytes */
+	ValueChunk* freeChunks;
+	/** The size of the chunks; 0 until the first value string is allocated */
+	Index chunkSize;
+	/** The last string carved; the unused part of it is given back by addValueEntry() */
+	CharType* lastString;
 };
 
 typedef struct ValueTable ValueTable;
@@ -847,6 +964,14 @@ typedef struct ValueTable ValueTable;
 	#endif
 		VxEntry* vx;
 		Index count;
+	#if HASH_TABLE_USE
+		/**
+		 * Index of the value strings of the partition; NULL until the table
+		 * is searched with more than STRING_TABLE_INDEX_THRESHOLD entries.
+		 * The entries removed from the partition are removed from the index.
+		 */
+		struct hashtable* hashTbl;
+	#endif
 	};
 
 	typedef struct VxTable VxTable;
@@ -885,6 +1010,13 @@ struct LnTable {
 #endif
 	LnEntry* ln;
 	Index count;
+#if HASH_TABLE_USE
+	/**
+	 * Index of the local names by string; NULL until the table
+	 * is searched with more than STRING_TABLE_INDEX_THRESHOLD entries
+	 */
+	struct hashtable* hashTbl;
+#endif
 };
 
 typedef struct LnTable LnTable;
@@ -903,6 +1035,13 @@ struct UriTable {
 #endif
 	UriEntry* uri;
 	SmallIndex count;
+#if HASH_TABLE_USE
+	/**
+	 * Index of the URIs by string; NULL until the table
+	 * is searched with more than STRING_TABLE_INDEX_THRESHOLD entries
+	 */
+	struct hashtable* hashTbl;
+#endif
 };
 
 typedef struct UriTable UriTable;
@@ -1116,6 +1255,11 @@ struct EXIPSchema
 	Index staticGrCount;
 
 	EnumTable enumTable;
+
+	/**
+	 * The allocator of the schema tables and grammars; NULL for EXIP_MALLOC
+	 */
+	const EXIPAllocator* allocator;
 };
 
 typedef struct EXIPSchema EXIPSchema;
@@ -1127,6 +1271,11 @@ struct StreamContext
 	 */
 	Index bufferIndx;
 
+	/**
+	 * When parsing: the position in the EXI stream of the first byte in the buffer
+	 */
+	Index bufferOffset;
+
 	/**
 	 * Value between 0 and 7; shows the current position within the current byte.
 	 * 7 is the least significant bit position in the byte.
@@ -1288,6 +1437,94 @@ struct BinaryBuffer
 
 typedef struct BinaryBuffer BinaryBuffer;
 
+/**
+ * Memory buffer reused by the EXI stream for temporary data
+ * (e.g. decoded binary values that cannot be referenced directly in the BinaryBuffer)
+ */
+struct ScratchBuffer
+{
+	/**
+	 * Dynamically allocated memory; NULL when not used yet
+	 */
+	char* buf;
+
+	/**
+	 * The size of the allocated memory
+	 */
+	Index bufLen;
+};
+
+typedef struct ScratchBuffer ScratchBuffer;
+
+/**
+ * Whether full buffers of the EXI stream can be written to the output
+ * stream by a background thread (see enableAsyncOutput()).
+ * Requires POSIX threads; OFF by default
+ */
+#ifndef EXIP_ASYNC_OUTPUT
+# define EXIP_ASYNC_OUTPUT OFF
+#endif
+
+#if EXIP_ASYNC_OUTPUT == ON
+/** State of the double-buffered output; defined in asyncOutput.c */
+typedef struct AsyncOutput AsyncOutput;
+#endif
+
+/**
+ * Whether the input of a parsed EXI stream can be read ahead
+ * by a background thread (see enableReadAhead()).
+ * Requires POSIX threads; OFF by default
+ */
+#ifndef EXIP_READ_AHEAD
+# define EXIP_READ_AHEAD OFF
+#endif
+
+#if EXIP_READ_AHEAD == ON
+/** State of the read-ahead of the input; defined in readAhead.c */
+typedef struct ReadAhead ReadAhead;
+#endif
+
+/**
+ * Whether the parsed events can be passed to the ContentHandler
+ * by a consumer thread (see enablePipeline()).
+ * Requires POSIX threads; OFF by default
+ */
+#ifndef EXIP_PIPELINE
+# define EXIP_PIPELINE OFF
+#endif
+
+#if EXIP_PIPELINE == ON
+/** State of the pipelined parsing; defined in eventPipeline.c */
+typedef struct EventPipeline EventPipeline;
+#endif
+
+/**
+ * Whether the self-contained elements of a stream can be parsed
+ * by several threads (see parseSelfContainedParallel()).
+ * Requires POSIX threads; OFF by default
+ */
+#ifndef EXIP_PARALLEL_SC
+# define EXIP_PARALLEL_SC OFF
+#endif
+
+/**
+ * Whether EXI compression (DEFLATE of the structure and value channels)
+ * is supported; requires zlib. OFF by default. The channels are
+ * available regardless; a compressed stream is refused when OFF.
+ */
+#ifndef EXIP_COMPRESSION
+# define EXIP_COMPRESSION OFF
+#endif
+
+/** The structure and value channels of the body; defined in valueChannels.c */
+typedef struct ValueChannels ValueChannels;
+
+/** The state of the self-contained elements of a stream; defined in selfContained.c */
+typedef struct SelfContained SelfContained;
+
+/** The checkpoints of the decoder state written while parsing; defined in checkpoint.c */
+typedef struct Checkpoints Checkpoints;
+
 /**
  * Represents an EXI stream
  */
@@ -1295,6 +1532,13 @@ struct EXIStream
 {
 	BinaryBuffer buffer;
 
+	/**
+	 * TRUE when the buffer holds the whole EXI stream in memory that is neither
+	 * refilled nor moved during parsing (see initParserMapped()). Decoded strings
+	 * can then reference the buffer instead of being copied.
+	 */
+	boolean bufferMapped;
+
 	/**
 	 * EXI Header - the most important field is the EXI Options. They control the
 	 * parsing and serialization of the stream.
@@ -1314,6 +1558,16 @@ struct EXIStream
 	 */
 	EXIGrammarStack* gStack;
 
+	/**
+	 * The nodes of the grammar stack
+	 */
+	GrammarStackPool gStackPool;
+
+	/**
+	 * The allocator of all the memory of the stream; NULL for EXIP_MALLOC
+	 */
+	const EXIPAllocator* allocator;
+
 	/**
 	 * Stores the information of all the allocated memory for that stream,
 	 * except the global sting values that are stored in the ValueTable
@@ -1325,6 +1579,40 @@ struct EXIStream
 	 * It contains the string tables and possibly schema-informed EXI grammars.
 	 */
 	EXIPSchema* schema;
+
+	/**
+	 * Scratch memory of the stream. Grows to the largest value
+	 * that needed it and is freed by freeAllMem()
+	 */
+	ScratchBuffer scratch;
+
+	/**
+	 * The channels of the body in compression mode;
+	 * NULL when the values are encoded in place
+	 */
+	ValueChannels* channels;
+
+	/**
+	 * The initial string tables and the enclosing documents of
+	 * the self-contained elements; NULL without the selfContained option
+	 */
+	SelfContained* sc;
+
+#if EXIP_ASYNC_OUTPUT == ON
+	/**
+	 * Double-buffered output of the stream;
+	 * NULL when the buffers are written synchronously
+	 */
+	AsyncOutput* asyncOutput;
+#endif
+
+#if EXIP_READ_AHEAD == ON
+	/**
+	 * Read-ahead of the input of the stream;
+	 * NULL when the input is read synchronously
+	 */
+	ReadAhead* readAhead;
+#endif
 };
 
 typedef struct EXIStream EXIStream;
@@ -26,9 +26,10 @@
  *
  * @param[in, out] str a pointer to the uninitialized string
  * @param[in] UCSchars the number of characters (as described by UCS [ISO/IEC 10646])
+ * @param[in] allocator the allocator of the string memory; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode allocateStringMemory(CharType** str, Index UCSchars);
+errorCode allocateStringMemory(CharType** str, Index UCSchars, const EXIPAllocator* allocator);
 
 /**
  * @brief Allocate a memory for a string with UCSchars number of UCS characters
@@ -68,6 +69,44 @@ errorCode writeCharToString(String* str, uint32_t code_point, Index* writerPosit
  */
 uint32_t readCharFromString(const String* str, Index* readerPosition);
 
+/**
+ * @brief Returns the number of UCS [ISO/IEC 10646] characters in a string
+ * It depends on the representation of the characters. The EXI string
+ * length prefixes are in UCS characters while String.length is in CharType units.
+ *
+ * @param[in] str string
+ * @param[out] UCSchars the number of characters (as described by UCS [ISO/IEC 10646])
+ * @return Error handling code - EXIP_INVALID_STRING_OPERATION if str is not a
+ * valid sequence of characters in the representation used
+ */
+errorCode getUCSCharsNumber(const String* str, Index* UCSchars);
+
+/**
+ * @brief Writes a run of 7-bit ASCII characters (UCS code points below 0x80) to a string
+ * Bulk equivalent of writeCharToString() used by the string decoder.
+ * The memory needed for str should be allocated before the invocation
+ * of this function
+ *
+ * @param[in, out] str string to be written on
+ * @param[in] ascii the characters, one byte per character
+ * @param[in] count the number of characters in ascii
+ * @param[in, out] writerPosition the index of the next CharType to be written; moved past the run on return
+ * @return Error handling code
+ */
+errorCode writeAsciiToString(String* str, const unsigned char* ascii, Index count, Index* writerPosition);
+
+/**
+ * @brief Reads the run of 7-bit ASCII characters (UCS code points below 0x80) starting at
+ * particular index from a String. Bulk equivalent of readCharFromString() used by the string encoder.
+ *
+ * @param[in] str string
+ * @param[in, out] readerPosition the position of the first character to be read; moved past the run on return
+ * @param[in] maxChars the maximum number of characters to be read
+ * @param[out] ascii receives the characters, one byte per character
+ * @return the number of characters read; 0 if the character at readerPosition is not ASCII
+ */
+Index readAsciiFromString(const String* str, Index* readerPosition, Index maxChars, unsigned char* ascii);
+
 /**
  * @brief Creates an empty string
  * @param[in, out] emptyStr empty string
@@ -121,9 +160,10 @@ boolean stringEqualToAscii(const String str1, const char* str2);
  * @brief Makes a copy of the string in a new location
  * @param[in] src the string to be copied
  * @param[in] newStr will point to the newly allocated memory with scr->CharType* copied there
+ * @param[in] allocator the allocator of the string memory; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode cloneString(const String* src, String* newStr);
+errorCode cloneString(const String* src, String* newStr, const EXIPAllocator* allocator);
 
 /**
  * @brief Makes a copy of the string in a new location
@@ -163,57 +203,62 @@ errorCode stringToInt64(const String* src, int64_t* number);
 /**
  * @brief Converts a integer to string representation.
  * Uses allocateStringMemory() so make sure to free the
- * memory allocated for the string manually!
+ * memory allocated for the string manually with the same allocator!
  *
  * @param[in] number the source integer
  * @param[out] outStr the resulting string representation
+ * @param[in] allocator the allocator of the string memory; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode integerToString(Integer number, String* outStr);
+errorCode integerToString(Integer number, String* outStr, const EXIPAllocator* allocator);
 
 /**
  * @brief Converts a boolean to string representation.
  * Uses allocateStringMemory() so make sure to free the
- * memory allocated for the string manually!
+ * memory allocated for the string manually with the same allocator!
  *
  * @param[in] b TRUE/FALSE
  * @param[out] outStr the resulting string representation
+ * @param[in] allocator the allocator of the string memory; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode booleanToString(boolean b, String* outStr);
+errorCode booleanToString(boolean b, String* outStr, const EXIPAllocator* allocator);
 
 /**
  * @brief Converts a float to string representation.
  * Uses allocateStringMemory() so make sure to free the
- * memory allocated for the string manually!
+ * memory allocated for the string manually with the same allocator!
  *
  * @param[in] f float in EXI format (base 10)
  * @param[out] outStr the resulting string representation
+ * @param[in] allocator the allocator of the string memory; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode floatToString(Float f, String* outStr);
+errorCode floatToString(Float f, String* outStr, const EXIPAllocator* allocator);
 
 /**
  * @brief Converts a decimal to string representation.
  * Uses allocateStringMemory() so make sure to free the
- * memory allocated for the string manually!
+ * memory allocated for the string manually with the same allocator!
  *
  * @param[in] d the source decimal
  * @param[out] outStr the resulting string representation
+ * @param[in] allocator the allocator of the string memory; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode decimalToString(Decimal d, String* outStr);
+errorCode decimalToString(Decimal d, String* outStr, const EXIPAllocator* allocator);
 
 /**
  * @brief Converts a dateTime value to string representation.
  * Uses allocateStringMemory() so make sure to free the
- * memory allocated for the string manually!
+ * memory allocated for the string manually with the same allocator!
  *
  * @param[in] dt the source dtValue
  * @param[out] outStr the resulting string representation
+ * @param[in] allocator the allocator of the string memory; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode dateTimeToString(EXIPDateTime dt, String* outStr);
+errorCode dateTimeToString(EXIPDateTime dt, String* outStr, const EXIPAllocator* allocator);
 
 #endif /* EXIP_IMPLICIT_DATA_TYPE_CONVERSION */
 
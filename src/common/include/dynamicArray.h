@@ -34,16 +34,26 @@
  */
 #define DYN_ARRAY_SIZE (sizeof(DynArray) + sizeof(void*) + sizeof(Index))
 
+#ifndef DYN_ARRAY_GEOMETRIC_GROWTH
+# define DYN_ARRAY_GEOMETRIC_GROWTH ON
+#endif
+
+#ifndef DYN_ARRAY_MAX_GROWTH
+# define DYN_ARRAY_MAX_GROWTH 0
+#endif
+
 /**
  * @brief Creates fresh empty Untyped Dynamic Array
  * This operation includes allocation of memory for DEFAULT_VALUE_ROWS_NUMBER number of value rows.
  * For every created array, destroyDynArray() must be invoked to release the allocated memory.
  * @param[in, out] dynArray Untyped Dynamic Array
  * @param[in] entrySize The size of a single array entry in bytes
- * @param[in] chunkSize Initial number of entries and the number of entries to be added each expansion time
+ * @param[in] chunkSize Initial number of entries and the minimum number of entries to be added each expansion time
+ * (the number of entries added when DYN_ARRAY_GEOMETRIC_GROWTH is OFF)
+ * @param[in] allocator the allocator of the entries; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode createDynArray(DynArray* dynArray, size_t entrySize, uint16_t chunkSize);
+errorCode createDynArray(DynArray* dynArray, size_t entrySize, uint16_t chunkSize, const EXIPAllocator* allocator);
 
 /**
  * @brief Add new empty entry into the dynamic array
@@ -77,6 +87,25 @@ errorCode addDynEntry(DynArray* dynArray, void* entry, Index* entryID);
  */
 errorCode delDynEntry(DynArray* dynArray, Index entryID);
 
+/**
+ * @brief Makes room for at least entries entries in the dynamic array
+ * Used before adding a known number of entries so that the array is extended once.
+ *
+ * @param[in, out] dynArray Untyped Dynamic Array
+ * @param[in] entries the total number of entries the array must be able to hold
+ * @return Error handling code
+ */
+errorCode reserveDynArray(DynArray* dynArray, Index entries);
+
+/**
+ * @brief Frees the room for entries beyond the count of the dynamic array
+ * Used once no more entries are expected; the array can still grow afterwards.
+ *
+ * @param[in, out] dynArray Untyped Dynamic Array
+ * @return Error handling code
+ */
+errorCode shrinkDynArray(DynArray* dynArray);
+
 /**
  * @brief Destroy a Dynamic Array
  * This operation frees the allocated memory
@@ -21,95 +21,66 @@
  **/
 uint32_t djbHash(String str);
 
-struct hashtable;
+/**
+ * String hash function used by the EXIP hash tables.
+ * Processes the string four bytes at a time (the block and the
+ * finalization steps of MurmurHash3 x86_32 by Austin Appleby,
+ * placed in the public domain).
+ **/
+uint32_t stringHash(String str);
 
-/* Example of use:
- *
- *      struct hashtable  *h;
- *      struct some_key   *k;
- *      struct some_value *v;
- *
- *      static unsigned int         hash_from_key_fn( void *k );
- *      static int                  keys_equal_fn ( void *key1, void *key2 );
- *
- *      h = create_hashtable(16, hash_from_key_fn, keys_equal_fn);
- *      k = (struct some_key *)     malloc(sizeof(struct some_key));
- *      v = (struct some_value *)   malloc(sizeof(struct some_value));
- *
- *      (initialise k and v to suitable values)
- * 
- *      if (! hashtable_insert(h,k,v) )
- *      {     exit(-1);               }
- *
- *      if (NULL == (found = hashtable_search(h,k) ))
- *      {    printf("not found!");                  }
- *
- *      if (NULL == (found = hashtable_remove(h,k) ))
- *      {    printf("Not found\n");                 }
- *
- */
+struct hashtable;
 
-/* Macros may be used to define type-safe(r) hashtable access functions, with
- * methods specialized to take known key and value types as parameters.
- * 
- * Example:
- *
- * Insert this at the start of your file:
- *
- * DEFINE_HASHTABLE_INSERT(insert_some, struct some_key, struct some_value);
- * DEFINE_HASHTABLE_SEARCH(search_some, struct some_key, struct some_value);
- * DEFINE_HASHTABLE_REMOVE(remove_some, struct some_key, struct some_value);
- *
- * This defines the functions 'insert_some', 'search_some' and 'remove_some'.
- * These operate just like hashtable_insert etc., with the same parameters,
- * but their function signatures have 'struct some_key *' rather than
- * 'void *', and hence can generate compile time errors if your program is
- * supplying incorrect data as a key (and similarly for value).
- *
- * Note that the hash and key equality functions passed to create_hashtable
- * still take 'void *' parameters instead of 'some key *'. This shouldn't be
- * a difficult issue as they're only defined and passed once, and the other
- * functions will ensure that only valid keys are supplied to them.
- *
- * The cost for this checking is increased code size and runtime overhead
- * - if performance is important, it may be worth switching back to the
- * unsafe methods once your program has been debugged with the safe methods.
- * This just requires switching to some simple alternative defines - eg:
- * #define insert_some hashtable_insert
- *
+/*
+ * The hash tables map String keys to Index values. The tables use open
+ * addressing with linear probing and Robin Hood insertion in an array of
+ * power-of-two size: there is no allocation per entry and the removals
+ * shift back the following entries instead of leaving tombstones.
+ * The keys are not copied; the strings must stay valid while in the table.
+ * INDEX_MAX cannot be used as a value as it denotes an empty slot.
+ *
+ * Example of use:
+ *      struct hashtable *h;
+ *      h = create_hashtable(64, stringHash, stringEqual, NULL);
+ *      if(hashtable_insert(h, key, id) != EXIP_OK)
+ *      {     error      }
+ *      if(INDEX_MAX == (found = hashtable_search(h, key)))
+ *      {    not found   }
+ *      hashtable_destroy(h);
  */
 
 /*****************************************************************************
  * create_hashtable
    
  * @name                    create_hashtable
- * @param   minsize         minimum initial size of hashtable
+ * @param   minsize         minimum initial size of hashtable; rounded up to a power of two
+ *                          and must not be larger than MAX_HASH_TABLE_SIZE
  * @param   hashfunction    function for hashing keys
  * @param   key_eq_fn       function for determining key equality
+ * @param   allocator       the allocator of the table; NULL for EXIP_MALLOC
  * @return                  newly created hashtable or NULL on failure
  */
 
 struct hashtable *
 create_hashtable(unsigned int minsize,
 				 uint32_t (*hashfn) (String key),
-				 boolean (*eqfn) (const String str1, const String str2));
+				 boolean (*eqfn) (const String str1, const String str2),
+				 const EXIPAllocator *allocator);
 
 /*****************************************************************************
  * hashtable_insert
    
  * @name        hashtable_insert
  * @param   h   the hashtable to insert into
- * @param   k   the key - hashtable claims ownership and will free on removal
- * @param   v   the value - does not claim ownership
+ * @param   k   the key - does not claim ownership
+ * @param   v   the value - cannot be INDEX_MAX
  * @return      EXIP_OK for successful insertion
  *
- * This function will cause the table to expand if the insertion would take
- * the ratio of entries to table size over the maximum load factor.
+ * This function will cause the table to double its size if the insertion
+ * would take the ratio of entries to table size over the maximum load factor.
  *
  * This function does not check for repeated insertions with a duplicate key.
- * The value returned when using a duplicate key is undefined -- when
- * the hashtable changes size, the order of retrieval of duplicate key
- * entries is reversed.
+ * The value returned when using a duplicate key is undefined.
  * If in doubt, remove before insert.
  */
 
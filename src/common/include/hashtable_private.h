@@ -8,50 +8,32 @@
 #include "hashtable.h"
 
 /*****************************************************************************/
+/* A slot of the table; empty when value == INDEX_MAX */
 struct entry
 {
     String key;
     Index value;
     uint32_t hash;
-    struct entry *next;
 };
 
 struct hashtable {
+    /* Always a power of two */
     unsigned int tablelength;
-    struct entry **table;
+    struct entry *table;
     unsigned int entrycount;
     unsigned int loadlimit;
-    unsigned int primeindex;
     uint32_t (*hashfn) (String key);
     boolean (*eqfn) (const String str1, const String str2);
+    /* The allocator of the table; NULL for EXIP_MALLOC */
+    const EXIPAllocator *allocator;
 };
 
-/*****************************************************************************/
-
-// uint32_t hash(struct hashtable *h, void *k, unsigned int len);
-
 /*****************************************************************************/
 /* indexFor */
-/* inline not supported by all platforms
-   static inline unsigned int
-indexFor(unsigned int tablelength, unsigned int hashvalue) {
-    return (hashvalue % tablelength);
-};
-*/
-#define indexFor(tablelength,hashvalue)		((unsigned int) (hashvalue % (uint32_t) tablelength))
-
-/* Only works if tablelength == 2^N */
-/*static inline unsigned int
-indexFor(unsigned int tablelength, unsigned int hashvalue)
-{
-    return (hashvalue & (tablelength - 1u));
-}
-*/
-
-/*****************************************************************************/
-#define freekey(X) EXIP_MFREE(X)
-/*define freekey(X) ; */
+#define indexFor(tablelength,hashvalue)		((unsigned int) ((hashvalue) & (uint32_t) ((tablelength) - 1u)))
 
+/* The distance of the slot index from the slot of its hash value */
+#define probeDistance(tablelength,hashvalue,index)		((unsigned int) (((index) - indexFor(tablelength, hashvalue)) & ((tablelength) - 1u)))
 
 /*****************************************************************************/
 
@@ -24,17 +24,36 @@
 #include "errorHandle.h"
 #include "procTypes.h"
 
+/**
+ * @name Allocator dispatch
+ * The memory of the containers with an EXIPAllocator goes through it;
+ * a NULL allocator falls back to EXIP_MALLOC, EXIP_REALLOC and EXIP_MFREE.
+ */
+/**@{*/
+#define EXIP_ALLOCATE(allocator, size) ((allocator) != NULL ? \
+		(allocator)->allocate((allocator)->context, (size)) : EXIP_MALLOC(size))
+#define EXIP_REALLOCATE(allocator, ptr, size) ((allocator) != NULL ? \
+		(allocator)->reallocate((allocator)->context, (ptr), (size)) : EXIP_REALLOC((ptr), (size)))
+#define EXIP_RELEASE(allocator, ptr) do { \
+		if((ptr) != NULL) { \
+			if((allocator) != NULL) (allocator)->release((allocator)->context, (ptr)); \
+			else EXIP_MFREE(ptr); } \
+	} while(0)
+/**@}*/
+
 /**
  * @brief Initial setup of an AllocList
  *
  * @param[in, out] list a memory list to be setup
+ * @param[in] allocator the allocator of the chunks; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode initAllocList(AllocList* list);
+errorCode initAllocList(AllocList* list, const EXIPAllocator* allocator);
 
 /**
- * @brief Allocate a memory block with size size and store a copy of
- * the pointer in a linked list for freeing it at the end.
+ * @brief Allocate a memory block with size size from the chunks of the list
+ * The memory is aligned to ALLOCATION_ALIGNMENT and is freed together
+ * with the list by freeAllocList().
  *
  * @param[in, out] list A list storing the memory allocations
  * @param[in] size the size of the memory block to be allocated
@@ -56,8 +75,50 @@ void freeAllMem(EXIStream* strm);
  * @brief Frees a particular Allocation list
  *
  * @param[in, out] list Allocation list to be freed
- * @return Error handling code
  */
 void freeAllocList(AllocList* list);
 
+/**
+ * @brief Frees the memory allocated from the list but keeps its last chunk
+ * for the next allocations. The same as freeAllocList() followed by
+ * initAllocList() without the allocation of the first chunk.
+ *
+ * @param[in, out] list Allocation list to be reset
+ */
+void resetAllocList(AllocList* list);
+
+/**
+ * @brief Sets up an allocator over a caller-owned memory region
+ * The state of the allocator is kept at the start of the region and the
+ * rest of it is handed out in blocks; nothing is taken from the heap.
+ * The region is used as a stack: a released block is given back to the
+ * region once all the blocks allocated after it are released too.
+ * When the region is exhausted the allocations return NULL.
+ *
+ * @param[in, out] memory the region; it must remain valid while the allocator is used
+ * @param[in] size the size in bytes of memory
+ * @param[out] allocator the allocator; it is stored in memory
+ * @return Error handling code; EXIP_MEMORY_ALLOCATION_ERROR if the region cannot
+ * hold the state of the allocator
+ */
+errorCode initMemoryRegion(void* memory, size_t size, const EXIPAllocator** allocator);
+
+/**
+ * @brief Checks if an allocator is set up by initMemoryRegion()
+ *
+ * @param[in] allocator the allocator; can be NULL
+ * @return TRUE if the allocator takes its memory from a region
+ */
+boolean isMemoryRegion(const EXIPAllocator* allocator);
+
+/**
+ * @brief Gets the largest part of its region an allocator has used so far
+ * including the state of the allocator and the alignment of the region.
+ *
+ * @param[in] allocator the allocator of a region
+ * @param[out] peak the size in bytes of the region that would have been enough
+ * @return EXIP_INVALID_EXIP_CONFIGURATION if the allocator is not of a region
+ */
+errorCode getMemoryRegionPeak(const EXIPAllocator* allocator, size_t* peak);
+
 #endif /* MEMMANAGEMENT_H_ */
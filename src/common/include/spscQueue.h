@@ -0,0 +1,110 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file spscQueue.h
+ * @brief Bounded lock-free queue of pointers between one producer thread
+ * and one consumer thread. Pushing and popping only use atomic loads and
+ * stores of the ring positions; the mutex and the condition variable are
+ * touched only while the consumer is blocked on an empty queue.
+ * Used by the background threads of the double-buffered output and of
+ * the pipelined parsing.
+ *
+ * @date Oct 17, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include "procTypes.h"
+#include "errorHandle.h"
+
+#if EXIP_ASYNC_OUTPUT == ON || EXIP_PIPELINE == ON
+
+#include <pthread.h>
+
+/**
+ * @def EXIP_ATOMIC_LOAD(ptr)
+ * 		Atomic load of *ptr; the writes done before the matching
+ * 		EXIP_ATOMIC_STORE() are visible after it
+ * @def EXIP_ATOMIC_STORE(ptr, val)
+ * 		Atomic store of val in *ptr after all previous writes
+ */
+#define EXIP_ATOMIC_LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define EXIP_ATOMIC_STORE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+
+/**
+ * Ring of size slots with at most size - 1 items: the consumer advances
+ * head and the producer advances tail, so each position has a single writer.
+ */
+struct SPSCQueue
+{
+	void** items;
+	unsigned int size;
+	/** The next item to be popped; written by the consumer only */
+	unsigned int head;
+	/** The next free slot; written by the producer only */
+	unsigned int tail;
+	/** Set by a consumer blocked in waitSPSCQueue() */
+	boolean waiting;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+typedef struct SPSCQueue SPSCQueue;
+
+/**
+ * @brief Creates an empty queue
+ * For every created queue, destroySPSCQueue() must be invoked to release the allocated memory.
+ *
+ * @param[out] queue the queue
+ * @param[in] capacity the maximum number of items in the queue
+ * @return Error handling code
+ */
+errorCode createSPSCQueue(SPSCQueue* queue, unsigned int capacity);
+
+/**
+ * @brief Adds an item at the end of the queue; called by the producer only
+ * Wakes the consumer if it is blocked in waitSPSCQueue().
+ *
+ * @param[in, out] queue the queue
+ * @param[in] item the item
+ * @return FALSE if the queue is full
+ */
+boolean pushSPSCQueue(SPSCQueue* queue, void* item);
+
+/**
+ * @brief Removes the first item of the queue; called by the consumer only
+ *
+ * @param[in, out] queue the queue
+ * @param[out] item the item removed
+ * @return FALSE if the queue is empty
+ */
+boolean popSPSCQueue(SPSCQueue* queue, void** item);
+
+/**
+ * @brief Blocks until the queue holds at least count items; called by the consumer only
+ *
+ * @param[in, out] queue the queue
+ * @param[in] count the number of items to wait for; at most the capacity
+ */
+void waitSPSCQueue(SPSCQueue* queue, unsigned int count);
+
+/**
+ * @brief Frees the memory of the queue
+ * The producer and the consumer must not use it anymore.
+ *
+ * @param[in, out] queue the queue
+ */
+void destroySPSCQueue(SPSCQueue* queue);
+
+#endif /* EXIP_ASYNC_OUTPUT == ON || EXIP_PIPELINE == ON */
+
+#endif /* SPSCQUEUE_H_ */
@@ -20,9 +20,9 @@
 
 #define PARSING_STRING_MAX_LENGTH 100
 
-errorCode allocateStringMemory(CharType** str, Index UCSchars)
+errorCode allocateStringMemory(CharType** str, Index UCSchars, const EXIPAllocator* allocator)
 {
-	*str = EXIP_MALLOC(sizeof(CharType)*UCSchars);
+	*str = EXIP_ALLOCATE(allocator, sizeof(CharType)*UCSchars);
 	if((*str) == NULL)
 		return EXIP_MEMORY_ALLOCATION_ERROR;
 	return EXIP_OK;
@@ -48,6 +48,21 @@ errorCode writeCharToString(String* str, uint32_t code_point, Index* writerPosit
 	return EXIP_OK;
 }
 
+errorCode getUCSCharsNumber(const String* str, Index* UCSchars)
+{
+	*UCSchars = str->length;
+	return EXIP_OK;
+}
+
+errorCode writeAsciiToString(String* str, const unsigned char* ascii, Index count, Index* writerPosition)
+{
+	if(*writerPosition + count > str->length)
+		return EXIP_OUT_OF_BOUND_BUFFER;
+	memcpy(str->str + *writerPosition, ascii, count);
+	*writerPosition += count;
+	return EXIP_OK;
+}
+
 void getEmptyString(String* emptyStr)
 {
 	emptyStr->length = 0;
@@ -152,11 +167,40 @@ uint32_t readCharFromString(const String* str, Index* readerPosition)
 	return (uint32_t) str->str[*readerPosition - 1];
 }
 
-errorCode cloneString(const String* src, String* newStr)
+Index readAsciiFromString(const String* str, Index* readerPosition, Index maxChars, unsigned char* ascii)
+{
+	const unsigned char* src = (const unsigned char*) str->str + *readerPosition;
+	uint64_t word;
+	Index i = 0;
+
+	if(maxChars > str->length - *readerPosition)
+		maxChars = str->length - *readerPosition;
+
+	// Eight characters at a time while none of them has its most significant bit set
+	while(i + sizeof(uint64_t) <= maxChars)
+	{
+		memcpy(&word, src + i, sizeof(uint64_t));
+		if(word & 0x8080808080808080ULL)
+			break;
+		memcpy(ascii + i, src + i, sizeof(uint64_t));
+		i += sizeof(uint64_t);
+	}
+
+	while(i < maxChars && src[i] < 0x80)
+	{
+		ascii[i] = src[i];
+		i++;
+	}
+
+	*readerPosition += i;
+	return i;
+}
+
+errorCode cloneString(const String* src, String* newStr, const EXIPAllocator* allocator)
 {
 	if(newStr == NULL)
 		return EXIP_NULL_POINTER_REF;
-	newStr->str = EXIP_MALLOC(sizeof(CharType)*src->length);
+	newStr->str = EXIP_ALLOCATE(allocator, sizeof(CharType)*src->length);
 	if(newStr->str == NULL)
 		return EXIP_MEMORY_ALLOCATION_ERROR;
 	newStr->length = src->length;
@@ -240,27 +284,27 @@ errorCode stringToInt64(const String* src, int64_t* number)
 
 #if EXIP_IMPLICIT_DATA_TYPE_CONVERSION
 
-errorCode integerToString(Integer number, String* outStr)
+errorCode integerToString(Integer number, String* outStr, const EXIPAllocator* allocator)
 {
 	return EXIP_NOT_IMPLEMENTED_YET;
 }
 
-errorCode booleanToString(boolean b, String* outStr)
+errorCode booleanToString(boolean b, String* outStr, const EXIPAllocator* allocator)
 {
 	return EXIP_NOT_IMPLEMENTED_YET;
 }
 
-errorCode floatToString(Float f, String* outStr)
+errorCode floatToString(Float f, String* outStr, const EXIPAllocator* allocator)
 {
 	return EXIP_NOT_IMPLEMENTED_YET;
 }
 
-errorCode decimalToString(Decimal d, String* outStr)
+errorCode decimalToString(Decimal d, String* outStr, const EXIPAllocator* allocator)
 {
 	return EXIP_NOT_IMPLEMENTED_YET;
 }
 
-errorCode dateTimeToString(EXIPDateTime dt, String* outStr)
+errorCode dateTimeToString(EXIPDateTime dt, String* outStr, const EXIPAllocator* allocator)
 {
 	return EXIP_NOT_IMPLEMENTED_YET;
 }
@@ -0,0 +1,578 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file UTF8_stringManipulate.c
+ * @brief String manipulation functions used for UCS <-> UTF-8 transformations
+ * The String.length is the number of UTF-8 code units (bytes) of a string.
+ * Select this implementation instead of ASCII_stringManipulate.c with
+ * STRING_MANIPULATE = UTF8 in the build parameters of the target.
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "stringManipulate.h"
+#include "memManagement.h"
+#include <stdio.h>
+
+#if CHAR_TYPE_MAX_UNITS < 4
+# error "UTF8_stringManipulate.c requires CHAR_TYPE_MAX_UNITS of 4"
+#endif
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+#define PARSING_STRING_MAX_LENGTH 100
+
+/** The most significant bits of the bytes in a 64-bit word */
+#define UTF8_HIGH_BITS 0x8080808080808080ULL
+
+/** Whether a byte is a UTF-8 continuation byte (10xxxxxx) */
+#define IS_UTF8_CONTINUATION(b) (((b) & 0xC0) == 0x80)
+
+/**
+ * @brief Returns the number of leading bytes of src below 0x80
+ * 16 bytes at a time with SSE2 when available, 8 bytes at a time otherwise
+ */
+static Index getAsciiPrefix(const unsigned char* src, Index len);
+
+errorCode allocateStringMemory(CharType** str, Index UCSchars, const EXIPAllocator* allocator)
+{
+	*str = EXIP_ALLOCATE(allocator, sizeof(CharType)*UCSchars*CHAR_TYPE_MAX_UNITS);
+	if((*str) == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	return EXIP_OK;
+}
+
+errorCode allocateStringMemoryManaged(CharType** str, Index UCSchars, AllocList* memList)
+{
+	(*str) = (CharType*) memManagedAllocate(memList, sizeof(CharType)*UCSchars*CHAR_TYPE_MAX_UNITS);
+	if((*str) == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	return EXIP_OK;
+}
+
+errorCode writeCharToString(String* str, uint32_t code_point, Index* writerPosition)
+{
+	unsigned char* dst = (unsigned char*) str->str + *writerPosition;
+	Index units;
+
+	if(code_point < 0x80)
+		units = 1;
+	else if(code_point < 0x800)
+		units = 2;
+	else if(code_point < 0x10000)
+	{
+		if(code_point >= 0xD800 && code_point <= 0xDFFF) // UTF-16 surrogates are not characters
+			return EXIP_INVALID_STRING_OPERATION;
+		units = 3;
+	}
+	else if(code_point < 0x110000)
+		units = 4;
+	else
+		return EXIP_INVALID_STRING_OPERATION;
+
+	if(*writerPosition + units > str->length)
+		return EXIP_OUT_OF_BOUND_BUFFER;
+
+	switch(units)
+	{
+		case 1:
+			dst[0] = (unsigned char) code_point;
+		break;
+		case 2:
+			dst[0] = (unsigned char) (0xC0 | (code_point >> 6));
+			dst[1] = (unsigned char) (0x80 | (code_point & 0x3F));
+		break;
+		case 3:
+			dst[0] = (unsigned char) (0xE0 | (code_point >> 12));
+			dst[1] = (unsigned char) (0x80 | ((code_point >> 6) & 0x3F));
+			dst[2] = (unsigned char) (0x80 | (code_point & 0x3F));
+		break;
+		default:
+			dst[0] = (unsigned char) (0xF0 | (code_point >> 18));
+			dst[1] = (unsigned char) (0x80 | ((code_point >> 12) & 0x3F));
+			dst[2] = (unsigned char) (0x80 | ((code_point >> 6) & 0x3F));
+			dst[3] = (unsigned char) (0x80 | (code_point & 0x3F));
+	}
+
+	*writerPosition += units;
+	return EXIP_OK;
+}
+
+static Index getAsciiPrefix(const unsigned char* src, Index len)
+{
+	Index i = 0;
+	uint64_t word;
+
+#if defined(__SSE2__)
+	while(i + 16 <= len)
+	{
+		int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) (src + i)));
+		if(mask != 0)
+		{
+			while((mask & 1) == 0)
+			{
+				mask = mask >> 1;
+				i++;
+			}
+			return i;
+		}
+		i += 16;
+	}
+#endif
+	while(i + sizeof(uint64_t) <= len)
+	{
+		memcpy(&word, src + i, sizeof(uint64_t));
+		if(word & UTF8_HIGH_BITS)
+			break;
+		i += sizeof(uint64_t);
+	}
+
+	while(i < len && src[i] < 0x80)
+		i++;
+
+	return i;
+}
+
+errorCode getUCSCharsNumber(const String* str, Index* UCSchars)
+{
+	const unsigned char* src = (const unsigned char*) str->str;
+	Index i = 0;
+	Index count = 0;
+
+	while(i < str->length)
+	{
+		Index run = getAsciiPrefix(src + i, str->length - i);
+		unsigned char lead;
+		uint32_t code_point;
+		Index units;
+		Index k;
+
+		i += run;
+		count += run;
+		if(i == str->length)
+			break;
+
+		// Validate a multi-byte sequence (RFC 3629): no overlong forms,
+		// no surrogates and nothing above U+10FFFF
+		lead = src[i];
+		if(lead >= 0xC2 && lead <= 0xDF)
+		{
+			units = 2;
+			code_point = lead & 0x1F;
+		}
+		else if(lead >= 0xE0 && lead <= 0xEF)
+		{
+			units = 3;
+			code_point = lead & 0x0F;
+		}
+		else if(lead >= 0xF0 && lead <= 0xF4)
+		{
+			units = 4;
+			code_point = lead & 0x07;
+		}
+		else
+			return EXIP_INVALID_STRING_OPERATION;
+
+		if(i + units > str->length)
+			return EXIP_INVALID_STRING_OPERATION;
+
+		for(k = 1; k < units; k++)
+		{
+			if(!IS_UTF8_CONTINUATION(src[i + k]))
+				return EXIP_INVALID_STRING_OPERATION;
+			code_point = (code_point << 6) | (src[i + k] & 0x3F);
+		}
+
+		if((units == 3 && (code_point < 0x800 || (code_point >= 0xD800 && code_point <= 0xDFFF))) ||
+				(units == 4 && (code_point < 0x10000 || code_point > 0x10FFFF)))
+			return EXIP_INVALID_STRING_OPERATION;
+
+		i += units;
+		count++;
+	}
+
+	*UCSchars = count;
+	return EXIP_OK;
+}
+
+errorCode writeAsciiToString(String* str, const unsigned char* ascii, Index count, Index* writerPosition)
+{
+	if(*writerPosition + count > str->length)
+		return EXIP_OUT_OF_BOUND_BUFFER;
+	memcpy(str->str + *writerPosition, ascii, count);
+	*writerPosition += count;
+	return EXIP_OK;
+}
+
+void getEmptyString(String* emptyStr)
+{
+	emptyStr->length = 0;
+	emptyStr->str = NULL;
+}
+
+boolean isStringEmpty(const String* str)
+{
+	if(str == NULL || str->length == 0)
+		return 1;
+	return 0;
+}
+
+errorCode asciiToString(const char* inStr, String* outStr, AllocList* memList, boolean clone)
+{
+	outStr->length = strlen(inStr);
+	if(outStr->length > 0)  // If == 0 -> empty string
+	{
+		if(clone == FALSE)
+		{
+			outStr->str = (CharType*) inStr;
+			return EXIP_OK;
+		}
+		else
+		{
+			outStr->str = (CharType*) memManagedAllocate(memList, sizeof(CharType)*(outStr->length));
+			if(outStr->str == NULL)
+				return EXIP_MEMORY_ALLOCATION_ERROR;
+			memcpy(outStr->str, inStr, outStr->length);
+			return EXIP_OK;
+		}
+	}
+	else
+		outStr->str = NULL;
+	return EXIP_OK;
+}
+
+boolean stringEqual(const String str1, const String str2)
+{
+	if(str1.length != str2.length)
+		return 0;
+	else if(str1.length == 0)
+		return 1;
+	else // The strings have the same length
+	{
+		Index i;
+		for(i = 0; i < str1.length; i++)
+		{
+			if(str1.str[i] != str2.str[i])
+				return 0;
+		}
+		return 1;
+	}
+}
+
+boolean stringEqualToAscii(const String str1, const char* str2)
+{
+	if(str1.length != strlen(str2))
+		return 0;
+	else // The strings have the same length
+	{
+		Index i;
+		for(i = 0; i < str1.length; i++)
+		{
+			if(str1.str[i] != str2[i])
+				return 0;
+		}
+		return 1;
+	}
+}
+
+int stringCompare(const String str1, const String str2)
+{
+	/* Check for NULL string pointers */
+	if(str1.str == NULL)
+	{
+		if(str2.str == NULL)
+			return 0;
+		return -1;
+	}
+	else if(str2.str == NULL)
+		return 1;
+	else // None of the strings is NULL
+	{
+		int diff;
+		Index i;
+		for(i = 0; i < str1.length && i < str2.length; i++)
+		{
+			// The order of the octets of UTF-8 is the order of the code points
+			diff = (unsigned char) str1.str[i] - (unsigned char) str2.str[i];
+			if(diff)
+				return diff; // There is a difference in the characters at index i
+		}
+		/* Up to index i the strings have the same characters and might differ only in length*/
+		return str1.length - str2.length;
+	}
+}
+
+uint32_t readCharFromString(const String* str, Index* readerPosition)
+{
+	const unsigned char* src = (const unsigned char*) str->str + *readerPosition;
+	uint32_t code_point;
+
+	assert(*readerPosition < str->length);
+
+	// The string is expected to be valid UTF-8 (see getUCSCharsNumber())
+	if(src[0] < 0x80)
+	{
+		*readerPosition += 1;
+		return src[0];
+	}
+	else if(src[0] < 0xE0)
+	{
+		code_point = ((uint32_t) (src[0] & 0x1F) << 6) | (src[1] & 0x3F);
+		*readerPosition += 2;
+	}
+	else if(src[0] < 0xF0)
+	{
+		code_point = ((uint32_t) (src[0] & 0x0F) << 12) | ((uint32_t) (src[1] & 0x3F) << 6) | (src[2] & 0x3F);
+		*readerPosition += 3;
+	}
+	else
+	{
+		code_point = ((uint32_t) (src[0] & 0x07) << 18) | ((uint32_t) (src[1] & 0x3F) << 12) |
+				((uint32_t) (src[2] & 0x3F) << 6) | (src[3] & 0x3F);
+		*readerPosition += 4;
+	}
+
+	return code_point;
+}
+
+Index readAsciiFromString(const String* str, Index* readerPosition, Index maxChars, unsigned char* ascii)
+{
+	const unsigned char* src = (const unsigned char*) str->str + *readerPosition;
+	uint64_t word;
+	Index i = 0;
+
+	if(maxChars > str->length - *readerPosition)
+		maxChars = str->length - *readerPosition;
+
+	// Eight characters at a time while none of them has its most significant bit set
+	while(i + sizeof(uint64_t) <= maxChars)
+	{
+		memcpy(&word, src + i, sizeof(uint64_t));
+		if(word & 0x8080808080808080ULL)
+			break;
+		memcpy(ascii + i, src + i, sizeof(uint64_t));
+		i += sizeof(uint64_t);
+	}
+
+	while(i < maxChars && src[i] < 0x80)
+	{
+		ascii[i] = src[i];
+		i++;
+	}
+
+	*readerPosition += i;
+	return i;
+}
+
+errorCode cloneString(const String* src, String* newStr, const EXIPAllocator* allocator)
+{
+	if(newStr == NULL)
+		return EXIP_NULL_POINTER_REF;
+	newStr->str = EXIP_ALLOCATE(allocator, sizeof(CharType)*src->length);
+	if(newStr->str == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	newStr->length = src->length;
+	memcpy(newStr->str, src->str, src->length);
+	return EXIP_OK;
+}
+
+errorCode cloneStringManaged(const String* src, String* newStr, AllocList* memList)
+{
+	if(newStr == NULL)
+		return EXIP_NULL_POINTER_REF;
+	newStr->str = memManagedAllocate(memList, sizeof(CharType)*src->length);
+	if(newStr->str == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	newStr->length = src->length;
+	memcpy(newStr->str, src->str, src->length);
+	return EXIP_OK;
+}
+
+Index getIndexOfChar(const String* src, CharType sCh)
+{
+	Index i;
+
+	for(i = 0; i < src->length; i++)
+	{
+		if(src->str[i] == sCh)
+			return i;
+	}
+	return INDEX_MAX;
+}
+
+errorCode stringToInteger(const String* src, int* number)
+{
+	char buff[PARSING_STRING_MAX_LENGTH];
+	long result;
+	char *endPointer;
+
+	if(src->length == 0 || src->length >= PARSING_STRING_MAX_LENGTH)
+		return EXIP_INVALID_STRING_OPERATION;
+
+	memcpy(buff, src->str, src->length);
+	buff[src->length] = '\0';
+
+	result = strtol(buff, &endPointer, 10);
+
+	if(result == LONG_MAX || result == LONG_MIN || *src->str == *endPointer)
+		return EXIP_INVALID_STRING_OPERATION;
+
+	if(result >= INT_MAX || result <= INT_MIN)
+		return EXIP_OUT_OF_BOUND_BUFFER;
+
+	*number = (int) result;
+
+	return EXIP_OK;
+}
+
+errorCode stringToInt64(const String* src, int64_t* number)
+{
+	char buff[PARSING_STRING_MAX_LENGTH];
+	long long result;
+	char *endPointer;
+
+	if(src->length == 0 || src->length >= PARSING_STRING_MAX_LENGTH)
+		return EXIP_INVALID_STRING_OPERATION;
+
+	memcpy(buff, src->str, src->length);
+	buff[src->length] = '\0';
+
+	result = EXIP_STRTOLL(buff, &endPointer, 10);
+
+	if(result == LLONG_MAX || result == LLONG_MIN || *src->str == *endPointer)
+		return EXIP_INVALID_STRING_OPERATION;
+
+	if(result >= LLONG_MAX || result <= LLONG_MIN)
+		return EXIP_OUT_OF_BOUND_BUFFER;
+
+	*number = (int64_t) result;
+
+	return EXIP_OK;
+}
+
+#if EXIP_IMPLICIT_DATA_TYPE_CONVERSION
+
+/**
+ * @brief Stores the ASCII representation of a value in a newly allocated String
+ */
+static errorCode bufferToString(const char* buff, String* outStr, const EXIPAllocator* allocator)
+{
+	outStr->length = strlen(buff);
+	outStr->str = EXIP_ALLOCATE(allocator, sizeof(CharType)*outStr->length);
+	if(outStr->str == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	memcpy(outStr->str, buff, outStr->length);
+	return EXIP_OK;
+}
+
+errorCode integerToString(Integer number, String* outStr, const EXIPAllocator* allocator)
+{
+	char buff[PARSING_STRING_MAX_LENGTH];
+
+	sprintf(buff, "%lld", (long long) number);
+	return bufferToString(buff, outStr, allocator);
+}
+
+errorCode booleanToString(boolean b, String* outStr, const EXIPAllocator* allocator)
+{
+	return bufferToString(b ? "true" : "false", outStr, allocator);
+}
+
+errorCode floatToString(Float f, String* outStr, const EXIPAllocator* allocator)
+{
+	char buff[PARSING_STRING_MAX_LENGTH];
+
+	// Special values as defined by the EXI Float datatype
+	if(f.exponent == -(1 << 14))
+	{
+		if(f.mantissa == 1)
+			return bufferToString("INF", outStr, allocator);
+		else if(f.mantissa == -1)
+			return bufferToString("-INF", outStr, allocator);
+		else
+			return bufferToString("NaN", outStr, allocator);
+	}
+
+	sprintf(buff, "%lldE%d", (long long) f.mantissa, (int) f.exponent);
+	return bufferToString(buff, outStr, allocator);
+}
+
+errorCode decimalToString(Decimal d, String* outStr, const EXIPAllocator* allocator)
+{
+	char digits[PARSING_STRING_MAX_LENGTH];
+	char buff[2*PARSING_STRING_MAX_LENGTH];
+	char* digit = digits;
+	int digitsCount;
+	int pos = 0;
+
+	if(d.exponent > PARSING_STRING_MAX_LENGTH || d.exponent < -PARSING_STRING_MAX_LENGTH)
+		return EXIP_OUT_OF_BOUND_BUFFER;
+
+	sprintf(digits, "%lld", (long long) d.mantissa);
+	if(*digit == '-')
+	{
+		buff[pos++] = '-';
+		digit++;
+	}
+	digitsCount = (int) strlen(digit);
+
+	if(d.exponent >= 0)
+	{
+		// The mantissa followed by exponent zeros
+		memcpy(buff + pos, digit, digitsCount);
+		pos += digitsCount;
+		memset(buff + pos, '0', d.exponent);
+		pos += d.exponent;
+	}
+	else if(digitsCount > -d.exponent)
+	{
+		// The decimal point falls inside the mantissa
+		memcpy(buff + pos, digit, digitsCount + d.exponent);
+		pos += digitsCount + d.exponent;
+		buff[pos++] = '.';
+		memcpy(buff + pos, digit + digitsCount + d.exponent, -d.exponent);
+		pos += -d.exponent;
+	}
+	else
+	{
+		// Leading zeros after the decimal point
+		buff[pos++] = '0';
+		buff[pos++] = '.';
+		memset(buff + pos, '0', -d.exponent - digitsCount);
+		pos += -d.exponent - digitsCount;
+		memcpy(buff + pos, digit, digitsCount);
+		pos += digitsCount;
+	}
+	buff[pos] = '\0';
+
+	return bufferToString(buff, outStr, allocator);
+}
+
+errorCode dateTimeToString(EXIPDateTime dt, String* outStr, const EXIPAllocator* allocator)
+{
+	return EXIP_NOT_IMPLEMENTED_YET;
+}
+
+#endif /* EXIP_IMPLICIT_DATA_TYPE_CONVERSION */
+
+#if EXIP_DEBUG == ON
+
+void printString(const String* inStr)
+{
+	if(inStr->length == 0)
+		return;
+
+	DEBUG_OUTPUT(("%.*s", (int) inStr->length, inStr->str));
+}
+
+#endif /* EXIP_DEBUG */
@@ -18,12 +18,12 @@
 #include "dynamicArray.h"
 #include "memManagement.h"
 
-errorCode createDynArray(DynArray* dynArray, size_t entrySize, uint16_t chunkEntries)
+errorCode createDynArray(DynArray* dynArray, size_t entrySize, uint16_t chunkEntries, const EXIPAllocator* allocator)
 {
 	void** base = (void **)(dynArray + 1);
 	Index* count = (Index*)(base + 1);
 
-	*base = EXIP_MALLOC(entrySize*chunkEntries);
+	*base = EXIP_ALLOCATE(allocator, entrySize*chunkEntries);
 	if(*base == NULL)
 		return EXIP_MEMORY_ALLOCATION_ERROR;
 
@@ -31,12 +31,33 @@ errorCode createDynArray(DynArray* dynArray, size_t entrySize, uint16_t chunkEnt
 	*count = 0;
 	dynArray->chunkEntries = chunkEntries;
 	dynArray->arrayEntries = chunkEntries;
+	dynArray->allocator = allocator;
+
+	return EXIP_OK;
+}
+
+/** Reallocates the entries of the array for arrayEntries entries */
+static errorCode resizeDynArray(DynArray* dynArray, Index arrayEntries)
+{
+	void** base = (void **)(dynArray + 1);
+	void* ptr;
+
+	if(arrayEntries > SIZE_MAX/dynArray->entrySize)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	ptr = EXIP_REALLOCATE(dynArray->allocator, *base, dynArray->entrySize*arrayEntries);
+	if(ptr == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	*base = ptr;
+	dynArray->arrayEntries = arrayEntries;
 
 	return EXIP_OK;
 }
 
 errorCode addEmptyDynEntry(DynArray* dynArray, void** entry, Index* entryID)
 {
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 	void** base;
 	Index* count;
 
@@ -47,12 +68,24 @@ errorCode addEmptyDynEntry(DynArray* dynArray, void** entry, Index* entryID)
 	count = (Index*)(base + 1);
 	if(dynArray->arrayEntries == *count)   // The dynamic array must be extended first
 	{
-		void* ptr = EXIP_REALLOC(*base, dynArray->entrySize * (*count + dynArray->chunkEntries));
-		if(ptr == NULL)
+		Index growth = dynArray->chunkEntries;
+
+#if DYN_ARRAY_GEOMETRIC_GROWTH == ON
+		if(growth < dynArray->arrayEntries)
+			growth = dynArray->arrayEntries;
+# if DYN_ARRAY_MAX_GROWTH > 0
+		if(growth > DYN_ARRAY_MAX_GROWTH)
+			growth = DYN_ARRAY_MAX_GROWTH > dynArray->chunkEntries ? DYN_ARRAY_MAX_GROWTH : dynArray->chunkEntries;
+# endif
+#endif
+		if(growth == 0)
+			growth = 1;
+		if(growth > INDEX_MAX - dynArray->arrayEntries)
+			growth = INDEX_MAX - dynArray->arrayEntries;
+		if(growth == 0)
 			return EXIP_MEMORY_ALLOCATION_ERROR;
 
-		*base = ptr;
-		dynArray->arrayEntries = dynArray->arrayEntries + dynArray->chunkEntries;
+		TRY(resizeDynArray(dynArray, dynArray->arrayEntries + growth));
 	}
 
 	*entry = (void*)((unsigned char *)(*base) + (*count * dynArray->entrySize));
@@ -85,26 +118,47 @@ errorCode delDynEntry(DynArray* dynArray, Index entryID)
 	base = (void **)(dynArray + 1);
 	count = (Index*)(base + 1);
 
-	if(entryID == *count - 1)
-	{
-		*count -= 1;
-	}
-	else if(*count - 1 - entryID >= 0)
-	{
-		/* Shuffle the array down to fill the removed entry */
-		memcpy(((unsigned char *)*base) + entryID * dynArray->entrySize,
-			   ((unsigned char *)*base) + entryID * dynArray->entrySize + dynArray->entrySize,
-			   (*count - 1 - entryID) * dynArray->entrySize);
-		*count -= 1;
-	}
-	else
+	if(entryID >= *count)
 		return EXIP_OUT_OF_BOUND_BUFFER;
 
+	/* Shuffle the array down to fill the removed entry */
+	memmove(((unsigned char *)*base) + entryID * dynArray->entrySize,
+		   ((unsigned char *)*base) + entryID * dynArray->entrySize + dynArray->entrySize,
+		   (*count - 1 - entryID) * dynArray->entrySize);
+	*count -= 1;
+
 	return EXIP_OK;
 }
 
+errorCode reserveDynArray(DynArray* dynArray, Index entries)
+{
+	if(dynArray == NULL)
+		return EXIP_NULL_POINTER_REF;
+
+	if(entries <= dynArray->arrayEntries)
+		return EXIP_OK;
+
+	return resizeDynArray(dynArray, entries);
+}
+
+errorCode shrinkDynArray(DynArray* dynArray)
+{
+	Index* count;
+
+	if(dynArray == NULL)
+		return EXIP_NULL_POINTER_REF;
+
+	count = (Index*)((void **)(dynArray + 1) + 1);
+
+	// Keeps an entry so that the array is not left without memory
+	if(dynArray->arrayEntries <= *count || dynArray->arrayEntries == 1)
+		return EXIP_OK;
+
+	return resizeDynArray(dynArray, *count > 0 ? *count : 1);
+}
+
 void destroyDynArray(DynArray* dynArray)
 {
 	void** base = (void **)(dynArray + 1);
-	EXIP_MFREE(*base);
+	EXIP_RELEASE(dynArray->allocator, *base);
 }
@@ -5,25 +5,15 @@
 #include "hashtable.h"
 #include "hashtable_private.h"
 #include "procTypes.h"
+#include "memManagement.h"
 
-#define CEIL(VARIABLE) ( ((VARIABLE) - (unsigned int)(VARIABLE))==0 ? (unsigned int)(VARIABLE) : (unsigned int) (VARIABLE)+1 )
+/* The smallest table that is created */
+#define MIN_TABLE_LENGTH 16
 
-/*
-Credit for primes table: Aaron Krowne
- http://br.endernet.org/~akrowne/
- http://planetmath.org/encyclopedia/GoodHashTablePrimes.html
-*/
-static const uint32_t primes[] = {
-53, 97, 193, 389,
-769, 1543, 3079, 6151,
-12289, 24593, 49157, 98317,
-196613, 393241, 786433, 1572869,
-3145739, 6291469, 12582917, 25165843,
-50331653, 100663319, 201326611, 402653189,
-805306457, 1610612741
-};
-const unsigned int prime_table_length = sizeof(primes)/sizeof(primes[0]);
-const float max_load_factor = 0.65F;
+/* The maximum load factor is 3/4 */
+#define LOAD_LIMIT(tablelength) ((tablelength) - (tablelength)/4)
+
+#define ROTL32(x, r) (((x) << (r)) | ((x) >> (32 - (r))))
 
 uint32_t djbHash(String str)
 {
@@ -39,104 +29,138 @@ uint32_t djbHash(String str)
 	return hash;
 }
 
+uint32_t stringHash(String str)
+{
+	const unsigned char* data = (const unsigned char*) str.str;
+	size_t len = sizeof(CharType)*str.length;
+	size_t blocks = len/4;
+	uint32_t hash = (uint32_t) len;
+	uint32_t k;
+	size_t i;
+
+	for(i = 0; i < blocks; i++)
+	{
+		// memcpy as the strings are not aligned
+		memcpy(&k, data + 4*i, 4);
+		k *= 0xcc9e2d51;
+		k = ROTL32(k, 15);
+		k *= 0x1b873593;
+
+		hash ^= k;
+		hash = ROTL32(hash, 13);
+		hash = hash*5 + 0xe6546b64;
+	}
+
+	k = 0;
+	switch(len & 3)
+	{
+		case 3:
+			k ^= (uint32_t) data[4*blocks + 2] << 16;
+			/* fall through */
+		case 2:
+			k ^= (uint32_t) data[4*blocks + 1] << 8;
+			/* fall through */
+		case 1:
+			k ^= (uint32_t) data[4*blocks];
+			k *= 0xcc9e2d51;
+			k = ROTL32(k, 15);
+			k *= 0x1b873593;
+			hash ^= k;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
 /*****************************************************************************/
 
+static struct entry* createTable(const EXIPAllocator *allocator, unsigned int size)
+{
+    struct entry *table;
+    unsigned int i;
+    table = (struct entry *)EXIP_ALLOCATE(allocator, sizeof(struct entry) * size);
+    if (NULL == table) return NULL; /*oom*/
+    for (i = 0; i < size; i++)
+        table[i].value = INDEX_MAX;
+    return table;
+}
+
 struct hashtable * create_hashtable(unsigned int minsize,
 						uint32_t (*hashfn) (String key),
-						boolean (*eqfn) (const String str1, const String str2))
+						boolean (*eqfn) (const String str1, const String str2),
+						const EXIPAllocator *allocator)
 {
     struct hashtable *h;
-    unsigned int pindex, size = primes[0];
+    unsigned int size = MIN_TABLE_LENGTH;
     /* Check requested hashtable isn't too large */
     if (minsize > MAX_HASH_TABLE_SIZE) return NULL;
-    /* Enforce size as prime */
-    for (pindex=0; pindex < prime_table_length; pindex++) {
-        if (primes[pindex] >= minsize) { size = primes[pindex]; break; }
-    }
-    h = (struct hashtable *)EXIP_MALLOC(sizeof(struct hashtable));
+    /* Enforce size as power of two */
+    while (size < minsize) size <<= 1;
+    h = (struct hashtable *)EXIP_ALLOCATE(allocator, sizeof(struct hashtable));
     if (NULL == h) return NULL; /*oom*/
-    h->table = (struct entry **)EXIP_MALLOC(sizeof(struct entry*) * size);
-    if (NULL == h->table) { EXIP_MFREE(h); return NULL; } /*oom*/
-    memset(h->table, 0, size * sizeof(struct entry *));
+    h->table = createTable(allocator, size);
+    if (NULL == h->table) { EXIP_RELEASE(allocator, h); return NULL; } /*oom*/
     h->tablelength  = size;
-    h->primeindex   = pindex;
     h->entrycount   = 0;
     h->hashfn       = hashfn;
     h->eqfn         = eqfn;
-    h->loadlimit    = CEIL(size * max_load_factor);
+    h->allocator    = allocator;
+    h->loadlimit    = LOAD_LIMIT(size);
     return h;
 }
 
 /*****************************************************************************/
+/* Places the entry e in the table; there must be an empty slot */
+static void placeEntry(struct entry *table, unsigned int tablelength, struct entry e)
+{
+    struct entry tmp;
+    unsigned int index = indexFor(tablelength, e.hash);
+    unsigned int dist = 0;
+    unsigned int edist;
 
-// Currently this function is not used. Some performance tests must be written
-// and performed to show if it is better when it is used
-//uint32_t hash(struct hashtable *h, void *k, unsigned int len)
-//{
-//    /* Aim to protect against poor hash functions by adding logic here
-//     * - logic taken from java 1.4 hashtable source */
-//    uint32_t i = h->hashfn(k, len);
-//    i += ~(i << 9);
-//    i ^=  ((i >> 14) | (i << 18)); /* >>> */
-//    i +=  (i << 4);
-//    i ^=  ((i >> 10) | (i << 22)); /* >>> */
-//    return i;
-//}
+    while (table[index].value != INDEX_MAX)
+    {
+        /* Robin Hood: the entry that is closer to its slot moves on */
+        edist = probeDistance(tablelength, table[index].hash, index);
+        if (edist < dist)
+        {
+            tmp = table[index];
+            table[index] = e;
+            e = tmp;
+            dist = edist;
+        }
+        index = indexFor(tablelength, index + 1);
+        dist++;
+    }
+    table[index] = e;
+}
 
 /*****************************************************************************/
 static int hashtable_expand(struct hashtable *h)
 {
     /* Double the size of the table to accommodate more entries */
-    struct entry **newtable;
-    struct entry *e;
-    struct entry **pE;
-    unsigned int newsize, i, index;
-    /* Check we're not hitting max capacity */
-    if (h->primeindex == (prime_table_length - 1) || primes[h->primeindex + 1] > MAX_HASH_TABLE_SIZE) return 0;
-    newsize = primes[++(h->primeindex)];
+    struct entry *newtable;
+    unsigned int newsize, i;
 
-    newtable = (struct entry **)EXIP_MALLOC(sizeof(struct entry*) * newsize);
-    if (NULL != newtable)
+    newsize = h->tablelength << 1;
+    if (newsize == 0) return 0;
+    newtable = createTable(h->allocator, newsize);
+    if (NULL == newtable) return 0;
+
+    for (i = 0; i < h->tablelength; i++)
     {
-        memset(newtable, 0, newsize * sizeof(struct entry *));
-        /* This algorithm is not 'stable'. ie. it reverses the list
-         * when it transfers entries between the tables */
-        for (i = 0; i < h->tablelength; i++) {
-            while (NULL != (e = h->table[i])) {
-                h->table[i] = e->next;
-                index = indexFor(newsize,e->hash);
-                e->next = newtable[index];
-                newtable[index] = e;
-            }
-        }
-        EXIP_MFREE(h->table);
-        h->table = newtable;
-    }
-    /* Plan B: realloc instead */
-    else 
-    {
-        newtable = (struct entry **) EXIP_REALLOC(h->table, newsize * sizeof(struct entry *));
-        if (NULL == newtable) { (h->primeindex)--; return 0; }
-        h->table = newtable;
-        memset(newtable[h->tablelength], 0, newsize - h->tablelength);
-        for (i = 0; i < h->tablelength; i++) {
-            for (pE = &(newtable[i]), e = *pE; e != NULL; e = *pE) {
-                index = indexFor(newsize,e->hash);
-                if (index == i)
-                {
-                    pE = &(e->next);
-                }
-                else
-                {
-                    *pE = e->next;
-                    e->next = newtable[index];
-                    newtable[index] = e;
-                }
-            }
-        }
+        if (h->table[i].value != INDEX_MAX)
+            placeEntry(newtable, newsize, h->table[i]);
     }
+    EXIP_RELEASE(h->allocator, h->table);
+    h->table = newtable;
     h->tablelength = newsize;
-    h->loadlimit   = CEIL(newsize * max_load_factor);
+    h->loadlimit   = LOAD_LIMIT(newsize);
     return -1;
 }
 
@@ -150,94 +174,87 @@ unsigned int hashtable_count(struct hashtable *h)
 errorCode hashtable_insert(struct hashtable *h, String key, Index value)
 {
     /* This method allows duplicate keys - but they shouldn't be used */
-    unsigned int index;
-    struct entry *e;
-    if (++(h->entrycount) > h->loadlimit)
+    struct entry e;
+    if (value == INDEX_MAX) return EXIP_HASH_TABLE_ERROR;
+    if (h->entrycount + 1 > h->loadlimit)
     {
-        /* Ignore the return value. If expand fails, we should
-         * still try cramming just this value into the existing table
-         * -- we may not have memory for a larger table, but one more
-         * element may be ok. Next time we insert, we'll try expanding again.*/
-        hashtable_expand(h);
+        /* If expand fails, we should still try cramming just this value
+         * into the existing table as long as one slot stays empty
+         * -- the search of missing keys stops at an empty slot.
+         * Next time we insert, we'll try expanding again.*/
+        if (!hashtable_expand(h) && h->entrycount + 1 >= h->tablelength)
+            return EXIP_MEMORY_ALLOCATION_ERROR;
     }
-    e = (struct entry *)EXIP_MALLOC(sizeof(struct entry));
-    if (NULL == e) { --(h->entrycount); return EXIP_MEMORY_ALLOCATION_ERROR; } /*oom*/
-    e->hash = h->hashfn(key); // hash(h,k, len);
-    index = indexFor(h->tablelength,e->hash);
-    e->key = key;
-    e->value = value;
-    e->next = h->table[index];
-    h->table[index] = e;
+    e.key = key;
+    e.value = value;
+    e.hash = h->hashfn(key);
+    placeEntry(h->table, h->tablelength, e);
+    h->entrycount++;
     return EXIP_OK;
 }
 
 /*****************************************************************************/
-Index hashtable_search(struct hashtable *h, String key)
+/* Returns the slot of the key or tablelength if none */
+static unsigned int findEntry(struct hashtable *h, String key)
 {
     struct entry *e;
     uint32_t hashvalue;
     unsigned int index;
-    hashvalue = h->hashfn(key); // hash(h,k, len);
-    index = indexFor(h->tablelength,hashvalue);
-    e = h->table[index];
-    while (NULL != e)
+    unsigned int dist = 0;
+    hashvalue = h->hashfn(key);
+    index = indexFor(h->tablelength, hashvalue);
+    while (1)
     {
+        e = &h->table[index];
+        /* The key would have displaced an entry closer to its slot */
+        if (e->value == INDEX_MAX || probeDistance(h->tablelength, e->hash, index) < dist)
+            return h->tablelength;
         /* Check hash value to short circuit heavier comparison */
-        if ((hashvalue == e->hash) && h->eqfn(key, e->key)) return e->value;
-        e = e->next;
+        if ((hashvalue == e->hash) && h->eqfn(key, e->key)) return index;
+        index = indexFor(h->tablelength, index + 1);
+        dist++;
     }
-    return INDEX_MAX;
 }
 
 /*****************************************************************************/
-Index hashtable_remove(struct hashtable *h, String key)
+Index hashtable_search(struct hashtable *h, String key)
 {
-    /* TODO: consider compacting the table when the load factor drops enough,
-     *       or provide a 'compact' method. */
+    unsigned int index = findEntry(h, key);
+    if (index == h->tablelength) return INDEX_MAX;
+    return h->table[index].value;
+}
 
-    struct entry *e;
-    struct entry **pE;
+/*****************************************************************************/
+Index hashtable_remove(struct hashtable *h, String key)
+{
     Index value;
-    uint32_t hashvalue;
-    unsigned int index;
+    unsigned int index = findEntry(h, key);
+    unsigned int next;
 
-    hashvalue = h->hashfn(key); // hash(h,k, len);
-    index = indexFor(h->tablelength, hashvalue);
-    pE = &(h->table[index]);
-    e = *pE;
-    while (NULL != e)
+    if (index == h->tablelength) return INDEX_MAX;
+    value = h->table[index].value;
+
+    /* Shift back the entries that are not in their slot */
+    next = indexFor(h->tablelength, index + 1);
+    while (h->table[next].value != INDEX_MAX && probeDistance(h->tablelength, h->table[next].hash, next) > 0)
     {
-        /* Check hash value to short circuit heavier comparison */
-        if (hashvalue == e->hash && h->eqfn(key, e->key))
-        {
-            *pE = e->next;
-            h->entrycount--;
-            value = e->value;
- //           freekey(e->key);
-            EXIP_MFREE(e);
-            return value;
-        }
-        pE = &(e->next);
-        e = e->next;
+        h->table[index] = h->table[next];
+        index = next;
+        next = indexFor(h->tablelength, next + 1);
     }
-    return INDEX_MAX;
+    h->table[index].value = INDEX_MAX;
+    h->entrycount--;
+    return value;
 }
 
 /*****************************************************************************/
 /* destroy */
 void hashtable_destroy(struct hashtable *h)
 {
-    unsigned int i;
-    struct entry *e, *f;
-    struct entry **table = h->table;
-	for (i = 0; i < h->tablelength; i++)
-	{
-		e = table[i];
-		while (NULL != e)
-		{ f = e; e = e->next; EXIP_MFREE(f); }
-	}
-    EXIP_MFREE(h->table);
-    EXIP_MFREE(h);
+    const EXIPAllocator *allocator = h->allocator;
+
+    EXIP_RELEASE(allocator, h->table);
+    EXIP_RELEASE(allocator, h);
 }
 
 /*
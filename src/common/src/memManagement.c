@@ -20,38 +20,83 @@
 #include "sTables.h"
 #include "grammars.h"
 
-errorCode initAllocList(AllocList* list)
+/** The size of the chunk header rounded up to the alignment */
+#define CHUNK_HEADER_SIZE ((sizeof(struct allocChunk) + ALLOCATION_ALIGNMENT - 1) & ~((size_t) ALLOCATION_ALIGNMENT - 1))
+
+#define CHUNK_DATA(chunk) ((unsigned char*) (chunk) + CHUNK_HEADER_SIZE)
+
+errorCode initAllocList(AllocList* list, const EXIPAllocator* allocator)
 {
-	list->firstBlock = EXIP_MALLOC(sizeof(struct allocBlock));
-	if(list->firstBlock == NULL)
-		return EXIP_MEMORY_ALLOCATION_ERROR;
-	list->firstBlock->nextBlock = NULL;
-	list->lastBlock = list->firstBlock;
-	list->currAllocSlot = 0;
+	list->currChunk = NULL;
+	list->chunkSize = ALLOCATION_CHUNK_SIZE;
+	list->allocator = allocator;
 
 	return EXIP_OK;
 }
 
+static struct allocChunk* createChunk(AllocList* list, size_t size)
+{
+	struct allocChunk* chunk;
+
+	if(size > (size_t) -1 - CHUNK_HEADER_SIZE)
+		return NULL;
+
+	chunk = EXIP_ALLOCATE(list->allocator, CHUNK_HEADER_SIZE + size);
+	if(chunk == NULL)
+		return NULL;
+
+	chunk->nextChunk = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+
+	return chunk;
+}
+
 void* memManagedAllocate(AllocList* list, size_t size)
 {
-	void* ptr = EXIP_MALLOC(size);
-	if(ptr != NULL)
+	struct allocChunk* chunk = list->currChunk;
+	void* ptr;
+
+	if(size > (size_t) -1 - ALLOCATION_ALIGNMENT)
+		return NULL;
+	// Distinct pointers for allocations of 0 bytes
+	if(size == 0)
+		size = 1;
+	size = (size + ALLOCATION_ALIGNMENT - 1) & ~((size_t) ALLOCATION_ALIGNMENT - 1);
+
+	if(chunk == NULL || chunk->size - chunk->used < size)
 	{
-		if(list->currAllocSlot == ALLOCATION_ARRAY_SIZE)
+		if(size > list->chunkSize/4)
 		{
-			struct allocBlock* newBlock = EXIP_MALLOC(sizeof(struct allocBlock));
-			if(newBlock == NULL)
+			// Put behind the current chunk so its free space is still used
+			chunk = createChunk(list, size);
+			if(chunk == NULL)
 				return NULL;
+			chunk->used = size;
 
-			newBlock->nextBlock = NULL;
-			list->lastBlock->nextBlock = newBlock;
-			list->lastBlock = newBlock;
-			list->currAllocSlot = 0;
+			if(list->currChunk == NULL)
+				list->currChunk = chunk;
+			else
+			{
+				chunk->nextChunk = list->currChunk->nextChunk;
+				list->currChunk->nextChunk = chunk;
+			}
+			return CHUNK_DATA(chunk);
 		}
 
-		list->lastBlock->allocation[list->currAllocSlot] = ptr;
-		list->currAllocSlot += 1;
+		chunk = createChunk(list, list->chunkSize);
+		if(chunk == NULL)
+			return NULL;
+
+		chunk->nextChunk = list->currChunk;
+		list->currChunk = chunk;
+		if(list->chunkSize < ALLOCATION_CHUNK_MAX_SIZE)
+			list->chunkSize *= 2;
 	}
+
+	ptr = CHUNK_DATA(chunk) + chunk->used;
+	chunk->used += size;
+
 	return ptr;
 }
 
@@ -72,9 +117,9 @@ void freeAllMem(EXIStream* strm)
 			{
 				tmp_rule = &((DynGrammarRule*) strm->schema->grammarTable.grammar[g].rule)[i];
 				if(tmp_rule->production != NULL)
-					EXIP_MFREE(tmp_rule->production);
+					EXIP_RELEASE(strm->allocator, tmp_rule->production);
 			}
-			EXIP_MFREE(strm->schema->grammarTable.grammar[g].rule);
+			EXIP_RELEASE(strm->allocator, strm->schema->grammarTable.grammar[g].rule);
 		}
 
 		strm->schema->grammarTable.count = strm->schema->staticGrCount;
@@ -94,7 +139,7 @@ void freeAllMem(EXIStream* strm)
 				if(GET_LN_URI_IDS(strm->schema->uriTable, i, j).vxTable != NULL)
 				{
 					assert(GET_LN_URI_IDS(strm->schema->uriTable, i, j).vxTable->vx);
-					destroyDynArray(&GET_LN_URI_IDS(strm->schema->uriTable, i, j).vxTable->dynArray);
+					destroyVxTable(GET_LN_URI_IDS(strm->schema->uriTable, i, j).vxTable);
 					GET_LN_URI_IDS(strm->schema->uriTable, i, j).vxTable = NULL;
 				}
 			}
@@ -102,6 +147,12 @@ void freeAllMem(EXIStream* strm)
 		}
 #endif
 
+#if HASH_TABLE_USE
+		// The string table indexes are also built for the tables of
+		// static schemas so they are freed together with the stream
+		destroyStringTableIndex(&strm->schema->uriTable);
+#endif
+
 		// In case a default schema was used for this stream
 		if(strm->schema->staticGrCount <= SIMPLE_TYPE_COUNT)
 		{
@@ -111,7 +162,7 @@ void freeAllMem(EXIStream* strm)
 			for(i = 0; i < strm->schema->uriTable.count; i++)
 			{
 				if(strm->schema->uriTable.uri[i].pfxTable != NULL)
-					EXIP_MFREE(strm->schema->uriTable.uri[i].pfxTable);
+					EXIP_RELEASE(strm->schema->uriTable.dynArray.allocator, strm->schema->uriTable.uri[i].pfxTable);
 
 				destroyDynArray(&strm->schema->uriTable.uri[i].lnTable.dynArray);
 			}
@@ -124,23 +175,17 @@ void freeAllMem(EXIStream* strm)
 		}
 	}
 
-	// Hash tables are freed separately
-	// #DOCUMENT#
-#if HASH_TABLE_USE
-	if(strm->valueTable.hashTbl != NULL)
-		hashtable_destroy(strm->valueTable.hashTbl);
-#endif
+	// Freeing the value table if present, with its strings and hash table
+	destroyValueTable(&strm->valueTable);
 
-	// Freeing the value table if present
-	if(strm->valueTable.value != NULL)
-	{
-		Index i;
-		for(i = 0; i < strm->valueTable.count; i++)
-		{
-			EXIP_MFREE(strm->valueTable.value[i].valueStr.str);
-		}
+	// The nodes of the grammar stack; the grammars are popped by then
+	destroyGrammarStack(strm);
 
-		destroyDynArray(&strm->valueTable.dynArray);
+	if(strm->scratch.buf != NULL)
+	{
+		EXIP_RELEASE(strm->allocator, strm->scratch.buf);
+		strm->scratch.buf = NULL;
+		strm->scratch.bufLen = 0;
 	}
 
 	freeAllocList(&(strm->memList));
@@ -148,23 +193,198 @@ void freeAllMem(EXIStream* strm)
 
 void freeAllocList(AllocList* list)
 {
-	struct allocBlock* tmpBlock = list->firstBlock;
-	struct allocBlock* rmBl;
-	unsigned int i = 0;
-	unsigned int allocLimitInBlock;
+	struct allocChunk* chunk;
+
+	while(list->currChunk != NULL)
+	{
+		chunk = list->currChunk;
+		list->currChunk = chunk->nextChunk;
+		EXIP_RELEASE(list->allocator, chunk);
+	}
+}
+
+void resetAllocList(AllocList* list)
+{
+	struct allocChunk* chunk;
+
+	if(list->currChunk == NULL)
+		return;
+
+	// The current chunk is the largest one unless it holds a single allocation
+	while(list->currChunk->nextChunk != NULL)
+	{
+		chunk = list->currChunk->nextChunk;
+		list->currChunk->nextChunk = chunk->nextChunk;
+		EXIP_RELEASE(list->allocator, chunk);
+	}
+	list->currChunk->used = 0;
+}
+
+/**
+ * The state of a memory region; it is at the start of the region and
+ * is followed by the blocks. Each block has a header with its size and
+ * the offset of the block before it so the blocks are popped from the
+ * top. A block released before the ones after it is marked free and is
+ * popped together with them once they are all released.
+ * A block that is not the last one is moved when it grows and its old
+ * space is marked free; it is then given at least twice its size, so an
+ * array growing in steps is moved a logarithmic number of times and the
+ * space it leaves behind stays below its final size.
+ */
+struct memRegion
+{
+	EXIPAllocator allocator;
+	unsigned char* base;
+	size_t size;
+	/** The offset of the free space */
+	size_t top;
+	/** The offset of the last block; REGION_NO_BLOCK if none */
+	size_t last;
+	size_t peak;
+};
+
+struct regionBlock
+{
+	size_t size;
+	size_t prev;
+	/** TRUE once released; the block is popped when it becomes the last one */
+	boolean freed;
+};
+
+#define REGION_NO_BLOCK ((size_t) -1)
+
+#define ALIGN_SIZE(size) (((size) + ALLOCATION_ALIGNMENT - 1) & ~((size_t) ALLOCATION_ALIGNMENT - 1))
+
+#define REGION_HEADER_SIZE ALIGN_SIZE(sizeof(struct regionBlock))
+
+#define REGION_BLOCK(region, offset) ((struct regionBlock*) ((region)->base + (offset)))
+
+static void* regionAllocate(void* context, size_t size)
+{
+	struct memRegion* region = (struct memRegion*) context;
+	struct regionBlock* block;
+
+	if(region->size - region->top < REGION_HEADER_SIZE || size > region->size - region->top - REGION_HEADER_SIZE)
+		return NULL;
+	size = ALIGN_SIZE(size);
+	if(size > region->size - region->top - REGION_HEADER_SIZE)
+		return NULL;
+
+	block = REGION_BLOCK(region, region->top);
+	block->size = size;
+	block->prev = region->last;
+	block->freed = FALSE;
+	region->last = region->top;
+	region->top += REGION_HEADER_SIZE + size;
+	if(region->top > region->peak)
+		region->peak = region->top;
+
+	return (unsigned char*) block + REGION_HEADER_SIZE;
+}
 
-	while(tmpBlock != NULL)
+static void regionRelease(void* context, void* ptr)
+{
+	struct memRegion* region = (struct memRegion*) context;
+	size_t offset;
+
+	if(ptr == NULL)
+		return;
+
+	offset = (size_t) ((unsigned char*) ptr - region->base) - REGION_HEADER_SIZE;
+	REGION_BLOCK(region, offset)->freed = TRUE;
+
+	// Pops the block if it is the last one, with the free blocks before it
+	while(region->last != REGION_NO_BLOCK && REGION_BLOCK(region, region->last)->freed)
 	{
-		if(tmpBlock->nextBlock != NULL)
-			allocLimitInBlock = ALLOCATION_ARRAY_SIZE;
-		else
-			allocLimitInBlock = list->currAllocSlot;
+		region->top = region->last;
+		region->last = REGION_BLOCK(region, region->last)->prev;
+	}
+}
+
+static void* regionReallocate(void* context, void* ptr, size_t size)
+{
+	struct memRegion* region = (struct memRegion*) context;
+	struct regionBlock* block;
+	size_t offset;
+	void* newPtr;
 
-		for(i = 0; i < allocLimitInBlock; i++)
-			EXIP_MFREE(tmpBlock->allocation[i]);
+	if(ptr == NULL)
+		return regionAllocate(context, size);
 
-		rmBl = tmpBlock;
-		tmpBlock = tmpBlock->nextBlock;
-		EXIP_MFREE(rmBl);
+	offset = (size_t) ((unsigned char*) ptr - region->base) - REGION_HEADER_SIZE;
+	block = REGION_BLOCK(region, offset);
+	if(size <= block->size)
+		return ptr;
+
+	if(offset == region->last)
+	{
+		// The last block grows in place
+		if(size > region->size - offset - REGION_HEADER_SIZE)
+			return NULL;
+		size = ALIGN_SIZE(size);
+		if(size > region->size - offset - REGION_HEADER_SIZE)
+			return NULL;
+		block->size = size;
+		region->top = offset + REGION_HEADER_SIZE + size;
+		if(region->top > region->peak)
+			region->peak = region->top;
+		return ptr;
 	}
+
+	newPtr = NULL;
+	if(size < 2*block->size)
+		newPtr = regionAllocate(context, 2*block->size);
+	if(newPtr == NULL)
+		newPtr = regionAllocate(context, size);
+	if(newPtr == NULL)
+		return NULL;
+	memcpy(newPtr, ptr, block->size);
+	block->freed = TRUE;
+
+	return newPtr;
+}
+
+errorCode initMemoryRegion(void* memory, size_t size, const EXIPAllocator** allocator)
+{
+	struct memRegion* region;
+	size_t skip;
+
+	if(memory == NULL)
+		return EXIP_NULL_POINTER_REF;
+
+	// The state is aligned as any other block
+	skip = ALIGN_SIZE((size_t) memory) - (size_t) memory;
+	if(size < skip + ALIGN_SIZE(sizeof(struct memRegion)))
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	region = (struct memRegion*) ((unsigned char*) memory + skip);
+	region->allocator.allocate = regionAllocate;
+	region->allocator.reallocate = regionReallocate;
+	region->allocator.release = regionRelease;
+	region->allocator.context = region;
+	region->base = (unsigned char*) region + ALIGN_SIZE(sizeof(struct memRegion));
+	region->size = size - skip - ALIGN_SIZE(sizeof(struct memRegion));
+	region->top = 0;
+	region->last = REGION_NO_BLOCK;
+	region->peak = 0;
+
+	*allocator = &region->allocator;
+
+	return EXIP_OK;
+}
+
+boolean isMemoryRegion(const EXIPAllocator* allocator)
+{
+	return allocator != NULL && allocator->allocate == regionAllocate;
+}
+
+errorCode getMemoryRegionPeak(const EXIPAllocator* allocator, size_t* peak)
+{
+	if(!isMemoryRegion(allocator))
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+
+	*peak = ((const struct memRegion*) allocator->context)->peak +
+			ALIGN_SIZE(sizeof(struct memRegion)) + ALLOCATION_ALIGNMENT - 1;
+
+	return EXIP_OK;
 }
@@ -0,0 +1,109 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file spscQueue.c
+ * @brief Implementation of the single-producer single-consumer queue
+ *
+ * @date Oct 17, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "spscQueue.h"
+
+#if EXIP_ASYNC_OUTPUT == ON || EXIP_PIPELINE == ON
+
+/** Number of items in the queue as seen by the consumer */
+static unsigned int countItems(SPSCQueue* queue)
+{
+	unsigned int tail = __atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST);
+
+	return (tail + queue->size - queue->head) % queue->size;
+}
+
+errorCode createSPSCQueue(SPSCQueue* queue, unsigned int capacity)
+{
+	queue->size = capacity + 1;
+	queue->items = (void**) EXIP_MALLOC(sizeof(void*)*queue->size);
+	if(queue->items == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	queue->head = 0;
+	queue->tail = 0;
+	queue->waiting = FALSE;
+
+	if(pthread_mutex_init(&queue->lock, NULL) != 0)
+	{
+		EXIP_MFREE(queue->items);
+		return EXIP_UNEXPECTED_ERROR;
+	}
+	if(pthread_cond_init(&queue->cond, NULL) != 0)
+	{
+		pthread_mutex_destroy(&queue->lock);
+		EXIP_MFREE(queue->items);
+		return EXIP_UNEXPECTED_ERROR;
+	}
+
+	return EXIP_OK;
+}
+
+boolean pushSPSCQueue(SPSCQueue* queue, void* item)
+{
+	unsigned int next = (queue->tail + 1) % queue->size;
+
+	if(next == EXIP_ATOMIC_LOAD(&queue->head))
+		return FALSE;
+
+	queue->items[queue->tail] = item;
+
+	// Either the consumer sees the new tail before it blocks or
+	// it is seen here as waiting; it sets the flag under the lock
+	__atomic_store_n(&queue->tail, next, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&queue->waiting, __ATOMIC_SEQ_CST))
+	{
+		pthread_mutex_lock(&queue->lock);
+		pthread_cond_signal(&queue->cond);
+		pthread_mutex_unlock(&queue->lock);
+	}
+
+	return TRUE;
+}
+
+boolean popSPSCQueue(SPSCQueue* queue, void** item)
+{
+	if(queue->head == EXIP_ATOMIC_LOAD(&queue->tail))
+		return FALSE;
+
+	*item = queue->items[queue->head];
+	EXIP_ATOMIC_STORE(&queue->head, (queue->head + 1) % queue->size);
+
+	return TRUE;
+}
+
+void waitSPSCQueue(SPSCQueue* queue, unsigned int count)
+{
+	if(countItems(queue) >= count)
+		return;
+
+	pthread_mutex_lock(&queue->lock);
+	__atomic_store_n(&queue->waiting, TRUE, __ATOMIC_SEQ_CST);
+	while(countItems(queue) < count)
+		pthread_cond_wait(&queue->cond, &queue->lock);
+	__atomic_store_n(&queue->waiting, FALSE, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+void destroySPSCQueue(SPSCQueue* queue)
+{
+	pthread_cond_destroy(&queue->cond);
+	pthread_mutex_destroy(&queue->lock);
+	EXIP_MFREE(queue->items);
+}
+
+#endif /* EXIP_ASYNC_OUTPUT == ON || EXIP_PIPELINE == ON */
@@ -86,9 +86,11 @@ errorCode decodePfx(EXIStream* strm, SmallIndex uriID, SmallIndex* pfxId);
  * @param[in, out] strm EXI stream representation
  * @param[in] qnameID The uri/ln ids in the URI string table
  * @param[out] value the string decoded
+ * @param[out] freeable TRUE if the memory of value is not owned by the value table and
+ * should be freed by the caller
  * @return Error handling code
  */
-errorCode decodeStringValue(EXIStream* strm, QNameID qnameID, String* value);
+errorCode decodeStringValue(EXIStream* strm, QNameID qnameID, String* value, boolean* freeable);
 
 /**
  * @brief Decodes the content of EXI event
@@ -144,5 +146,28 @@ errorCode decodeSEWildcardEvent(EXIStream* strm, ContentHandler* handler, SmallI
  */
 errorCode decodeATWildcardEvent(EXIStream* strm, ContentHandler* handler, SmallIndex* nonTermID_out, void* app_data);
 
+/**
+ * @brief Starts the fragment of a self-contained element and decodes the SE event of its element
+ * The stream must be at the first byte of the fragment. On error the state
+ * of the enclosing document is restored.
+ * @param[in, out] strm EXI stream representation
+ * @param[in] handler application content handler; stores the callback functions
+ * @param[out] nonTermID_out nonTerminal ID after the content decoding
+ * @param[in] app_data Application data to be passed to the content handler callbacks
+ * @return Error handling code
+ */
+errorCode decodeSelfContainedStart(EXIStream* strm, ContentHandler* handler, SmallIndex* nonTermID_out, void* app_data);
+
+/**
+ * @brief Decodes the ED event that ends the fragment of a self-contained element
+ * Called once the element of the fragment is closed (see isSelfContainedEnd()).
+ * The ED is not passed to any handler; the state of the enclosing document
+ * is restored with the SC element on top of the grammar stack.
+ * @param[in, out] strm EXI stream representation
+ * @param[out] nonTermID_out GR_VOID_NON_TERMINAL as the SC element is ended as well
+ * @return Error handling code
+ */
+errorCode decodeSelfContainedEnd(EXIStream* strm, SmallIndex* nonTermID_out);
+
 
 #endif /* BODYDECODE_H_ */
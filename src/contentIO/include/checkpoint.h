@@ -0,0 +1,104 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file checkpoint.h
+ * @brief Checkpoints of the decoder state for random access to EXI streams.
+ * A checkpoint holds the position in the stream, the stream context, the
+ * grammar stack and everything added to the string tables and the grammars
+ * since the start of the body. It is written in a compact form of unsigned
+ * varints and strings to a side-car stream while the body is parsed.
+ * A parser in its initial state can resume the decoding from any checkpoint.
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include "errorHandle.h"
+#include "procTypes.h"
+
+/** The size of the big-endian length that precedes each checkpoint in the side-car stream */
+#define CHECKPOINT_LENGTH_SIZE 4
+
+/**
+ * The maximum size in bytes of a checkpoint; at most 0xFFFFFFFF, the
+ * largest one its length can hold. Each checkpoint holds the whole state
+ * added since the start of the body so it grows with the string tables.
+ */
+#ifndef CHECKPOINT_MAX_SIZE
+# define CHECKPOINT_MAX_SIZE 0xFFFFFFFF
+#endif
+
+/**
+ * @brief Starts writing checkpoints of the parsed EXI body
+ * Called before the first event of the body is parsed; the current
+ * state of the string tables is the one the checkpoints are relative to.
+ *
+ * @param[in] strm EXI stream after the grammar of the document is set
+ * @param[out] cp the created checkpoint state
+ * @param[in] byteInterval number of bytes parsed between two checkpoints; 0 for none
+ * @param[in] elementInterval number of elements parsed between two checkpoints; 0 for none
+ * @param[in] sideCar the output stream of the checkpoints
+ * @return Error handling code
+ */
+errorCode createCheckpoints(EXIStream* strm, Checkpoints** cp, Index byteInterval, Index elementInterval, IOStream sideCar);
+
+/**
+ * @brief Writes a checkpoint if one of the intervals has passed since the last one
+ * Called between two content items of the body.
+ *
+ * @param[in, out] cp the checkpoint state
+ * @param[in] strm EXI stream
+ * @return Error handling code; EXIP_OUT_OF_BOUND_BUFFER if the checkpoint
+ * is larger than CHECKPOINT_MAX_SIZE
+ */
+errorCode writeDueCheckpoint(Checkpoints* cp, EXIStream* strm);
+
+/**
+ * @brief Counts an SE event towards the element interval
+ *
+ * @param[in, out] cp the checkpoint state
+ */
+void countCheckpointElement(Checkpoints* cp);
+
+/**
+ * @brief Restores the state of the decoder saved in a checkpoint
+ *
+ * @param[in, out] strm EXI stream after the grammar of the document is set and
+ * before any event of the body is parsed
+ * @param[in, out] cp the checkpoint state of the stream; NULL if none
+ * @param[in] checkpoint the checkpoint without the length that precedes it in the side-car
+ * @param[in] size the size in bytes of checkpoint
+ * @return EXIP_HEADER_OPTIONS_MISMATCH if the checkpoint is of a stream with other options;
+ * EXIP_INCONSISTENT_PROC_STATE if the decoder is not in its initial state
+ */
+errorCode restoreStreamCheckpoint(EXIStream* strm, Checkpoints* cp, const char* checkpoint, Index size);
+
+/**
+ * @brief Reads the position of a checkpoint in the EXI stream
+ *
+ * @param[in] checkpoint the checkpoint without the length that precedes it in the side-car
+ * @param[in] size the size in bytes of checkpoint
+ * @param[out] byteOffset the offset of the byte holding the next bit to be parsed
+ * @param[out] elementCount the number of SE events parsed before the checkpoint
+ * @return Error handling code
+ */
+errorCode readCheckpointPosition(const char* checkpoint, Index size, Index* byteOffset, Index* elementCount);
+
+/**
+ * @brief Frees the checkpoint state
+ *
+ * @param[in, out] cp the checkpoint state
+ */
+void destroyCheckpoints(Checkpoints* cp);
+
+#endif /* CHECKPOINT_H_ */
@@ -0,0 +1,171 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file eventBuffer.h
+ * @brief Recording of the parsed EXI events so that they can be passed
+ * to the application's ContentHandler later on
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#ifndef EVENTBUFFER_H_
+#define EVENTBUFFER_H_
+
+#include "errorHandle.h"
+#include "procTypes.h"
+#include "contentHandler.h"
+
+/**
+ * @name The types of the recorded events
+ * Each corresponds to a ContentHandler callback
+ */
+/**@{*/
+#define RECORDED_START_DOCUMENT   0
+#define RECORDED_END_DOCUMENT     1
+#define RECORDED_START_ELEMENT    2
+#define RECORDED_END_ELEMENT      3
+#define RECORDED_ATTRIBUTE        4
+#define RECORDED_INT_DATA         5
+#define RECORDED_BOOLEAN_DATA     6
+#define RECORDED_STRING_DATA      7
+#define RECORDED_FLOAT_DATA       8
+#define RECORDED_BINARY_DATA      9
+#define RECORDED_DATE_TIME_DATA  10
+#define RECORDED_DECIMAL_DATA    11
+#define RECORDED_LIST_DATA       12
+#define RECORDED_QNAME_DATA      13
+#define RECORDED_PI              14
+#define RECORDED_NS_DECLARATION  15
+#define RECORDED_SELF_CONTAINED  16
+/** Not a ContentHandler event: a placeholder used by the users of the buffer */
+#define RECORDED_PLACEHOLDER     17
+/**@}*/
+
+/**
+ * A QName copied out of the string tables. The tables can be extended
+ * (and moved in memory) before the event is passed on, the characters
+ * of the strings stay in place.
+ */
+struct RecordedQName
+{
+	String uri;
+	String localName;
+	String prefix;
+	boolean hasPrefix;
+};
+
+struct RecordedEvent
+{
+	unsigned char type;
+	union
+	{
+		struct RecordedQName qname;
+		Integer intVal;
+		boolean boolVal;
+		String strVal;
+		Float floatVal;
+		struct
+		{
+			char* val;
+			Index nbytes;
+		} binaryVal;
+		EXIPDateTime dtVal;
+		Decimal decVal;
+		struct
+		{
+			EXITypeClass exiType;
+			unsigned int itemCount;
+		} list;
+		struct
+		{
+			String ns;
+			String prefix;
+			boolean isLocalElementNS;
+		} ns;
+		/** Set by the users of the buffer for RECORDED_PLACEHOLDER */
+		Index placeholder;
+	} data;
+};
+
+typedef struct RecordedEvent RecordedEvent;
+
+/**
+ * Recorded events in the order of parsing. The values that are valid
+ * only during the ContentHandler call (string and binary) are copied
+ * in memList.
+ */
+struct EventBuffer
+{
+	DynArray dynArray;
+	RecordedEvent* event;
+	Index count;
+	AllocList memList;
+};
+
+typedef struct EventBuffer EventBuffer;
+
+/**
+ * @brief Creates an empty EventBuffer
+ * For every created buffer destroyEventBuffer() must be invoked.
+ *
+ * @param[out] evBuf the buffer
+ * @param[in] allocator the allocator of the events and their values; NULL for EXIP_MALLOC
+ * @return Error handling code
+ */
+errorCode createEventBuffer(EventBuffer* evBuf, const EXIPAllocator* allocator);
+
+/**
+ * @brief Removes all events from the buffer and frees the copied values
+ *
+ * @param[in, out] evBuf the buffer
+ * @return Error handling code
+ */
+errorCode clearEventBuffer(EventBuffer* evBuf);
+
+/**
+ * @brief Frees the memory of the buffer
+ *
+ * @param[in, out] evBuf the buffer
+ */
+void destroyEventBuffer(EventBuffer* evBuf);
+
+/**
+ * @brief Appends a new event to the buffer
+ * The returned entry is valid until the next event is added.
+ *
+ * @param[in, out] evBuf the buffer
+ * @param[in] type one of the RECORDED_* event types
+ * @param[out] event the entry to be filled in
+ * @return Error handling code
+ */
+errorCode addRecordedEvent(EventBuffer* evBuf, unsigned char type, RecordedEvent** event);
+
+/**
+ * @brief Sets the callbacks of a ContentHandler that append the events
+ * they receive to an EventBuffer. The EventBuffer must be passed as app_data
+ * to the parsing functions.
+ *
+ * @param[out] handler the recording handler
+ */
+void setRecordingHandler(ContentHandler* handler);
+
+/**
+ * @brief Invokes the callback of handler that corresponds to a recorded event
+ * Nothing is done for a missing callback or a RECORDED_PLACEHOLDER.
+ *
+ * @param[in] event the recorded event
+ * @param[in] handler the application's handler
+ * @param[in] app_data the application data passed to the callback
+ * @return the error code returned by the callback
+ */
+errorCode replayRecordedEvent(const RecordedEvent* event, ContentHandler* handler, void* app_data);
+
+#endif /* EVENTBUFFER_H_ */
@@ -0,0 +1,95 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file eventPipeline.h
+ * @brief Pipelined parsing: the parsed events are recorded in batches
+ * that a consumer thread passes to the application's ContentHandler
+ * while the next events are being decoded.
+ * Available when EXIP_PIPELINE is ON.
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#ifndef EVENTPIPELINE_H_
+#define EVENTPIPELINE_H_
+
+#include "procTypes.h"
+#include "errorHandle.h"
+#include "contentHandler.h"
+#include "eventBuffer.h"
+
+/**
+ * @def IS_PIPELINED(parser)
+ * 		TRUE if the events parsed by parser are passed to
+ * 		its handler by a consumer thread (see createEventPipeline())
+ */
+#if EXIP_PIPELINE == ON
+# define IS_PIPELINED(parser) ((parser)->pipeline != NULL)
+#else
+# define IS_PIPELINED(parser) FALSE
+#endif
+
+#if EXIP_PIPELINE == ON
+
+/** Number of recorded events after which a batch is passed to the consumer thread */
+#define PIPELINE_BATCH_EVENTS 256
+
+/**
+ * @brief Starts a consumer thread that passes the recorded events to a handler
+ *
+ * @param[out] pipeline the created pipeline
+ * @param[in] batchCount number of batches of events; at least 2
+ * @param[in] handler the application's handler; read when the events are dispatched
+ * @param[in] app_data the application data passed to the handler
+ * @return Error handling code
+ */
+errorCode createEventPipeline(EventPipeline** pipeline, unsigned int batchCount, ContentHandler* handler, void* app_data);
+
+/**
+ * @brief Returns the batch in which the parsed events are to be recorded
+ *
+ * @param[in] pipeline the pipeline
+ * @return the batch; valid until the next call to submitPipelineBatch()
+ */
+EventBuffer* getPipelineBatch(EventPipeline* pipeline);
+
+/**
+ * @brief Returns the handler that records the parsed events
+ * The batch returned by getPipelineBatch() is its app_data.
+ *
+ * @param[in] pipeline the pipeline
+ * @return the recording handler
+ */
+ContentHandler* getPipelineRecorder(EventPipeline* pipeline);
+
+/**
+ * @brief Passes the current batch to the consumer thread once it holds
+ * PIPELINE_BATCH_EVENTS events. Blocks while all batches are in use.
+ *
+ * @param[in, out] pipeline the pipeline
+ * @param[in] drain if TRUE the batch is passed on regardless of its size
+ * and all recorded events are dispatched before returning
+ * @return the first error returned by a callback of the handler, if any
+ */
+errorCode submitPipelineBatch(EventPipeline* pipeline, boolean drain);
+
+/**
+ * @brief Stops the consumer thread and frees the batches
+ * The events that are not dispatched yet are discarded; a callback
+ * that is in progress is waited for.
+ *
+ * @param[in, out] pipeline the pipeline
+ */
+void destroyEventPipeline(EventPipeline* pipeline);
+
+#endif /* EXIP_PIPELINE == ON */
+
+#endif /* EVENTPIPELINE_H_ */
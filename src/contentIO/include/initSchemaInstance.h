@@ -71,8 +71,9 @@ errorCode createBuiltInTypesDefinitions(SimpleTypeTable* simpleTypeTable, AllocL
  * @param[in, out] schema a resulting EXIPSchema container
  * @param[in] initializationType one of INIT_SCHEMA_SCHEMA_LESS_MODE, INIT_SCHEMA_BUILD_IN_TYPES or
  * INIT_SCHEMA_SCHEMA_ENABLED
+ * @param[in] allocator the allocator of the schema tables; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode initSchema(EXIPSchema* schema, InitSchemaType initializationType);
+errorCode initSchema(EXIPSchema* schema, InitSchemaType initializationType, const EXIPAllocator* allocator);
 
 #endif /* INITSCHEMAINSTANCE_H_ */
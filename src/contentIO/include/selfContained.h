@@ -0,0 +1,97 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file selfContained.h
+ * @brief Processing of self-contained (SC) elements.
+ * The content of an SC element starts at a byte boundary and is processed
+ * as an EXI fragment: SD, SE(qname), ..., EE, ED with the string tables
+ * and the built-in element grammars in their state at the start of the body.
+ * The state of the enclosing document is restored after the ED.
+ *
+ * @see http://www.w3.org/TR/2011/REC-exi-20110310/#key-selfContained
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#ifndef SELFCONTAINED_H_
+#define SELFCONTAINED_H_
+
+#include "errorHandle.h"
+#include "procTypes.h"
+
+/**
+ * @brief Records the initial state of the string tables
+ * Called once the string tables are created, before the body is processed.
+ * Only streams without schema-informed grammars are supported; for the
+ * others the SC elements are refused by startSelfContained().
+ *
+ * @param[in, out] strm EXI stream with the selfContained option set
+ * @return Error handling code
+ */
+errorCode initSelfContained(EXIStream* strm);
+
+/**
+ * @brief Starts the content of an SC element after its SC event
+ * The string tables and the built-in grammars are set aside and reset to their
+ * initial state and the grammar stack is replaced with one holding only the
+ * fragment grammar.
+ *
+ * @param[in, out] strm EXI stream at the byte boundary after the SC event
+ * @return EXIP_NOT_IMPLEMENTED_YET if the stream uses schema-informed grammars
+ */
+errorCode startSelfContained(EXIStream* strm);
+
+/**
+ * @brief Checks if the fragment of the innermost SC element is at its end
+ * i.e. the element of the fragment is closed and only ED is left.
+ *
+ * @param[in] strm EXI stream
+ * @return TRUE if ED of the SC fragment is next
+ */
+boolean isSelfContainedEnd(EXIStream* strm);
+
+/**
+ * @brief Checks if the content of an SC element is being processed
+ *
+ * @param[in] strm EXI stream
+ * @return TRUE between startSelfContained() and the matching endSelfContained()
+ */
+boolean isInSelfContained(EXIStream* strm);
+
+/**
+ * @brief Gets the offset of the fragment of the innermost SC element
+ * Only meaningful for parsed streams: the offset is counted from the
+ * start of the input.
+ *
+ * @param[in] strm EXI stream
+ * @param[out] byteOffset the offset of the first byte of the fragment
+ * @return EXIP_INCONSISTENT_PROC_STATE outside SC elements
+ */
+errorCode getFragmentOffset(EXIStream* strm, Index* byteOffset);
+
+/**
+ * @brief Ends the content of the innermost SC element after the ED of its fragment
+ * The string tables, the grammars and the grammar stack of the enclosing
+ * document are restored. The SC element itself is on top of the stack.
+ *
+ * @param[in, out] strm EXI stream
+ */
+void endSelfContained(EXIStream* strm);
+
+/**
+ * @brief Restores the enclosing document of the SC elements that are not ended
+ * Called when the stream is closed.
+ *
+ * @param[in, out] strm EXI stream
+ */
+void destroySelfContained(EXIStream* strm);
+
+#endif /* SELFCONTAINED_H_ */
@@ -0,0 +1,177 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file valueChannels.h
+ * @brief Structure and value channels of the EXI body in compression and
+ * pre-compression modes.
+ * The body is split in blocks of blockSize values. The values of a block
+ * are grouped in channels by the QName of their attribute or element and
+ * are encoded after the structure (event codes, QNames, prefixes, xsi:type
+ * and xsi:nil values) of the block. With compression the channels are
+ * DEFLATE compressed, with pre-compression they are written as they are.
+ *
+ * @see http://www.w3.org/TR/2011/REC-exi-20110310/#compression
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#ifndef VALUECHANNELS_H_
+#define VALUECHANNELS_H_
+
+#include "errorHandle.h"
+#include "procTypes.h"
+#include "contentHandler.h"
+
+/**
+ * @def IS_CHANNELLED(strm)
+ * 		TRUE if the values of the EXI stream strm are
+ * 		put into channels instead of being encoded/decoded in place
+ */
+#define IS_CHANNELLED(strm) ((strm)->channels != NULL)
+
+/**
+ * The channels of a block with up to this number of values are
+ * compressed together in a single DEFLATE stream
+ */
+#define CHANNEL_SMALL_VALUES 100
+
+/**
+ * @name The types of the channel values on the encoder side
+ * Each corresponds to one of the functions encoding the values
+ */
+/**@{*/
+#define CHANNEL_INT_VALUE        0
+#define CHANNEL_BOOLEAN_VALUE    1
+#define CHANNEL_STRING_VALUE     2
+#define CHANNEL_FLOAT_VALUE      3
+#define CHANNEL_BINARY_VALUE     4
+#define CHANNEL_DATE_TIME_VALUE  5
+#define CHANNEL_DECIMAL_VALUE    6
+#define CHANNEL_LIST_VALUE       7
+/**@}*/
+
+/**
+ * A value passed to the serializer, together with what is needed to encode it
+ * later on. A list value is followed by its items in the same channel.
+ */
+struct ChannelValue
+{
+	unsigned char type;
+	/** The QName of the attribute or of the element with the character data */
+	QNameID qnameID;
+	/** The type of the value in the simple type table; INDEX_MAX if none */
+	Index typeId;
+	union
+	{
+		Integer intVal;
+		boolean boolVal;
+		String strVal;
+		Float floatVal;
+		struct
+		{
+			char* val;
+			Index nbytes;
+		} binaryVal;
+		struct
+		{
+			EXIType exiType;
+			EXIPDateTime dtVal;
+		} dateTime;
+		Decimal decVal;
+		unsigned int itemCount;
+	} data;
+	/** The next value in the same channel; set by addChannelValue() */
+	Index next;
+};
+
+typedef struct ChannelValue ChannelValue;
+
+/**
+ * @brief Starts encoding the EXI body in channels
+ * Called after the header is encoded. The structure of the body is written
+ * in memory from here on and strm->buffer receives the compressed blocks.
+ *
+ * @param[in, out] strm EXI stream
+ * @return EXIP_NOT_IMPLEMENTED_YET for compression when the build does not support it
+ */
+errorCode initEncodeChannels(EXIStream* strm);
+
+/**
+ * @brief Encodes a value in the current position of the EXI stream
+ *
+ * @param[in, out] strm EXI stream
+ * @param[in] value the value
+ * @return Error handling code
+ */
+errorCode encodeChannelValue(EXIStream* strm, const ChannelValue* value);
+
+/**
+ * @brief Adds a value to its channel in the current block
+ * The string and binary values are copied. When the block is full it is
+ * compressed and written out. If the stream is not channelled the value
+ * is encoded in place with encodeChannelValue().
+ *
+ * @param[in, out] strm EXI stream
+ * @param[in] value the value
+ * @return Error handling code
+ */
+errorCode addChannelValue(EXIStream* strm, const ChannelValue* value);
+
+/**
+ * @brief Writes out the last block after the ED event and stops the channelling
+ * strm->buffer holds the end of the stream as in the non-channelled mode.
+ *
+ * @param[in, out] strm EXI stream
+ * @return Error handling code
+ */
+errorCode closeEncodeChannels(EXIStream* strm);
+
+/**
+ * @brief Starts decoding the EXI body in channels
+ * Called after the header is decoded.
+ *
+ * @param[in, out] strm EXI stream
+ * @return EXIP_NOT_IMPLEMENTED_YET for compression when the build does not support it
+ */
+errorCode initDecodeChannels(EXIStream* strm);
+
+/**
+ * @brief Reserves the place of a value in the structure of the block being decoded
+ * The value is decoded from its channel when the whole structure is decoded.
+ *
+ * @param[in, out] strm EXI stream
+ * @param[in] typeId the type of the value in the simple type table; INDEX_MAX if none
+ * @param[in] qnameID the QName of the attribute or of the element with the character data
+ * @return Error handling code
+ */
+errorCode addValueSlot(EXIStream* strm, Index typeId, QNameID qnameID);
+
+/**
+ * @brief Parses the next event of a channelled EXI body
+ * The events of a block are decoded at once and then passed to the handler
+ * one at a time.
+ *
+ * @param[in, out] strm EXI stream
+ * @param[in] handler the application's handler
+ * @param[in] app_data the application data passed to the handler
+ * @return EXIP_PARSING_COMPLETE after the ED event; error handling code
+ */
+errorCode parseNextChannelled(EXIStream* strm, ContentHandler* handler, void* app_data);
+
+/**
+ * @brief Frees the channels of the EXI stream
+ * strm->buffer is restored if it is replaced by an in-memory buffer.
+ *
+ * @param[in, out] strm EXI stream
+ */
+void destroyValueChannels(EXIStream* strm);
+
+#endif /* VALUECHANNELS_H_ */
@@ -23,11 +23,18 @@
 #include "sTables.h"
 #include "grammars.h"
 #include "initSchemaInstance.h"
+#include "readAhead.h"
+#include "valueChannels.h"
+#include "eventPipeline.h"
+#include "checkpoint.h"
+#include "selfContained.h"
+#include "ioUtil.h"
 
 /**
  * The handler to be used by the applications to parse EXI streams
  */
 const EXIParser parse ={initParser,
+						initParserMapped,
 						parseHeader,
 						setSchema,
 						parseNext,
@@ -35,23 +42,64 @@ const EXIParser parse ={initParser,
 						destroyParser};
 
 errorCode initParser(Parser* parser, BinaryBuffer buffer, void* app_data)
+{
+	return initParserAllocator(parser, buffer, app_data, NULL);
+}
+
+errorCode initParserRegion(Parser* parser, BinaryBuffer buffer, void* app_data, void* region, size_t regionSize)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
-	TRY(initAllocList(&parser->strm.memList));
+	const EXIPAllocator* allocator;
+
+	TRY(initMemoryRegion(region, regionSize, &allocator));
+
+	return initParserAllocator(parser, buffer, app_data, allocator);
+}
+
+errorCode getParserRegionPeak(Parser* parser, size_t* peak)
+{
+	return getMemoryRegionPeak(parser->strm.allocator, peak);
+}
+
+errorCode initParserAllocator(Parser* parser, BinaryBuffer buffer, void* app_data, const EXIPAllocator* allocator)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	parser->strm.allocator = allocator;
+	TRY(initAllocList(&parser->strm.memList, allocator));
 
 	parser->strm.buffer = buffer;
+	parser->strm.bufferMapped = FALSE;
 	parser->strm.context.bitPointer = 0;
 	parser->strm.context.bufferIndx = 0;
+	parser->strm.context.bufferOffset = 0;
 	parser->strm.context.currAttr.lnId = 0;
 	parser->strm.context.currAttr.uriId = 0;
 	parser->strm.context.expectATData = FALSE;
 	parser->strm.context.isNilType = FALSE;
 	parser->strm.context.attrTypeId = INDEX_MAX;
 	parser->strm.gStack = NULL;
+	parser->strm.gStackPool.freeNode = NULL;
+	parser->strm.gStackPool.block = NULL;
 	parser->strm.valueTable.value = NULL;
 	parser->strm.valueTable.count = 0;
 	parser->app_data = app_data;
 	parser->strm.schema = NULL;
+	parser->strm.scratch.buf = NULL;
+	parser->strm.scratch.bufLen = 0;
+	parser->strm.channels = NULL;
+	parser->strm.sc = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+	parser->strm.asyncOutput = NULL;
+#endif
+#if EXIP_READ_AHEAD == ON
+	parser->strm.readAhead = NULL;
+#endif
+#if EXIP_PIPELINE == ON
+	parser->pipeline = NULL;
+#endif
+	parser->checkpoints = NULL;
+	parser->fragmentPending = FALSE;
     makeDefaultOpts(&parser->strm.header.opts);
 
 	initContentHandler(&parser->handler);
@@ -63,6 +111,48 @@ errorCode initParser(Parser* parser, BinaryBuffer buffer, void* app_data)
 	return EXIP_OK;
 }
 
+errorCode initParserMapped(Parser* parser, const char* data, Index size, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	BinaryBuffer buffer;
+
+	// The buffer is only read from in this mode
+	buffer.buf = (char*) data;
+	buffer.bufLen = size;
+	buffer.bufContent = size;
+	buffer.ioStrm.readWriteToStream = NULL;
+	buffer.ioStrm.stream = NULL;
+
+	TRY(initParser(parser, buffer, app_data));
+	parser->strm.bufferMapped = TRUE;
+
+	return EXIP_OK;
+}
+
+#if EXIP_READ_AHEAD == ON
+errorCode enableReadAhead(Parser* parser, unsigned int blockCount)
+{
+	// The blocks are allocated from the heap
+	if(isMemoryRegion(parser->strm.allocator))
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+
+	return createReadAhead(&parser->strm, blockCount);
+}
+#endif
+
+#if EXIP_PIPELINE == ON
+errorCode enablePipeline(Parser* parser, unsigned int batchCount)
+{
+	if(parser->pipeline != NULL)
+		return EXIP_INCONSISTENT_PROC_STATE;
+	// The batches are allocated from the heap
+	if(isMemoryRegion(parser->strm.allocator))
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+
+	return createEventPipeline(&parser->pipeline, batchCount, &parser->handler, parser->app_data);
+}
+#endif
+
 errorCode parseHeader(Parser* parser, boolean outOfBandOpts)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
@@ -71,7 +161,13 @@ errorCode parseHeader(Parser* parser, boolean outOfBandOpts)
 
 	if(parser->strm.header.opts.valuePartitionCapacity > 0)
 	{
-		TRY(createValueTable(&parser->strm.valueTable));
+		TRY(createValueTable(&parser->strm.valueTable, parser->strm.allocator));
+	}
+
+	if(WITH_CHANNELS(parser->strm.header.opts.enumOpt))
+	{
+		// The structure and the values of the body are read in blocks
+		TRY(initDecodeChannels(&parser->strm));
 	}
 
 	// The parsing of the header is successful
@@ -115,7 +211,7 @@ errorCode setSchema(Parser* parser, EXIPSchema* schema)
 		if(parser->strm.schema == NULL)
 			return EXIP_MEMORY_ALLOCATION_ERROR;
 
-		TRY(initSchema(parser->strm.schema, INIT_SCHEMA_BUILD_IN_TYPES));
+		TRY(initSchema(parser->strm.schema, INIT_SCHEMA_BUILD_IN_TYPES, parser->strm.allocator));
 
 		if(WITH_FRAGMENT(parser->strm.header.opts.enumOpt))
 		{
@@ -159,7 +255,7 @@ errorCode setSchema(Parser* parser, EXIPSchema* schema)
 		if(parser->strm.schema == NULL)
 			return EXIP_MEMORY_ALLOCATION_ERROR;
 
-		TRY(initSchema(parser->strm.schema, INIT_SCHEMA_SCHEMA_LESS_MODE));
+		TRY(initSchema(parser->strm.schema, INIT_SCHEMA_SCHEMA_LESS_MODE, parser->strm.allocator));
 
 		if(WITH_FRAGMENT(parser->strm.header.opts.enumOpt))
 		{
@@ -173,21 +269,59 @@ errorCode setSchema(Parser* parser, EXIPSchema* schema)
 
 	{
 		QNameID emptyQNameID = {URI_MAX, LN_MAX};
-		TRY(pushGrammar(&parser->strm.gStack, emptyQNameID, &parser->strm.schema->docGrammar));
+		TRY(pushGrammar(&parser->strm, emptyQNameID, &parser->strm.schema->docGrammar));
+	}
+
+	// The self-contained elements are supported without schema-informed grammars
+	if(WITH_SELF_CONTAINED(parser->strm.header.opts.enumOpt) && parser->strm.schema->staticGrCount <= SIMPLE_TYPE_COUNT)
+	{
+		TRY(initSelfContained(&parser->strm));
 	}
 
 	return EXIP_OK;
 }
 
-errorCode parseNext(Parser* parser)
+/** Parses the next content item passing its events to handler */
+static errorCode parseNextEvent(Parser* parser, ContentHandler* handler, void* app_data)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 	SmallIndex tmpNonTermID = GR_VOID_NON_TERMINAL;
 	StreamContext savedContext = parser->strm.context;
+	EXIGrammarStack* savedTop = parser->strm.gStack;
+
+	if(IS_CHANNELLED(&parser->strm))
+	{
+		tmp_err_code = parseNextChannelled(&parser->strm, handler, app_data);
+		if(tmp_err_code != EXIP_OK && tmp_err_code != EXIP_PARSING_COMPLETE)
+			DEBUG_MSG(ERROR, EXIP_DEBUG, ("\n>Error %s:%d at %s, line %d", GET_ERR_STRING(tmp_err_code), tmp_err_code, __FILE__, __LINE__));
+		return tmp_err_code;
+	}
+
+	if(parser->checkpoints != NULL && !parser->fragmentPending)
+	{
+		TRY(writeDueCheckpoint(parser->checkpoints, &parser->strm));
+	}
+
+	if(parser->fragmentPending)
+	{
+		// The element of the fragment positioned by seekSelfContained()
+		tmp_err_code = decodeSelfContainedStart(&parser->strm, handler, &tmpNonTermID, app_data);
+		if(tmp_err_code == EXIP_OK)
+			parser->fragmentPending = FALSE;
+	}
+	else if(isSelfContainedEnd(&parser->strm))
+		tmp_err_code = decodeSelfContainedEnd(&parser->strm, &tmpNonTermID);
+	else
+		tmp_err_code = processNextProduction(&parser->strm, &tmpNonTermID, handler, app_data);
 
-	tmp_err_code = processNextProduction(&parser->strm, &tmpNonTermID, &parser->handler, parser->app_data);
 	if(tmp_err_code == EXIP_BUFFER_END_REACHED)
-		parser->strm.context = savedContext;
+	{
+		// The whole stream is in a mapped buffer: there is no more data to come
+		if(parser->strm.bufferMapped)
+			tmp_err_code = EXIP_INVALID_EXI_INPUT;
+		else
+			parser->strm.context = savedContext;
+	}
 
 	if(tmp_err_code != EXIP_OK)
 	{
@@ -197,7 +331,7 @@ errorCode parseNext(Parser* parser)
 
 	if(tmpNonTermID == GR_VOID_NON_TERMINAL)
 	{
-		popGrammar(&(parser->strm.gStack));
+		popGrammar(&parser->strm);
 		if(parser->strm.gStack == NULL) // There is no more grammars in the stack
 		{
 			return EXIP_PARSING_COMPLETE; // The stream is parsed
@@ -205,16 +339,60 @@ errorCode parseNext(Parser* parser)
 	}
 	else
 	{
+		// An SE event pushes the grammar of the element
+		if(parser->checkpoints != NULL && parser->strm.gStack->nextInStack == savedTop)
+			countCheckpointElement(parser->checkpoints);
 		parser->strm.gStack->currNonTermID = tmpNonTermID;
 	}
 
 	return EXIP_OK;
 }
 
+#if EXIP_PIPELINE == ON
+/** Records the events of the next content item for the consumer thread */
+static errorCode parseNextPipelined(Parser* parser)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	errorCode handler_err_code;
+	EventBuffer* batch = getPipelineBatch(parser->pipeline);
+	Index recordedCount = batch->count;
+
+	tmp_err_code = parseNextEvent(parser, getPipelineRecorder(parser->pipeline), batch);
+	if(tmp_err_code == EXIP_OK)
+		return submitPipelineBatch(parser->pipeline, FALSE);
+
+	// The item is parsed again after pushEXIData()
+	if(tmp_err_code == EXIP_BUFFER_END_REACHED)
+		batch->count = recordedCount;
+
+	// The application sees all events parsed so far before it gets the control
+	handler_err_code = submitPipelineBatch(parser->pipeline, TRUE);
+	if(handler_err_code != EXIP_OK)
+		return handler_err_code;
+
+	return tmp_err_code;
+}
+#endif
+
+errorCode parseNext(Parser* parser)
+{
+#if EXIP_PIPELINE == ON
+	if(IS_PIPELINED(parser))
+		return parseNextPipelined(parser);
+#endif
+
+	return parseNextEvent(parser, &parser->handler, parser->app_data);
+}
+
 errorCode pushEXIData(char* inBuf, unsigned int bufSize, Parser* parser)
 {
 	Index bytesCopied = parser->strm.buffer.bufContent - parser->strm.context.bufferIndx;
 
+	// The mapped buffer is read-only and already holds the whole stream;
+	// with read-ahead the input is taken from the input stream only
+	if(parser->strm.bufferMapped || IS_READ_AHEAD(&parser->strm))
+		return EXIP_INCONSISTENT_PROC_STATE;
+
 	if(bufSize > parser->strm.buffer.bufLen - bytesCopied)
 		return EXIP_OUT_OF_BOUND_BUFFER;
 
@@ -227,18 +405,96 @@ errorCode pushEXIData(char* inBuf, unsigned int bufSize, Parser* parser)
 	memcpy(parser->strm.buffer.buf, parser->strm.buffer.buf + parser->strm.context.bufferIndx, bytesCopied);
 	memcpy(parser->strm.buffer.buf + bytesCopied, inBuf, bufSize);
 
+	parser->strm.context.bufferOffset += parser->strm.context.bufferIndx;
 	parser->strm.context.bufferIndx = 0;
 	parser->strm.buffer.bufContent = bytesCopied + bufSize;
 
 	return EXIP_OK;
 }
 
+errorCode enableCheckpoints(Parser* parser, Index byteInterval, Index elementInterval, IOStream sideCar)
+{
+	if(parser->checkpoints != NULL)
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	return createCheckpoints(&parser->strm, &parser->checkpoints, byteInterval, elementInterval, sideCar);
+}
+
+errorCode restoreCheckpoint(Parser* parser, const char* checkpoint, Index size)
+{
+	if(parser->fragmentPending)
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	return restoreStreamCheckpoint(&parser->strm, parser->checkpoints, checkpoint, size);
+}
+
+errorCode getSelfContainedOffset(Parser* parser, Index* byteOffset)
+{
+	return getFragmentOffset(&parser->strm, byteOffset);
+}
+
+errorCode seekSelfContained(Parser* parser, Index byteOffset)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	if(!WITH_SELF_CONTAINED(parser->strm.header.opts.enumOpt))
+		return EXIP_INCONSISTENT_PROC_STATE;
+	// Only available without schema-informed grammars (see initSelfContained())
+	if(parser->strm.sc == NULL)
+		return EXIP_NOT_IMPLEMENTED_YET;
+	// The read-ahead blocks are not dropped; enable it after the seek
+	if(IS_READ_AHEAD(&parser->strm) || parser->fragmentPending || isInSelfContained(&parser->strm) ||
+			parser->strm.gStack == NULL || parser->strm.gStack->nextInStack != NULL ||
+			parser->strm.gStack->currNonTermID != GR_DOC_CONTENT)
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	parser->strm.context.bitPointer = 0;
+	TRY(seekEXIStream(&parser->strm, byteOffset));
+
+	// The fragment takes the place of the document: the document grammar
+	// is popped after the ED of the fragment and the parsing is complete
+	parser->fragmentPending = TRUE;
+
+	return EXIP_OK;
+}
+
+errorCode getCheckpointPosition(const char* checkpoint, Index size, Index* byteOffset, Index* elementCount)
+{
+	return readCheckpointPosition(checkpoint, size, byteOffset, elementCount);
+}
+
 void destroyParser(Parser* parser)
 {
+#if EXIP_PIPELINE == ON
+	// The recorded events reference the string tables
+	if(IS_PIPELINED(parser))
+	{
+		destroyEventPipeline(parser->pipeline);
+		parser->pipeline = NULL;
+	}
+#endif
+
+	// The grammar stack of the document is restored
+	destroySelfContained(&parser->strm);
+
 	while(parser->strm.gStack != NULL)
 	{
-		popGrammar(&parser->strm.gStack);
+		popGrammar(&parser->strm);
 	}
 
+	if(IS_CHANNELLED(&parser->strm))
+		destroyValueChannels(&parser->strm);
+
+	if(parser->checkpoints != NULL)
+	{
+		destroyCheckpoints(parser->checkpoints);
+		parser->checkpoints = NULL;
+	}
+
+#if EXIP_READ_AHEAD == ON
+	if(IS_READ_AHEAD(&parser->strm))
+		destroyReadAhead(&parser->strm);
+#endif
+
 	freeAllMem(&parser->strm);
 }
@@ -24,9 +24,13 @@
 #include "hashtable.h"
 #include "stringManipulate.h"
 #include "streamEncode.h"
+#include "asyncOutput.h"
+#include "valueChannels.h"
+#include "selfContained.h"
 #include "initSchemaInstance.h"
 #include "ioUtil.h"
 #include "streamEncode.h"
+#include "streamWrite.h"
 
 /**
  * The handler to be used by the applications to serialize EXI streams
@@ -51,7 +55,8 @@ const EXISerializer serialize ={startDocument,
 								selfContained,
 								initHeader,
 								initStream,
-								closeEXIStream};
+								closeEXIStream,
+								flushEXIData};
 
 #if EXI_PROFILE_DEFAULT
 
@@ -72,6 +77,26 @@ void initHeader(EXIStream* strm)
 }
 
 errorCode initStream(EXIStream* strm, BinaryBuffer buffer, EXIPSchema* schema)
+{
+	return initStreamAllocator(strm, buffer, schema, NULL);
+}
+
+errorCode initStreamRegion(EXIStream* strm, BinaryBuffer buffer, EXIPSchema* schema, void* region, size_t regionSize)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	const EXIPAllocator* allocator;
+
+	TRY(initMemoryRegion(region, regionSize, &allocator));
+
+	return initStreamAllocator(strm, buffer, schema, allocator);
+}
+
+errorCode getStreamRegionPeak(EXIStream* strm, size_t* peak)
+{
+	return getMemoryRegionPeak(strm->allocator, peak);
+}
+
+errorCode initStreamAllocator(EXIStream* strm, BinaryBuffer buffer, EXIPSchema* schema, const EXIPAllocator* allocator)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 
@@ -79,23 +104,38 @@ errorCode initStream(EXIStream* strm, BinaryBuffer buffer, EXIPSchema* schema)
 
 	TRY(checkOptionValues(&strm->header.opts));
 
-	TRY(initAllocList(&(strm->memList)));
+	strm->allocator = allocator;
+	TRY(initAllocList(&(strm->memList), allocator));
 	strm->buffer = buffer;
+	strm->bufferMapped = FALSE;
 	strm->context.bitPointer = 0;
 	strm->context.bufferIndx = 0;
+	strm->context.bufferOffset = 0;
 	strm->context.currAttr.uriId = URI_MAX;
 	strm->context.currAttr.lnId = LN_MAX;
 	strm->context.expectATData = FALSE;
 	strm->context.isNilType = FALSE;
 	strm->context.attrTypeId = INDEX_MAX;
 	strm->gStack = NULL;
+	strm->gStackPool.freeNode = NULL;
+	strm->gStackPool.block = NULL;
 	strm->valueTable.value = NULL;
 	strm->valueTable.count = 0;
 	strm->schema = NULL;
+	strm->scratch.buf = NULL;
+	strm->scratch.bufLen = 0;
+	strm->channels = NULL;
+	strm->sc = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+	strm->asyncOutput = NULL;
+#endif
+#if EXIP_READ_AHEAD == ON
+	strm->readAhead = NULL;
+#endif
 
 	if(strm->header.opts.valuePartitionCapacity > 0)
 	{
-		TRY(createValueTable(&strm->valueTable));
+		TRY(createValueTable(&strm->valueTable, strm->allocator));
 	}
 
 	if(strm->header.opts.schemaIDMode == SCHEMA_ID_NIL)
@@ -126,7 +166,7 @@ errorCode initStream(EXIStream* strm, BinaryBuffer buffer, EXIPSchema* schema)
 		if(strm->schema == NULL)
 			return EXIP_MEMORY_ALLOCATION_ERROR;
 
-		TRY(initSchema(strm->schema, INIT_SCHEMA_BUILD_IN_TYPES));
+		TRY(initSchema(strm->schema, INIT_SCHEMA_BUILD_IN_TYPES, strm->allocator));
 
 		if(WITH_FRAGMENT(strm->header.opts.enumOpt))
 		{
@@ -176,7 +216,7 @@ errorCode initStream(EXIStream* strm, BinaryBuffer buffer, EXIPSchema* schema)
 		if(strm->schema == NULL)
 			return EXIP_MEMORY_ALLOCATION_ERROR;
 
-		TRY(initSchema(strm->schema, INIT_SCHEMA_SCHEMA_LESS_MODE));
+		TRY(initSchema(strm->schema, INIT_SCHEMA_SCHEMA_LESS_MODE, strm->allocator));
 
 		if(WITH_FRAGMENT(strm->header.opts.enumOpt))
 		{
@@ -190,7 +230,13 @@ errorCode initStream(EXIStream* strm, BinaryBuffer buffer, EXIPSchema* schema)
 
 	{
 		QNameID emptyQNameID = {URI_MAX, LN_MAX};
-		TRY(pushGrammar(&strm->gStack, emptyQNameID, &strm->schema->docGrammar));
+		TRY(pushGrammar(strm, emptyQNameID, &strm->schema->docGrammar));
+	}
+
+	// The self-contained elements are supported without schema-informed grammars
+	if(WITH_SELF_CONTAINED(strm->header.opts.enumOpt) && strm->schema->staticGrCount <= SIMPLE_TYPE_COUNT)
+	{
+		TRY(initSelfContained(strm));
 	}
 	// #DOCUMENT#
 	// Hashtable for fast look-up of global values in the table.
@@ -203,9 +249,9 @@ errorCode initStream(EXIStream* strm, BinaryBuffer buffer, EXIPSchema* schema)
 	if(strm->header.opts.valuePartitionCapacity > DEFAULT_VALUE_ENTRIES_NUMBER &&
 			strm->header.opts.valueMaxLength > 0)
 	{
-		strm->valueTable.hashTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, djbHash, stringEqual);
+		strm->valueTable.hashTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, stringHash, stringEqual, strm->allocator);
 		if(strm->valueTable.hashTbl == NULL)
-			return EXIP_HASH_TABLE_ERROR;
+			return EXIP_MEMORY_ALLOCATION_ERROR;
 	}
 	else
 		strm->valueTable.hashTbl = NULL;
@@ -233,6 +279,8 @@ errorCode endDocument(EXIStream* strm)
 		return EXIP_INCONSISTENT_PROC_STATE;
 
 	tmp_err_code = encodeProduction(strm, EVENT_ED_CLASS, TRUE, NULL, VALUE_TYPE_NONE_CLASS, &prodHit);
+	if(tmp_err_code == EXIP_OK && IS_CHANNELLED(strm))
+		tmp_err_code = closeEncodeChannels(strm);
 
 	// Store the size of the encoded stream contained in the BinaryBuffer in the BinaryBuffer.bufContent
 	strm->buffer.bufContent = strm->context.bufferIndx + (strm->context.bitPointer > 0);
@@ -280,7 +328,7 @@ errorCode startElement(EXIStream* strm, QName qname, EXITypeClass* valueType)
 
 		if(elemGrammar != NULL) // The grammar is found
 		{
-			TRY(pushGrammar(&(strm->gStack), tmpQid, elemGrammar));
+			TRY(pushGrammar(strm, tmpQid, elemGrammar));
 		}
 		else
 		{
@@ -292,13 +340,13 @@ errorCode startElement(EXIStream* strm, QName qname, EXITypeClass* valueType)
 			TRY(addDynEntry(&strm->schema->grammarTable.dynArray, &newElementGrammar, &dynArrIndx));
 
 			GET_LN_URI_QNAME(strm->schema->uriTable, tmpQid).elemGrammar = dynArrIndx;
-			TRY(pushGrammar(&(strm->gStack), tmpQid, &strm->schema->grammarTable.grammar[dynArrIndx]));
+			TRY(pushGrammar(strm, tmpQid, &strm->schema->grammarTable.grammar[dynArrIndx]));
 #elif EXI_PROFILE_DEFAULT
 			// Leave the grammar NULL - if the next event is valid AT(xsi:type)
 			// then its value will be the next grammar.
 			// If the next event is not valid AT(xsi:type) - then the event
 			// AT(xsi:type="anyType") will be inserted beforehand
-			TRY(pushGrammar(&(strm->gStack), tmpQid, elemGrammar));
+			TRY(pushGrammar(strm, tmpQid, elemGrammar));
 
 			return EXIP_OK;
 #else
@@ -325,7 +373,7 @@ errorCode startElement(EXIStream* strm, QName qname, EXITypeClass* valueType)
 		}
 
 		if(elemGrammar != NULL) // The grammar is found
-			TRY(pushGrammar(&(strm->gStack), prodHit.qnameId, elemGrammar));
+			TRY(pushGrammar(strm, prodHit.qnameId, elemGrammar));
 		else
 			return EXIP_INCONSISTENT_PROC_STATE;  // The event require the presence of Element Grammar previously created
 	}
@@ -372,10 +420,18 @@ errorCode endElement(EXIStream* strm)
 	TRY(encodeProduction(strm, EVENT_EE_CLASS, TRUE, NULL, VALUE_TYPE_NONE_CLASS, &prodHit));
 
 	if(strm->gStack->currNonTermID == GR_VOID_NON_TERMINAL)
-		popGrammar(&(strm->gStack));
+		popGrammar(strm);
 	else
 		return EXIP_INCONSISTENT_PROC_STATE;
 
+	if(isSelfContainedEnd(strm))
+	{
+		// The end of a self-contained element: ED of its fragment
+		TRY(encodeProduction(strm, EVENT_ED_CLASS, TRUE, NULL, VALUE_TYPE_NONE_CLASS, &prodHit));
+		endSelfContained(strm);
+		popGrammar(strm);
+	}
+
 	return EXIP_OK;
 }
 
@@ -482,6 +538,7 @@ errorCode intData(EXIStream* strm, Integer int_val)
 {
 	Index intTypeId;
 	QNameID qnameID;
+	ChannelValue value;
 	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("\n>Start integer data serialization\n"));
 
 	if(strm->gStack->grammar == NULL)
@@ -507,7 +564,12 @@ errorCode intData(EXIStream* strm, Integer int_val)
 		intTypeId = prodHit.typeId;
 	}
 
-	return encodeIntData(strm, int_val, qnameID, intTypeId);
+	value.type = CHANNEL_INT_VALUE;
+	value.qnameID = qnameID;
+	value.typeId = intTypeId;
+	value.data.intVal = int_val;
+
+	return addChannelValue(strm, &value);
 }
 
 errorCode booleanData(EXIStream* strm, boolean bool_val)
@@ -517,6 +579,7 @@ errorCode booleanData(EXIStream* strm, boolean bool_val)
 	Index booleanTypeId;
 	EXIType exiType;
 	QNameID qnameID;
+	ChannelValue value;
 
 	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("\n>Start boolean data serialization\n"));
 
@@ -550,20 +613,18 @@ errorCode booleanData(EXIStream* strm, boolean bool_val)
 
 	if(exiType == VALUE_TYPE_BOOLEAN)
 	{
-		TRY(encodeBoolean(strm, bool_val));
+		value.type = CHANNEL_BOOLEAN_VALUE;
+		value.data.boolVal = bool_val;
 	}
 	else if(exiType == VALUE_TYPE_STRING || exiType == VALUE_TYPE_UNTYPED || exiType == VALUE_TYPE_NONE)
 	{
 		//       1) Print Warning
 		//       2) convert the boolean to sting
 		//       3) encode string
-		String tmpStr;
-
 		DEBUG_MSG(WARNING, DEBUG_CONTENT_IO, ("\n>Boolean to String conversion required \n"));
 #if EXIP_IMPLICIT_DATA_TYPE_CONVERSION
-		TRY(booleanToString(bool_val, &tmpStr));
-		TRY(encodeStringData(strm, tmpStr, qnameID, booleanTypeId));
-		EXIP_MFREE(tmpStr.str);
+		TRY(booleanToString(bool_val, &value.data.strVal, strm->allocator));
+		value.type = CHANNEL_STRING_VALUE;
 #else
 		return EXIP_INVALID_EXI_INPUT;
 #endif
@@ -574,6 +635,20 @@ errorCode booleanData(EXIStream* strm, boolean bool_val)
 		return EXIP_INCONSISTENT_PROC_STATE;
 	}
 
+	value.qnameID = qnameID;
+	value.typeId = booleanTypeId;
+
+	// The value of xsi:nil is part of the structure and never goes in a value channel
+	if(isXsiNilAttr)
+		tmp_err_code = encodeChannelValue(strm, &value);
+	else
+		tmp_err_code = addChannelValue(strm, &value);
+
+	if(value.type == CHANNEL_STRING_VALUE)
+		EXIP_RELEASE(strm->allocator, value.data.strVal.str);
+	if(tmp_err_code != EXIP_OK)
+		return tmp_err_code;
+
 	if(IS_SCHEMA(strm->gStack->grammar->props) && isXsiNilAttr && bool_val)
 	{
 		// In a schema-informed grammar && xsi:nil == TRUE
@@ -590,6 +665,7 @@ errorCode stringData(EXIStream* strm, const String str_val)
 	QNameID qnameID;
 	Index typeId;
 	EXIType exiType;
+	ChannelValue value;
 
 	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("\n>Start string data serialization\n"));
 
@@ -628,7 +704,12 @@ errorCode stringData(EXIStream* strm, const String str_val)
 
 	if(exiType == VALUE_TYPE_STRING || exiType == VALUE_TYPE_UNTYPED || exiType == VALUE_TYPE_NONE)
 	{
-		return encodeStringData(strm, str_val, qnameID, typeId);
+		value.type = CHANNEL_STRING_VALUE;
+		value.qnameID = qnameID;
+		value.typeId = typeId;
+		value.data.strVal = str_val;
+
+		return addChannelValue(strm, &value);
 	}
 	else
 	{
@@ -643,6 +724,7 @@ errorCode floatData(EXIStream* strm, Float float_val)
 	Index typeId;
 	QNameID qnameID;
 	EXIType exiType;
+	ChannelValue value;
 	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("\n>Start float data serialization\n"));
 
 	if(strm->gStack->grammar == NULL)
@@ -671,20 +753,18 @@ errorCode floatData(EXIStream* strm, Float float_val)
 
 	if(exiType == VALUE_TYPE_FLOAT)
 	{
-		return encodeFloatValue(strm, float_val);
+		value.type = CHANNEL_FLOAT_VALUE;
+		value.data.floatVal = float_val;
 	}
 	else if(exiType == VALUE_TYPE_STRING || exiType == VALUE_TYPE_UNTYPED || exiType == VALUE_TYPE_NONE)
 	{
 		//       1) Print Warning
 		//       2) convert the float to sting
 		//       3) encode string
-		String tmpStr;
-
 		DEBUG_MSG(WARNING, DEBUG_CONTENT_IO, ("\n>Float to String conversion required \n"));
 #if EXIP_IMPLICIT_DATA_TYPE_CONVERSION
-		TRY(floatToString(float_val, &tmpStr));
-		TRY(encodeStringData(strm, tmpStr, qnameID, typeId));
-		EXIP_MFREE(tmpStr.str);
+		TRY(floatToString(float_val, &value.data.strVal, strm->allocator));
+		value.type = CHANNEL_STRING_VALUE;
 #else
 		return EXIP_INVALID_EXI_INPUT;
 #endif
@@ -695,12 +775,21 @@ errorCode floatData(EXIStream* strm, Float float_val)
 		return EXIP_INCONSISTENT_PROC_STATE;
 	}
 
-	return EXIP_OK;
+	value.qnameID = qnameID;
+	value.typeId = typeId;
+	tmp_err_code = addChannelValue(strm, &value);
+
+	if(value.type == CHANNEL_STRING_VALUE)
+		EXIP_RELEASE(strm->allocator, value.data.strVal.str);
+
+	return tmp_err_code;
 }
 
 errorCode binaryData(EXIStream* strm, const char* binary_val, Index nbytes)
 {
 	Index typeId;
+	QNameID qnameID;
+	ChannelValue value;
 	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("\n>Start binary data serialization\n"));
 
 	if(strm->gStack->grammar == NULL)
@@ -710,6 +799,7 @@ errorCode binaryData(EXIStream* strm, const char* binary_val, Index nbytes)
 	{
 		strm->context.expectATData -= 1;
 		typeId = strm->context.attrTypeId;
+		qnameID = strm->context.currAttr;
 	}
 	else
 	{
@@ -718,6 +808,7 @@ errorCode binaryData(EXIStream* strm, const char* binary_val, Index nbytes)
 
 		TRY(encodeProduction(strm, EVENT_CH_CLASS, TRUE, NULL, VALUE_TYPE_BINARY_CLASS, &prodHit));
 		typeId = prodHit.typeId;
+		qnameID = strm->gStack->currQNameID;
 	}
 
 	if(typeId == INDEX_MAX || GET_EXI_TYPE(strm->schema->simpleTypeTable.sType[typeId].content) != VALUE_TYPE_BINARY)
@@ -727,7 +818,13 @@ errorCode binaryData(EXIStream* strm, const char* binary_val, Index nbytes)
 		return EXIP_INCONSISTENT_PROC_STATE;
 	}
 
-	return encodeBinary(strm, (char *)binary_val, nbytes);
+	value.type = CHANNEL_BINARY_VALUE;
+	value.qnameID = qnameID;
+	value.typeId = typeId;
+	value.data.binaryVal.val = (char *)binary_val;
+	value.data.binaryVal.nbytes = nbytes;
+
+	return addChannelValue(strm, &value);
 }
 
 errorCode dateTimeData(EXIStream* strm, EXIPDateTime dt_val)
@@ -736,6 +833,7 @@ errorCode dateTimeData(EXIStream* strm, EXIPDateTime dt_val)
 	Index typeId;
 	QNameID qnameID;
 	EXIType exiType;
+	ChannelValue value;
 	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("\n>Start dateTime data serialization\n"));
 
 	if(strm->gStack->grammar == NULL)
@@ -768,20 +866,19 @@ errorCode dateTimeData(EXIStream* strm, EXIPDateTime dt_val)
 
 	if(GET_EVENT_CLASS(exiType) == VALUE_TYPE_DATE_TIME_CLASS)
 	{
-		return encodeDateTimeValue(strm, exiType, dt_val);
+		value.type = CHANNEL_DATE_TIME_VALUE;
+		value.data.dateTime.exiType = exiType;
+		value.data.dateTime.dtVal = dt_val;
 	}
 	else if(exiType == VALUE_TYPE_STRING || exiType == VALUE_TYPE_UNTYPED || exiType == VALUE_TYPE_NONE)
 	{
 		//       1) Print Warning
 		//       2) convert the dateTime to sting
 		//       3) encode string
-		String tmpStr;
-
 		DEBUG_MSG(WARNING, DEBUG_CONTENT_IO, ("\n>DateTime to String conversion required \n"));
 #if EXIP_IMPLICIT_DATA_TYPE_CONVERSION
-		TRY(dateTimeToString(dt_val, &tmpStr));
-		TRY(encodeStringData(strm, tmpStr, qnameID, typeId));
-		EXIP_MFREE(tmpStr.str);
+		TRY(dateTimeToString(dt_val, &value.data.strVal, strm->allocator));
+		value.type = CHANNEL_STRING_VALUE;
 #else
 		return EXIP_INVALID_EXI_INPUT;
 #endif
@@ -792,7 +889,14 @@ errorCode dateTimeData(EXIStream* strm, EXIPDateTime dt_val)
 		return EXIP_INCONSISTENT_PROC_STATE;
 	}
 
-	return EXIP_OK;
+	value.qnameID = qnameID;
+	value.typeId = typeId;
+	tmp_err_code = addChannelValue(strm, &value);
+
+	if(value.type == CHANNEL_STRING_VALUE)
+		EXIP_RELEASE(strm->allocator, value.data.strVal.str);
+
+	return tmp_err_code;
 }
 
 errorCode decimalData(EXIStream* strm, Decimal dec_val)
@@ -801,6 +905,7 @@ errorCode decimalData(EXIStream* strm, Decimal dec_val)
 	Index typeId;
 	QNameID qnameID;
 	EXIType exiType;
+	ChannelValue value;
 	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("\n>Start decimal data serialization\n"));
 
 	if(strm->gStack->grammar == NULL)
@@ -829,20 +934,18 @@ errorCode decimalData(EXIStream* strm, Decimal dec_val)
 
 	if(exiType == VALUE_TYPE_DECIMAL)
 	{
-		return encodeDecimalValue(strm, dec_val);
+		value.type = CHANNEL_DECIMAL_VALUE;
+		value.data.decVal = dec_val;
 	}
 	else if(exiType == VALUE_TYPE_STRING || exiType == VALUE_TYPE_UNTYPED || exiType == VALUE_TYPE_NONE)
 	{
 		//       1) Print Warning
 		//       2) convert the float to sting
 		//       3) encode string
-		String tmpStr;
-
 		DEBUG_MSG(WARNING, DEBUG_CONTENT_IO, ("\n>Decimal to String conversion required \n"));
 #if EXIP_IMPLICIT_DATA_TYPE_CONVERSION
-		TRY(decimalToString(dec_val, &tmpStr));
-		TRY(encodeStringData(strm, tmpStr, qnameID, typeId));
-		EXIP_MFREE(tmpStr.str);
+		TRY(decimalToString(dec_val, &value.data.strVal, strm->allocator));
+		value.type = CHANNEL_STRING_VALUE;
 #else
 		return EXIP_INVALID_EXI_INPUT;
 #endif
@@ -853,12 +956,20 @@ errorCode decimalData(EXIStream* strm, Decimal dec_val)
 		return EXIP_INCONSISTENT_PROC_STATE;
 	}
 
-	return EXIP_OK;
+	value.qnameID = qnameID;
+	value.typeId = typeId;
+	tmp_err_code = addChannelValue(strm, &value);
+
+	if(value.type == CHANNEL_STRING_VALUE)
+		EXIP_RELEASE(strm->allocator, value.data.strVal.str);
+
+	return tmp_err_code;
 }
 
 errorCode listData(EXIStream* strm, unsigned int itemCount)
 {
 	Index typeId;
+	ChannelValue value;
 	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("\n>Start list data serialization\n"));
 
 	if(strm->gStack->grammar == NULL)
@@ -868,6 +979,7 @@ errorCode listData(EXIStream* strm, unsigned int itemCount)
 	{
 		strm->context.expectATData -= 1;
 		typeId = strm->context.attrTypeId;
+		value.qnameID = strm->context.currAttr;
 
 		// TODO: is it allowed to have list with elements lists??? To be checked...
 	}
@@ -877,12 +989,19 @@ errorCode listData(EXIStream* strm, unsigned int itemCount)
 		Production prodHit = {0, INDEX_MAX, {URI_MAX, LN_MAX}};
 
 		TRY(encodeProduction(strm, EVENT_CH_CLASS, TRUE, NULL, VALUE_TYPE_LIST_CLASS, &prodHit));
+		typeId = prodHit.typeId;
+		value.qnameID = strm->gStack->currQNameID;
 	}
 
 	strm->context.expectATData = itemCount;
  	strm->context.attrTypeId = strm->schema->simpleTypeTable.sType[typeId].length; // The actual type of the list items
 
-	return encodeUnsignedInteger(strm, (UnsignedInteger) itemCount);
+	// The items follow the list in the same channel
+	value.type = CHANNEL_LIST_VALUE;
+	value.typeId = typeId;
+	value.data.itemCount = itemCount;
+
+	return addChannelValue(strm, &value);
 }
 
 errorCode qnameData(EXIStream* strm, QName qname)
@@ -910,8 +1029,8 @@ errorCode qnameData(EXIStream* strm, QName qname)
 			// The grammar is found
 			// preserve the currQNameID
 			QNameID currQNameID = strm->gStack->currQNameID;
-			popGrammar(&(strm->gStack));
-			TRY(pushGrammar(&(strm->gStack), currQNameID, newGrammar));
+			popGrammar(strm);
+			TRY(pushGrammar(strm, currQNameID, newGrammar));
 		}
 		else if(strm->gStack->grammar == NULL)
 			return EXIP_INCONSISTENT_PROC_STATE;
@@ -967,7 +1086,7 @@ errorCode namespaceDeclaration(EXIStream* strm, const String ns, const String pr
 		TRY(encodeUri(strm, (String*) &ns, &uriId));
 		if(strm->schema->uriTable.uri[uriId].pfxTable == NULL)
 		{
-			TRY(createPfxTable(&strm->schema->uriTable.uri[uriId].pfxTable));
+			TRY(createPfxTable(&strm->schema->uriTable.uri[uriId].pfxTable, strm->schema->uriTable.dynArray.allocator));
 		}
 		TRY(encodePfx(strm, uriId, (String*) &prefix));
 		// Leave the current grammar NULL
@@ -984,7 +1103,7 @@ errorCode namespaceDeclaration(EXIStream* strm, const String ns, const String pr
 
 	if(strm->schema->uriTable.uri[uriId].pfxTable == NULL)
 	{
-		TRY(createPfxTable(&strm->schema->uriTable.uri[uriId].pfxTable));
+		TRY(createPfxTable(&strm->schema->uriTable.uri[uriId].pfxTable, strm->schema->uriTable.dynArray.allocator));
 	}
 	TRY(encodePfx(strm, uriId, (String*) &prefix));
 
@@ -993,22 +1112,71 @@ errorCode namespaceDeclaration(EXIStream* strm, const String ns, const String pr
 
 errorCode selfContained(EXIStream* strm)
 {
-	return EXIP_NOT_IMPLEMENTED_YET;
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Production prodHit = {0, INDEX_MAX, {URI_MAX, LN_MAX}};
+	QName qname;
+	String uri;
+	String ln;
+	EXITypeClass valueType;
+
+	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, (">Self-contained element serialization\n"));
+
+	if(!WITH_SELF_CONTAINED(strm->header.opts.enumOpt) || strm->gStack->grammar == NULL)
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	// Only available without schema-informed grammars (see initSelfContained())
+	if(strm->sc == NULL)
+		return EXIP_NOT_IMPLEMENTED_YET;
+
+	// The entries of the qname can be replaced once the string tables are reset
+	// but the characters stay valid
+	uri = strm->schema->uriTable.uri[strm->gStack->currQNameID.uriId].uriStr;
+	ln = GET_LN_URI_QNAME(strm->schema->uriTable, strm->gStack->currQNameID).lnStr;
+	qname.uri = &uri;
+	qname.localName = &ln;
+	qname.prefix = NULL;
+
+	TRY(encodeProduction(strm, EVENT_SC_CLASS, FALSE, NULL, VALUE_TYPE_NONE_CLASS, &prodHit));
+
+	// Padding bits
+	if(strm->context.bitPointer != 0)
+	{
+		TRY(writeNBits(strm, 8 - strm->context.bitPointer, 0));
+	}
+	TRY(startSelfContained(strm));
+
+	// The element is encoded again as the root of the fragment
+	return startElement(strm, qname, &valueType);
 }
 
 errorCode closeEXIStream(EXIStream* strm)
 {
 	errorCode tmp_err_code = EXIP_OK;
 
+	// The stream was closed inside self-contained elements
+	destroySelfContained(strm);
+
 	while(strm->gStack != NULL)
 	{
-		popGrammar(&strm->gStack);
+		popGrammar(strm);
 	}
 
-	// Flush the buffer first if there is an output Stream
+	// The stream was closed before the ED event
+	if(IS_CHANNELLED(strm))
+		destroyValueChannels(strm);
+
+	// Flush the buffer first if there is an output Stream.
+	// A partially filled last byte is written together with its padding bits
+#if EXIP_ASYNC_OUTPUT == ON
+	if(IS_ASYNC_OUTPUT(strm))
+		tmp_err_code = closeAsyncOutput(strm, strm->context.bufferIndx + (strm->context.bitPointer > 0));
+	else
+#endif
 	if(strm->buffer.ioStrm.readWriteToStream != NULL)
 	{
-		if((Index)strm->buffer.ioStrm.readWriteToStream(strm->buffer.buf, strm->context.bufferIndx + 1, strm->buffer.ioStrm.stream) < strm->context.bufferIndx + 1)
+		Index bytesToWrite = strm->context.bufferIndx + (strm->context.bitPointer > 0);
+
+		if((Index)strm->buffer.ioStrm.readWriteToStream(strm->buffer.buf, bytesToWrite, strm->buffer.ioStrm.stream) < bytesToWrite)
 			tmp_err_code = EXIP_BUFFER_END_REACHED;
 	}
 
@@ -1016,6 +1184,17 @@ errorCode closeEXIStream(EXIStream* strm)
 	return tmp_err_code;
 }
 
+#if EXIP_ASYNC_OUTPUT == ON
+errorCode enableAsyncOutput(EXIStream* strm, unsigned int bufCount)
+{
+	// The buffers are allocated from the heap
+	if(isMemoryRegion(strm->allocator))
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+
+	return createAsyncOutput(strm, bufCount);
+}
+#endif
+
 errorCode flushEXIData(EXIStream* strm, char* outBuf, unsigned int bufSize, unsigned int* bytesFlush)
 {
 	char leftOverBits;
@@ -1026,12 +1205,11 @@ errorCode flushEXIData(EXIStream* strm, char* outBuf, unsigned int bufSize, unsi
 	leftOverBits = strm->buffer.buf[strm->context.bufferIndx];
 
 	memcpy(outBuf, strm->buffer.buf, strm->context.bufferIndx);
+	*bytesFlush = strm->context.bufferIndx;
 
 	strm->buffer.buf[0] = leftOverBits;
 	strm->context.bufferIndx = 0;
 
-	*bytesFlush = strm->context.bufferIndx;
-
 	return EXIP_OK;
 }
 
@@ -1112,7 +1290,7 @@ errorCode serializeEvent(EXIStream* strm, EventCode ec, QName* qname)
 			}
 
 			if(elemGrammar != NULL) // The grammar is found
-				TRY(pushGrammar(&(strm->gStack), tmpProd->qnameId, elemGrammar));
+				TRY(pushGrammar(strm, tmpProd->qnameId, elemGrammar));
 			else
 				return EXIP_INCONSISTENT_PROC_STATE;  // The event require the presence of Element Grammar previously created
 		}
@@ -1140,7 +1318,7 @@ errorCode serializeEvent(EXIStream* strm, EventCode ec, QName* qname)
 
 			if(elemGrammar != NULL) // The grammar is found
 			{
-				TRY(pushGrammar(&(strm->gStack), tmpQid, elemGrammar));
+				TRY(pushGrammar(strm, tmpQid, elemGrammar));
 			}
 			else
 			{
@@ -1153,13 +1331,13 @@ errorCode serializeEvent(EXIStream* strm, EventCode ec, QName* qname)
 
 				GET_LN_URI_QNAME(strm->schema->uriTable, tmpQid).elemGrammar = dynArrIndx;
 
-				TRY(pushGrammar(&(strm->gStack), tmpQid, &strm->schema->grammarTable.grammar[dynArrIndx]));
+				TRY(pushGrammar(strm, tmpQid, &strm->schema->grammarTable.grammar[dynArrIndx]));
 #elif EXI_PROFILE_DEFAULT
 				// Leave the grammar NULL - if the next event is valid AT(xsi:type)
 				// then its value will be the next grammar.
 				// If the next event is not valid AT(xsi:type) - then the event
 				// AT(xsi:type="anyType") will be inserted beforehand
-				TRY(pushGrammar(&(strm->gStack), tmpQid, elemGrammar));
+				TRY(pushGrammar(strm, tmpQid, elemGrammar));
 
 				return EXIP_OK;
 #else
@@ -1173,7 +1351,7 @@ errorCode serializeEvent(EXIStream* strm, EventCode ec, QName* qname)
 		case EVENT_EE:
 			assert(strm->gStack->currNonTermID == GR_VOID_NON_TERMINAL);
 
-			popGrammar(&(strm->gStack));
+			popGrammar(strm);
 		break;
 		case EVENT_CH:
 			return EXIP_NOT_IMPLEMENTED_YET;
@@ -1253,13 +1431,13 @@ static errorCode encodeAnyType(EXIStream* strm)
 	TRY(encodeNBitUnsignedInteger(strm, getBitsNumber((unsigned int)(strm->schema->uriTable.uri[XML_SCHEMA_NAMESPACE_ID].lnTable.count - 1)), SIMPLE_TYPE_ANY_TYPE));
 
 	// "xs:anyType" grammar is pushed on the stack instead of the NULL one
-	popGrammar(&(strm->gStack));
+	popGrammar(strm);
 	anyTypeId.uriId = XML_SCHEMA_NAMESPACE_ID;
 	anyTypeId.lnId = SIMPLE_TYPE_ANY_TYPE;
 	anyGrammar = GET_TYPE_GRAMMAR_QNAMEID(strm->schema, anyTypeId);
 	assert(anyGrammar != NULL);
 
-	TRY(pushGrammar(&(strm->gStack), currQNameID, anyGrammar));
+	TRY(pushGrammar(strm, currQNameID, anyGrammar));
 
 	return EXIP_OK;
 }
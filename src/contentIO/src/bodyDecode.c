@@ -22,11 +22,14 @@
 #include "grammars.h"
 #include "dynamicArray.h"
 #include "stringManipulate.h"
+#include "valueChannels.h"
+#include "selfContained.h"
 
 
 static errorCode stateMachineProdDecode(EXIStream* strm, GrammarRule* currentRule, SmallIndex* nonTermID_out, ContentHandler* handler, void* app_data);
 static errorCode handleProduction(EXIStream* strm, Production* prodHit, SmallIndex* nonTermID_out, ContentHandler* handler, void* app_data);
 static errorCode decodeQNameValue(EXIStream* strm, ContentHandler* handler, SmallIndex* nonTermID_out, void* app_data);
+static errorCode decodeSCEvent(EXIStream* strm, ContentHandler* handler, SmallIndex* nonTermID_out, void* app_data);
 
 errorCode processNextProduction(EXIStream* strm, SmallIndex* nonTermID_out, ContentHandler* handler, void* app_data)
 {
@@ -147,11 +150,7 @@ static errorCode handleProduction(EXIStream* strm, Production* prodHit, SmallInd
 			}
 		break;
 		case EVENT_SC:
-			DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("> SC event:\n"));
-			if(handler->selfContained != NULL)
-			{
-				TRY(handler->selfContained(app_data));
-			}
+			return decodeSCEvent(strm, handler, nonTermID_out, app_data);
 		break;
 		default: // The event has content!
 			return decodeEventContent(strm, prodHit, handler, nonTermID_out, app_data);
@@ -243,7 +242,7 @@ static errorCode stateMachineProdDecode(EXIStream* strm, GrammarRule* currentRul
 				*nonTermID_out = GR_VOID_NON_TERMINAL;
 
 				// TODO: First you need to check if EE does not already exists, just then insert it
-				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_EE, GR_VOID_NON_TERMINAL, &voidQnameID, 1));
+				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_EE, GR_VOID_NON_TERMINAL, &voidQnameID, 1, strm->allocator));
 			break;
 			case 1:
 				// StartTagContent : AT(*) event
@@ -259,11 +258,11 @@ static errorCode stateMachineProdDecode(EXIStream* strm, GrammarRule* currentRul
 					if(!RULE_CONTAIN_XSI_TYPE(((DynGrammarRule*) currentRule)->meta))
 					{
 						RULE_SET_CONTAIN_XSI_TYPE(((DynGrammarRule*) currentRule)->meta);
-						TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_AT_QNAME, GR_START_TAG_CONTENT, &strm->context.currAttr, 1));
+						TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_AT_QNAME, GR_START_TAG_CONTENT, &strm->context.currAttr, 1, strm->allocator));
 					}
 				}
 				else
-					TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_AT_QNAME, GR_START_TAG_CONTENT, &strm->context.currAttr, 1));
+					TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_AT_QNAME, GR_START_TAG_CONTENT, &strm->context.currAttr, 1, strm->allocator));
 			break;
 			case 2:
 				// StartTagContent : NS event
@@ -271,14 +270,14 @@ static errorCode stateMachineProdDecode(EXIStream* strm, GrammarRule* currentRul
 			break;
 			case 3:
 				// StartTagContent : SC event
-				return EXIP_NOT_IMPLEMENTED_YET;
+				TRY(decodeSCEvent(strm, handler, nonTermID_out, app_data));
 			break;
 			case 4:
 				// SE(*) event
 				strm->gStack->currNonTermID = GR_ELEMENT_CONTENT;
 
 				TRY(decodeSEWildcardEvent(strm, handler, nonTermID_out, app_data));
-				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_SE_QNAME, GR_ELEMENT_CONTENT, &strm->gStack->currQNameID, 1));
+				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_SE_QNAME, GR_ELEMENT_CONTENT, &strm->gStack->currQNameID, 1, strm->allocator));
 			break;
 			case 5:
 				// CH event
@@ -288,7 +287,7 @@ static errorCode stateMachineProdDecode(EXIStream* strm, GrammarRule* currentRul
 
 				TRY(decodeValueItem(strm, INDEX_MAX, handler, nonTermID_out, strm->gStack->currQNameID, app_data));
 				// TODO: First you need to check if CH does not already exists, just then insert it
-				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_CH, *nonTermID_out, &voidQnameID, 1));
+				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_CH, *nonTermID_out, &voidQnameID, 1, strm->allocator));
 			break;
 			case 6:
 				// ER event
@@ -663,7 +662,7 @@ static errorCode stateMachineProdDecode(EXIStream* strm, GrammarRule* currentRul
 				break;
 				case 6:
 					// SC event
-					return EXIP_NOT_IMPLEMENTED_YET;
+					TRY(decodeSCEvent(strm, handler, nonTermID_out, app_data));
 				break;
 				case 7:
 					// SE(*) content|same_rule
@@ -788,13 +787,16 @@ errorCode decodeLn(EXIStream* strm, Index uriId, Index* lnId)
 		String lnStr;
 		DEBUG_MSG(INFO, DEBUG_CONTENT_IO, (">local-name table miss\n"));
 
-		TRY(allocateStringMemoryManaged(&(lnStr.str),(Index) (tmpVar - 1), &strm->memList));
-		TRY(decodeStringOnly(strm, (Index)tmpVar - 1, &lnStr));
+		if(!decodeStringReference(strm, (Index) tmpVar - 1, &lnStr))
+		{
+			TRY(allocateStringMemoryManaged(&(lnStr.str),(Index) (tmpVar - 1), &strm->memList));
+			TRY(decodeStringOnly(strm, (Index)tmpVar - 1, &lnStr));
+		}
 
 		if(strm->schema->uriTable.uri[uriId].lnTable.ln == NULL)
 		{
 			// Create local name table for this URI entry
-			TRY(createDynArray(&strm->schema->uriTable.uri[uriId].lnTable.dynArray, sizeof(LnEntry), DEFAULT_LN_ENTRIES_NUMBER));
+			TRY(createDynArray(&strm->schema->uriTable.uri[uriId].lnTable.dynArray, sizeof(LnEntry), DEFAULT_LN_ENTRIES_NUMBER, strm->schema->uriTable.dynArray.allocator));
 		}
 		TRY(addLnEntry(&strm->schema->uriTable.uri[uriId].lnTable, lnStr, lnId));
 	}
@@ -857,11 +859,12 @@ errorCode decodePfx(EXIStream* strm, SmallIndex uriId, SmallIndex* pfxId)
 	return EXIP_OK;
 }
 
-errorCode decodeStringValue(EXIStream* strm, QNameID qnameID, String* value)
+errorCode decodeStringValue(EXIStream* strm, QNameID qnameID, String* value, boolean* freeable)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 	UnsignedInteger tmpVar = 0;
 	TRY(decodeUnsignedInteger(strm, &tmpVar));
+	*freeable = FALSE;
 
 	if(tmpVar == 0) // "local" value partition table hit
 	{
@@ -895,14 +898,20 @@ errorCode decodeStringValue(EXIStream* strm, QNameID qnameID, String* value)
 	{
 		Index vStrLen = (Index) tmpVar - 2;
 
-		TRY(allocateStringMemory(&value->str, vStrLen));
-		TRY(decodeStringOnly(strm, vStrLen, value));
-
 		if(vStrLen > 0 && vStrLen <= strm->header.opts.valueMaxLength && strm->header.opts.valuePartitionCapacity > 0)
 		{
+			TRY(allocateValueString(strm, vStrLen*CHAR_TYPE_MAX_UNITS, &value->str));
+			TRY(decodeStringOnly(strm, vStrLen, value));
+
 			// The value should be entered in the value partitions of the string tables
 			TRY(addValueEntry(strm, *value, qnameID));
 		}
+		else if(!decodeStringReference(strm, vStrLen, value))
+		{
+			TRY(allocateStringMemory(&value->str, vStrLen, strm->allocator));
+			TRY(decodeStringOnly(strm, vStrLen, value));
+			*freeable = TRUE;
+		}
 	}
 	return EXIP_OK;
 }
@@ -958,7 +967,7 @@ errorCode decodeEventContent(EXIStream* strm, Production* prodHit, ContentHandle
 			if(elemGrammar != NULL) // The grammar is found
 			{
 				*nonTermID_out = GR_START_TAG_CONTENT;
-				TRY(pushGrammar(&(strm->gStack), prodHit->qnameId, elemGrammar));
+				TRY(pushGrammar(strm, prodHit->qnameId, elemGrammar));
 			}
 			else
 			{
@@ -1013,6 +1022,14 @@ errorCode decodeValueItem(EXIStream* strm, Index typeId, ContentHandler* handler
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 	EXIType exiType = VALUE_TYPE_NONE;
 
+	if(IS_CHANNELLED(strm) && (localQNameID.uriId != XML_SCHEMA_INSTANCE_ID ||
+			(localQNameID.lnId != XML_SCHEMA_INSTANCE_TYPE_ID && localQNameID.lnId != XML_SCHEMA_INSTANCE_NIL_ID)))
+	{
+		// The value is in a value channel; the values of xsi:type
+		// and xsi:nil are part of the structure
+		return addValueSlot(strm, typeId, localQNameID);
+	}
+
 	if(typeId != INDEX_MAX)
 		exiType = GET_EXI_TYPE(strm->schema->simpleTypeTable.sType[typeId].content);
 	else if(localQNameID.uriId == XML_SCHEMA_INSTANCE_ID &&
@@ -1099,7 +1116,7 @@ errorCode decodeValueItem(EXIStream* strm, Index typeId, ContentHandler* handler
 			}
 
 			// handle xsi:nil attribute
-			if(IS_SCHEMA(strm->gStack->grammar->props) && localQNameID.uriId == XML_SCHEMA_INSTANCE_ID && localQNameID.lnId == XML_SCHEMA_INSTANCE_NIL_ID) // Schema-enabled grammar and http://www.w3.org/2001/XMLSchema-instance:nil
+			if(localQNameID.uriId == XML_SCHEMA_INSTANCE_ID && localQNameID.lnId == XML_SCHEMA_INSTANCE_NIL_ID && IS_SCHEMA(strm->gStack->grammar->props)) // Schema-enabled grammar and http://www.w3.org/2001/XMLSchema-instance:nil
 			{
 				if(bool_val == TRUE)
 				{
@@ -1119,11 +1136,8 @@ errorCode decodeValueItem(EXIStream* strm, Index typeId, ContentHandler* handler
 
 			if(handler->binaryData != NULL)  // Invoke handler method
 			{
-				TRY_CATCH(handler->binaryData(binary_val, nbytes, app_data), EXIP_MFREE(binary_val));
+				TRY(handler->binaryData(binary_val, nbytes, app_data));
 			}
-			
-			/* Free the memory allocated by decodeBinary() */
-			EXIP_MFREE(binary_val);
 		}
 		break;
 		case VALUE_TYPE_DECIMAL:
@@ -1206,10 +1220,7 @@ errorCode decodeValueItem(EXIStream* strm, Index typeId, ContentHandler* handler
 			}
 			else
 			{
-				TRY(decodeStringValue(strm, localQNameID, &value));
-
-				if(value.length == 0 || value.length > strm->header.opts.valueMaxLength || strm->header.opts.valuePartitionCapacity == 0)
-					freeable = TRUE;
+				TRY(decodeStringValue(strm, localQNameID, &value, &freeable));
 			}
 
 			if(handler->stringData != NULL)  // Invoke handler method
@@ -1218,7 +1229,7 @@ errorCode decodeValueItem(EXIStream* strm, Index typeId, ContentHandler* handler
 			}
 
 			if(freeable)
-				EXIP_MFREE(value.str);
+				EXIP_RELEASE(strm->allocator, value.str);
 		} break;
 	}
 
@@ -1239,7 +1250,7 @@ errorCode decodeNSEvent(EXIStream* strm, ContentHandler* handler, SmallIndex* no
 
 	if(strm->schema->uriTable.uri[ns_uriId].pfxTable == NULL)
 	{
-		TRY(createPfxTable(&strm->schema->uriTable.uri[ns_uriId].pfxTable));
+		TRY(createPfxTable(&strm->schema->uriTable.uri[ns_uriId].pfxTable, strm->schema->uriTable.dynArray.allocator));
 	}
 
 	TRY(decodePfx(strm, ns_uriId, &pfxId));
@@ -1281,7 +1292,7 @@ errorCode decodeSEWildcardEvent(EXIStream* strm, ContentHandler* handler, SmallI
 	if(elemGrammar != NULL)
 	{
 		// The grammar is found
-		TRY(pushGrammar(&(strm->gStack), qnameId, elemGrammar));
+		TRY(pushGrammar(strm, qnameId, elemGrammar));
 	}
 	else
 	{
@@ -1292,7 +1303,7 @@ errorCode decodeSEWildcardEvent(EXIStream* strm, ContentHandler* handler, SmallI
 		TRY(addDynEntry(&strm->schema->grammarTable.dynArray, &newElementGrammar, &dynArrIndx));
 
 		GET_LN_URI_QNAME(strm->schema->uriTable, qnameId).elemGrammar = dynArrIndx;
-		TRY(pushGrammar(&(strm->gStack), qnameId, &strm->schema->grammarTable.grammar[dynArrIndx]));
+		TRY(pushGrammar(strm, qnameId, &strm->schema->grammarTable.grammar[dynArrIndx]));
 #elif EXI_PROFILE_DEFAULT
 		{
 			unsigned int prodCnt = 4;
@@ -1369,7 +1380,7 @@ errorCode decodeSEWildcardEvent(EXIStream* strm, ContentHandler* handler, SmallI
 			if(elemGrammar != NULL)
 			{
 				// The grammar is found
-				TRY(pushGrammar(&(strm->gStack), qnameId, elemGrammar));
+				TRY(pushGrammar(strm, qnameId, elemGrammar));
 			}
 			else
 			{
@@ -1441,10 +1452,73 @@ static errorCode decodeQNameValue(EXIStream* strm, ContentHandler* handler, Smal
 		// The grammar is found
 		// preserve the currQNameID
 		QNameID currQNameID = strm->gStack->currQNameID;
-		popGrammar(&(strm->gStack));
+		popGrammar(strm);
 
 		*nonTermID_out = GR_START_TAG_CONTENT;
-		TRY(pushGrammar(&(strm->gStack), currQNameID, newGrammar));
+		TRY(pushGrammar(strm, currQNameID, newGrammar));
+	}
+
+	return EXIP_OK;
+}
+
+errorCode decodeSelfContainedStart(EXIStream* strm, ContentHandler* handler, SmallIndex* nonTermID_out, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	TRY(startSelfContained(strm));
+
+	tmp_err_code = processNextProduction(strm, nonTermID_out, handler, app_data);
+	// An empty fragment
+	if(tmp_err_code == EXIP_OK && strm->gStack->nextInStack == NULL)
+		tmp_err_code = EXIP_INVALID_EXI_INPUT;
+
+	if(tmp_err_code != EXIP_OK)
+	{
+		// The state of the document is back as before the fragment
+		// so that it can be parsed again when more data is available
+		endSelfContained(strm);
+		return tmp_err_code;
+	}
+
+	return EXIP_OK;
+}
+
+errorCode decodeSelfContainedEnd(EXIStream* strm, SmallIndex* nonTermID_out)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ContentHandler noHandler;
+
+	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, (">End of self-contained fragment\n"));
+
+	// The EE of the element of the fragment is the EE of the SC element
+	initContentHandler(&noHandler);
+	TRY(processNextProduction(strm, nonTermID_out, &noHandler, NULL));
+	if(*nonTermID_out != GR_VOID_NON_TERMINAL)
+		return EXIP_INVALID_EXI_INPUT;
+
+	endSelfContained(strm);
+
+	return EXIP_OK;
+}
+
+static errorCode decodeSCEvent(EXIStream* strm, ContentHandler* handler, SmallIndex* nonTermID_out, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ContentHandler noHandler;
+
+	DEBUG_MSG(INFO, DEBUG_CONTENT_IO, ("> SC event:\n"));
+
+	// Padding bits
+	if(strm->context.bitPointer != 0)
+		moveBitPointer(strm, 8 - strm->context.bitPointer);
+
+	// The fragment starts with the SE of the SC element that is already passed to the handler
+	initContentHandler(&noHandler);
+	TRY(decodeSelfContainedStart(strm, &noHandler, nonTermID_out, NULL));
+
+	if(handler->selfContained != NULL)
+	{
+		TRY(handler->selfContained(app_data));
 	}
 
 	return EXIP_OK;
@@ -31,6 +31,11 @@ extern const String XML_SCHEMA_INSTANCE;
 static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventClass, GrammarRule* currentRule,
 										QName* qname, EventCode ec, Production* prodHit);
 
+/**
+ * @brief Finds the IDs of qname in the string tables; the IDs of a missing
+ * URI or local name are the ones it gets when added */
+static errorCode lookupQNameID(EXIStream* strm, QName* qname, QNameID* qnameID);
+
 errorCode encodeStringData(EXIStream* strm, String strng, QNameID qnameID, Index typeId)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
@@ -63,7 +68,7 @@ errorCode encodeStringData(EXIStream* strm, String strng, QNameID qnameID, Index
 	{
 		VxTable* vxTable = GET_LN_URI_QNAME(strm->schema->uriTable, qnameID).vxTable;
 		Index vxEntryId = 0;
-		flag_StringLiteralsPartition = lookupVx(&strm->valueTable, vxTable, strng, &vxEntryId);
+		TRY(lookupVx(&strm->valueTable, vxTable, strng, &vxEntryId, &flag_StringLiteralsPartition));
 		if(flag_StringLiteralsPartition && vxTable->vx[vxEntryId].globalId != INDEX_MAX) //  "local" value partition table hit; when INDEX_MAX -> compact identifier permanently unassigned
 		{
 			unsigned char vxBits;
@@ -88,15 +93,20 @@ errorCode encodeStringData(EXIStream* strm, String strng, QNameID qnameID, Index
 		}
 		else // "local" value partition and global value partition table miss
 		{
-			TRY(encodeUnsignedInteger(strm, (UnsignedInteger)(strng.length + 2)));
+			Index UCSchars;
+
+			TRY(getUCSCharsNumber(&strng, &UCSchars));
+			TRY(encodeUnsignedInteger(strm, (UnsignedInteger)(UCSchars + 2)));
 			TRY(encodeStringOnly(strm, &strng));
 
-			if(strng.length > 0 && strng.length <= strm->header.opts.valueMaxLength && strm->header.opts.valuePartitionCapacity > 0)
+			if(UCSchars > 0 && UCSchars <= strm->header.opts.valueMaxLength && strm->header.opts.valuePartitionCapacity > 0)
 			{
 				// The value should be added in the value partitions of the string tables
 				String clonedValue;
 
-				TRY(cloneString(&strng, &clonedValue));
+				TRY(allocateValueString(strm, strng.length, &clonedValue.str));
+				memcpy(clonedValue.str, strng.str, sizeof(CharType)*strng.length);
+				clonedValue.length = strng.length;
 				TRY(addValueEntry(strm, clonedValue, qnameID));
 			}
 		}
@@ -281,7 +291,7 @@ static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventCla
 				// #1# COMMENT and #2# COMMENT
 				// NOTE: In general, first you need to check if EE does not already exists, just then insert it
 				// However, the encodeProduction(); will always use first level EE if exists so no such check is needed here.
-				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_EE, GR_VOID_NON_TERMINAL, &voidQnameID, 1));
+				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_EE, GR_VOID_NON_TERMINAL, &voidQnameID, 1, strm->allocator));
 			break;
 			case EVENT_AT_CLASS:
 				if(strm->gStack->currNonTermID != GR_START_TAG_CONTENT)
@@ -291,15 +301,7 @@ static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventCla
 				ec.part[1] = 1;
 				strm->gStack->currNonTermID = GR_START_TAG_CONTENT;
 
-				if(!lookupUri(&strm->schema->uriTable, *qname->uri, &qnameID.uriId))
-				{
-					qnameID.uriId = strm->schema->uriTable.count;
-					qnameID.lnId = 0;
-				}
-				else if(!lookupLn(&strm->schema->uriTable.uri[qnameID.uriId].lnTable, *qname->localName,  &qnameID.lnId))
-				{
-					qnameID.lnId = strm->schema->uriTable.uri[qnameID.uriId].lnTable.count;
-				}
+				TRY(lookupQNameID(strm, qname, &qnameID));
 
 				// If eventType == AT(qname) and qname == xsi:type check first if there is no
 				// such production already at top level (see http://www.w3.org/XML/EXI/exi-10-errata#Substantive20120508)
@@ -309,11 +311,11 @@ static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventCla
 					if(!RULE_CONTAIN_XSI_TYPE(((DynGrammarRule*) currentRule)->meta))
 					{
 						RULE_SET_CONTAIN_XSI_TYPE(((DynGrammarRule*) currentRule)->meta);
-						TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_AT_QNAME, GR_START_TAG_CONTENT, &qnameID, 1));
+						TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_AT_QNAME, GR_START_TAG_CONTENT, &qnameID, 1, strm->allocator));
 					}
 				}
 				else
-					TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_AT_QNAME, GR_START_TAG_CONTENT, &qnameID, 1));
+					TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_AT_QNAME, GR_START_TAG_CONTENT, &qnameID, 1, strm->allocator));
 			break;
 			case EVENT_NS_CLASS:
 				if(strm->gStack->currNonTermID != GR_START_TAG_CONTENT || !IS_PRESERVED(strm->header.opts.preserve, PRESERVE_PREFIXES))
@@ -324,7 +326,11 @@ static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventCla
 				strm->gStack->currNonTermID = GR_START_TAG_CONTENT;
 			break;
 			case EVENT_SC_CLASS:
-				return EXIP_NOT_IMPLEMENTED_YET;
+				if(strm->gStack->currNonTermID != GR_START_TAG_CONTENT || !WITH_SELF_CONTAINED(strm->header.opts.enumOpt))
+					return EXIP_INCONSISTENT_PROC_STATE;
+
+				SET_PROD_EXI_EVENT(prodHit->content, EVENT_SC);
+				ec.part[1] = 2 + IS_PRESERVED(strm->header.opts.preserve, PRESERVE_PREFIXES);
 			break;
 			case EVENT_SE_CLASS:
 				SET_PROD_EXI_EVENT(prodHit->content, EVENT_SE_ALL);
@@ -334,17 +340,9 @@ static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventCla
 					ec.part[1] = 0;
 				strm->gStack->currNonTermID = GR_ELEMENT_CONTENT;
 
-				if(!lookupUri(&strm->schema->uriTable, *qname->uri, &qnameID.uriId))
-				{
-					qnameID.uriId = strm->schema->uriTable.count;
-					qnameID.lnId = 0;
-				}
-				else if(!lookupLn(&strm->schema->uriTable.uri[qnameID.uriId].lnTable, *qname->localName,  &qnameID.lnId))
-				{
-					qnameID.lnId = strm->schema->uriTable.uri[qnameID.uriId].lnTable.count;
-				}
+				TRY(lookupQNameID(strm, qname, &qnameID));
 
-				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_SE_QNAME, GR_ELEMENT_CONTENT, &qnameID, 1));
+				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_SE_QNAME, GR_ELEMENT_CONTENT, &qnameID, 1, strm->allocator));
 			break;
 			case EVENT_CH_CLASS:
 				SET_PROD_EXI_EVENT(prodHit->content, EVENT_CH);
@@ -357,7 +355,7 @@ static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventCla
 				// #1# COMMENT and #2# COMMENT
 				// NOTE: In general, first you need to check if CH does not already exists, just then insert it
 				// However, the encodeProduction(); will always use first level CH if exists so no such check is needed here.
-				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_CH, GR_ELEMENT_CONTENT, &voidQnameID, 1));
+				TRY(insertZeroProduction((DynGrammarRule*) currentRule, EVENT_CH, GR_ELEMENT_CONTENT, &voidQnameID, 1, strm->allocator));
 			break;
 			case EVENT_ER_CLASS:
 				return EXIP_NOT_IMPLEMENTED_YET;
@@ -412,6 +410,8 @@ static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventCla
 	}
 	else
 	{
+		errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
 		// Schema-informed element/type grammar
 		if(WITH_STRICT(strm->header.opts.enumOpt))
 		{
@@ -522,15 +522,7 @@ static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventCla
 				break;
 				case EVENT_AT_CLASS:
 
-					if(!lookupUri(&strm->schema->uriTable, *qname->uri, &qnameID.uriId))
-					{
-						qnameID.uriId = strm->schema->uriTable.count;
-						qnameID.lnId = 0;
-					}
-					else if(!lookupLn(&strm->schema->uriTable.uri[qnameID.uriId].lnTable, *qname->localName,  &qnameID.lnId))
-					{
-						qnameID.lnId = strm->schema->uriTable.uri[qnameID.uriId].lnTable.count;
-					}
+					TRY(lookupQNameID(strm, qname, &qnameID));
 
 					if(qnameID.uriId == XML_SCHEMA_INSTANCE_ID)
 					{
@@ -576,7 +568,14 @@ static errorCode stateMachineProdEncode(EXIStream* strm, EventTypeClass eventCla
 					strm->gStack->currNonTermID = GR_START_TAG_CONTENT;
 				break;
 				case EVENT_SC_CLASS:
-					return EXIP_NOT_IMPLEMENTED_YET;
+					if(strm->gStack->currNonTermID != GR_START_TAG_CONTENT ||
+						!WITH_SELF_CONTAINED(strm->header.opts.enumOpt))
+						return EXIP_INCONSISTENT_PROC_STATE;
+
+					SET_PROD_EXI_EVENT(prodHit->content, EVENT_SC);
+					ec.length = 2;
+					ec.part[1] = !RULE_CONTAIN_EE(currentRule->meta) + 4 + IS_PRESERVED(strm->header.opts.preserve, PRESERVE_PREFIXES);
+					ec.bits[1] = getBitsNumber(prod2Count - 1);
 				break;
 				case EVENT_SE_CLASS:
 					// SE(*) content|same_rule
@@ -647,8 +646,10 @@ errorCode encodeUri(EXIStream* strm, String* uri, SmallIndex* uriId)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 	unsigned char uriBits = getBitsNumber(strm->schema->uriTable.count);
+	boolean found;
 
-	if(lookupUri(&strm->schema->uriTable, *uri, uriId)) // uri hit
+	TRY(lookupUri(&strm->schema->uriTable, *uri, uriId, &found));
+	if(found) // uri hit
 	{
 		TRY(encodeNBitUnsignedInteger(strm, uriBits, *uriId + 1));
 	}
@@ -667,8 +668,10 @@ errorCode encodeUri(EXIStream* strm, String* uri, SmallIndex* uriId)
 errorCode encodeLn(EXIStream* strm, String* ln, QNameID* qnameID)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	boolean found;
 
-	if(lookupLn(&strm->schema->uriTable.uri[qnameID->uriId].lnTable, *ln, &qnameID->lnId)) // local-name table hit
+	TRY(lookupLn(&strm->schema->uriTable.uri[qnameID->uriId].lnTable, *ln, &qnameID->lnId, &found));
+	if(found) // local-name table hit
 	{
 		unsigned char lnBits = getBitsNumber((unsigned int)(strm->schema->uriTable.uri[qnameID->uriId].lnTable.count - 1));
 		TRY(encodeUnsignedInteger(strm, 0));
@@ -677,13 +680,16 @@ errorCode encodeLn(EXIStream* strm, String* ln, QNameID* qnameID)
 	else // local-name table miss
 	{
 		String copiedLN;
-		TRY(encodeUnsignedInteger(strm, (UnsignedInteger)(ln->length + 1)));
+		Index UCSchars;
+
+		TRY(getUCSCharsNumber(ln, &UCSchars));
+		TRY(encodeUnsignedInteger(strm, (UnsignedInteger)(UCSchars + 1)));
 		TRY(encodeStringOnly(strm,  ln));
 
 		if(strm->schema->uriTable.uri[qnameID->uriId].lnTable.ln == NULL)
 		{
 			// Create local name table for this URI entry
-			TRY(createDynArray(&strm->schema->uriTable.uri[qnameID->uriId].lnTable.dynArray, sizeof(LnEntry), DEFAULT_LN_ENTRIES_NUMBER));
+			TRY(createDynArray(&strm->schema->uriTable.uri[qnameID->uriId].lnTable.dynArray, sizeof(LnEntry), DEFAULT_LN_ENTRIES_NUMBER, strm->schema->uriTable.dynArray.allocator));
 		}
 
 		TRY(cloneStringManaged(ln, &copiedLN, &strm->memList));
@@ -792,9 +798,9 @@ errorCode encodeIntData(EXIStream* strm, Integer int_val, QNameID qnameID, Index
 
 		DEBUG_MSG(WARNING, DEBUG_CONTENT_IO, ("\n>Integer to String conversion required \n"));
 #if EXIP_IMPLICIT_DATA_TYPE_CONVERSION
-		TRY(integerToString(int_val, &tmpStr));
+		TRY(integerToString(int_val, &tmpStr, strm->allocator));
 		TRY(encodeStringData(strm, tmpStr, qnameID, typeId));
-		EXIP_MFREE(tmpStr.str);
+		EXIP_RELEASE(strm->allocator, tmpStr.str);
 #else
 		return EXIP_INVALID_EXI_INPUT;
 #endif
@@ -806,3 +812,23 @@ errorCode encodeIntData(EXIStream* strm, Integer int_val, QNameID qnameID, Index
 	}
 	return EXIP_OK;
 }
+
+static errorCode lookupQNameID(EXIStream* strm, QName* qname, QNameID* qnameID)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	boolean found;
+
+	TRY(lookupUri(&strm->schema->uriTable, *qname->uri, &qnameID->uriId, &found));
+	if(!found)
+	{
+		qnameID->uriId = strm->schema->uriTable.count;
+		qnameID->lnId = 0;
+		return EXIP_OK;
+	}
+
+	TRY(lookupLn(&strm->schema->uriTable.uri[qnameID->uriId].lnTable, *qname->localName, &qnameID->lnId, &found));
+	if(!found)
+		qnameID->lnId = strm->schema->uriTable.uri[qnameID->uriId].lnTable.count;
+
+	return EXIP_OK;
+}
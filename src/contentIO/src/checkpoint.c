@@ -0,0 +1,1042 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file checkpoint.c
+ * @brief Implementation of the checkpoints of the decoder state
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "checkpoint.h"
+#include "grammars.h"
+#include "sTables.h"
+#include "dynamicArray.h"
+#include "memManagement.h"
+#include "stringManipulate.h"
+#include "ioUtil.h"
+#include "readAhead.h"
+#include "valueChannels.h"
+#include "selfContained.h"
+
+#define CHECKPOINT_VERSION 1
+
+/** The initial size of the buffer in which the checkpoints are composed */
+#define CHECKPOINT_CHUNK_SIZE 1024
+
+/** Set in the flags of a checkpoint when the value cross tables are used */
+#define CHECKPOINT_FLAG_CROSSTABLE 0x01
+
+/**
+ * @name The codes of the grammars in the grammar stack
+ * A grammar of the grammar table is coded with its index plus CHECKPOINT_GRAMMAR_INDEX
+ */
+/**@{*/
+#define CHECKPOINT_DOC_GRAMMAR   0
+#define CHECKPOINT_NO_GRAMMAR    1
+#define CHECKPOINT_GRAMMAR_INDEX 2
+/**@}*/
+
+/** The position in the EXI stream of the byte holding the next bit to be parsed */
+#define STREAM_POSITION(strm) ((strm)->context.bufferOffset + (strm)->context.bufferIndx)
+
+static const unsigned char CHECKPOINT_MAGIC[4] = {'E', 'X', 'C', 'P'};
+
+/** A growable buffer of bytes */
+struct CheckpointBytes
+{
+	unsigned char* buf;
+	Index size;
+	Index len;
+	/** The allocator of the stream the checkpoints are written for */
+	const EXIPAllocator* allocator;
+};
+
+typedef struct CheckpointBytes CheckpointBytes;
+
+/** Reads a checkpoint; any read past size is an invalid checkpoint */
+struct CheckpointReader
+{
+	const unsigned char* buf;
+	Index size;
+	Index pos;
+};
+
+typedef struct CheckpointReader CheckpointReader;
+
+struct Checkpoints
+{
+	IOStream sideCar;
+	Index byteInterval;
+	Index elementInterval;
+	/** The number of SE events parsed */
+	Index elements;
+	/** The position and the number of SE events of the last checkpoint */
+	Index lastPosition;
+	Index lastElements;
+	/** The number of URI partitions when the checkpoints are started */
+	SmallIndex initUriCount;
+	/** The number of local names of each initial URI partition */
+	Index* initLnCount;
+	/** The number of prefixes of each initial URI partition; SMALL_INDEX_MAX if it has no prefix table */
+	SmallIndex* initPfxCount;
+	/** The record being written: the length followed by the checkpoint */
+	CheckpointBytes out;
+};
+
+static errorCode reserveBytes(CheckpointBytes* b, Index count)
+{
+	unsigned char* ptr;
+	uint64_t needed = (uint64_t) b->len + count;
+	uint64_t max = (uint64_t) CHECKPOINT_MAX_SIZE + CHECKPOINT_LENGTH_SIZE;
+	uint64_t size = b->size;
+
+	if(needed <= b->size)
+		return EXIP_OK;
+
+	if(max > INDEX_MAX)
+		max = INDEX_MAX;
+	if(needed > max)
+		return EXIP_OUT_OF_BOUND_BUFFER;
+
+	while(needed > size)
+		size = size*2;
+	if(size > max)
+		size = max;
+
+	ptr = (unsigned char*) EXIP_REALLOCATE(b->allocator, b->buf, size);
+	if(ptr == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	b->buf = ptr;
+	b->size = (Index) size;
+	return EXIP_OK;
+}
+
+/** Writes an unsigned varint: 7 bits per byte, the least significant first */
+static errorCode writeUInt(CheckpointBytes* b, uint64_t val)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	TRY(reserveBytes(b, 10));
+	while(val >= 0x80)
+	{
+		b->buf[b->len++] = (unsigned char) (0x80 | (val & 0x7F));
+		val = val >> 7;
+	}
+	b->buf[b->len++] = (unsigned char) val;
+
+	return EXIP_OK;
+}
+
+/** Writes an index that can be max: 0 for max, the index plus one otherwise */
+static errorCode writeIndexOrMax(CheckpointBytes* b, uint64_t val, uint64_t max)
+{
+	return writeUInt(b, val == max ? 0 : val + 1);
+}
+
+static errorCode writeString(CheckpointBytes* b, const String* str)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Index bytes = sizeof(CharType)*str->length;
+
+	TRY(writeUInt(b, str->length));
+	TRY(reserveBytes(b, bytes));
+	if(bytes > 0)
+		memcpy(b->buf + b->len, str->str, bytes);
+	b->len += bytes;
+
+	return EXIP_OK;
+}
+
+static errorCode readUInt(CheckpointReader* r, uint64_t* val)
+{
+	unsigned int shift = 0;
+	unsigned char byte;
+
+	*val = 0;
+	do
+	{
+		if(r->pos >= r->size || shift > 63)
+			return EXIP_INVALID_EXI_INPUT;
+		byte = r->buf[r->pos++];
+		*val = *val | ((uint64_t) (byte & 0x7F) << shift);
+		shift += 7;
+	}
+	while(byte & 0x80);
+
+	return EXIP_OK;
+}
+
+static errorCode readBounded(CheckpointReader* r, uint64_t max, uint64_t* val)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	TRY(readUInt(r, val));
+	if(*val > max)
+		return EXIP_INVALID_EXI_INPUT;
+
+	return EXIP_OK;
+}
+
+static errorCode readIndex(CheckpointReader* r, Index* val)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	uint64_t tmp;
+
+	TRY(readBounded(r, INDEX_MAX, &tmp));
+	*val = (Index) tmp;
+
+	return EXIP_OK;
+}
+
+static errorCode readSmallIndex(CheckpointReader* r, SmallIndex* val)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	uint64_t tmp;
+
+	TRY(readBounded(r, SMALL_INDEX_MAX, &tmp));
+	*val = (SmallIndex) tmp;
+
+	return EXIP_OK;
+}
+
+/** Reads an index written by writeIndexOrMax() */
+static errorCode readIndexOrMax(CheckpointReader* r, uint64_t max, uint64_t* val)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	TRY(readBounded(r, max, val));
+	if(*val == 0)
+		*val = max;
+	else
+		*val = *val - 1;
+
+	return EXIP_OK;
+}
+
+/** Reads a string into memory of memList */
+static errorCode readString(CheckpointReader* r, String* str, AllocList* memList)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Index length;
+
+	TRY(readIndex(r, &length));
+	if(length > (r->size - r->pos)/sizeof(CharType))
+		return EXIP_INVALID_EXI_INPUT;
+
+	str->length = length;
+	str->str = NULL;
+	if(length == 0)
+		return EXIP_OK;
+
+	str->str = (CharType*) memManagedAllocate(memList, sizeof(CharType)*length);
+	if(str->str == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	memcpy(str->str, r->buf + r->pos, sizeof(CharType)*length);
+	r->pos += sizeof(CharType)*length;
+
+	return EXIP_OK;
+}
+
+/** The same as readString() for the strings of the value table */
+static errorCode readValueString(CheckpointReader* r, EXIStream* strm, String* str)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Index length;
+
+	TRY(readIndex(r, &length));
+	if(length == 0 || length > (r->size - r->pos)/sizeof(CharType))
+		return EXIP_INVALID_EXI_INPUT;
+
+	TRY(allocateValueString(strm, length, &str->str));
+	str->length = length;
+
+	memcpy(str->str, r->buf + r->pos, sizeof(CharType)*length);
+	r->pos += sizeof(CharType)*length;
+
+	return EXIP_OK;
+}
+
+/** TRUE if no event of the body is parsed yet */
+static boolean isInitialState(EXIStream* strm)
+{
+	return strm->gStack != NULL && strm->gStack->nextInStack == NULL &&
+			strm->gStack->grammar == &strm->schema->docGrammar &&
+			strm->gStack->currNonTermID == GR_DOC_CONTENT &&
+			strm->schema->grammarTable.count == strm->schema->staticGrCount &&
+			strm->valueTable.count == 0;
+}
+
+errorCode createCheckpoints(EXIStream* strm, Checkpoints** cp, Index byteInterval, Index elementInterval, IOStream sideCar)
+{
+	Checkpoints* c;
+	UriTable* uriTable;
+	SmallIndex i;
+
+	if((byteInterval == 0 && elementInterval == 0) || sideCar.readWriteToStream == NULL)
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+	// The values of a channelled body are decoded a block at a time
+	if(IS_CHANNELLED(strm))
+		return EXIP_NOT_IMPLEMENTED_YET;
+	if(strm->schema == NULL || !isInitialState(strm))
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	uriTable = &strm->schema->uriTable;
+	c = (Checkpoints*) EXIP_ALLOCATE(strm->allocator, sizeof(Checkpoints));
+	if(c == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	c->out.allocator = strm->allocator;
+	c->initLnCount = (Index*) EXIP_ALLOCATE(strm->allocator, sizeof(Index)*(uriTable->count + 1));
+	c->initPfxCount = (SmallIndex*) EXIP_ALLOCATE(strm->allocator, sizeof(SmallIndex)*(uriTable->count + 1));
+	c->out.buf = (unsigned char*) EXIP_ALLOCATE(strm->allocator, CHECKPOINT_CHUNK_SIZE);
+	c->out.size = CHECKPOINT_CHUNK_SIZE;
+	c->out.len = 0;
+	if(c->initLnCount == NULL || c->initPfxCount == NULL || c->out.buf == NULL)
+	{
+		destroyCheckpoints(c);
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	}
+
+	c->initUriCount = uriTable->count;
+	for(i = 0; i < uriTable->count; i++)
+	{
+		c->initLnCount[i] = uriTable->uri[i].lnTable.count;
+		if(uriTable->uri[i].pfxTable == NULL)
+			c->initPfxCount[i] = SMALL_INDEX_MAX;
+		else
+			c->initPfxCount[i] = uriTable->uri[i].pfxTable->count;
+	}
+
+	c->sideCar = sideCar;
+	c->byteInterval = byteInterval;
+	c->elementInterval = elementInterval;
+	c->elements = 0;
+	c->lastPosition = STREAM_POSITION(strm);
+	c->lastElements = 0;
+
+	*cp = c;
+	return EXIP_OK;
+}
+
+/** Writes the string table entries added after the checkpoints are started */
+static errorCode encodeUriTable(Checkpoints* cp, UriTable* uriTable)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	CheckpointBytes* b = &cp->out;
+	UriEntry* uri;
+	Index lnFirst;
+	SmallIndex pfxFirst;
+	SmallIndex i;
+	Index j;
+
+	TRY(writeUInt(b, cp->initUriCount));
+	TRY(writeUInt(b, uriTable->count));
+	for(i = 0; i < uriTable->count; i++)
+	{
+		uri = &uriTable->uri[i];
+		lnFirst = 0;
+		pfxFirst = 0;
+		if(i < cp->initUriCount)
+		{
+			lnFirst = cp->initLnCount[i];
+			if(cp->initPfxCount[i] != SMALL_INDEX_MAX)
+				pfxFirst = cp->initPfxCount[i];
+		}
+		else
+		{
+			TRY(writeString(b, &uri->uriStr));
+		}
+
+		TRY(writeUInt(b, lnFirst));
+		TRY(writeUInt(b, uri->lnTable.count - lnFirst));
+		for(j = lnFirst; j < uri->lnTable.count; j++)
+		{
+			TRY(writeString(b, &uri->lnTable.ln[j].lnStr));
+		}
+
+		if(uri->pfxTable == NULL)
+		{
+			TRY(writeUInt(b, 0));
+		}
+		else
+		{
+			TRY(writeUInt(b, 1));
+			TRY(writeUInt(b, pfxFirst));
+			TRY(writeUInt(b, uri->pfxTable->count - pfxFirst));
+			for(j = pfxFirst; j < uri->pfxTable->count; j++)
+			{
+				TRY(writeString(b, &uri->pfxTable->pfxStr[j]));
+			}
+		}
+	}
+
+	return EXIP_OK;
+}
+
+/** Writes the built-in element grammars and the local names they are assigned to */
+static errorCode encodeGrammars(CheckpointBytes* b, EXIPSchema* schema)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	UriTable* uriTable = &schema->uriTable;
+	SmallIndex i;
+	Index j;
+
+#if BUILD_IN_GRAMMARS_USE
+	{
+		EXIGrammar* grammar;
+		DynGrammarRule* rule;
+		Index g;
+		Index p;
+
+		TRY(writeUInt(b, schema->grammarTable.count - schema->staticGrCount));
+		for(g = schema->staticGrCount; g < schema->grammarTable.count; g++)
+		{
+			grammar = &schema->grammarTable.grammar[g];
+			TRY(writeUInt(b, grammar->props));
+			TRY(writeUInt(b, grammar->count));
+			for(j = 0; j < grammar->count; j++)
+			{
+				rule = &((DynGrammarRule*) grammar->rule)[j];
+				TRY(writeUInt(b, rule->pCount));
+				TRY(writeUInt(b, rule->meta));
+				for(p = 0; p < rule->pCount; p++)
+				{
+					TRY(writeUInt(b, rule->production[p].content));
+					TRY(writeIndexOrMax(b, rule->production[p].typeId, INDEX_MAX));
+					TRY(writeIndexOrMax(b, rule->production[p].qnameId.uriId, URI_MAX));
+					TRY(writeIndexOrMax(b, rule->production[p].qnameId.lnId, LN_MAX));
+				}
+			}
+		}
+	}
+#else
+	TRY(writeUInt(b, 0));
+#endif
+
+	// The local names with a built-in element grammar, terminated by 0
+	for(i = 0; i < uriTable->count; i++)
+	{
+		for(j = 0; j < uriTable->uri[i].lnTable.count; j++)
+		{
+			Index elemGrammar = uriTable->uri[i].lnTable.ln[j].elemGrammar;
+			if(elemGrammar != INDEX_MAX && elemGrammar >= schema->staticGrCount)
+			{
+				TRY(writeUInt(b, (uint64_t) i + 1));
+				TRY(writeUInt(b, j));
+				TRY(writeUInt(b, elemGrammar));
+			}
+		}
+	}
+
+	return writeUInt(b, 0);
+}
+
+/** Writes the value table and the value cross tables */
+static errorCode encodeValues(CheckpointBytes* b, EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ValueTable* valueTable = &strm->valueTable;
+	Index i;
+
+	TRY(writeUInt(b, valueTable->count));
+	TRY(writeUInt(b, valueTable->count > 0 ? valueTable->globalId : 0));
+	for(i = 0; i < valueTable->count; i++)
+	{
+		TRY(writeString(b, &valueTable->value[i].valueStr));
+#if VALUE_CROSSTABLE_USE
+		TRY(writeUInt(b, valueTable->value[i].locValuePartition.forQNameId.uriId));
+		TRY(writeUInt(b, valueTable->value[i].locValuePartition.forQNameId.lnId));
+		TRY(writeUInt(b, valueTable->value[i].locValuePartition.vxEntryId));
+#endif
+	}
+
+#if VALUE_CROSSTABLE_USE
+	// The local names with a value cross table, terminated by 0
+	{
+		UriTable* uriTable = &strm->schema->uriTable;
+		VxTable* vxTable;
+		SmallIndex u;
+		Index j;
+
+		for(u = 0; u < uriTable->count; u++)
+		{
+			for(j = 0; j < uriTable->uri[u].lnTable.count; j++)
+			{
+				vxTable = uriTable->uri[u].lnTable.ln[j].vxTable;
+				if(vxTable == NULL)
+					continue;
+
+				TRY(writeUInt(b, (uint64_t) u + 1));
+				TRY(writeUInt(b, j));
+				TRY(writeUInt(b, vxTable->count));
+				for(i = 0; i < vxTable->count; i++)
+				{
+					TRY(writeIndexOrMax(b, vxTable->vx[i].globalId, INDEX_MAX));
+				}
+			}
+		}
+		TRY(writeUInt(b, 0));
+	}
+#endif
+
+	return EXIP_OK;
+}
+
+/** Writes the grammar stack from the top */
+static errorCode encodeGrammarStack(CheckpointBytes* b, EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	SchemaGrammarTable* grammarTable = &strm->schema->grammarTable;
+	EXIGrammarStack* node;
+	Index depth = 0;
+	uint64_t code;
+
+	for(node = strm->gStack; node != NULL; node = node->nextInStack)
+		depth++;
+
+	TRY(writeUInt(b, depth));
+	for(node = strm->gStack; node != NULL; node = node->nextInStack)
+	{
+		if(node->grammar == &strm->schema->docGrammar)
+			code = CHECKPOINT_DOC_GRAMMAR;
+		else if(node->grammar == NULL)
+			code = CHECKPOINT_NO_GRAMMAR;
+		else if(node->grammar >= grammarTable->grammar && node->grammar < grammarTable->grammar + grammarTable->count)
+			code = (uint64_t) (node->grammar - grammarTable->grammar) + CHECKPOINT_GRAMMAR_INDEX;
+		else
+			return EXIP_NOT_IMPLEMENTED_YET;
+
+		TRY(writeUInt(b, code));
+		TRY(writeIndexOrMax(b, node->currNonTermID, GR_VOID_NON_TERMINAL));
+		TRY(writeIndexOrMax(b, node->currQNameID.uriId, URI_MAX));
+		TRY(writeIndexOrMax(b, node->currQNameID.lnId, LN_MAX));
+	}
+
+	return EXIP_OK;
+}
+
+static errorCode encodeCheckpoint(Checkpoints* cp, EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	CheckpointBytes* b = &cp->out;
+	EXIOptions* opts = &strm->header.opts;
+	Index length;
+	unsigned char flags = 0;
+
+#if VALUE_CROSSTABLE_USE
+	flags = flags | CHECKPOINT_FLAG_CROSSTABLE;
+#endif
+
+	// The length of the checkpoint is set at the end
+	b->len = CHECKPOINT_LENGTH_SIZE;
+	TRY(reserveBytes(b, sizeof(CHECKPOINT_MAGIC)));
+	memcpy(b->buf + b->len, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	b->len += sizeof(CHECKPOINT_MAGIC);
+	TRY(writeUInt(b, CHECKPOINT_VERSION));
+
+	TRY(writeUInt(b, STREAM_POSITION(strm)));
+	TRY(writeUInt(b, strm->context.bitPointer));
+	TRY(writeUInt(b, cp->elements));
+
+	TRY(writeUInt(b, opts->enumOpt));
+	TRY(writeUInt(b, opts->preserve));
+	TRY(writeIndexOrMax(b, opts->valueMaxLength, INDEX_MAX));
+	TRY(writeIndexOrMax(b, opts->valuePartitionCapacity, INDEX_MAX));
+	TRY(writeUInt(b, flags));
+	TRY(writeUInt(b, strm->schema->staticGrCount));
+
+	TRY(writeIndexOrMax(b, strm->context.currAttr.uriId, URI_MAX));
+	TRY(writeIndexOrMax(b, strm->context.currAttr.lnId, LN_MAX));
+	TRY(writeUInt(b, strm->context.expectATData));
+	TRY(writeUInt(b, strm->context.isNilType));
+	TRY(writeIndexOrMax(b, strm->context.attrTypeId, INDEX_MAX));
+
+	TRY(encodeUriTable(cp, &strm->schema->uriTable));
+	TRY(encodeGrammars(b, strm->schema));
+	TRY(encodeValues(b, strm));
+	TRY(encodeGrammarStack(b, strm));
+
+	length = b->len - CHECKPOINT_LENGTH_SIZE;
+	if((uint64_t) length > CHECKPOINT_MAX_SIZE)
+		return EXIP_OUT_OF_BOUND_BUFFER;
+	b->buf[0] = (unsigned char) (length >> 24);
+	b->buf[1] = (unsigned char) (length >> 16);
+	b->buf[2] = (unsigned char) (length >> 8);
+	b->buf[3] = (unsigned char) length;
+
+	return EXIP_OK;
+}
+
+errorCode writeDueCheckpoint(Checkpoints* cp, EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Index position = STREAM_POSITION(strm);
+
+	// The state of the document is set aside inside SC elements: the next
+	// checkpoint is written after the end of the outermost one
+	if(isInSelfContained(strm))
+		return EXIP_OK;
+
+	if(!(cp->byteInterval > 0 && position - cp->lastPosition >= cp->byteInterval) &&
+			!(cp->elementInterval > 0 && cp->elements - cp->lastElements >= cp->elementInterval))
+		return EXIP_OK;
+
+	TRY(encodeCheckpoint(cp, strm));
+	if(cp->sideCar.readWriteToStream(cp->out.buf, cp->out.len, cp->sideCar.stream) < cp->out.len)
+		return EXIP_UNEXPECTED_ERROR;
+
+	cp->lastPosition = position;
+	cp->lastElements = cp->elements;
+
+	return EXIP_OK;
+}
+
+void countCheckpointElement(Checkpoints* cp)
+{
+	cp->elements++;
+}
+
+/** Reads the start of a checkpoint up to the options */
+static errorCode readCheckpointStart(CheckpointReader* r, Index* position, unsigned char* bitPointer, Index* elements)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	uint64_t tmp;
+
+	if(r->size < sizeof(CHECKPOINT_MAGIC) || memcmp(r->buf, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0)
+		return EXIP_INVALID_EXI_INPUT;
+	r->pos = sizeof(CHECKPOINT_MAGIC);
+
+	TRY(readUInt(r, &tmp));
+	if(tmp != CHECKPOINT_VERSION)
+		return EXIP_NOT_IMPLEMENTED_YET;
+
+	TRY(readIndex(r, position));
+	TRY(readBounded(r, 7, &tmp));
+	*bitPointer = (unsigned char) tmp;
+	TRY(readIndex(r, elements));
+
+	return EXIP_OK;
+}
+
+errorCode readCheckpointPosition(const char* checkpoint, Index size, Index* byteOffset, Index* elementCount)
+{
+	CheckpointReader r;
+	unsigned char bitPointer;
+
+	r.buf = (const unsigned char*) checkpoint;
+	r.size = size;
+	r.pos = 0;
+
+	return readCheckpointStart(&r, byteOffset, &bitPointer, elementCount);
+}
+
+/** Reads the options of the stream and checks them against the ones of strm */
+static errorCode readOptions(CheckpointReader* r, EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	EXIOptions* opts = &strm->header.opts;
+	uint64_t enumOpt;
+	uint64_t preserve;
+	uint64_t valueMaxLength;
+	uint64_t valuePartitionCapacity;
+	uint64_t flags;
+	uint64_t staticGrCount;
+
+	TRY(readUInt(r, &enumOpt));
+	TRY(readUInt(r, &preserve));
+	TRY(readIndexOrMax(r, INDEX_MAX, &valueMaxLength));
+	TRY(readIndexOrMax(r, INDEX_MAX, &valuePartitionCapacity));
+	TRY(readUInt(r, &flags));
+	TRY(readUInt(r, &staticGrCount));
+
+	if(enumOpt != opts->enumOpt || preserve != opts->preserve ||
+			valueMaxLength != opts->valueMaxLength || valuePartitionCapacity != opts->valuePartitionCapacity)
+		return EXIP_HEADER_OPTIONS_MISMATCH;
+
+#if VALUE_CROSSTABLE_USE
+	if(flags != CHECKPOINT_FLAG_CROSSTABLE)
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+#else
+	if(flags != 0)
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+#endif
+
+	if(staticGrCount != strm->schema->staticGrCount)
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	return EXIP_OK;
+}
+
+static errorCode readUriTable(CheckpointReader* r, EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	UriTable* uriTable = &strm->schema->uriTable;
+	PfxTable* pfxTable;
+	SmallIndex initUriCount;
+	SmallIndex uriCount;
+	SmallIndex i;
+	SmallIndex pfxId;
+	Index lnFirst;
+	Index count;
+	Index j;
+	Index lnId;
+	uint64_t hasPfx;
+	String str;
+
+	TRY(readSmallIndex(r, &initUriCount));
+	TRY(readSmallIndex(r, &uriCount));
+	if(initUriCount != uriTable->count || uriCount < initUriCount)
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	for(i = 0; i < uriCount; i++)
+	{
+		if(i >= initUriCount)
+		{
+			TRY(readString(r, &str, &strm->memList));
+			TRY(addUriEntry(uriTable, str, &pfxId));
+		}
+
+		TRY(readIndex(r, &lnFirst));
+		if(lnFirst != uriTable->uri[i].lnTable.count)
+			return EXIP_INCONSISTENT_PROC_STATE;
+		TRY(readIndex(r, &count));
+		for(j = 0; j < count; j++)
+		{
+			TRY(readString(r, &str, &strm->memList));
+			TRY(addLnEntry(&uriTable->uri[i].lnTable, str, &lnId));
+		}
+
+		TRY(readBounded(r, 1, &hasPfx));
+		if(hasPfx)
+		{
+			TRY(readSmallIndex(r, &pfxId));
+			if(uriTable->uri[i].pfxTable == NULL)
+			{
+				if(pfxId != 0)
+					return EXIP_INCONSISTENT_PROC_STATE;
+				TRY(createPfxTable(&uriTable->uri[i].pfxTable, uriTable->dynArray.allocator));
+			}
+			pfxTable = uriTable->uri[i].pfxTable;
+			if(pfxId != pfxTable->count)
+				return EXIP_INCONSISTENT_PROC_STATE;
+
+			TRY(readIndex(r, &count));
+			for(j = 0; j < count; j++)
+			{
+				TRY(readString(r, &str, &strm->memList));
+				TRY(addPfxEntry(pfxTable, str, &pfxId));
+			}
+		}
+	}
+
+	return EXIP_OK;
+}
+
+/** Reads a local name entry given by its URI partition plus one; NULL at the end of the list */
+static errorCode readLnEntry(CheckpointReader* r, UriTable* uriTable, LnEntry** lnEntry)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	uint64_t uriId;
+	Index lnId;
+
+	*lnEntry = NULL;
+	TRY(readBounded(r, uriTable->count, &uriId));
+	if(uriId == 0)
+		return EXIP_OK;
+
+	TRY(readIndex(r, &lnId));
+	if(lnId >= uriTable->uri[uriId - 1].lnTable.count)
+		return EXIP_INVALID_EXI_INPUT;
+
+	*lnEntry = &uriTable->uri[uriId - 1].lnTable.ln[lnId];
+	return EXIP_OK;
+}
+
+static errorCode readGrammars(CheckpointReader* r, EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	SchemaGrammarTable* grammarTable = &strm->schema->grammarTable;
+	LnEntry* lnEntry;
+	Index elemGrammar;
+	Index count;
+	Index g;
+
+	TRY(readIndex(r, &count));
+#if BUILD_IN_GRAMMARS_USE
+	for(g = 0; g < count; g++)
+	{
+		EXIGrammar grammar;
+		DynGrammarRule* rule;
+		Index grIndx;
+		Index j;
+		Index p;
+		uint64_t tmp;
+
+		TRY(readBounded(r, UINT32_MAX, &tmp));
+		grammar.props = (uint32_t) tmp;
+		TRY(readSmallIndex(r, &grammar.count));
+		if(grammar.count == 0)
+			return EXIP_INVALID_EXI_INPUT;
+
+		// The rules are freed by freeAllMem() once the grammar is in the table
+		grammar.rule = (GrammarRule*) EXIP_ALLOCATE(strm->allocator, sizeof(DynGrammarRule)*grammar.count);
+		if(grammar.rule == NULL)
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		for(j = 0; j < grammar.count; j++)
+			((DynGrammarRule*) grammar.rule)[j].production = NULL;
+
+		tmp_err_code = addDynEntry(&grammarTable->dynArray, &grammar, &grIndx);
+		if(tmp_err_code != EXIP_OK)
+		{
+			EXIP_RELEASE(strm->allocator, grammar.rule);
+			return tmp_err_code;
+		}
+
+		for(j = 0; j < grammar.count; j++)
+		{
+			rule = &((DynGrammarRule*) grammar.rule)[j];
+			TRY(readIndex(r, &rule->pCount));
+			TRY(readBounded(r, UINT16_MAX, &tmp));
+			rule->meta = (uint16_t) tmp;
+			if(rule->pCount > (r->size - r->pos)/4)
+				return EXIP_INVALID_EXI_INPUT;
+
+			rule->prodDim = rule->pCount + DEFAULT_PROD_ARRAY_DIM;
+			rule->production = (Production*) EXIP_ALLOCATE(strm->allocator, sizeof(Production)*rule->prodDim);
+			if(rule->production == NULL)
+				return EXIP_MEMORY_ALLOCATION_ERROR;
+
+			for(p = 0; p < rule->pCount; p++)
+			{
+				TRY(readBounded(r, UINT32_MAX, &tmp));
+				rule->production[p].content = (uint32_t) tmp;
+				TRY(readIndexOrMax(r, INDEX_MAX, &tmp));
+				rule->production[p].typeId = (Index) tmp;
+				TRY(readIndexOrMax(r, URI_MAX, &tmp));
+				rule->production[p].qnameId.uriId = (SmallIndex) tmp;
+				TRY(readIndexOrMax(r, LN_MAX, &tmp));
+				rule->production[p].qnameId.lnId = (Index) tmp;
+			}
+		}
+	}
+#else
+	if(count > 0)
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+#endif
+
+	while(TRUE)
+	{
+		TRY(readLnEntry(r, &strm->schema->uriTable, &lnEntry));
+		if(lnEntry == NULL)
+			break;
+
+		TRY(readIndex(r, &elemGrammar));
+#if EXI_PROFILE_DEFAULT
+		if(elemGrammar == EXI_PROFILE_STUB_GRAMMAR_INDX)
+		{
+			lnEntry->elemGrammar = elemGrammar;
+			continue;
+		}
+#endif
+		if(elemGrammar < strm->schema->staticGrCount || elemGrammar >= grammarTable->count)
+			return EXIP_INVALID_EXI_INPUT;
+		lnEntry->elemGrammar = elemGrammar;
+	}
+
+	return EXIP_OK;
+}
+
+static errorCode readValues(CheckpointReader* r, EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ValueTable* valueTable = &strm->valueTable;
+	ValueEntry* valueEntry;
+	Index count;
+	Index globalId;
+	Index i;
+	Index valueEntryId;
+
+	TRY(readIndex(r, &count));
+	TRY(readIndex(r, &globalId));
+	if(count > 0 && (valueTable->value == NULL || count > strm->header.opts.valuePartitionCapacity ||
+			globalId >= strm->header.opts.valuePartitionCapacity || globalId > count))
+		return EXIP_INVALID_EXI_INPUT;
+	// Every value takes at least a byte
+	if(count > r->size - r->pos)
+		return EXIP_INVALID_EXI_INPUT;
+	if(count > 0)
+		TRY(reserveDynArray(&valueTable->dynArray, valueTable->count + count));
+
+	for(i = 0; i < count; i++)
+	{
+		TRY(addEmptyDynEntry(&valueTable->dynArray, (void**)&valueEntry, &valueEntryId));
+		valueEntry->valueStr.str = NULL;
+		valueEntry->valueStr.length = 0;
+		TRY(readValueString(r, strm, &valueEntry->valueStr));
+#if VALUE_CROSSTABLE_USE
+		TRY(readSmallIndex(r, &valueEntry->locValuePartition.forQNameId.uriId));
+		TRY(readIndex(r, &valueEntry->locValuePartition.forQNameId.lnId));
+		TRY(readIndex(r, &valueEntry->locValuePartition.vxEntryId));
+		if(valueEntry->locValuePartition.forQNameId.uriId >= strm->schema->uriTable.count ||
+				valueEntry->locValuePartition.forQNameId.lnId >= strm->schema->uriTable.uri[valueEntry->locValuePartition.forQNameId.uriId].lnTable.count)
+			return EXIP_INVALID_EXI_INPUT;
+#endif
+	}
+	valueTable->globalId = globalId;
+
+#if VALUE_CROSSTABLE_USE
+	while(TRUE)
+	{
+		LnEntry* lnEntry;
+		VxEntry vxEntry;
+		Index vxEntryId;
+		uint64_t tmp;
+
+		TRY(readLnEntry(r, &strm->schema->uriTable, &lnEntry));
+		if(lnEntry == NULL)
+			break;
+		if(lnEntry->vxTable != NULL)
+			return EXIP_INVALID_EXI_INPUT;
+
+		lnEntry->vxTable = memManagedAllocate(&strm->memList, sizeof(VxTable));
+		if(lnEntry->vxTable == NULL)
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		TRY(createVxTable(lnEntry->vxTable, strm->allocator));
+
+		TRY(readIndex(r, &count));
+		if(count > r->size - r->pos)
+			return EXIP_INVALID_EXI_INPUT;
+		TRY(reserveDynArray(&lnEntry->vxTable->dynArray, count));
+		for(i = 0; i < count; i++)
+		{
+			TRY(readIndexOrMax(r, INDEX_MAX, &tmp));
+			if(tmp != INDEX_MAX && tmp >= valueTable->count)
+				return EXIP_INVALID_EXI_INPUT;
+			vxEntry.globalId = (Index) tmp;
+			TRY(addDynEntry(&lnEntry->vxTable->dynArray, &vxEntry, &vxEntryId));
+		}
+	}
+#endif
+
+	return EXIP_OK;
+}
+
+/**
+ * Reads the grammar stack from the top in place of the one of the stream.
+ * The nodes are pushed first so they are taken from the node pool of the stream.
+ */
+static errorCode readGrammarStack(CheckpointReader* r, EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	SchemaGrammarTable* grammarTable = &strm->schema->grammarTable;
+	QNameID emptyQNameID = {URI_MAX, LN_MAX};
+	EXIGrammarStack* node;
+	Index depth;
+	Index i;
+	uint64_t code;
+	uint64_t tmp;
+
+	TRY(readIndex(r, &depth));
+	// Every node takes at least a byte
+	if(depth == 0 || depth > r->size - r->pos)
+		return EXIP_INVALID_EXI_INPUT;
+
+	while(strm->gStack != NULL)
+		popGrammar(strm);
+	for(i = 0; i < depth; i++)
+		TRY(pushGrammar(strm, emptyQNameID, NULL));
+
+	for(node = strm->gStack; node != NULL; node = node->nextInStack)
+	{
+		TRY(readBounded(r, (uint64_t) grammarTable->count + CHECKPOINT_GRAMMAR_INDEX - 1, &code));
+		if(code == CHECKPOINT_DOC_GRAMMAR)
+			node->grammar = &strm->schema->docGrammar;
+		else if(code == CHECKPOINT_NO_GRAMMAR)
+			node->grammar = NULL;
+		else
+			node->grammar = &grammarTable->grammar[code - CHECKPOINT_GRAMMAR_INDEX];
+
+		TRY(readIndexOrMax(r, GR_VOID_NON_TERMINAL, &tmp));
+		if(node->grammar != NULL && tmp != GR_VOID_NON_TERMINAL && tmp >= node->grammar->count)
+			return EXIP_INVALID_EXI_INPUT;
+		node->currNonTermID = (SmallIndex) tmp;
+		TRY(readIndexOrMax(r, URI_MAX, &tmp));
+		node->currQNameID.uriId = (SmallIndex) tmp;
+		TRY(readIndexOrMax(r, LN_MAX, &tmp));
+		node->currQNameID.lnId = (Index) tmp;
+	}
+
+	return EXIP_OK;
+}
+
+errorCode restoreStreamCheckpoint(EXIStream* strm, Checkpoints* cp, const char* checkpoint, Index size)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	CheckpointReader r;
+	StreamContext context = strm->context;
+	Index position;
+	Index elements;
+	uint64_t tmp;
+
+	if(IS_CHANNELLED(strm))
+		return EXIP_NOT_IMPLEMENTED_YET;
+	// The read-ahead blocks are not dropped; enable it after the restore
+	if(IS_READ_AHEAD(strm) || strm->schema == NULL || !isInitialState(strm))
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	r.buf = (const unsigned char*) checkpoint;
+	r.size = size;
+	r.pos = 0;
+
+	TRY(readCheckpointStart(&r, &position, &context.bitPointer, &elements));
+	if(strm->bufferMapped && position >= strm->buffer.bufContent)
+		return EXIP_INVALID_EXI_INPUT;
+	TRY(readOptions(&r, strm));
+
+	TRY(readIndexOrMax(&r, URI_MAX, &tmp));
+	context.currAttr.uriId = (SmallIndex) tmp;
+	TRY(readIndexOrMax(&r, LN_MAX, &tmp));
+	context.currAttr.lnId = (Index) tmp;
+	TRY(readBounded(&r, UINT_MAX, &tmp));
+	context.expectATData = (unsigned int) tmp;
+	TRY(readBounded(&r, 1, &tmp));
+	context.isNilType = (boolean) tmp;
+	TRY(readIndexOrMax(&r, INDEX_MAX, &tmp));
+	context.attrTypeId = (Index) tmp;
+
+	// From here on a failure leaves the tables half restored; the parser is to be destroyed
+	TRY(readUriTable(&r, strm));
+	TRY(readGrammars(&r, strm));
+	TRY(readValues(&r, strm));
+	TRY(readGrammarStack(&r, strm));
+	strm->context = context;
+
+	if(cp != NULL)
+	{
+		cp->elements = elements;
+		cp->lastElements = elements;
+		cp->lastPosition = position;
+	}
+
+	return seekEXIStream(strm, position);
+}
+
+void destroyCheckpoints(Checkpoints* cp)
+{
+	const EXIPAllocator* allocator = cp->out.allocator;
+
+	EXIP_RELEASE(allocator, cp->initLnCount);
+	EXIP_RELEASE(allocator, cp->initPfxCount);
+	EXIP_RELEASE(allocator, cp->out.buf);
+	EXIP_RELEASE(allocator, cp);
+}
@@ -0,0 +1,364 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file eventBuffer.c
+ * @brief Implementation of the recording of parsed EXI events
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "eventBuffer.h"
+#include "dynamicArray.h"
+#include "memManagement.h"
+
+#define DEFAULT_RECORDED_EVENTS_NUMBER 256
+
+static errorCode rec_startDocument(void* app_data);
+static errorCode rec_endDocument(void* app_data);
+static errorCode rec_startElement(QName qname, void* app_data);
+static errorCode rec_endElement(void* app_data);
+static errorCode rec_attribute(QName qname, void* app_data);
+static errorCode rec_intData(Integer int_val, void* app_data);
+static errorCode rec_booleanData(boolean bool_val, void* app_data);
+static errorCode rec_stringData(const String str_val, void* app_data);
+static errorCode rec_floatData(Float float_val, void* app_data);
+static errorCode rec_binaryData(const char* binary_val, Index nbytes, void* app_data);
+static errorCode rec_dateTimeData(EXIPDateTime dt_val, void* app_data);
+static errorCode rec_decimalData(Decimal dec_val, void* app_data);
+static errorCode rec_listData(EXITypeClass exiType, unsigned int itemCount, void* app_data);
+static errorCode rec_qnameData(const QName qname, void* app_data);
+static errorCode rec_processingInstruction(void* app_data);
+static errorCode rec_namespaceDeclaration(const String ns, const String prefix, boolean isLocalElementNS, void* app_data);
+static errorCode rec_selfContained(void* app_data);
+
+errorCode createEventBuffer(EventBuffer* evBuf, const EXIPAllocator* allocator)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	TRY(createDynArray(&evBuf->dynArray, sizeof(RecordedEvent), DEFAULT_RECORDED_EVENTS_NUMBER, allocator));
+	TRY_CATCH(initAllocList(&evBuf->memList, allocator), destroyDynArray(&evBuf->dynArray); evBuf->event = NULL);
+
+	return EXIP_OK;
+}
+
+errorCode clearEventBuffer(EventBuffer* evBuf)
+{
+	evBuf->count = 0;
+	resetAllocList(&evBuf->memList);
+	return EXIP_OK;
+}
+
+void destroyEventBuffer(EventBuffer* evBuf)
+{
+	destroyDynArray(&evBuf->dynArray);
+	freeAllocList(&evBuf->memList);
+}
+
+errorCode addRecordedEvent(EventBuffer* evBuf, unsigned char type, RecordedEvent** event)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Index entryID;
+
+	TRY(addEmptyDynEntry(&evBuf->dynArray, (void**) event, &entryID));
+	(*event)->type = type;
+
+	return EXIP_OK;
+}
+
+void setRecordingHandler(ContentHandler* handler)
+{
+	initContentHandler(handler);
+	handler->startDocument = rec_startDocument;
+	handler->endDocument = rec_endDocument;
+	handler->startElement = rec_startElement;
+	handler->endElement = rec_endElement;
+	handler->attribute = rec_attribute;
+	handler->intData = rec_intData;
+	handler->booleanData = rec_booleanData;
+	handler->stringData = rec_stringData;
+	handler->floatData = rec_floatData;
+	handler->binaryData = rec_binaryData;
+	handler->dateTimeData = rec_dateTimeData;
+	handler->decimalData = rec_decimalData;
+	handler->listData = rec_listData;
+	handler->qnameData = rec_qnameData;
+	handler->processingInstruction = rec_processingInstruction;
+	handler->namespaceDeclaration = rec_namespaceDeclaration;
+	handler->selfContained = rec_selfContained;
+}
+
+errorCode replayRecordedEvent(const RecordedEvent* event, ContentHandler* handler, void* app_data)
+{
+	QName qname;
+
+	switch(event->type)
+	{
+		case RECORDED_START_DOCUMENT:
+			if(handler->startDocument != NULL)
+				return handler->startDocument(app_data);
+		break;
+		case RECORDED_END_DOCUMENT:
+			if(handler->endDocument != NULL)
+				return handler->endDocument(app_data);
+		break;
+		case RECORDED_START_ELEMENT:
+		case RECORDED_ATTRIBUTE:
+		case RECORDED_QNAME_DATA:
+			qname.uri = &event->data.qname.uri;
+			qname.localName = &event->data.qname.localName;
+			qname.prefix = event->data.qname.hasPrefix ? &event->data.qname.prefix : NULL;
+
+			if(event->type == RECORDED_START_ELEMENT && handler->startElement != NULL)
+				return handler->startElement(qname, app_data);
+			else if(event->type == RECORDED_ATTRIBUTE && handler->attribute != NULL)
+				return handler->attribute(qname, app_data);
+			else if(event->type == RECORDED_QNAME_DATA && handler->qnameData != NULL)
+				return handler->qnameData(qname, app_data);
+		break;
+		case RECORDED_END_ELEMENT:
+			if(handler->endElement != NULL)
+				return handler->endElement(app_data);
+		break;
+		case RECORDED_INT_DATA:
+			if(handler->intData != NULL)
+				return handler->intData(event->data.intVal, app_data);
+		break;
+		case RECORDED_BOOLEAN_DATA:
+			if(handler->booleanData != NULL)
+				return handler->booleanData(event->data.boolVal, app_data);
+		break;
+		case RECORDED_STRING_DATA:
+			if(handler->stringData != NULL)
+				return handler->stringData(event->data.strVal, app_data);
+		break;
+		case RECORDED_FLOAT_DATA:
+			if(handler->floatData != NULL)
+				return handler->floatData(event->data.floatVal, app_data);
+		break;
+		case RECORDED_BINARY_DATA:
+			if(handler->binaryData != NULL)
+				return handler->binaryData(event->data.binaryVal.val, event->data.binaryVal.nbytes, app_data);
+		break;
+		case RECORDED_DATE_TIME_DATA:
+			if(handler->dateTimeData != NULL)
+				return handler->dateTimeData(event->data.dtVal, app_data);
+		break;
+		case RECORDED_DECIMAL_DATA:
+			if(handler->decimalData != NULL)
+				return handler->decimalData(event->data.decVal, app_data);
+		break;
+		case RECORDED_LIST_DATA:
+			if(handler->listData != NULL)
+				return handler->listData(event->data.list.exiType, event->data.list.itemCount, app_data);
+		break;
+		case RECORDED_PI:
+			if(handler->processingInstruction != NULL)
+				return handler->processingInstruction(app_data);
+		break;
+		case RECORDED_NS_DECLARATION:
+			if(handler->namespaceDeclaration != NULL)
+				return handler->namespaceDeclaration(event->data.ns.ns, event->data.ns.prefix, event->data.ns.isLocalElementNS, app_data);
+		break;
+		case RECORDED_SELF_CONTAINED:
+			if(handler->selfContained != NULL)
+				return handler->selfContained(app_data);
+		break;
+	}
+
+	return EXIP_OK;
+}
+
+/** Copies the characters of str to the memory of the buffer */
+static errorCode copyRecordedString(EventBuffer* evBuf, const String* str, String* copy)
+{
+	copy->length = str->length;
+	copy->str = NULL;
+	if(str->length > 0)
+	{
+		copy->str = memManagedAllocate(&evBuf->memList, sizeof(CharType)*str->length);
+		if(copy->str == NULL)
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		memcpy(copy->str, str->str, sizeof(CharType)*str->length);
+	}
+
+	return EXIP_OK;
+}
+
+static errorCode recordQName(unsigned char type, const QName* qname, EventBuffer* evBuf)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent(evBuf, type, &event));
+	event->data.qname.uri = *qname->uri;
+	event->data.qname.localName = *qname->localName;
+	event->data.qname.hasPrefix = qname->prefix != NULL;
+	if(qname->prefix != NULL)
+		event->data.qname.prefix = *qname->prefix;
+
+	return EXIP_OK;
+}
+
+static errorCode recordEvent(unsigned char type, EventBuffer* evBuf)
+{
+	RecordedEvent* event;
+	return addRecordedEvent(evBuf, type, &event);
+}
+
+static errorCode rec_startDocument(void* app_data)
+{
+	return recordEvent(RECORDED_START_DOCUMENT, (EventBuffer*) app_data);
+}
+
+static errorCode rec_endDocument(void* app_data)
+{
+	return recordEvent(RECORDED_END_DOCUMENT, (EventBuffer*) app_data);
+}
+
+static errorCode rec_startElement(QName qname, void* app_data)
+{
+	return recordQName(RECORDED_START_ELEMENT, &qname, (EventBuffer*) app_data);
+}
+
+static errorCode rec_endElement(void* app_data)
+{
+	return recordEvent(RECORDED_END_ELEMENT, (EventBuffer*) app_data);
+}
+
+static errorCode rec_attribute(QName qname, void* app_data)
+{
+	return recordQName(RECORDED_ATTRIBUTE, &qname, (EventBuffer*) app_data);
+}
+
+static errorCode rec_intData(Integer int_val, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent((EventBuffer*) app_data, RECORDED_INT_DATA, &event));
+	event->data.intVal = int_val;
+
+	return EXIP_OK;
+}
+
+static errorCode rec_booleanData(boolean bool_val, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent((EventBuffer*) app_data, RECORDED_BOOLEAN_DATA, &event));
+	event->data.boolVal = bool_val;
+
+	return EXIP_OK;
+}
+
+static errorCode rec_stringData(const String str_val, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	EventBuffer* evBuf = (EventBuffer*) app_data;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent(evBuf, RECORDED_STRING_DATA, &event));
+	return copyRecordedString(evBuf, &str_val, &event->data.strVal);
+}
+
+static errorCode rec_floatData(Float float_val, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent((EventBuffer*) app_data, RECORDED_FLOAT_DATA, &event));
+	event->data.floatVal = float_val;
+
+	return EXIP_OK;
+}
+
+static errorCode rec_binaryData(const char* binary_val, Index nbytes, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	EventBuffer* evBuf = (EventBuffer*) app_data;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent(evBuf, RECORDED_BINARY_DATA, &event));
+	event->data.binaryVal.nbytes = nbytes;
+	event->data.binaryVal.val = NULL;
+	if(nbytes > 0)
+	{
+		event->data.binaryVal.val = memManagedAllocate(&evBuf->memList, nbytes);
+		if(event->data.binaryVal.val == NULL)
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		memcpy(event->data.binaryVal.val, binary_val, nbytes);
+	}
+
+	return EXIP_OK;
+}
+
+static errorCode rec_dateTimeData(EXIPDateTime dt_val, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent((EventBuffer*) app_data, RECORDED_DATE_TIME_DATA, &event));
+	event->data.dtVal = dt_val;
+
+	return EXIP_OK;
+}
+
+static errorCode rec_decimalData(Decimal dec_val, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent((EventBuffer*) app_data, RECORDED_DECIMAL_DATA, &event));
+	event->data.decVal = dec_val;
+
+	return EXIP_OK;
+}
+
+static errorCode rec_listData(EXITypeClass exiType, unsigned int itemCount, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent((EventBuffer*) app_data, RECORDED_LIST_DATA, &event));
+	event->data.list.exiType = exiType;
+	event->data.list.itemCount = itemCount;
+
+	return EXIP_OK;
+}
+
+static errorCode rec_qnameData(const QName qname, void* app_data)
+{
+	return recordQName(RECORDED_QNAME_DATA, &qname, (EventBuffer*) app_data);
+}
+
+static errorCode rec_processingInstruction(void* app_data)
+{
+	return recordEvent(RECORDED_PI, (EventBuffer*) app_data);
+}
+
+static errorCode rec_namespaceDeclaration(const String ns, const String prefix, boolean isLocalElementNS, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	RecordedEvent* event;
+
+	TRY(addRecordedEvent((EventBuffer*) app_data, RECORDED_NS_DECLARATION, &event));
+	event->data.ns.ns = ns;
+	event->data.ns.prefix = prefix;
+	event->data.ns.isLocalElementNS = isLocalElementNS;
+
+	return EXIP_OK;
+}
+
+static errorCode rec_selfContained(void* app_data)
+{
+	return recordEvent(RECORDED_SELF_CONTAINED, (EventBuffer*) app_data);
+}
@@ -0,0 +1,210 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file eventPipeline.c
+ * @brief Implementation of the pipelined parsing using POSIX threads
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "eventPipeline.h"
+
+#if EXIP_PIPELINE == ON
+
+#include <pthread.h>
+#include "spscQueue.h"
+
+/**
+ * The batches are passed between the parser and the consumer thread through
+ * two lock-free queues: the recorded batches in the order of parsing and the
+ * free ones. A thread only blocks when its queue is empty, i.e. when the
+ * consumer has caught up or all batches are waiting to be dispatched.
+ */
+struct EventPipeline
+{
+	pthread_t consumer;
+	ContentHandler recorder;
+	ContentHandler* handler;
+	void* app_data;
+	unsigned int batchCount;
+	/** All batches; the ones created are freed by destroyEventPipeline() */
+	EventBuffer* batches;
+	/** The batch being recorded by the parser */
+	EventBuffer* current;
+	/** Written by the consumer in the order of parsing; NULL stops the consumer */
+	SPSCQueue ready;
+	/** Dispatched batches given back to the parser */
+	SPSCQueue freeBatches;
+	/** The first error returned by the handler; the events after it are discarded */
+	errorCode handlerError;
+	/** Set by destroyEventPipeline() */
+	boolean stopping;
+};
+
+static void* pipelineWorker(void* arg)
+{
+	EventPipeline* pl = (EventPipeline*) arg;
+	errorCode tmp_err_code;
+	EventBuffer* batch;
+	void* item;
+	Index i;
+
+	while(TRUE)
+	{
+		waitSPSCQueue(&pl->ready, 1);
+		popSPSCQueue(&pl->ready, &item);
+		if(item == NULL || EXIP_ATOMIC_LOAD(&pl->stopping))
+			break;
+
+		batch = (EventBuffer*) item;
+		tmp_err_code = pl->handlerError;
+		for(i = 0; i < batch->count && tmp_err_code == EXIP_OK; i++)
+			tmp_err_code = replayRecordedEvent(&batch->event[i], pl->handler, pl->app_data);
+		if(tmp_err_code == EXIP_OK)
+			tmp_err_code = clearEventBuffer(batch);
+		else
+			clearEventBuffer(batch);
+
+		if(pl->handlerError == EXIP_OK)
+			EXIP_ATOMIC_STORE(&pl->handlerError, tmp_err_code);
+		pushSPSCQueue(&pl->freeBatches, batch);
+	}
+
+	return NULL;
+}
+
+static void freeEventPipeline(EventPipeline* pl, unsigned int created)
+{
+	unsigned int i;
+
+	if(pl->batches != NULL)
+	{
+		for(i = 0; i < created; i++)
+			destroyEventBuffer(&pl->batches[i]);
+		EXIP_MFREE(pl->batches);
+	}
+	EXIP_MFREE(pl);
+}
+
+errorCode createEventPipeline(EventPipeline** pipeline, unsigned int batchCount, ContentHandler* handler, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	EventPipeline* pl;
+	unsigned int i;
+
+	if(batchCount < 2)
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+
+	pl = (EventPipeline*) EXIP_MALLOC(sizeof(EventPipeline));
+	if(pl == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	pl->batches = (EventBuffer*) EXIP_MALLOC(sizeof(EventBuffer)*batchCount);
+	if(pl->batches == NULL)
+	{
+		freeEventPipeline(pl, 0);
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	}
+
+	setRecordingHandler(&pl->recorder);
+	pl->handler = handler;
+	pl->app_data = app_data;
+	pl->batchCount = batchCount;
+	// The first batch is the current one
+	pl->current = &pl->batches[0];
+	pl->handlerError = EXIP_OK;
+	pl->stopping = FALSE;
+
+	for(i = 0; i < batchCount; i++)
+	{
+		if(createEventBuffer(&pl->batches[i], NULL) != EXIP_OK)
+		{
+			freeEventPipeline(pl, i);
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		}
+	}
+
+	// All batches but the current one and the NULL that stops the consumer
+	tmp_err_code = createSPSCQueue(&pl->ready, batchCount);
+	if(tmp_err_code != EXIP_OK)
+	{
+		freeEventPipeline(pl, batchCount);
+		return tmp_err_code;
+	}
+	// All batches are free while the parser passes on the current one
+	tmp_err_code = createSPSCQueue(&pl->freeBatches, batchCount);
+	if(tmp_err_code != EXIP_OK)
+	{
+		destroySPSCQueue(&pl->ready);
+		freeEventPipeline(pl, batchCount);
+		return tmp_err_code;
+	}
+
+	for(i = 1; i < batchCount; i++)
+		pushSPSCQueue(&pl->freeBatches, &pl->batches[i]);
+
+	if(pthread_create(&pl->consumer, NULL, pipelineWorker, pl) != 0)
+	{
+		destroySPSCQueue(&pl->freeBatches);
+		destroySPSCQueue(&pl->ready);
+		freeEventPipeline(pl, batchCount);
+		return EXIP_UNEXPECTED_ERROR;
+	}
+
+	*pipeline = pl;
+	return EXIP_OK;
+}
+
+EventBuffer* getPipelineBatch(EventPipeline* pipeline)
+{
+	return pipeline->current;
+}
+
+ContentHandler* getPipelineRecorder(EventPipeline* pipeline)
+{
+	return &pipeline->recorder;
+}
+
+errorCode submitPipelineBatch(EventPipeline* pipeline, boolean drain)
+{
+	void* item;
+
+	if(!drain && pipeline->current->count < PIPELINE_BATCH_EVENTS)
+		return EXIP_OK;
+
+	if(pipeline->current->count > 0)
+	{
+		pushSPSCQueue(&pipeline->ready, pipeline->current);
+		waitSPSCQueue(&pipeline->freeBatches, 1);
+		popSPSCQueue(&pipeline->freeBatches, &item);
+		pipeline->current = (EventBuffer*) item;
+	}
+
+	// All batches but the current one are dispatched once they are free
+	if(drain)
+		waitSPSCQueue(&pipeline->freeBatches, pipeline->batchCount - 1);
+
+	return EXIP_ATOMIC_LOAD(&pipeline->handlerError);
+}
+
+void destroyEventPipeline(EventPipeline* pipeline)
+{
+	EXIP_ATOMIC_STORE(&pipeline->stopping, TRUE);
+	pushSPSCQueue(&pipeline->ready, NULL);
+
+	pthread_join(pipeline->consumer, NULL);
+	destroySPSCQueue(&pipeline->freeBatches);
+	destroySPSCQueue(&pipeline->ready);
+
+	freeEventPipeline(pipeline, pipeline->batchCount);
+}
+
+#endif /* EXIP_PIPELINE == ON */
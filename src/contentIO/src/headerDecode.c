@@ -138,7 +138,7 @@ errorCode decodeHeader(EXIStream* strm, boolean outOfBandOpts)
 		Parser optionsParser;
 		struct ops_AppData appD;
 
-		TRY(initParser(&optionsParser, strm->buffer, &appD));
+		TRY(initParserAllocator(&optionsParser, strm->buffer, &appD, strm->allocator));
 
 		optionsParser.strm.context.bitPointer = strm->context.bitPointer;
 		optionsParser.strm.context.bufferIndx = strm->context.bufferIndx;
@@ -165,18 +165,27 @@ errorCode decodeHeader(EXIStream* strm, boolean outOfBandOpts)
 		appD.permanentAllocList = &strm->memList;
 
 		TRY_CATCH(setSchema(&optionsParser, (EXIPSchema*) &ops_schema), destroyParser(&optionsParser));
-		TRY_CATCH(createValueTable(&optionsParser.strm.valueTable), destroyParser(&optionsParser));
+		TRY_CATCH(createValueTable(&optionsParser.strm.valueTable, optionsParser.strm.allocator), destroyParser(&optionsParser));
+
+#if EXIP_READ_AHEAD == ON
+		// The options document is read through the blocks of the EXI stream
+		optionsParser.strm.readAhead = strm->readAhead;
+#endif
 
 		while(tmp_err_code == EXIP_OK)
 		{
 			tmp_err_code = parseNext(&optionsParser);
 		}
 
+#if EXIP_READ_AHEAD == ON
+		optionsParser.strm.readAhead = NULL;
+#endif
 		destroyParser(&optionsParser);
 
 		if(tmp_err_code != EXIP_PARSING_COMPLETE)
 			return tmp_err_code;
 
+		strm->buffer.buf = optionsParser.strm.buffer.buf;
 		strm->buffer.bufContent = optionsParser.strm.buffer.bufContent;
 		strm->context.bitPointer = optionsParser.strm.context.bitPointer;
 		strm->context.bufferIndx = optionsParser.strm.context.bufferIndx;
@@ -25,6 +25,7 @@
 #include "bodyEncode.h"
 #include "ioUtil.h"
 #include "streamEncode.h"
+#include "valueChannels.h"
 
 /** This is the statically generated EXIP schema definition for the EXI Options document*/
 extern const EXIPSchema ops_schema;
@@ -73,23 +74,39 @@ errorCode encodeHeader(EXIStream* strm)
 
 		makeDefaultOpts(&options_strm.header.opts);
 		SET_STRICT(options_strm.header.opts.enumOpt);
-		TRY(initAllocList(&options_strm.memList));
+		options_strm.allocator = strm->allocator;
+		TRY(initAllocList(&options_strm.memList, options_strm.allocator));
 
 		options_strm.buffer = strm->buffer;
+		options_strm.bufferMapped = FALSE;
 		options_strm.context.bitPointer = strm->context.bitPointer;
 		options_strm.context.bufferIndx = strm->context.bufferIndx;
+		options_strm.context.bufferOffset = 0;
 		options_strm.context.currAttr.lnId = LN_MAX;
 		options_strm.context.currAttr.uriId = URI_MAX;
 		options_strm.context.expectATData = FALSE;
 		options_strm.context.isNilType = FALSE;
 		options_strm.context.attrTypeId = 0;
 		options_strm.gStack = NULL;
+		options_strm.gStackPool.freeNode = NULL;
+		options_strm.gStackPool.block = NULL;
 		options_strm.schema = (EXIPSchema*) &ops_schema;
-
-		TRY_CATCH(createValueTable(&options_strm.valueTable), closeOptionsStream(&options_strm));
-		TRY_CATCH(pushGrammar(&options_strm.gStack, emptyQnameID, (EXIGrammar*) &ops_schema.docGrammar), closeOptionsStream(&options_strm));
+		options_strm.scratch.buf = NULL;
+		options_strm.scratch.bufLen = 0;
+		options_strm.channels = NULL;
+		options_strm.sc = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+		options_strm.asyncOutput = strm->asyncOutput;
+#endif
+#if EXIP_READ_AHEAD == ON
+		options_strm.readAhead = NULL;
+#endif
+
+		TRY_CATCH(createValueTable(&options_strm.valueTable, options_strm.allocator), closeOptionsStream(&options_strm));
+		TRY_CATCH(pushGrammar(&options_strm, emptyQnameID, (EXIGrammar*) &ops_schema.docGrammar), closeOptionsStream(&options_strm));
 		TRY_CATCH(serializeOptionsStream(&options_strm, &strm->header.opts, &strm->schema->uriTable), closeOptionsStream(&options_strm));
 
+		strm->buffer.buf = options_strm.buffer.buf;
 		strm->buffer.bufContent = options_strm.buffer.bufContent;
 		strm->context.bitPointer = options_strm.context.bitPointer;
 		strm->context.bufferIndx = options_strm.context.bufferIndx;
@@ -108,6 +125,12 @@ errorCode encodeHeader(EXIStream* strm)
 		closeOptionsStream(&options_strm);
 	}
 
+	if(WITH_CHANNELS(strm->header.opts.enumOpt))
+	{
+		// The structure and the values of the body are written in blocks
+		TRY(initEncodeChannels(strm));
+	}
+
 	return EXIP_OK;
 }
 
@@ -115,7 +138,7 @@ static void closeOptionsStream(EXIStream* strm)
 {
 	while(strm->gStack != NULL)
 	{
-		popGrammar(&strm->gStack);
+		popGrammar(strm);
 	}
 	freeAllMem(strm);
 }
@@ -31,11 +31,12 @@
 # define DEFAULT_ENUM_TABLE              5
 #endif
 
-errorCode initSchema(EXIPSchema* schema, InitSchemaType initializationType)
+errorCode initSchema(EXIPSchema* schema, InitSchemaType initializationType, const EXIPAllocator* allocator)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 
-	TRY(initAllocList(&schema->memList));
+	schema->allocator = allocator;
+	TRY(initAllocList(&schema->memList, allocator));
 
 	schema->staticGrCount = 0;
 	SET_CONTENT_INDEX(schema->docGrammar.props, 0);
@@ -50,22 +51,25 @@ errorCode initSchema(EXIPSchema* schema, InitSchemaType initializationType)
 	schema->enumTable.enumDef = NULL;
 
 	/* Create and initialize initial string table entries */
-	TRY_CATCH(createDynArray(&schema->uriTable.dynArray, sizeof(UriEntry), DEFAULT_URI_ENTRIES_NUMBER), freeAllocList(&schema->memList));
+	TRY_CATCH(createDynArray(&schema->uriTable.dynArray, sizeof(UriEntry), DEFAULT_URI_ENTRIES_NUMBER, allocator), freeAllocList(&schema->memList));
+#if HASH_TABLE_USE
+	schema->uriTable.hashTbl = NULL;
+#endif
 	TRY_CATCH(createUriTableEntries(&schema->uriTable, initializationType != INIT_SCHEMA_SCHEMA_LESS_MODE), freeAllocList(&schema->memList));
 
 	if(initializationType == INIT_SCHEMA_SCHEMA_ENABLED)
 	{
 		/* Create and initialize enumDef table */
-		TRY_CATCH(createDynArray(&schema->enumTable.dynArray, sizeof(EnumDefinition), DEFAULT_ENUM_TABLE), freeAllocList(&schema->memList));
+		TRY_CATCH(createDynArray(&schema->enumTable.dynArray, sizeof(EnumDefinition), DEFAULT_ENUM_TABLE, allocator), freeAllocList(&schema->memList));
 	}
 
 	/* Create the schema grammar table */
-	TRY_CATCH(createDynArray(&schema->grammarTable.dynArray, sizeof(EXIGrammar), DEFAULT_GRAMMAR_TABLE), freeAllocList(&schema->memList));
+	TRY_CATCH(createDynArray(&schema->grammarTable.dynArray, sizeof(EXIGrammar), DEFAULT_GRAMMAR_TABLE, allocator), freeAllocList(&schema->memList));
 
 	if(initializationType != INIT_SCHEMA_SCHEMA_LESS_MODE)
 	{
 		/* Create and initialize simple type table */
-		TRY_CATCH(createDynArray(&schema->simpleTypeTable.dynArray, sizeof(SimpleType), DEFAULT_SIMPLE_GRAMMAR_TABLE), freeAllocList(&schema->memList));
+		TRY_CATCH(createDynArray(&schema->simpleTypeTable.dynArray, sizeof(SimpleType), DEFAULT_SIMPLE_GRAMMAR_TABLE, allocator), freeAllocList(&schema->memList));
 		TRY_CATCH(createBuiltInTypesDefinitions(&schema->simpleTypeTable, &schema->memList), freeAllocList(&schema->memList));
 
 		// Must be done after createBuiltInTypesDefinitions()
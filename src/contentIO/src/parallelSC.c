@@ -0,0 +1,307 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file parallelSC.c
+ * @brief Parsing of the self-contained elements of an EXI stream by
+ * worker threads using POSIX threads
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "EXIParser.h"
+
+#if EXIP_PARALLEL_SC == ON
+
+#include <pthread.h>
+#include "eventBuffer.h"
+#include "sTables.h"
+
+#define SLOT_FREE    0
+#define SLOT_PARSING 1
+#define SLOT_PARSED  2
+
+/**
+ * An element being parsed or waiting to be passed to the handler. The
+ * recorded qnames point into the string tables of the parser so it is
+ * destroyed only after the events are passed on.
+ */
+struct SCSlot
+{
+	unsigned char state;
+	/** The index of the element in the offsets */
+	Index element;
+	Parser parser;
+	boolean parserCreated;
+	EventBuffer events;
+	errorCode err;
+};
+
+/**
+ * The elements are parsed in the order of offsets; element i uses the
+ * slot i % slotCount so at most slotCount elements are parsed ahead of
+ * the ones passed to the handler.
+ */
+struct ParallelSC
+{
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	const char* data;
+	Index size;
+	const Index* offsets;
+	Index count;
+	/** The header decoded by the calling thread; only read by the workers */
+	const EXIheader* header;
+	struct SCSlot* slots;
+	unsigned int slotCount;
+	/** The next element to be parsed */
+	Index next;
+	/** Set when the parsing is stopped because of an error */
+	boolean stopping;
+};
+
+/** Parses the element at offset into the events of the slot */
+static errorCode parseSlot(struct ParallelSC* pc, struct SCSlot* slot, Index offset)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	TRY(initParserMapped(&slot->parser, pc->data, pc->size, &slot->events));
+	slot->parserCreated = TRUE;
+
+	// The options document of the header is parsed with the static schema of
+	// the EXI options, which is written by every parser; it is decoded only
+	// once and the workers take a copy. The self-contained streams are not
+	// compressed so there are no channels to set up.
+	slot->parser.strm.header = *pc->header;
+	if(slot->parser.strm.header.opts.valuePartitionCapacity > 0)
+	{
+		TRY(createValueTable(&slot->parser.strm.valueTable, slot->parser.strm.allocator));
+	}
+	TRY(setSchema(&slot->parser, NULL));
+	setRecordingHandler(&slot->parser.handler);
+	TRY(seekSelfContained(&slot->parser, offset));
+
+	while(tmp_err_code == EXIP_OK)
+	{
+		tmp_err_code = parseNext(&slot->parser);
+	}
+
+	if(tmp_err_code == EXIP_PARSING_COMPLETE)
+		return EXIP_OK;
+
+	return tmp_err_code;
+}
+
+static void* parallelWorker(void* arg)
+{
+	struct ParallelSC* pc = (struct ParallelSC*) arg;
+	struct SCSlot* slot;
+	Index element;
+	errorCode tmp_err_code;
+
+	pthread_mutex_lock(&pc->lock);
+	while(TRUE)
+	{
+		while(!pc->stopping && pc->next < pc->count && pc->slots[pc->next % pc->slotCount].state != SLOT_FREE)
+			pthread_cond_wait(&pc->cond, &pc->lock);
+
+		if(pc->stopping || pc->next >= pc->count)
+			break;
+
+		element = pc->next;
+		pc->next++;
+		slot = &pc->slots[element % pc->slotCount];
+		slot->state = SLOT_PARSING;
+		slot->element = element;
+		pthread_mutex_unlock(&pc->lock);
+
+		tmp_err_code = parseSlot(pc, slot, pc->offsets[element]);
+
+		pthread_mutex_lock(&pc->lock);
+		slot->err = tmp_err_code;
+		slot->state = SLOT_PARSED;
+		pthread_cond_broadcast(&pc->cond);
+	}
+	pthread_mutex_unlock(&pc->lock);
+
+	return NULL;
+}
+
+/** Passes the events of a parsed slot to the handler and frees the slot */
+static errorCode dispatchSlot(struct SCSlot* slot, ContentHandler* handler, void** app_data)
+{
+	errorCode tmp_err_code = slot->err;
+	void* elementData = app_data != NULL ? app_data[slot->element] : NULL;
+	Index i;
+
+	for(i = 0; i < slot->events.count && tmp_err_code == EXIP_OK; i++)
+		tmp_err_code = replayRecordedEvent(&slot->events.event[i], handler, elementData);
+
+	if(slot->parserCreated)
+	{
+		destroyParser(&slot->parser);
+		slot->parserCreated = FALSE;
+	}
+	if(tmp_err_code == EXIP_OK)
+		tmp_err_code = clearEventBuffer(&slot->events);
+	else
+		clearEventBuffer(&slot->events);
+
+	return tmp_err_code;
+}
+
+errorCode parseSelfContainedParallel(const char* data, Index size, const Index* offsets, Index count,
+		unsigned int threadCount, boolean ordered, ContentHandler* handler, void** app_data)
+{
+	errorCode tmp_err_code = EXIP_OK;
+	struct ParallelSC pc;
+	Parser headerParser;
+	pthread_t* workers;
+	unsigned int created = 0;
+	unsigned int slotsCreated = 0;
+	Index dispatched = 0;
+	struct SCSlot* slot;
+	unsigned int i;
+
+	if(threadCount == 0)
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+	if(count == 0)
+		return EXIP_OK;
+
+	// The options of the header may point into the memory of headerParser,
+	// so it is destroyed after the workers are joined
+	TRY(initParserMapped(&headerParser, data, size, NULL));
+	TRY_CATCH(parseHeader(&headerParser, FALSE), destroyParser(&headerParser));
+	// The parsers of the workers would share the string tables and the
+	// grammars of a schema; only the built-in types are created per parser
+	if(headerParser.strm.header.opts.schemaIDMode == SCHEMA_ID_SET)
+	{
+		destroyParser(&headerParser);
+		return EXIP_NOT_IMPLEMENTED_YET;
+	}
+
+	pc.data = data;
+	pc.size = size;
+	pc.offsets = offsets;
+	pc.count = count;
+	pc.header = &headerParser.strm.header;
+	pc.slotCount = 2*threadCount;
+	pc.next = 0;
+	pc.stopping = FALSE;
+
+	pc.slots = (struct SCSlot*) EXIP_MALLOC(sizeof(struct SCSlot)*pc.slotCount);
+	workers = (pthread_t*) EXIP_MALLOC(sizeof(pthread_t)*threadCount);
+	if(pc.slots == NULL || workers == NULL)
+	{
+		EXIP_MFREE(pc.slots);
+		EXIP_MFREE(workers);
+		destroyParser(&headerParser);
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	}
+
+	for(i = 0; i < pc.slotCount && tmp_err_code == EXIP_OK; i++)
+	{
+		pc.slots[i].state = SLOT_FREE;
+		pc.slots[i].parserCreated = FALSE;
+		tmp_err_code = createEventBuffer(&pc.slots[i].events, NULL);
+		if(tmp_err_code == EXIP_OK)
+			slotsCreated++;
+	}
+
+	if(tmp_err_code == EXIP_OK)
+	{
+		if(pthread_mutex_init(&pc.lock, NULL) != 0)
+			tmp_err_code = EXIP_UNEXPECTED_ERROR;
+		else if(pthread_cond_init(&pc.cond, NULL) != 0)
+		{
+			pthread_mutex_destroy(&pc.lock);
+			tmp_err_code = EXIP_UNEXPECTED_ERROR;
+		}
+	}
+
+	if(tmp_err_code != EXIP_OK)
+	{
+		for(i = 0; i < slotsCreated; i++)
+			destroyEventBuffer(&pc.slots[i].events);
+		EXIP_MFREE(pc.slots);
+		EXIP_MFREE(workers);
+		destroyParser(&headerParser);
+		return tmp_err_code;
+	}
+
+	for(i = 0; i < threadCount; i++)
+	{
+		if(pthread_create(&workers[i], NULL, parallelWorker, &pc) != 0)
+		{
+			tmp_err_code = EXIP_UNEXPECTED_ERROR;
+			break;
+		}
+		created++;
+	}
+
+	pthread_mutex_lock(&pc.lock);
+	while(created > 0 && tmp_err_code == EXIP_OK && dispatched < count)
+	{
+		slot = NULL;
+		if(ordered)
+		{
+			if(pc.slots[dispatched % pc.slotCount].state == SLOT_PARSED &&
+					pc.slots[dispatched % pc.slotCount].element == dispatched)
+				slot = &pc.slots[dispatched % pc.slotCount];
+		}
+		else
+		{
+			for(i = 0; i < pc.slotCount && slot == NULL; i++)
+			{
+				if(pc.slots[i].state == SLOT_PARSED)
+					slot = &pc.slots[i];
+			}
+		}
+
+		if(slot == NULL)
+		{
+			pthread_cond_wait(&pc.cond, &pc.lock);
+			continue;
+		}
+
+		// The slot is not touched by the workers until it is free
+		pthread_mutex_unlock(&pc.lock);
+		tmp_err_code = dispatchSlot(slot, handler, app_data);
+		pthread_mutex_lock(&pc.lock);
+
+		slot->state = SLOT_FREE;
+		dispatched++;
+		pthread_cond_broadcast(&pc.cond);
+	}
+	pc.stopping = TRUE;
+	pthread_cond_broadcast(&pc.cond);
+	pthread_mutex_unlock(&pc.lock);
+
+	for(i = 0; i < created; i++)
+		pthread_join(workers[i], NULL);
+
+	// The elements parsed after an error
+	for(i = 0; i < pc.slotCount; i++)
+	{
+		if(pc.slots[i].parserCreated)
+			destroyParser(&pc.slots[i].parser);
+		destroyEventBuffer(&pc.slots[i].events);
+	}
+
+	pthread_cond_destroy(&pc.cond);
+	pthread_mutex_destroy(&pc.lock);
+	EXIP_MFREE(pc.slots);
+	EXIP_MFREE(workers);
+	destroyParser(&headerParser);
+
+	return tmp_err_code;
+}
+
+#endif /* EXIP_PARALLEL_SC == ON */
@@ -0,0 +1,367 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file selfContained.c
+ * @brief Implementation of the processing of self-contained elements
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "selfContained.h"
+#include "grammars.h"
+#include "sTables.h"
+#include "dynamicArray.h"
+#include "memManagement.h"
+#include "hashtable.h"
+#include "stringManipulate.h"
+
+/**
+ * The state of the document enclosing an SC element. The entries added
+ * to the string tables after the start of the body are hidden from the
+ * SC fragment by decreasing the counts of the tables. As the fragment
+ * adds its own entries over them, the hidden entries are copied here.
+ */
+struct SCSnapshot
+{
+	/** The grammar stack of the enclosing document */
+	EXIGrammarStack* gStack;
+	/** The number of grammars; the ones added by the fragment are freed */
+	Index grammarCount;
+	SmallIndex uriCount;
+	/** The URI partitions [0, uriCount) */
+	UriEntry* uri;
+	/** The local names of each initial URI partition */
+	LnEntry** ln;
+	/** The prefixes of each initial URI partition that has a prefix table */
+	PfxTable* pfx;
+	ValueTable valueTable;
+	/** The offset of the first byte of the fragment in a parsed stream */
+	Index offset;
+	/** The snapshot of the enclosing SC element; NULL if none */
+	struct SCSnapshot* prev;
+};
+
+typedef struct SCSnapshot SCSnapshot;
+
+struct SelfContained
+{
+	/** The number of URI partitions at the start of the body */
+	SmallIndex initUriCount;
+	/** The number of local names of each initial URI partition */
+	Index* initLnCount;
+	/** The number of prefixes of each initial URI partition; SMALL_INDEX_MAX if it has no prefix table */
+	SmallIndex* initPfxCount;
+	/** The fragment grammar of the SC elements; NULL until the first SC element */
+	EXIGrammar* fragment;
+	EXIGrammar fragmentGrammar;
+	/** The snapshot of the innermost SC element being processed; NULL if none */
+	SCSnapshot* top;
+};
+
+static void freeSnapshot(SCSnapshot* snap, SmallIndex initUriCount, const EXIPAllocator* allocator)
+{
+	SmallIndex i;
+
+	if(snap->ln != NULL)
+	{
+		for(i = 0; i < initUriCount; i++)
+			EXIP_RELEASE(allocator, snap->ln[i]);
+		EXIP_RELEASE(allocator, snap->ln);
+	}
+	EXIP_RELEASE(allocator, snap->uri);
+	EXIP_RELEASE(allocator, snap->pfx);
+	EXIP_RELEASE(allocator, snap);
+}
+
+/** Frees the string table entries and the grammars added by the SC fragment */
+static void freeFragmentState(EXIStream* strm, SCSnapshot* snap)
+{
+	UriTable* uriTable = &strm->schema->uriTable;
+	SmallIndex i;
+
+	destroyValueTable(&strm->valueTable);
+#if HASH_TABLE_USE
+	destroyStringTableIndex(uriTable);
+#endif
+
+	for(i = 0; i < uriTable->count; i++)
+	{
+#if VALUE_CROSSTABLE_USE
+		Index j;
+		for(j = 0; j < uriTable->uri[i].lnTable.count; j++)
+		{
+			if(uriTable->uri[i].lnTable.ln[j].vxTable != NULL)
+				destroyVxTable(uriTable->uri[i].lnTable.ln[j].vxTable);
+		}
+#endif
+		if(i >= strm->sc->initUriCount)
+		{
+			destroyDynArray(&uriTable->uri[i].lnTable.dynArray);
+			if(uriTable->uri[i].pfxTable != NULL)
+				EXIP_RELEASE(uriTable->dynArray.allocator, uriTable->uri[i].pfxTable);
+		}
+		else if(uriTable->uri[i].pfxTable != NULL && uriTable->uri[i].pfxTable != snap->uri[i].pfxTable)
+			EXIP_RELEASE(uriTable->dynArray.allocator, uriTable->uri[i].pfxTable);
+	}
+
+#if BUILD_IN_GRAMMARS_USE
+	{
+		Index g;
+		Index r;
+		DynGrammarRule* tmp_rule;
+
+		for(g = snap->grammarCount; g < strm->schema->grammarTable.count; g++)
+		{
+			for(r = 0; r < strm->schema->grammarTable.grammar[g].count; r++)
+			{
+				tmp_rule = &((DynGrammarRule*) strm->schema->grammarTable.grammar[g].rule)[r];
+				if(tmp_rule->production != NULL)
+					EXIP_RELEASE(strm->allocator, tmp_rule->production);
+			}
+			EXIP_RELEASE(strm->allocator, strm->schema->grammarTable.grammar[g].rule);
+		}
+		strm->schema->grammarTable.count = snap->grammarCount;
+	}
+#endif
+}
+
+/** Restores the state of the document enclosing the innermost SC element */
+static void restoreSnapshot(EXIStream* strm)
+{
+	SCSnapshot* snap = strm->sc->top;
+	UriTable* uriTable = &strm->schema->uriTable;
+	SmallIndex i;
+
+	freeFragmentState(strm, snap);
+
+	for(i = 0; i < snap->uriCount; i++)
+	{
+		if(i < strm->sc->initUriCount)
+		{
+			uriTable->uri[i].pfxTable = snap->uri[i].pfxTable;
+			if(uriTable->uri[i].pfxTable != NULL)
+				*uriTable->uri[i].pfxTable = snap->pfx[i];
+
+			// The array might be moved but not shrunk by the fragment
+			memcpy(uriTable->uri[i].lnTable.ln, snap->ln[i], sizeof(LnEntry)*snap->uri[i].lnTable.count);
+			uriTable->uri[i].lnTable.count = snap->uri[i].lnTable.count;
+		}
+		else
+			uriTable->uri[i] = snap->uri[i];
+	}
+	uriTable->count = snap->uriCount;
+	strm->valueTable = snap->valueTable;
+	strm->gStack = snap->gStack;
+
+	strm->sc->top = snap->prev;
+	freeSnapshot(snap, strm->sc->initUriCount, strm->allocator);
+}
+
+errorCode initSelfContained(EXIStream* strm)
+{
+	SelfContained* sc;
+	SmallIndex i;
+
+	sc = (SelfContained*) memManagedAllocate(&strm->memList, sizeof(SelfContained));
+	if(sc == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	sc->initUriCount = strm->schema->uriTable.count;
+	sc->initLnCount = (Index*) memManagedAllocate(&strm->memList, sizeof(Index)*sc->initUriCount);
+	sc->initPfxCount = (SmallIndex*) memManagedAllocate(&strm->memList, sizeof(SmallIndex)*sc->initUriCount);
+	if(sc->initLnCount == NULL || sc->initPfxCount == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	for(i = 0; i < sc->initUriCount; i++)
+	{
+		sc->initLnCount[i] = strm->schema->uriTable.uri[i].lnTable.count;
+		if(strm->schema->uriTable.uri[i].pfxTable != NULL)
+			sc->initPfxCount[i] = strm->schema->uriTable.uri[i].pfxTable->count;
+		else
+			sc->initPfxCount[i] = SMALL_INDEX_MAX;
+	}
+
+	sc->fragment = NULL;
+	sc->top = NULL;
+	strm->sc = sc;
+
+	return EXIP_OK;
+}
+
+errorCode startSelfContained(EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	SelfContained* sc = strm->sc;
+	UriTable* uriTable = &strm->schema->uriTable;
+	SCSnapshot* snap;
+	SmallIndex i;
+	Index j;
+
+#if BUILD_IN_GRAMMARS_USE
+	if(sc == NULL)
+		return EXIP_NOT_IMPLEMENTED_YET;
+#else
+	return EXIP_NOT_IMPLEMENTED_YET;
+#endif
+
+	if(sc->fragment == NULL)
+	{
+		if(WITH_FRAGMENT(strm->header.opts.enumOpt))
+			sc->fragment = &strm->schema->docGrammar;
+		else
+		{
+			// The schema is owned by the stream so its document grammar
+			// can be replaced while the fragment grammar is created
+			EXIGrammar docGrammar = strm->schema->docGrammar;
+
+			tmp_err_code = createFragmentGrammar(strm->schema, NULL, 0);
+			sc->fragmentGrammar = strm->schema->docGrammar;
+			strm->schema->docGrammar = docGrammar;
+			if(tmp_err_code != EXIP_OK)
+				return tmp_err_code;
+			sc->fragment = &sc->fragmentGrammar;
+		}
+	}
+
+	snap = (SCSnapshot*) EXIP_ALLOCATE(strm->allocator, sizeof(SCSnapshot));
+	if(snap == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	snap->offset = strm->context.bufferOffset + strm->context.bufferIndx;
+	snap->uriCount = uriTable->count;
+	snap->grammarCount = strm->schema->grammarTable.count;
+	snap->uri = (UriEntry*) EXIP_ALLOCATE(strm->allocator, sizeof(UriEntry)*uriTable->count);
+	snap->ln = (LnEntry**) EXIP_ALLOCATE(strm->allocator, sizeof(LnEntry*)*sc->initUriCount);
+	snap->pfx = (PfxTable*) EXIP_ALLOCATE(strm->allocator, sizeof(PfxTable)*sc->initUriCount);
+	if(snap->ln != NULL)
+	{
+		for(i = 0; i < sc->initUriCount; i++)
+			snap->ln[i] = NULL;
+	}
+	if(snap->uri == NULL || snap->ln == NULL || snap->pfx == NULL)
+	{
+		freeSnapshot(snap, sc->initUriCount, strm->allocator);
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	}
+
+#if HASH_TABLE_USE
+	// The indexes would hold the entries of both the fragment and the
+	// enclosing document; they are built again on demand
+	destroyStringTableIndex(uriTable);
+#endif
+	memcpy(snap->uri, uriTable->uri, sizeof(UriEntry)*uriTable->count);
+	for(i = 0; i < sc->initUriCount; i++)
+	{
+		snap->ln[i] = (LnEntry*) EXIP_ALLOCATE(strm->allocator, sizeof(LnEntry)*uriTable->uri[i].lnTable.count + 1);
+		if(snap->ln[i] == NULL)
+		{
+			freeSnapshot(snap, sc->initUriCount, strm->allocator);
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		}
+		memcpy(snap->ln[i], uriTable->uri[i].lnTable.ln, sizeof(LnEntry)*uriTable->uri[i].lnTable.count);
+		if(uriTable->uri[i].pfxTable != NULL)
+			snap->pfx[i] = *uriTable->uri[i].pfxTable;
+	}
+
+	snap->valueTable = strm->valueTable;
+	if(snap->valueTable.value != NULL)
+	{
+		tmp_err_code = createValueTable(&strm->valueTable, strm->allocator);
+#if HASH_TABLE_USE
+		if(tmp_err_code == EXIP_OK && snap->valueTable.hashTbl != NULL)
+		{
+			strm->valueTable.hashTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, stringHash, stringEqual, strm->allocator);
+			if(strm->valueTable.hashTbl == NULL)
+			{
+				destroyDynArray(&strm->valueTable.dynArray);
+				tmp_err_code = EXIP_MEMORY_ALLOCATION_ERROR;
+			}
+		}
+#endif
+		if(tmp_err_code != EXIP_OK)
+		{
+			strm->valueTable = snap->valueTable;
+			freeSnapshot(snap, sc->initUriCount, strm->allocator);
+			return tmp_err_code;
+		}
+	}
+	strm->valueTable.count = 0;
+
+	// Reset the string tables and the built-in element grammars
+	for(i = 0; i < sc->initUriCount; i++)
+	{
+		uriTable->uri[i].lnTable.count = sc->initLnCount[i];
+		for(j = 0; j < uriTable->uri[i].lnTable.count; j++)
+		{
+#if VALUE_CROSSTABLE_USE
+			uriTable->uri[i].lnTable.ln[j].vxTable = NULL;
+#endif
+			if(uriTable->uri[i].lnTable.ln[j].elemGrammar != INDEX_MAX &&
+					uriTable->uri[i].lnTable.ln[j].elemGrammar >= strm->schema->staticGrCount)
+				uriTable->uri[i].lnTable.ln[j].elemGrammar = INDEX_MAX;
+		}
+
+		if(sc->initPfxCount[i] == SMALL_INDEX_MAX)
+			uriTable->uri[i].pfxTable = NULL;
+		else
+			uriTable->uri[i].pfxTable->count = sc->initPfxCount[i];
+	}
+	uriTable->count = sc->initUriCount;
+
+	snap->gStack = strm->gStack;
+	snap->prev = sc->top;
+	sc->top = snap;
+
+	strm->gStack = NULL;
+	{
+		QNameID emptyQNameID = {URI_MAX, LN_MAX};
+		TRY(pushGrammar(strm, emptyQNameID, sc->fragment));
+	}
+
+	return EXIP_OK;
+}
+
+boolean isSelfContainedEnd(EXIStream* strm)
+{
+	return strm->sc != NULL && strm->sc->top != NULL &&
+			strm->gStack != NULL && strm->gStack->nextInStack == NULL;
+}
+
+boolean isInSelfContained(EXIStream* strm)
+{
+	return strm->sc != NULL && strm->sc->top != NULL;
+}
+
+errorCode getFragmentOffset(EXIStream* strm, Index* byteOffset)
+{
+	if(!isInSelfContained(strm))
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	*byteOffset = strm->sc->top->offset;
+	return EXIP_OK;
+}
+
+void endSelfContained(EXIStream* strm)
+{
+	while(strm->gStack != NULL)
+		popGrammar(strm);
+
+	restoreSnapshot(strm);
+}
+
+void destroySelfContained(EXIStream* strm)
+{
+	if(strm->sc == NULL)
+		return;
+
+	while(strm->sc->top != NULL)
+		endSelfContained(strm);
+}
@@ -2812,7 +2812,7 @@ static CONST SimpleType ops_simpleTypes[67] =
 
 CONST EXIPSchema ops_schema =
 {
-    {NULL, NULL},
+    {NULL, 0},
     {{sizeof(UriEntry), 5, 5}, ops_uriEntry, 5},
     {ops_docGrammarRule, 100663296, 2},
     {{sizeof(SimpleType), 67, 67}, ops_simpleTypes, 67},
@@ -0,0 +1,991 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file valueChannels.c
+ * @brief Implementation of the structure and value channels of the EXI body
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "valueChannels.h"
+#include "eventBuffer.h"
+#include "bodyEncode.h"
+#include "bodyDecode.h"
+#include "streamEncode.h"
+#include "grammars.h"
+#include "dynamicArray.h"
+#include "memManagement.h"
+#include "ioUtil.h"
+
+#if EXIP_COMPRESSION == ON
+# include <zlib.h>
+#endif
+
+#define DEFAULT_CHANNELS_NUMBER 16
+#define DEFAULT_CHANNEL_VALUES_NUMBER 256
+
+/** The size of the in-memory buffer used while encoding the channels */
+#define CHANNEL_CHUNK_SIZE 512
+
+/** The size of the output of a single call to deflate() */
+#define DEFLATE_CHUNK_SIZE 512
+
+/**
+ * A channel of the current block: the values of an attribute or of
+ * the character data of an element. The values (encoder) or the value
+ * slots (decoder) of a channel are linked through their "next" field.
+ */
+struct Channel
+{
+	QNameID qnameID;
+	Index first;
+	Index last;
+	Index count;
+	/** The end of the encoded channel in valueBytes */
+	Index end;
+};
+
+struct ChannelArray
+{
+	DynArray dynArray;
+	struct Channel* channel;
+	Index count;
+};
+
+struct ChannelValueArray
+{
+	DynArray dynArray;
+	ChannelValue* value;
+	Index count;
+};
+
+/**
+ * The place of a value in the structure of a decoded block and
+ * the recorded events of the value once it is decoded
+ */
+struct ValueSlot
+{
+	QNameID qnameID;
+	Index typeId;
+	Index next;
+	Index firstEvent;
+	Index eventCount;
+};
+
+struct ValueSlotArray
+{
+	DynArray dynArray;
+	struct ValueSlot* slot;
+	Index count;
+};
+
+/** A growing in-memory byte buffer */
+struct ChannelBytes
+{
+	char* buf;
+	Index size;
+	Index len;
+	const EXIPAllocator* allocator;
+};
+
+struct ValueChannels
+{
+	/** The channels of the block in the order of their first value */
+	struct ChannelArray channels;
+	/** The last channel looked up; consecutive values often share it */
+	Index lastChannel;
+	/** Number of values in the block; a list is a single value */
+	Index valueCount;
+
+	/** The application's buffer while strm->buffer is in memory */
+	BinaryBuffer appBuffer;
+	Index appBufferIndx;
+	unsigned char appBitPointer;
+	boolean inMemory;
+#if EXIP_ASYNC_OUTPUT == ON
+	AsyncOutput* asyncOutput;
+#endif
+#if EXIP_READ_AHEAD == ON
+	ReadAhead* readAhead;
+#endif
+
+	// Encoder
+	struct ChannelValueArray values;
+	/** Copies of the string and binary values of the block */
+	AllocList memList;
+	/** The channel of the list value whose items are being added */
+	Index listChannel;
+	unsigned int listItems;
+	struct ChannelBytes structure;
+	struct ChannelBytes valueBytes;
+	char chunk[CHANNEL_CHUNK_SIZE + 1];
+
+	// Decoder
+	/** The structure of the block; the values are RECORDED_PLACEHOLDER events */
+	EventBuffer structureEvents;
+	EventBuffer valueEvents;
+	struct ValueSlotArray slots;
+	/** The next structure event to be passed to the application */
+	Index replayIndx;
+	struct ChannelBytes inflated;
+
+	/** FALSE in pre-compression mode: the channels are not compressed */
+	boolean compressed;
+#if EXIP_COMPRESSION == ON
+	z_stream zStrm;
+	boolean zStrmInit;
+#endif
+	/** TRUE on the decoder side */
+	boolean decoding;
+};
+
+#if EXIP_COMPRESSION == ON
+/** The zlib memory of a stream with an allocator goes through it */
+static voidpf zlibAllocate(voidpf opaque, uInt items, uInt size)
+{
+	const EXIPAllocator* allocator = (const EXIPAllocator*) opaque;
+
+	if(size != 0 && items > ((size_t) -1)/size)
+		return Z_NULL;
+	return allocator->allocate(allocator->context, (size_t) items*size);
+}
+
+static void zlibRelease(voidpf opaque, voidpf address)
+{
+	const EXIPAllocator* allocator = (const EXIPAllocator*) opaque;
+
+	allocator->release(allocator->context, address);
+}
+
+static void setZlibAllocator(z_stream* zStrm, const EXIPAllocator* allocator)
+{
+	if(allocator == NULL)
+	{
+		zStrm->zalloc = Z_NULL;
+		zStrm->zfree = Z_NULL;
+		zStrm->opaque = Z_NULL;
+	}
+	else
+	{
+		zStrm->zalloc = zlibAllocate;
+		zStrm->zfree = zlibRelease;
+		zStrm->opaque = (voidpf) allocator;
+	}
+}
+#endif
+
+static size_t appendChannelBytes(void* buf, size_t size, void* stream)
+{
+	struct ChannelBytes* bytes = (struct ChannelBytes*) stream;
+
+	if(bytes->len + size > bytes->size)
+	{
+		Index newSize = bytes->size == 0 ? CHANNEL_CHUNK_SIZE : bytes->size;
+		char* ptr;
+
+		while(newSize < bytes->len + size)
+			newSize = 2*newSize;
+
+		ptr = EXIP_REALLOCATE(bytes->allocator, bytes->buf, newSize);
+		if(ptr == NULL)
+			return 0;
+		bytes->buf = ptr;
+		bytes->size = newSize;
+	}
+
+	memcpy(bytes->buf + bytes->len, buf, size);
+	bytes->len += size;
+
+	return size;
+}
+
+/** Moves to the next byte boundary; the channels are byte-aligned */
+static void alignChannel(EXIStream* strm)
+{
+	if(strm->context.bitPointer != 0)
+	{
+		strm->context.bitPointer = 0;
+		strm->context.bufferIndx += 1;
+	}
+}
+
+/** Replaces strm->buffer with an in-memory buffer; the background IO is suspended */
+static void useMemoryBuffer(EXIStream* strm, ValueChannels* ch, char* buf, Index bufLen, Index bufContent, struct ChannelBytes* sink)
+{
+	if(!ch->inMemory)
+	{
+		ch->appBuffer = strm->buffer;
+		ch->appBufferIndx = strm->context.bufferIndx;
+		ch->appBitPointer = strm->context.bitPointer;
+#if EXIP_ASYNC_OUTPUT == ON
+		ch->asyncOutput = strm->asyncOutput;
+		strm->asyncOutput = NULL;
+#endif
+#if EXIP_READ_AHEAD == ON
+		ch->readAhead = strm->readAhead;
+		strm->readAhead = NULL;
+#endif
+		ch->inMemory = TRUE;
+	}
+
+	strm->buffer.buf = buf;
+	strm->buffer.bufLen = bufLen;
+	strm->buffer.bufContent = bufContent;
+	strm->buffer.ioStrm.readWriteToStream = sink != NULL ? appendChannelBytes : NULL;
+	strm->buffer.ioStrm.stream = sink;
+	strm->context.bufferIndx = 0;
+	strm->context.bitPointer = 0;
+}
+
+static void useAppBuffer(EXIStream* strm, ValueChannels* ch)
+{
+	if(ch->inMemory)
+	{
+		strm->buffer = ch->appBuffer;
+		strm->context.bufferIndx = ch->appBufferIndx;
+		strm->context.bitPointer = ch->appBitPointer;
+#if EXIP_ASYNC_OUTPUT == ON
+		strm->asyncOutput = ch->asyncOutput;
+#endif
+#if EXIP_READ_AHEAD == ON
+		strm->readAhead = ch->readAhead;
+#endif
+		ch->inMemory = FALSE;
+	}
+}
+
+/** Encodes into chunk and then into sink */
+static void useEncodeBuffer(EXIStream* strm, ValueChannels* ch, struct ChannelBytes* sink)
+{
+	sink->len = 0;
+	useMemoryBuffer(strm, ch, ch->chunk, CHANNEL_CHUNK_SIZE, 0, sink);
+}
+
+/** Moves the encoded bytes (with a padded last byte) from chunk to the sink */
+static errorCode drainEncodeBuffer(EXIStream* strm)
+{
+	alignChannel(strm);
+	if(strm->context.bufferIndx > 0 &&
+			appendChannelBytes(strm->buffer.buf, strm->context.bufferIndx, strm->buffer.ioStrm.stream) == 0)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	strm->context.bufferIndx = 0;
+
+	return EXIP_OK;
+}
+
+static errorCode getChannel(ValueChannels* ch, QNameID qnameID, Index* chID)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	struct Channel* channel;
+	Index i;
+
+	if(ch->lastChannel < ch->channels.count)
+	{
+		channel = &ch->channels.channel[ch->lastChannel];
+		if(channel->qnameID.uriId == qnameID.uriId && channel->qnameID.lnId == qnameID.lnId)
+		{
+			*chID = ch->lastChannel;
+			return EXIP_OK;
+		}
+	}
+
+	for(i = 0; i < ch->channels.count; i++)
+	{
+		channel = &ch->channels.channel[i];
+		if(channel->qnameID.uriId == qnameID.uriId && channel->qnameID.lnId == qnameID.lnId)
+		{
+			ch->lastChannel = i;
+			*chID = i;
+			return EXIP_OK;
+		}
+	}
+
+	TRY(addEmptyDynEntry(&ch->channels.dynArray, (void**) &channel, chID));
+	channel->qnameID = qnameID;
+	channel->first = INDEX_MAX;
+	channel->last = INDEX_MAX;
+	channel->count = 0;
+	channel->end = 0;
+	ch->lastChannel = *chID;
+
+	return EXIP_OK;
+}
+
+static errorCode createValueChannels(EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ValueChannels* ch;
+
+#if EXIP_COMPRESSION == OFF
+	if(WITH_COMPRESSION(strm->header.opts.enumOpt))
+	{
+		DEBUG_MSG(ERROR, DEBUG_CONTENT_IO, ("\n> Compression requires a build with EXIP_COMPRESSION"));
+		return EXIP_NOT_IMPLEMENTED_YET;
+	}
+#endif
+
+	ch = (ValueChannels*) EXIP_ALLOCATE(strm->allocator, sizeof(ValueChannels));
+	if(ch == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	ch->lastChannel = INDEX_MAX;
+	ch->valueCount = 0;
+	ch->inMemory = FALSE;
+	ch->listChannel = INDEX_MAX;
+	ch->listItems = 0;
+	ch->structure.buf = NULL;
+	ch->structure.size = 0;
+	ch->structure.len = 0;
+	ch->structure.allocator = strm->allocator;
+	ch->valueBytes = ch->structure;
+	ch->inflated = ch->structure;
+	ch->replayIndx = 0;
+	ch->values.dynArray.chunkEntries = 0;
+	ch->values.value = NULL;
+	ch->structureEvents.event = NULL;
+	ch->valueEvents.event = NULL;
+	ch->slots.slot = NULL;
+#if EXIP_COMPRESSION == ON
+	ch->zStrmInit = FALSE;
+#endif
+	ch->compressed = WITH_COMPRESSION(strm->header.opts.enumOpt);
+	ch->decoding = FALSE;
+
+	if(createDynArray(&ch->channels.dynArray, sizeof(struct Channel), DEFAULT_CHANNELS_NUMBER, strm->allocator) != EXIP_OK)
+	{
+		EXIP_RELEASE(strm->allocator, ch);
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	}
+	TRY_CATCH(initAllocList(&ch->memList, strm->allocator), destroyDynArray(&ch->channels.dynArray); EXIP_RELEASE(strm->allocator, ch));
+
+	strm->channels = ch;
+
+	return EXIP_OK;
+}
+
+void destroyValueChannels(EXIStream* strm)
+{
+	ValueChannels* ch = strm->channels;
+
+	useAppBuffer(strm, ch);
+
+	destroyDynArray(&ch->channels.dynArray);
+	freeAllocList(&ch->memList);
+	if(ch->values.value != NULL)
+		destroyDynArray(&ch->values.dynArray);
+	if(ch->structureEvents.event != NULL)
+		destroyEventBuffer(&ch->structureEvents);
+	if(ch->valueEvents.event != NULL)
+		destroyEventBuffer(&ch->valueEvents);
+	if(ch->slots.slot != NULL)
+		destroyDynArray(&ch->slots.dynArray);
+	EXIP_RELEASE(strm->allocator, ch->structure.buf);
+	EXIP_RELEASE(strm->allocator, ch->valueBytes.buf);
+	EXIP_RELEASE(strm->allocator, ch->inflated.buf);
+
+#if EXIP_COMPRESSION == ON
+	if(ch->zStrmInit)
+	{
+		if(ch->decoding)
+			inflateEnd(&ch->zStrm);
+		else
+			deflateEnd(&ch->zStrm);
+	}
+#endif
+
+	EXIP_RELEASE(strm->allocator, ch);
+	strm->channels = NULL;
+}
+
+/********* Encoder *********/
+
+/**
+ * Writes data to the application's buffer (that must be in use)
+ * flushing it when full
+ */
+static errorCode writeOutput(EXIStream* strm, const char* data, Index len)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Index run;
+
+	while(len > 0)
+	{
+		// The byte at bufferIndx is kept as in encodeBinary()
+		run = 0;
+		if(strm->buffer.bufLen > strm->context.bufferIndx + 1)
+			run = strm->buffer.bufLen - strm->context.bufferIndx - 1;
+
+		if(run == 0)
+		{
+			TRY(writeEncodedEXIChunk(strm));
+			continue;
+		}
+
+		if(run > len)
+			run = len;
+
+		memcpy(strm->buffer.buf + strm->context.bufferIndx, data, run);
+		strm->context.bufferIndx += run;
+		data += run;
+		len -= run;
+	}
+
+	return EXIP_OK;
+}
+
+/**
+ * Compresses data followed by data2 in a single DEFLATE stream
+ * written to the application's buffer (that must be in use)
+ */
+static errorCode writeChannelStream(EXIStream* strm, ValueChannels* ch, char* data, Index len, char* data2, Index len2)
+{
+#if EXIP_COMPRESSION == ON
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char out[DEFLATE_CHUNK_SIZE];
+	int flush;
+	int ret;
+
+	if(deflateReset(&ch->zStrm) != Z_OK)
+		return EXIP_UNEXPECTED_ERROR;
+
+	ch->zStrm.next_in = (Bytef*) data;
+	ch->zStrm.avail_in = (uInt) len;
+	flush = len2 > 0 ? Z_NO_FLUSH : Z_FINISH;
+
+	do
+	{
+		ch->zStrm.next_out = (Bytef*) out;
+		ch->zStrm.avail_out = DEFLATE_CHUNK_SIZE;
+		ret = deflate(&ch->zStrm, flush);
+		if(ret == Z_STREAM_ERROR)
+			return EXIP_UNEXPECTED_ERROR;
+
+		TRY(writeOutput(strm, out, DEFLATE_CHUNK_SIZE - ch->zStrm.avail_out));
+
+		if(ch->zStrm.avail_in == 0 && flush == Z_NO_FLUSH)
+		{
+			ch->zStrm.next_in = (Bytef*) data2;
+			ch->zStrm.avail_in = (uInt) len2;
+			flush = Z_FINISH;
+		}
+	}
+	while(ret != Z_STREAM_END);
+
+	return EXIP_OK;
+#else
+	return EXIP_NOT_IMPLEMENTED_YET;
+#endif
+}
+
+errorCode initEncodeChannels(EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ValueChannels* ch;
+
+	TRY(createValueChannels(strm));
+	ch = strm->channels;
+
+	TRY_CATCH(createDynArray(&ch->values.dynArray, sizeof(ChannelValue), DEFAULT_CHANNEL_VALUES_NUMBER, strm->allocator), destroyValueChannels(strm));
+
+#if EXIP_COMPRESSION == ON
+	setZlibAllocator(&ch->zStrm, strm->allocator);
+	// Raw DEFLATE stream (RFC 1951), no zlib header or checksum
+	if(ch->compressed && deflateInit2(&ch->zStrm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		destroyValueChannels(strm);
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	}
+	ch->zStrmInit = ch->compressed;
+#endif
+
+	// The channels start at a byte boundary
+	alignChannel(strm);
+	useEncodeBuffer(strm, ch, &ch->structure);
+
+	return EXIP_OK;
+}
+
+errorCode encodeChannelValue(EXIStream* strm, const ChannelValue* value)
+{
+	switch(value->type)
+	{
+		case CHANNEL_INT_VALUE:
+			return encodeIntData(strm, value->data.intVal, value->qnameID, value->typeId);
+		case CHANNEL_BOOLEAN_VALUE:
+			return encodeBoolean(strm, value->data.boolVal);
+		case CHANNEL_STRING_VALUE:
+			return encodeStringData(strm, value->data.strVal, value->qnameID, value->typeId);
+		case CHANNEL_FLOAT_VALUE:
+			return encodeFloatValue(strm, value->data.floatVal);
+		case CHANNEL_BINARY_VALUE:
+			return encodeBinary(strm, value->data.binaryVal.val, value->data.binaryVal.nbytes);
+		case CHANNEL_DATE_TIME_VALUE:
+			return encodeDateTimeValue(strm, value->data.dateTime.exiType, value->data.dateTime.dtVal);
+		case CHANNEL_DECIMAL_VALUE:
+			return encodeDecimalValue(strm, value->data.decVal);
+		case CHANNEL_LIST_VALUE:
+			return encodeUnsignedInteger(strm, (UnsignedInteger) value->data.itemCount);
+	}
+
+	return EXIP_UNEXPECTED_ERROR;
+}
+
+/** Encodes the values of the block in the order of the compressed streams */
+static errorCode encodeBlockValues(EXIStream* strm, ValueChannels* ch)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	struct Channel* channel;
+	boolean small;
+	unsigned int pass;
+	Index i, v;
+
+	// The channels with up to CHANNEL_SMALL_VALUES values go first
+	for(pass = 0; pass < 2; pass++)
+	{
+		small = pass == 0;
+		for(i = 0; i < ch->channels.count; i++)
+		{
+			channel = &ch->channels.channel[i];
+			if((channel->count <= CHANNEL_SMALL_VALUES) != small)
+				continue;
+
+			for(v = channel->first; v != INDEX_MAX; v = ch->values.value[v].next)
+			{
+				TRY(encodeChannelValue(strm, &ch->values.value[v]));
+			}
+			TRY(drainEncodeBuffer(strm));
+			channel->end = ch->valueBytes.len;
+		}
+	}
+
+	return EXIP_OK;
+}
+
+/** Compresses and writes out the current block and starts a new one */
+static errorCode flushBlock(EXIStream* strm, ValueChannels* ch)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	struct Channel* channel;
+	Index smallEnd = 0;
+	Index start;
+	Index i;
+
+	TRY(drainEncodeBuffer(strm));
+
+	useEncodeBuffer(strm, ch, &ch->valueBytes);
+	// The values are encoded in place while the channels are written
+	strm->channels = NULL;
+	tmp_err_code = encodeBlockValues(strm, ch);
+	strm->channels = ch;
+	if(tmp_err_code != EXIP_OK)
+		return tmp_err_code;
+
+	useAppBuffer(strm, ch);
+
+	if(!ch->compressed)
+	{
+		// Pre-compression: the same order of the channels, without DEFLATE
+		TRY(writeOutput(strm, ch->structure.buf, ch->structure.len));
+		TRY(writeOutput(strm, ch->valueBytes.buf, ch->valueBytes.len));
+	}
+	else if(ch->valueCount <= CHANNEL_SMALL_VALUES)
+	{
+		TRY(writeChannelStream(strm, ch, ch->structure.buf, ch->structure.len, ch->valueBytes.buf, ch->valueBytes.len));
+	}
+	else
+	{
+		TRY(writeChannelStream(strm, ch, ch->structure.buf, ch->structure.len, NULL, 0));
+
+		for(i = 0; i < ch->channels.count; i++)
+		{
+			if(ch->channels.channel[i].count <= CHANNEL_SMALL_VALUES)
+				smallEnd = ch->channels.channel[i].end;
+		}
+		if(smallEnd > 0)
+		{
+			TRY(writeChannelStream(strm, ch, ch->valueBytes.buf, smallEnd, NULL, 0));
+		}
+
+		start = smallEnd;
+		for(i = 0; i < ch->channels.count; i++)
+		{
+			channel = &ch->channels.channel[i];
+			if(channel->count > CHANNEL_SMALL_VALUES)
+			{
+				TRY(writeChannelStream(strm, ch, ch->valueBytes.buf + start, channel->end - start, NULL, 0));
+				start = channel->end;
+			}
+		}
+	}
+
+	ch->channels.count = 0;
+	ch->lastChannel = INDEX_MAX;
+	ch->values.count = 0;
+	ch->valueCount = 0;
+	resetAllocList(&ch->memList);
+
+	useEncodeBuffer(strm, ch, &ch->structure);
+
+	return EXIP_OK;
+}
+
+errorCode addChannelValue(EXIStream* strm, const ChannelValue* value)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ValueChannels* ch = strm->channels;
+	struct Channel* channel;
+	ChannelValue* copy;
+	Index chID;
+	Index valueID;
+
+	if(!IS_CHANNELLED(strm))
+		return encodeChannelValue(strm, value);
+
+	if(ch->listItems > 0)
+	{
+		// The items of a list are in the channel of the list
+		chID = ch->listChannel;
+		ch->listItems--;
+	}
+	else
+	{
+		TRY(getChannel(ch, value->qnameID, &chID));
+		ch->valueCount++;
+		ch->channels.channel[chID].count++;
+	}
+
+	TRY(addEmptyDynEntry(&ch->values.dynArray, (void**) &copy, &valueID));
+	*copy = *value;
+	copy->next = INDEX_MAX;
+
+	if(value->type == CHANNEL_STRING_VALUE && value->data.strVal.length > 0)
+	{
+		copy->data.strVal.str = memManagedAllocate(&ch->memList, sizeof(CharType)*value->data.strVal.length);
+		if(copy->data.strVal.str == NULL)
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		memcpy(copy->data.strVal.str, value->data.strVal.str, sizeof(CharType)*value->data.strVal.length);
+	}
+	else if(value->type == CHANNEL_BINARY_VALUE && value->data.binaryVal.nbytes > 0)
+	{
+		copy->data.binaryVal.val = memManagedAllocate(&ch->memList, value->data.binaryVal.nbytes);
+		if(copy->data.binaryVal.val == NULL)
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		memcpy(copy->data.binaryVal.val, value->data.binaryVal.val, value->data.binaryVal.nbytes);
+	}
+	else if(value->type == CHANNEL_LIST_VALUE)
+	{
+		ch->listChannel = chID;
+		ch->listItems = value->data.itemCount;
+	}
+
+	channel = &ch->channels.channel[chID];
+	if(channel->last == INDEX_MAX)
+		channel->first = valueID;
+	else
+		ch->values.value[channel->last].next = valueID;
+	channel->last = valueID;
+
+	if(ch->valueCount >= strm->header.opts.blockSize && ch->listItems == 0)
+		return flushBlock(strm, ch);
+
+	return EXIP_OK;
+}
+
+errorCode closeEncodeChannels(EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ValueChannels* ch = strm->channels;
+
+	// The last block is written even if its structure is encoded
+	// with zero bits so that the decoder finds the ED event
+	TRY_CATCH(flushBlock(strm, ch), destroyValueChannels(strm));
+	destroyValueChannels(strm);
+
+	return EXIP_OK;
+}
+
+/********* Decoder *********/
+
+/**
+ * Inflates the next DEFLATE stream of the application's buffer
+ * (that must be in use) into ch->inflated
+ */
+static errorCode inflateChannelStream(EXIStream* strm, ValueChannels* ch)
+{
+#if EXIP_COMPRESSION == ON
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	uInt availIn;
+	int ret;
+
+	if(inflateReset(&ch->zStrm) != Z_OK)
+		return EXIP_UNEXPECTED_ERROR;
+
+	ch->inflated.len = 0;
+	do
+	{
+		if(strm->context.bufferIndx >= strm->buffer.bufContent)
+		{
+			tmp_err_code = readEXIChunkForParsing(strm, 1);
+			if(tmp_err_code != EXIP_OK)
+			{
+				DEBUG_MSG(ERROR, DEBUG_CONTENT_IO, ("\n> Incomplete compressed stream"));
+				return EXIP_INVALID_EXI_INPUT;
+			}
+		}
+
+		if(ch->inflated.len == ch->inflated.size)
+		{
+			Index newSize = ch->inflated.size == 0 ? CHANNEL_CHUNK_SIZE : 2*ch->inflated.size;
+			char* ptr = EXIP_REALLOCATE(strm->allocator, ch->inflated.buf, newSize);
+			if(ptr == NULL)
+				return EXIP_MEMORY_ALLOCATION_ERROR;
+			ch->inflated.buf = ptr;
+			ch->inflated.size = newSize;
+		}
+
+		availIn = (uInt) (strm->buffer.bufContent - strm->context.bufferIndx);
+		ch->zStrm.next_in = (Bytef*) strm->buffer.buf + strm->context.bufferIndx;
+		ch->zStrm.avail_in = availIn;
+		ch->zStrm.next_out = (Bytef*) ch->inflated.buf + ch->inflated.len;
+		ch->zStrm.avail_out = (uInt) (ch->inflated.size - ch->inflated.len);
+
+		ret = inflate(&ch->zStrm, Z_NO_FLUSH);
+		if(ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+			return EXIP_INVALID_EXI_INPUT;
+
+		strm->context.bufferIndx += availIn - ch->zStrm.avail_in;
+		ch->inflated.len = ch->inflated.size - ch->zStrm.avail_out;
+	}
+	while(ret != Z_STREAM_END);
+
+	return EXIP_OK;
+#else
+	return EXIP_NOT_IMPLEMENTED_YET;
+#endif
+}
+
+/**
+ * Continues the decoding from the next DEFLATE stream of the input.
+ * In pre-compression mode the channels are decoded from the input as they are.
+ */
+static errorCode nextChannelStream(EXIStream* strm, ValueChannels* ch)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	if(!ch->compressed)
+		return EXIP_OK;
+
+	useAppBuffer(strm, ch);
+	TRY(inflateChannelStream(strm, ch));
+	useMemoryBuffer(strm, ch, ch->inflated.buf, ch->inflated.len, ch->inflated.len, NULL);
+
+	return EXIP_OK;
+}
+
+errorCode initDecodeChannels(EXIStream* strm)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ValueChannels* ch;
+
+	TRY(createValueChannels(strm));
+	ch = strm->channels;
+	ch->decoding = TRUE;
+
+	TRY_CATCH(createEventBuffer(&ch->structureEvents, strm->allocator), destroyValueChannels(strm));
+	TRY_CATCH(createEventBuffer(&ch->valueEvents, strm->allocator), destroyValueChannels(strm));
+	TRY_CATCH(createDynArray(&ch->slots.dynArray, sizeof(struct ValueSlot), DEFAULT_CHANNEL_VALUES_NUMBER, strm->allocator), destroyValueChannels(strm));
+
+#if EXIP_COMPRESSION == ON
+	setZlibAllocator(&ch->zStrm, strm->allocator);
+	ch->zStrm.next_in = Z_NULL;
+	ch->zStrm.avail_in = 0;
+	if(ch->compressed && inflateInit2(&ch->zStrm, -MAX_WBITS) != Z_OK)
+	{
+		destroyValueChannels(strm);
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	}
+	ch->zStrmInit = ch->compressed;
+#endif
+
+	// The channels start at a byte boundary
+	alignChannel(strm);
+
+	return EXIP_OK;
+}
+
+errorCode addValueSlot(EXIStream* strm, Index typeId, QNameID qnameID)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ValueChannels* ch = strm->channels;
+	struct Channel* channel;
+	struct ValueSlot* slot;
+	RecordedEvent* event;
+	Index chID;
+	Index slotID;
+
+	TRY(getChannel(ch, qnameID, &chID));
+	TRY(addEmptyDynEntry(&ch->slots.dynArray, (void**) &slot, &slotID));
+	slot->qnameID = qnameID;
+	slot->typeId = typeId;
+	slot->next = INDEX_MAX;
+	slot->firstEvent = 0;
+	slot->eventCount = 0;
+
+	channel = &ch->channels.channel[chID];
+	if(channel->last == INDEX_MAX)
+		channel->first = slotID;
+	else
+		ch->slots.slot[channel->last].next = slotID;
+	channel->last = slotID;
+	channel->count++;
+	ch->valueCount++;
+
+	TRY(addRecordedEvent(&ch->structureEvents, RECORDED_PLACEHOLDER, &event));
+	event->data.placeholder = slotID;
+
+	return EXIP_OK;
+}
+
+/** Decodes the values of the block once the structure is known */
+static errorCode decodeBlockValues(EXIStream* strm, ValueChannels* ch, ContentHandler* recorder)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	SmallIndex nonTermID = GR_VOID_NON_TERMINAL;
+	struct Channel* channel;
+	struct ValueSlot* slot;
+	boolean small;
+	boolean smallStream = FALSE;
+	unsigned int pass;
+	Index i, s;
+
+	// The channels with up to CHANNEL_SMALL_VALUES values go first
+	for(pass = 0; pass < 2; pass++)
+	{
+		small = pass == 0;
+		for(i = 0; i < ch->channels.count; i++)
+		{
+			channel = &ch->channels.channel[i];
+			if((channel->count <= CHANNEL_SMALL_VALUES) != small)
+				continue;
+
+			if(ch->valueCount > CHANNEL_SMALL_VALUES && (!small || !smallStream))
+			{
+				// The values are not in the stream of the structure: the small
+				// channels share the next stream and the others have one each
+				TRY(nextChannelStream(strm, ch));
+				smallStream = small;
+			}
+
+			for(s = channel->first; s != INDEX_MAX; s = slot->next)
+			{
+				slot = &ch->slots.slot[s];
+				slot->firstEvent = ch->valueEvents.count;
+				TRY(decodeValueItem(strm, slot->typeId, recorder, &nonTermID, slot->qnameID, &ch->valueEvents));
+				slot->eventCount = ch->valueEvents.count - slot->firstEvent;
+			}
+			alignChannel(strm);
+		}
+	}
+
+	return EXIP_OK;
+}
+
+/** Decodes the structure of the next block and then its values */
+static errorCode decodeBlock(EXIStream* strm, ValueChannels* ch)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ContentHandler recorder;
+	SmallIndex nonTermID;
+
+	TRY(clearEventBuffer(&ch->structureEvents));
+	TRY(clearEventBuffer(&ch->valueEvents));
+	ch->slots.count = 0;
+	ch->channels.count = 0;
+	ch->lastChannel = INDEX_MAX;
+	ch->valueCount = 0;
+	ch->replayIndx = 0;
+
+	setRecordingHandler(&recorder);
+	TRY(nextChannelStream(strm, ch));
+
+	do
+	{
+		nonTermID = GR_VOID_NON_TERMINAL;
+		tmp_err_code = processNextProduction(strm, &nonTermID, &recorder, &ch->structureEvents);
+		if(tmp_err_code == EXIP_BUFFER_END_REACHED)
+		{
+			DEBUG_MSG(ERROR, DEBUG_CONTENT_IO, ("\n> Incomplete structure channel"));
+			return EXIP_INVALID_EXI_INPUT;
+		}
+		else if(tmp_err_code != EXIP_OK)
+			return tmp_err_code;
+
+		if(nonTermID == GR_VOID_NON_TERMINAL)
+		{
+			popGrammar(strm);
+			if(strm->gStack == NULL) // The end of the document
+				break;
+		}
+		else
+			strm->gStack->currNonTermID = nonTermID;
+	}
+	while(ch->valueCount < strm->header.opts.blockSize);
+	alignChannel(strm);
+
+	// The values are decoded in place
+	strm->channels = NULL;
+	tmp_err_code = decodeBlockValues(strm, ch, &recorder);
+	strm->channels = ch;
+	if(tmp_err_code != EXIP_OK)
+		return tmp_err_code;
+
+	useAppBuffer(strm, ch);
+
+	return EXIP_OK;
+}
+
+errorCode parseNextChannelled(EXIStream* strm, ContentHandler* handler, void* app_data)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	ValueChannels* ch = strm->channels;
+	RecordedEvent* event;
+	struct ValueSlot* slot;
+	Index i;
+
+	if(ch->replayIndx == ch->structureEvents.count)
+	{
+		if(strm->gStack == NULL)
+			return EXIP_INCONSISTENT_PROC_STATE;
+		TRY(decodeBlock(strm, ch));
+		if(ch->structureEvents.count == 0)
+			return EXIP_INVALID_EXI_INPUT;
+	}
+
+	event = &ch->structureEvents.event[ch->replayIndx];
+	ch->replayIndx++;
+
+	if(event->type == RECORDED_PLACEHOLDER)
+	{
+		slot = &ch->slots.slot[event->data.placeholder];
+		for(i = slot->firstEvent; i < slot->firstEvent + slot->eventCount; i++)
+		{
+			TRY(replayRecordedEvent(&ch->valueEvents.event[i], handler, app_data));
+		}
+	}
+	else
+	{
+		TRY(replayRecordedEvent(event, handler, app_data));
+		if(event->type == RECORDED_END_DOCUMENT)
+			return EXIP_PARSING_COMPLETE;
+	}
+
+	return EXIP_OK;
+}
@@ -24,6 +24,14 @@
 // Defines the initial dimension of the dynamic array - production
 #define DEFAULT_PROD_ARRAY_DIM 10
 
+/**
+ * The number of nodes of the first block of the grammar stack pool;
+ * the following blocks are twice as large as the previous one
+ */
+#ifndef GRAMMAR_STACK_DEPTH
+# define GRAMMAR_STACK_DEPTH 16
+#endif
+
 /**
  * Get global element EXIGrammar from the SchemaGrammarTable by given QNameID.
  * Returns NULL if the grammar does not exists in the SchemaGrammarTable
@@ -40,20 +48,31 @@
 
 /**
  * @brief Push a grammar on top of the Grammar Stack
- * 
- * @param[in, out] gStack the Grammar Stack
+ * The node is taken from the node pool of the stream; a new block of nodes
+ * is allocated only when all the nodes are in use.
+ *
+ * @param[in, out] strm EXI stream holding the Grammar Stack
  * @param[in] currQNameID the currently proccessed element QNameID that is having this grammar
  * @param[in] grammar a EXI grammar
  * @return Error handling code
  */
-errorCode pushGrammar(EXIGrammarStack** gStack, QNameID currQNameID, EXIGrammar* grammar);
+errorCode pushGrammar(EXIStream* strm, QNameID currQNameID, EXIGrammar* grammar);
 
 /**
  * @brief Pop a grammar off the top of the Grammar Stack
- * 
- * @param[in, out] gStack the Grammar stack
+ * The node is returned to the node pool of the stream.
+ *
+ * @param[in, out] strm EXI stream holding the Grammar Stack
+ */
+void popGrammar(EXIStream* strm);
+
+/**
+ * @brief Frees the node pool of the Grammar Stack
+ * The Grammar Stack is left empty.
+ *
+ * @param[in, out] strm EXI stream holding the Grammar Stack
  */
-void popGrammar(EXIGrammarStack** gStack);
+void destroyGrammarStack(EXIStream* strm);
 
 /**
  * @brief Creates an instance of the EXI Built-in Document Grammar or Schema-Informed Document Grammar
@@ -102,9 +121,10 @@ errorCode createFragmentGrammar(EXIPSchema* schema, QNameID* elQnameArr, Index q
 	 * @param[in] qname qname identifier of the Event Type corresponding to the inserted production
 	 * @param[in] hasSecondLevelProd FALSE if there are no second level productions (only possible in Fragment Grammar);
 	 * otherwise TRUE
+	 * @param[in] allocator the allocator of the productions of the rule; NULL for EXIP_MALLOC
 	 * @return Error handling code
 	 */
-	errorCode insertZeroProduction(DynGrammarRule* rule, EventType evnt, SmallIndex nonTermID, QNameID* qname, boolean hasSecondLevelProd);
+	errorCode insertZeroProduction(DynGrammarRule* rule, EventType evnt, SmallIndex nonTermID, QNameID* qname, boolean hasSecondLevelProd, const EXIPAllocator* allocator);
 #endif
 
 /**
@@ -130,7 +130,7 @@ errorCode createBuiltInElementGrammar(EXIGrammar* elementGrammar, EXIStream* str
 	elementGrammar->count = DEF_ELEMENT_GRAMMAR_RULE_NUMBER;
 	elementGrammar->props = 0;
 	SET_BUILT_IN_ELEM_GR(elementGrammar->props);
-	elementGrammar->rule = (GrammarRule*) EXIP_MALLOC(sizeof(DynGrammarRule)*DEF_ELEMENT_GRAMMAR_RULE_NUMBER);
+	elementGrammar->rule = (GrammarRule*) EXIP_ALLOCATE(strm->allocator, sizeof(DynGrammarRule)*DEF_ELEMENT_GRAMMAR_RULE_NUMBER);
 	if(elementGrammar->rule == NULL)
 		return EXIP_MEMORY_ALLOCATION_ERROR;
 
@@ -150,7 +150,7 @@ errorCode createBuiltInElementGrammar(EXIGrammar* elementGrammar, EXIStream* str
 	tmp_rule = &((DynGrammarRule*) elementGrammar->rule)[GR_START_TAG_CONTENT];
 
 	/* Part 1 */
-	tmp_rule->production = (Production*) EXIP_MALLOC(sizeof(Production)*DEFAULT_PROD_ARRAY_DIM);
+	tmp_rule->production = (Production*) EXIP_ALLOCATE(strm->allocator, sizeof(Production)*DEFAULT_PROD_ARRAY_DIM);
 	if(tmp_rule->production == NULL)
 		return EXIP_MEMORY_ALLOCATION_ERROR;
 
@@ -171,7 +171,7 @@ errorCode createBuiltInElementGrammar(EXIGrammar* elementGrammar, EXIStream* str
 	tmp_rule = &((DynGrammarRule*) elementGrammar->rule)[GR_ELEMENT_CONTENT];
 
 	/* Part 1 */
-	tmp_rule->production = (Production*) EXIP_MALLOC(sizeof(Production)*DEFAULT_PROD_ARRAY_DIM);
+	tmp_rule->production = (Production*) EXIP_ALLOCATE(strm->allocator, sizeof(Production)*DEFAULT_PROD_ARRAY_DIM);
 	if(tmp_rule->production == NULL)
 		return EXIP_MEMORY_ALLOCATION_ERROR;
 
@@ -189,11 +189,11 @@ errorCode createBuiltInElementGrammar(EXIGrammar* elementGrammar, EXIStream* str
 	return EXIP_OK;
 }
 
-errorCode insertZeroProduction(DynGrammarRule* rule, EventType eventType, SmallIndex nonTermID, QNameID* qnameId, boolean hasSecondLevelProd)
+errorCode insertZeroProduction(DynGrammarRule* rule, EventType eventType, SmallIndex nonTermID, QNameID* qnameId, boolean hasSecondLevelProd, const EXIPAllocator* allocator)
 {
 	if(rule->pCount == rule->prodDim) // The dynamic array rule->production needs to be resized
 	{
-		void* ptr = EXIP_REALLOC(rule->production, sizeof(Production)*(rule->prodDim + DEFAULT_PROD_ARRAY_DIM));
+		void* ptr = EXIP_REALLOCATE(allocator, rule->production, sizeof(Production)*(rule->prodDim + DEFAULT_PROD_ARRAY_DIM));
 		if(ptr == NULL)
 			return EXIP_MEMORY_ALLOCATION_ERROR;
 
@@ -211,30 +211,78 @@ errorCode insertZeroProduction(DynGrammarRule* rule, EventType eventType, SmallI
 }
 #endif
 
-errorCode pushGrammar(EXIGrammarStack** gStack, QNameID currQNameID, EXIGrammar* grammar)
+/** Adds a block of nodes to the free nodes of the pool */
+static errorCode addGrammarStackBlock(GrammarStackPool* pool, const EXIPAllocator* allocator)
 {
-	struct GrammarStackNode* node = (struct GrammarStackNode*)EXIP_MALLOC(sizeof(struct GrammarStackNode));
-	if(node == NULL)
+	struct GrammarStackBlock* block;
+	EXIGrammarStack* node;
+	Index count = GRAMMAR_STACK_DEPTH;
+	Index i;
+
+	if(pool->block != NULL && pool->block->count <= (INDEX_MAX - sizeof(struct GrammarStackBlock))/(2*sizeof(EXIGrammarStack)))
+		count = 2*pool->block->count;
+
+	block = (struct GrammarStackBlock*) EXIP_ALLOCATE(allocator, sizeof(struct GrammarStackBlock) + count*sizeof(EXIGrammarStack));
+	if(block == NULL)
 		return EXIP_MEMORY_ALLOCATION_ERROR;
 
+	block->count = count;
+	block->nextBlock = pool->block;
+	pool->block = block;
+
+	// The nodes are taken in the order they have in the block
+	node = (EXIGrammarStack*) (block + 1);
+	for(i = 0; i < count - 1; i++)
+		node[i].nextInStack = &node[i + 1];
+	node[count - 1].nextInStack = pool->freeNode;
+	pool->freeNode = node;
+
+	return EXIP_OK;
+}
+
+errorCode pushGrammar(EXIStream* strm, QNameID currQNameID, EXIGrammar* grammar)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	EXIGrammarStack* node;
+
+	if(strm->gStackPool.freeNode == NULL)
+		TRY(addGrammarStackBlock(&strm->gStackPool, strm->allocator));
+
+	node = strm->gStackPool.freeNode;
+	strm->gStackPool.freeNode = node->nextInStack;
+
 	node->grammar = grammar;
 	node->currNonTermID = GR_START_TAG_CONTENT;
 	node->currQNameID = currQNameID;
-	node->nextInStack = *gStack;
-	*gStack = node;
+	node->nextInStack = strm->gStack;
+	strm->gStack = node;
 	return EXIP_OK;
 }
 
-void popGrammar(EXIGrammarStack** gStack)
+void popGrammar(EXIStream* strm)
 {
-	struct GrammarStackNode* node = *gStack;
-	if((*gStack) != NULL)
+	EXIGrammarStack* node = strm->gStack;
+	if(node != NULL)
 	{
-		node = *gStack;
-		*gStack = (*gStack)->nextInStack;
+		strm->gStack = node->nextInStack;
+
+		node->nextInStack = strm->gStackPool.freeNode;
+		strm->gStackPool.freeNode = node;
+	}
+}
+
+void destroyGrammarStack(EXIStream* strm)
+{
+	struct GrammarStackBlock* block;
 
-		EXIP_MFREE(node);
+	while(strm->gStackPool.block != NULL)
+	{
+		block = strm->gStackPool.block;
+		strm->gStackPool.block = block->nextBlock;
+		EXIP_RELEASE(strm->allocator, block);
 	}
+	strm->gStackPool.freeNode = NULL;
+	strm->gStack = NULL;
 }
 
 errorCode createFragmentGrammar(EXIPSchema* schema, QNameID* elQnameArr, Index qnameCount)
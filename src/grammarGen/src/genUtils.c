@@ -519,11 +519,13 @@ errorCode createWildcardTermGrammar(String* wildcardArray, Index wildcardArraySi
 	else if(wildcardArraySize >= 1)
 	{
 		Index i;
+		boolean found;
 
 		qnameID.lnId = LN_MAX;
 		for(i = 0; i < wildcardArraySize; i++)
 		{
-			if(!lookupUri(uriT, wildcardArray[i], &qnameID.uriId))
+			TRY(lookupUri(uriT, wildcardArray[i], &qnameID.uriId, &found));
+			if(!found)
 			 	return EXIP_UNEXPECTED_ERROR;
 			TRY(addProduction(pRuleEntry, EVENT_SE_URI, INDEX_MAX, qnameID, 1));
 		}
@@ -38,6 +38,7 @@ errorCode generateSchemaInformedGrammars(BinaryBuffer* buffers, unsigned int buf
 	SubstituteTable substituteTbl;
 	unsigned int treeTCount = bufCount;
 	unsigned int i = 0;
+	boolean found;
 
 	// TODO: again in error cases all the memory must be released
 
@@ -46,14 +47,14 @@ errorCode generateSchemaInformedGrammars(BinaryBuffer* buffers, unsigned int buf
 		return EXIP_MEMORY_ALLOCATION_ERROR;
 
 	/* Initialize the SubstituteTable in case there are substitution groups defined in the schema */
-	TRY(createDynArray(&substituteTbl.dynArray, sizeof(SubtGroupHead), 5));
+	TRY(createDynArray(&substituteTbl.dynArray, sizeof(SubtGroupHead), 5, NULL));
 
 	for(i = 0; i < bufCount; i++)
 	{
 		TRY(initTreeTable(&treeT[i]));
 	}
 
-	TRY(initSchema(schema, INIT_SCHEMA_SCHEMA_ENABLED));
+	TRY(initSchema(schema, INIT_SCHEMA_SCHEMA_ENABLED, NULL));
 
 	for(i = 0; i < bufCount; i++)
 	{
@@ -104,7 +105,8 @@ errorCode generateSchemaInformedGrammars(BinaryBuffer* buffers, unsigned int buf
 	// Find the correct targetNsId in the string tables for each TreeTable
 	for(i = 0; i < treeTCount; i++)
 	{
-		if(!lookupUri(&schema->uriTable, treeT[i].globalDefs.targetNs, &treeT[i].globalDefs.targetNsId))
+		TRY(lookupUri(&schema->uriTable, treeT[i].globalDefs.targetNs, &treeT[i].globalDefs.targetNsId, &found));
+		if(!found)
 			return EXIP_UNEXPECTED_ERROR;
 	}
 
@@ -128,6 +130,16 @@ errorCode generateSchemaInformedGrammars(BinaryBuffer* buffers, unsigned int buf
 
 	TRY(convertTreeTablesToExipSchema(treeT, treeTCount, schema, &substituteTbl));
 
+	// The tables of the schema are complete; the streams rarely add entries to them
+	for(i = 0; i < schema->uriTable.count; i++)
+	{
+		TRY(shrinkDynArray(&schema->uriTable.uri[i].lnTable.dynArray));
+	}
+	TRY(shrinkDynArray(&schema->uriTable.dynArray));
+	TRY(shrinkDynArray(&schema->grammarTable.dynArray));
+	TRY(shrinkDynArray(&schema->simpleTypeTable.dynArray));
+	TRY(shrinkDynArray(&schema->enumTable.dynArray));
+
 	/* Destroy all tree tables */
 	for(i = 0; i < treeTCount; i++)
 	{
@@ -153,11 +165,14 @@ void destroySchema(EXIPSchema* schema)
 	Index i;
 
 	// Freeing the string tables
+#if HASH_TABLE_USE
+	destroyStringTableIndex(&schema->uriTable);
+#endif
 
 	for(i = 0; i < schema->uriTable.count; i++)
 	{
 		if(schema->uriTable.uri[i].pfxTable != NULL)
-			EXIP_MFREE(schema->uriTable.uri[i].pfxTable);
+			EXIP_RELEASE(schema->uriTable.dynArray.allocator, schema->uriTable.uri[i].pfxTable);
 
 		destroyDynArray(&schema->uriTable.uri[i].lnTable.dynArray);
 	}
@@ -190,6 +205,11 @@ static void sortUriTable(UriTable* uriTable)
 {
 	uint16_t i = 0;
 
+#if HASH_TABLE_USE
+	// The IDs of the entries are changed
+	destroyStringTableIndex(uriTable);
+#endif
+
 	// First sort the local name tables
 
 	for (i = 0; i < uriTable->count; i++)
@@ -26,7 +26,7 @@ errorCode createProtoGrammar(Index rulesDim, ProtoGrammar* pg)
 {
 	pg->contentIndex = 0;
 
-	return createDynArray(&pg->dynArray, sizeof(ProtoRuleEntry), rulesDim);
+	return createDynArray(&pg->dynArray, sizeof(ProtoRuleEntry), rulesDim, NULL);
 }
 
 errorCode addProtoRule(ProtoGrammar* pg, Index prodDim, ProtoRuleEntry** ruleEntry)
@@ -36,7 +36,7 @@ errorCode addProtoRule(ProtoGrammar* pg, Index prodDim, ProtoRuleEntry** ruleEnt
 
 	TRY(addEmptyDynEntry(&pg->dynArray, (void **) ruleEntry, &ruleId));
 
-	return createDynArray(&((*ruleEntry)->dynArray), sizeof(Production), prodDim);
+	return createDynArray(&((*ruleEntry)->dynArray), sizeof(Production), prodDim, NULL);
 }
 
 errorCode addProduction(ProtoRuleEntry* ruleEntry, EventType eventType, Index typeId, QNameID qnameID, SmallIndex nonTermID)
@@ -289,13 +289,15 @@ static errorCode xsd_startElement(QName qname, void* app_data)
 		errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 		Index treeTableId;
 		int i;
+		boolean found;
 
 		if(ttpd->propsStat == SCHEMA_ELEMENT_STATE)
 		{
 			/** The next element after the <schema>
 			 *  The targetNamespace should be defined by now, so inserted in the schema->uriTable
 			 */
-			if(!lookupUri(&ttpd->schema->uriTable, ttpd->treeT->globalDefs.targetNs, &ttpd->targetNsId))
+			TRY(lookupUri(&ttpd->schema->uriTable, ttpd->treeT->globalDefs.targetNs, &ttpd->targetNsId, &found));
+			if(!found)
 			{
 				String clonedTargetNS;
 
@@ -458,6 +460,7 @@ static errorCode xsd_endElement(void* app_data)
 		{
 			Index lnId;
 			SmallIndex uriId = 0; // URI	0	"" [empty string]
+			boolean found;
 
 			if(ttpd->contextStack == NULL) // If the schema definition is global
 			{
@@ -480,7 +483,8 @@ static errorCode xsd_endElement(void* app_data)
 				}
 			}
 
-			if(!lookupLn(&ttpd->schema->uriTable.uri[uriId].lnTable, *elName, &lnId))
+			TRY(lookupLn(&ttpd->schema->uriTable.uri[uriId].lnTable, *elName, &lnId, &found));
+			if(!found)
 			{
 				TRY(cloneStringManaged(elName, &clonedName, &ttpd->schema->memList));
 
@@ -493,14 +497,15 @@ static errorCode xsd_endElement(void* app_data)
 				NsTable nsTable;
 				size_t i;
 
-				TRY(createDynArray(&nsTable.dynArray, sizeof(String), 5));
+				TRY(createDynArray(&nsTable.dynArray, sizeof(String), 5, NULL));
 
 				if(EXIP_OK != getNsList(ttpd->treeT, entry->attributePointers[ATTRIBUTE_NAMESPACE], &nsTable))
 					return	EXIP_HANDLER_STOP;
 
 				for(i = 0; i < nsTable.count; i++)
 				{
-					if(!lookupUri(&ttpd->schema->uriTable, nsTable.base[i], &uriId))
+					TRY(lookupUri(&ttpd->schema->uriTable, nsTable.base[i], &uriId, &found));
+					if(!found)
 					{
 						TRY(cloneStringManaged(&nsTable.base[i], &clonedName, &ttpd->schema->memList));
 
@@ -229,10 +229,10 @@ errorCode initTreeTable(TreeTable* treeT)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 
-	TRY(initAllocList(&treeT->memList));
+	TRY(initAllocList(&treeT->memList, NULL));
 
-	TRY(createDynArray(&treeT->dynArray, sizeof(TreeTableEntry), TREE_TABLE_ENTRY_COUNT));
-	TRY(createDynArray(&treeT->globalDefs.pfxNsTable.dynArray, sizeof(PfxNsEntry), 10));
+	TRY(createDynArray(&treeT->dynArray, sizeof(TreeTableEntry), TREE_TABLE_ENTRY_COUNT, NULL));
+	TRY(createDynArray(&treeT->globalDefs.pfxNsTable.dynArray, sizeof(PfxNsEntry), 10, NULL));
 
 	treeT->globalDefs.attrFormDefault = UNQUALIFIED;
 	treeT->globalDefs.elemFormDefault = UNQUALIFIED;
@@ -242,23 +242,23 @@ errorCode initTreeTable(TreeTable* treeT)
 #if HASH_TABLE_USE
 	// TODO: conditionally create the table, only if the schema is big.
 	// How to determine when the schema is big?
-	treeT->typeTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, djbHash, stringEqual);
+	treeT->typeTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, stringHash, stringEqual, NULL);
 	if(treeT->typeTbl == NULL)
 		return EXIP_HASH_TABLE_ERROR;
 
-	treeT->elemTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, djbHash, stringEqual);
+	treeT->elemTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, stringHash, stringEqual, NULL);
 	if(treeT->elemTbl == NULL)
 		return EXIP_HASH_TABLE_ERROR;
 
-	treeT->attrTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, djbHash, stringEqual);
+	treeT->attrTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, stringHash, stringEqual, NULL);
 	if(treeT->attrTbl == NULL)
 		return EXIP_HASH_TABLE_ERROR;
 
-	treeT->groupTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, djbHash, stringEqual);
+	treeT->groupTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, stringHash, stringEqual, NULL);
 	if(treeT->groupTbl == NULL)
 		return EXIP_HASH_TABLE_ERROR;
 
-	treeT->attrGroupTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, djbHash, stringEqual);
+	treeT->attrGroupTbl = create_hashtable(INITIAL_HASH_TABLE_SIZE, stringHash, stringEqual, NULL);
 	if(treeT->attrGroupTbl == NULL)
 		return EXIP_HASH_TABLE_ERROR;
 #endif
@@ -491,7 +491,7 @@ static errorCode lookupGlobalDefinition(EXIPSchema* schema, TreeTable* treeT, un
 			{
 				SubtGroupHead newHead;
 				newHead.headId = typeQnameID;
-				TRY(createDynArray(&newHead.dynArray, sizeof(QualifiedTreeTableEntry), 5));
+				TRY(createDynArray(&newHead.dynArray, sizeof(QualifiedTreeTableEntry), 5, NULL));
 
 				TRY(addDynEntry(&subsTbl->dynArray, (void*) &newHead, &s));
 			}
@@ -513,11 +513,13 @@ static errorCode lookupGlobalDefinition(EXIPSchema* schema, TreeTable* treeT, un
 
 errorCode getTypeQName(EXIPSchema* schema, TreeTable* treeT, const String typeLiteral, QNameID* qNameID)
 {
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 	Index indx;
 	String lnStr;
 	String uriStr;
 	Index i;
 	boolean pfxFound = FALSE;
+	boolean found;
 
 	/*
 	 * The type literal string passed in will be in the form of either:
@@ -595,9 +597,11 @@ errorCode getTypeQName(EXIPSchema* schema, TreeTable* treeT, const String typeLi
 		lnStr.str = typeLiteral.str;
 	}
 
-	if(!lookupUri(&schema->uriTable, uriStr, &qNameID->uriId))
+	TRY(lookupUri(&schema->uriTable, uriStr, &qNameID->uriId, &found));
+	if(!found)
 		return EXIP_INVALID_EXI_INPUT;
-	if(!lookupLn(&schema->uriTable.uri[qNameID->uriId].lnTable, lnStr, &qNameID->lnId))
+	TRY(lookupLn(&schema->uriTable.uri[qNameID->uriId].lnTable, lnStr, &qNameID->lnId, &found));
+	if(!found)
 		return EXIP_INVALID_EXI_INPUT;
 
 	// http://www.w3.org/TR/xmlschema11-1/#sec-src-resolve
@@ -306,8 +306,8 @@ errorCode convertTreeTablesToExipSchema(TreeTable* treeT, unsigned int count, EX
 	ctx.emptyGrIndex = INDEX_MAX;
 	getEmptyString(&ctx.emptyString);
 
-	TRY(initAllocList(&ctx.tmpMemList));
-	TRY(createDynArray(&ctx.gElTbl.dynArray, sizeof(QNameID), DEFAULT_GLOBAL_QNAME_COUNT));
+	TRY(initAllocList(&ctx.tmpMemList, NULL));
+	TRY(createDynArray(&ctx.gElTbl.dynArray, sizeof(QNameID), DEFAULT_GLOBAL_QNAME_COUNT, NULL));
 
 	/** For every tree table */
 	for(i = 0; i < count; i++)
@@ -428,7 +428,7 @@ static errorCode getElementTermProtoGrammar(BuildContext* ctx, QualifiedTreeTabl
 	if(minOccurs < 0 || maxOccurs < -1)
 		return EXIP_UNEXPECTED_ERROR;
 
-	TRY(createDynArray(&subsElGrTbl.dynArray, sizeof(QNameIDGrIndx), 10));
+	TRY(createDynArray(&subsElGrTbl.dynArray, sizeof(QNameIDGrIndx), 10, NULL));
 
 	TRY(recursiveSubsitutionGroupAdd(ctx, qGrIndex, &subsElGrTbl));
 
@@ -458,6 +458,7 @@ static errorCode handleElementEl(BuildContext* ctx, QualifiedTreeTableEntry* tre
 	QNameID elQNameID;
 	QNameID typeQNameID;
 	boolean isNillable = FALSE;
+	boolean found;
 
 #if DEBUG_GRAMMAR_GEN == ON && EXIP_DEBUG_LEVEL == INFO
 	DEBUG_MSG(INFO, DEBUG_GRAMMAR_GEN, ("\n>Handle Element: "));
@@ -488,7 +489,8 @@ static errorCode handleElementEl(BuildContext* ctx, QualifiedTreeTableEntry* tre
 			elQNameID.uriId = 0;
 
 		/** The element qname must be already in the string tables */
-		if(!lookupLn(&ctx->schema->uriTable.uri[elQNameID.uriId].lnTable, treeTEntry->entry->attributePointers[ATTRIBUTE_NAME], &elQNameID.lnId))
+		TRY(lookupLn(&ctx->schema->uriTable.uri[elQNameID.uriId].lnTable, treeTEntry->entry->attributePointers[ATTRIBUTE_NAME], &elQNameID.lnId, &found));
+		if(!found)
 			return EXIP_UNEXPECTED_ERROR;
 	}
 
@@ -712,6 +714,7 @@ static errorCode getAttributeProtoGrammar(BuildContext* ctx, QualifiedTreeTableE
 	boolean required = FALSE;
 	Index typeId;
 	QNameID atQnameID;
+	boolean found;
 
 	if(isGlobal)
 	{
@@ -741,7 +744,8 @@ static errorCode getAttributeProtoGrammar(BuildContext* ctx, QualifiedTreeTableE
 			atQnameID.uriId = 0; // URI	0	"" [empty string]
 
 		/* The attribute qname must be already in the string tables */
-		if(!lookupLn(&ctx->schema->uriTable.uri[atQnameID.uriId].lnTable, attrEntry->entry->attributePointers[ATTRIBUTE_NAME], &atQnameID.lnId))
+		TRY(lookupLn(&ctx->schema->uriTable.uri[atQnameID.uriId].lnTable, attrEntry->entry->attributePointers[ATTRIBUTE_NAME], &atQnameID.lnId, &found));
+		if(!found)
 			return EXIP_UNEXPECTED_ERROR;
 	}
 
@@ -828,11 +832,13 @@ static errorCode handleSimpleTypeEl(BuildContext* ctx, QualifiedTreeTableEntry*
 		// Named simple type
 		QNameID stQNameID;
 		ProtoGrammar* simpleProtoGrammar;
+		boolean found;
 
 		stQNameID.uriId = stEntry->treeT->globalDefs.targetNsId;
 
 		/** The type qname must be in the string tables */
-		if(!lookupLn(&ctx->schema->uriTable.uri[stQNameID.uriId].lnTable, stEntry->entry->attributePointers[ATTRIBUTE_NAME], &stQNameID.lnId))
+		TRY(lookupLn(&ctx->schema->uriTable.uri[stQNameID.uriId].lnTable, stEntry->entry->attributePointers[ATTRIBUTE_NAME], &stQNameID.lnId, &found));
+		if(!found)
 			return EXIP_UNEXPECTED_ERROR;
 
 		if(GET_LN_URI_QNAME(ctx->schema->uriTable, stQNameID).typeGrammar == INDEX_MAX)
@@ -1072,6 +1078,7 @@ static errorCode getComplexTypeProtoGrammar(BuildContext* ctx, QualifiedTreeTabl
 	ProtoGrammar* contentTypeGrammar = NULL;
 	String* attrWildcardNS = NULL;
 	boolean isMixedContent = FALSE;
+	boolean found;
 	Index i;
 
 	if(complEntry->entry->loopDetection == 0)
@@ -1101,11 +1108,11 @@ static errorCode getComplexTypeProtoGrammar(BuildContext* ctx, QualifiedTreeTabl
 	}
 
 	TRY(getContentTypeProtoGrammar(ctx, complEntry, &contentTypeGrammar));
-	TRY(createDynArray(&attrUseArray.dynArray, sizeof(ProtoGrammar*), 10));
+	TRY(createDynArray(&attrUseArray.dynArray, sizeof(ProtoGrammar*), 10, NULL));
 
 	{ // get all the attribute uses
 		struct localAttrNames aNamesTbl;
-		TRY(createDynArray(&aNamesTbl.dynArray, sizeof(String), 20));
+		TRY(createDynArray(&aNamesTbl.dynArray, sizeof(String), 20, NULL));
 		TRY(getAttributeUseProtoGrammars(ctx, complEntry, &attrUseArray, &attrWildcardNS, &aNamesTbl));
 
 		destroyDynArray(&aNamesTbl.dynArray);
@@ -1122,7 +1129,7 @@ static errorCode getComplexTypeProtoGrammar(BuildContext* ctx, QualifiedTreeTabl
 		ProtoRuleEntry* pRuleEntry;
 		ProtoGrammar* pAttrWildGrammar;
 
-		TRY(createDynArray(&nsTable.dynArray, sizeof(String), 5));
+		TRY(createDynArray(&nsTable.dynArray, sizeof(String), 5, NULL));
 		TRY(getNsList(complEntry->treeT, *attrWildcardNS, &nsTable));
 
 		pAttrWildGrammar = memManagedAllocate(&ctx->tmpMemList, sizeof(ProtoGrammar));
@@ -1155,7 +1162,8 @@ static errorCode getComplexTypeProtoGrammar(BuildContext* ctx, QualifiedTreeTabl
 
 			for(j = 0; j < nsTable.count; j++)
 			{
-				if(!lookupUri(&ctx->schema->uriTable, nsTable.base[j], &qnameID.uriId))
+				TRY(lookupUri(&ctx->schema->uriTable, nsTable.base[j], &qnameID.uriId, &found));
+				if(!found)
 				 	return EXIP_UNEXPECTED_ERROR;
 
 				for(i = 0; i < attrUseArray.count; i++)
@@ -1208,11 +1216,13 @@ static errorCode handleComplexTypeEl(BuildContext* ctx, QualifiedTreeTableEntry*
 	if(!isStringEmpty(&ctEntry->entry->attributePointers[ATTRIBUTE_NAME]))
 	{
 		QNameID ctQNameID;
+		boolean found;
 
 		ctQNameID.uriId = ctEntry->treeT->globalDefs.targetNsId;
 
 		/** The type qname must be in the string tables */
-		if(!lookupLn(&ctx->schema->uriTable.uri[ctQNameID.uriId].lnTable, ctEntry->entry->attributePointers[ATTRIBUTE_NAME], &ctQNameID.lnId))
+		TRY(lookupLn(&ctx->schema->uriTable.uri[ctQNameID.uriId].lnTable, ctEntry->entry->attributePointers[ATTRIBUTE_NAME], &ctQNameID.lnId, &found));
+		if(!found)
 			return EXIP_UNEXPECTED_ERROR;
 
 		if(GET_LN_URI_QNAME(ctx->schema->uriTable, ctQNameID).typeGrammar == INDEX_MAX)
@@ -1336,7 +1346,7 @@ static errorCode getSequenceProtoGrammar(BuildContext* ctx, QualifiedTreeTableEn
 	Index dummyTblIndx;
 	Index i;
 
-	TRY(createDynArray(&partGrammarTbl.dynArray, sizeof(ProtoGrammar*), 30));
+	TRY(createDynArray(&partGrammarTbl.dynArray, sizeof(ProtoGrammar*), 30, NULL));
 
 	TRY(parseOccuranceAttribute(seqEntry->entry->attributePointers[ATTRIBUTE_MIN_OCCURS], &minOccurs));
 	TRY(parseOccuranceAttribute(seqEntry->entry->attributePointers[ATTRIBUTE_MAX_OCCURS], &maxOccurs));
@@ -1407,7 +1417,7 @@ static errorCode getAnyProtoGrammar(BuildContext* ctx, QualifiedTreeTableEntry*
 	int maxOccurs = 1;
 	NsTable nsTable;
 
-	TRY(createDynArray(&nsTable.dynArray, sizeof(String), 5));
+	TRY(createDynArray(&nsTable.dynArray, sizeof(String), 5, NULL));
 
 	TRY(getNsList(anyEntry->treeT, anyEntry->entry->attributePointers[ATTRIBUTE_NAMESPACE], &nsTable));
 
@@ -1453,7 +1463,7 @@ static errorCode getChoiceProtoGrammar(BuildContext* ctx, QualifiedTreeTableEntr
 	if(minOccurs < 0 || maxOccurs < -1)
 		return EXIP_UNEXPECTED_ERROR;
 
-	TRY(createDynArray(&particleProtoGrammarArray.dynArray, sizeof(ProtoGrammar*), 15));
+	TRY(createDynArray(&particleProtoGrammarArray.dynArray, sizeof(ProtoGrammar*), 15, NULL));
 
 	nextIterator = chEntry->entry->child;
 	while(nextIterator.entry != NULL)
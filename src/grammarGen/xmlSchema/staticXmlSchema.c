@@ -15502,7 +15502,7 @@ static CONST EnumDefinition xmlscm_enumTable[12] = {
 
 CONST EXIPSchema xmlscm_schema =
 {
-    {NULL, NULL},
+    {NULL, 0},
     {{sizeof(UriEntry), 4, 4}, xmlscm_uriEntry, 4},
     {xmlscm_docGrammarRule, 100663296, 2},
     {{sizeof(SimpleType), 62, 62}, xmlscm_simpleTypes, 62},
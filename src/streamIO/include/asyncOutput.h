@@ -0,0 +1,75 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file asyncOutput.h
+ * @brief Double-buffered output of the EXI stream: full buffers are written
+ * to the output stream by a background thread while the encoding continues
+ * in the next buffer. Available when EXIP_ASYNC_OUTPUT is ON.
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#ifndef ASYNCOUTPUT_H_
+#define ASYNCOUTPUT_H_
+
+#include "procTypes.h"
+#include "errorHandle.h"
+
+/**
+ * @def IS_ASYNC_OUTPUT(strm)
+ * 		TRUE if the full buffers of the EXI stream strm are written by
+ * 		a background thread (see createAsyncOutput())
+ */
+#if EXIP_ASYNC_OUTPUT == ON
+# define IS_ASYNC_OUTPUT(strm) ((strm)->asyncOutput != NULL)
+#else
+# define IS_ASYNC_OUTPUT(strm) FALSE
+#endif
+
+#if EXIP_ASYNC_OUTPUT == ON
+
+/**
+ * @brief Switches the output of an EXI stream to double-buffered mode
+ * The strm->buffer.buf becomes one of bufCount buffers of strm->buffer.bufLen
+ * bytes; the others are allocated here. A writer thread is started that
+ * passes the full buffers to strm->buffer.ioStrm.readWriteToStream in order.
+ *
+ * @param[in, out] strm EXI stream with an output stream set
+ * @param[in] bufCount number of buffers; at least 2
+ * @return Error handling code
+ */
+errorCode createAsyncOutput(EXIStream* strm, unsigned int bufCount);
+
+/**
+ * @brief Hands over the first strm->context.bufferIndx bytes of the buffer
+ * to the writer thread and continues in a free buffer. The bits of a
+ * partially written octet are moved to the start of the new buffer.
+ * Blocks while all the other buffers are still waiting to be written.
+ *
+ * @param[in, out] strm EXI stream in double-buffered mode
+ * @return Error handling code - the error of a failed background write, if any
+ */
+errorCode submitAsyncOutput(EXIStream* strm);
+
+/**
+ * @brief Hands over the last size bytes of the buffer to the writer thread,
+ * waits for all pending writes and stops the thread. The application buffer
+ * is restored in strm->buffer.buf and the other buffers are freed.
+ *
+ * @param[in, out] strm EXI stream in double-buffered mode
+ * @param[in] size number of bytes in the buffer to be written
+ * @return Error handling code - the error of a failed background write, if any
+ */
+errorCode closeAsyncOutput(EXIStream* strm, Index size);
+
+#endif /* EXIP_ASYNC_OUTPUT == ON */
+
+#endif /* ASYNCOUTPUT_H_ */
@@ -21,6 +21,40 @@
 #include "procTypes.h"
 #include "errorHandle.h"
 
+/**
+ * @def READ_BE64(p)
+ * 		Assembles the 8 octets starting at p (unsigned char*) into a big-endian
+ * 		64-bit word. Optimizing compilers turn this into a single unaligned load
+ * 		(plus a byte swap on little-endian targets).
+ */
+#define READ_BE64(p) (((uint64_t) (p)[0] << 56) | ((uint64_t) (p)[1] << 48) | \
+					  ((uint64_t) (p)[2] << 40) | ((uint64_t) (p)[3] << 32) | \
+					  ((uint64_t) (p)[4] << 24) | ((uint64_t) (p)[5] << 16) | \
+					  ((uint64_t) (p)[6] << 8)  |  (uint64_t) (p)[7])
+
+/**
+ * @def WRITE_BE64(p, w)
+ * 		Stores the 64-bit word w as 8 big-endian octets starting at p (unsigned char*).
+ * 		The counterpart of READ_BE64(p); merged into a single store by optimizing compilers.
+ */
+#define WRITE_BE64(p, w) do { (p)[0] = (unsigned char) ((w) >> 56); (p)[1] = (unsigned char) ((w) >> 48); \
+							  (p)[2] = (unsigned char) ((w) >> 40); (p)[3] = (unsigned char) ((w) >> 32); \
+							  (p)[4] = (unsigned char) ((w) >> 24); (p)[5] = (unsigned char) ((w) >> 16); \
+							  (p)[6] = (unsigned char) ((w) >> 8);  (p)[7] = (unsigned char) (w); } while(0)
+
+/**
+ * @def UNSIGNED_INT_MAX_OCTETS
+ * 		The number of 7-bit groups (octets) needed to encode any UnsignedInteger value
+ */
+#define UNSIGNED_INT_MAX_OCTETS ((sizeof(UnsignedInteger)*8 + 6) / 7)
+
+/**
+ * @def ASCII_RUN_CHUNK
+ * 		The maximum number of 7-bit ASCII characters transferred at once between
+ * 		a non byte-aligned EXI stream and a String
+ */
+#define ASCII_RUN_CHUNK 64
+
 /**
  * @brief Moves the BitPointer with certain positions. Takes care of byteIndex increasing when
  *        the movement cross a byte boundary
@@ -48,8 +82,50 @@ unsigned char getBitsNumber(uint64_t val);
  */
 unsigned int log2INT(uint64_t val);
 
+/**
+ * @brief Scans a run of single-octet EXI Unsigned Integers, i.e. octets below 0x80 such as the
+ * code points of 7-bit ASCII characters, starting at a given bit offset.
+ * Uses SSE2 when available and scans a 64-bit word at a time otherwise.
+ *
+ * @param[in] src the byte containing the first octet; when bitPointer > 0 the
+ * byte src[maxOctets] must be readable as well
+ * @param[in] bitPointer the bit offset of the first octet within src[0] (0-7)
+ * @param[in] maxOctets the maximum number of octets to scan
+ * @param[out] dst receives the byte-aligned octets when bitPointer > 0; not used when
+ * bitPointer == 0 as the octets can be taken directly from src
+ * @return The number of leading octets below 0x80
+ */
+Index getAsciiRun(const unsigned char* src, unsigned char bitPointer, Index maxOctets, unsigned char* dst);
+
+/**
+ * @brief Copies octets that start at a given bit offset into byte-aligned memory.
+ * Shifts a 64-bit word at a time.
+ *
+ * @param[in] src the byte containing the first bit of the first octet; when bitPointer > 0 the
+ * byte src[count] must be readable as well
+ * @param[in] bitPointer the bit offset of the first octet within src[0] (0-7)
+ * @param[in] count the number of octets to copy
+ * @param[out] dst receives the octets
+ */
+void getAlignedOctets(const unsigned char* src, unsigned char bitPointer, Index count, unsigned char* dst);
+
+/**
+ * @brief Copies byte-aligned octets to a given bit offset.
+ * The counterpart of getAlignedOctets(); shifts a 64-bit word at a time.
+ * The first bitPointer bits of dst[0] are preserved and the unused bits
+ * of the last byte are set to 0.
+ *
+ * @param[in] src the octets
+ * @param[in] count the number of octets to copy
+ * @param[in] bitPointer the bit offset within dst[0] where the first octet starts (1-7)
+ * @param[in, out] dst receives the octets; count + 1 bytes are written
+ */
+void putShiftedOctets(const unsigned char* src, Index count, unsigned char bitPointer, unsigned char* dst);
+
 /**
  * @brief Reads an EXI stream chunk using buffer.ioStrm.readWriteToStream if available
+ * In read-ahead mode (see readAhead.h) the parsing continues in the next block
+ * read by the reader thread instead.
  * @param[in] strm EXI stream of bits
  * @param[in] numBytesToBeRead the number of bytes that are requested for parsing
  *
@@ -57,8 +133,22 @@ unsigned int log2INT(uint64_t val);
  */
 errorCode readEXIChunkForParsing(EXIStream* strm, unsigned int numBytesToBeRead);
 
+/**
+ * @brief Moves the parsing to a byte of the EXI stream
+ * A mapped buffer is only repositioned. Otherwise the content of the buffer is
+ * dropped and the input must continue from the byte at byteOffset: it is read
+ * using buffer.ioStrm.readWriteToStream if available. The bitPointer is kept.
+ * @param[in, out] strm EXI stream of bits
+ * @param[in] byteOffset the offset of the byte in the EXI stream
+ *
+ * @return EXIP_INVALID_EXI_INPUT if byteOffset is outside of a mapped buffer
+ */
+errorCode seekEXIStream(EXIStream* strm, Index byteOffset);
+
 /**
  * @brief Flushes the EXI buffer using buffer.ioStrm.readWriteToStream if available
+ * In double-buffered mode (see asyncOutput.h) the buffer is handed over to
+ * the writer thread and strm->buffer.buf is switched to a free buffer.
  * @param[in] strm EXI stream of bits
  *
  * @return The number of bits needed
@@ -0,0 +1,74 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file readAhead.h
+ * @brief Read-ahead of the parsed EXI stream: a background thread reads
+ * the next blocks of the input while the current one is being parsed.
+ * Available when EXIP_READ_AHEAD is ON.
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#ifndef READAHEAD_H_
+#define READAHEAD_H_
+
+#include "procTypes.h"
+#include "errorHandle.h"
+
+/**
+ * @def IS_READ_AHEAD(strm)
+ * 		TRUE if the input of the EXI stream strm is read by
+ * 		a background thread (see createReadAhead())
+ */
+#if EXIP_READ_AHEAD == ON
+# define IS_READ_AHEAD(strm) ((strm)->readAhead != NULL)
+#else
+# define IS_READ_AHEAD(strm) FALSE
+#endif
+
+#if EXIP_READ_AHEAD == ON
+
+/**
+ * @brief Starts reading the input of an EXI stream ahead of the parsing
+ * A reader thread fills up to blockCount blocks of strm->buffer.bufLen bytes
+ * using strm->buffer.ioStrm.readWriteToStream. The content of strm->buffer
+ * is parsed first; the application buffer is not refilled afterwards.
+ *
+ * @param[in, out] strm EXI stream with an input stream set
+ * @param[in] blockCount number of blocks; at least 2
+ * @return Error handling code
+ */
+errorCode createReadAhead(EXIStream* strm, unsigned int blockCount);
+
+/**
+ * @brief Continues the parsing in the next block read by the reader thread
+ * The unparsed octets from strm->context.bufferIndx to strm->buffer.bufContent
+ * are placed in front of the new block so that they remain contiguous with it.
+ * Blocks until the next block is read.
+ *
+ * @param[in, out] strm EXI stream in read-ahead mode
+ * @return EXIP_BUFFER_END_REACHED at the end of the input, in which case
+ * the stream is not changed
+ */
+errorCode nextReadAheadBlock(EXIStream* strm);
+
+/**
+ * @brief Stops the reader thread and frees the blocks
+ * The application buffer is restored in strm->buffer.buf (with no content).
+ * A read that is in progress is waited for.
+ *
+ * @param[in, out] strm EXI stream in read-ahead mode
+ */
+void destroyReadAhead(EXIStream* strm);
+
+#endif /* EXIP_READ_AHEAD == ON */
+
+#endif /* READAHEAD_H_ */
@@ -80,10 +80,26 @@ errorCode decodeString(EXIStream* strm, String* string_val);
  */
 errorCode decodeStringOnly(EXIStream* strm, Index str_length, String* string_val);
 
+/**
+ * @brief Points a String to its characters in the input buffer instead of decoding them
+ * Possible only when the whole EXI stream is in a mapped buffer (see initParserMapped()),
+ * the stream is byte-aligned and all the characters are 7-bit ASCII.
+ * The stream is not moved when the string cannot be referenced.
+ *
+ * @param[in, out] strm EXI stream of bits
+ * @param[in] str_length the length of the string
+ * @param[out] string_val the string referencing the buffer
+ * @return TRUE if the string is referenced and the stream is moved past it, FALSE otherwise
+ */
+boolean decodeStringReference(EXIStream* strm, Index str_length, String* string_val);
+
 /**
  * @brief Decode EXI Binary type
  * Decode a binary value as a length-prefixed sequence of octets.
- * Dynamically allocate a memory for the buffer
+ * When the stream is byte-aligned and the value is fully in the buffer,
+ * binary_val points directly into strm->buffer. Otherwise the value is
+ * copied into strm->scratch. In both cases binary_val must not be freed
+ * and is valid only until the next decoding call on the stream.
  *
  * @param[in] strm EXI stream of bits
  * @param[out] binary_val decoded binary value
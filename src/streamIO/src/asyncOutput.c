@@ -0,0 +1,209 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file asyncOutput.c
+ * @brief Implementation of the double-buffered output of the EXI stream
+ * using POSIX threads
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "asyncOutput.h"
+
+#if EXIP_ASYNC_OUTPUT == ON
+
+#include <pthread.h>
+#include "spscQueue.h"
+
+/**
+ * A buffer of the stream and the number of bytes to be written from it
+ */
+struct OutputBuffer
+{
+	char* buf;
+	Index size;
+};
+
+/**
+ * The buffers are passed between the encoder and the writer thread through
+ * two lock-free queues: the pending ones in the order of the stream and the
+ * free ones that can be filled by the encoder. A thread only blocks when its
+ * queue is empty, i.e. when the writer has caught up or all buffers are full.
+ */
+struct AsyncOutput
+{
+	pthread_t writer;
+	/** bufCount buffers; the first one is the buffer of the application */
+	struct OutputBuffer* buffers;
+	unsigned int bufCount;
+	/** The buffer being filled by the encoder */
+	struct OutputBuffer* current;
+	/** Written by the writer in stream order; NULL stops the writer */
+	SPSCQueue pending;
+	/** Written back by the writer and taken by the encoder */
+	SPSCQueue freeBufs;
+	/** The error of a failed write; the following buffers are discarded */
+	errorCode writeErr;
+	IOStream ioStrm;
+};
+
+static void* asyncWriter(void* arg)
+{
+	AsyncOutput* out = (AsyncOutput*) arg;
+	struct OutputBuffer* next;
+	void* item;
+
+	while(TRUE)
+	{
+		waitSPSCQueue(&out->pending, 1);
+		popSPSCQueue(&out->pending, &item);
+		if(item == NULL)
+			break;
+		next = (struct OutputBuffer*) item;
+
+		if(EXIP_ATOMIC_LOAD(&out->writeErr) == EXIP_OK &&
+				out->ioStrm.readWriteToStream(next->buf, next->size, out->ioStrm.stream) < next->size)
+			EXIP_ATOMIC_STORE(&out->writeErr, EXIP_BUFFER_END_REACHED);
+
+		pushSPSCQueue(&out->freeBufs, next);
+	}
+
+	return NULL;
+}
+
+static void freeAsyncOutput(AsyncOutput* out, unsigned int created)
+{
+	unsigned int i;
+
+	for(i = 1; i < created; i++)
+		EXIP_MFREE(out->buffers[i].buf);
+	EXIP_MFREE(out->buffers);
+	EXIP_MFREE(out);
+}
+
+errorCode createAsyncOutput(EXIStream* strm, unsigned int bufCount)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	AsyncOutput* out;
+	unsigned int i;
+
+	if(bufCount < 2 || strm->buffer.ioStrm.readWriteToStream == NULL || strm->buffer.bufLen == 0)
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+	if(strm->asyncOutput != NULL)
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	out = (AsyncOutput*) EXIP_MALLOC(sizeof(AsyncOutput));
+	if(out == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	out->buffers = (struct OutputBuffer*) EXIP_MALLOC(sizeof(struct OutputBuffer)*bufCount);
+	if(out->buffers == NULL)
+	{
+		EXIP_MFREE(out);
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	}
+
+	out->bufCount = bufCount;
+	out->buffers[0].buf = strm->buffer.buf;
+	out->current = &out->buffers[0];
+	out->writeErr = EXIP_OK;
+	out->ioStrm = strm->buffer.ioStrm;
+
+	for(i = 1; i < bufCount; i++)
+	{
+		out->buffers[i].buf = (char*) EXIP_MALLOC(strm->buffer.bufLen);
+		if(out->buffers[i].buf == NULL)
+		{
+			freeAsyncOutput(out, i);
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		}
+	}
+
+	// All buffers and the NULL that stops the writer can be pending at once
+	tmp_err_code = createSPSCQueue(&out->pending, bufCount + 1);
+	if(tmp_err_code != EXIP_OK)
+	{
+		freeAsyncOutput(out, bufCount);
+		return tmp_err_code;
+	}
+	tmp_err_code = createSPSCQueue(&out->freeBufs, bufCount);
+	if(tmp_err_code != EXIP_OK)
+	{
+		destroySPSCQueue(&out->pending);
+		freeAsyncOutput(out, bufCount);
+		return tmp_err_code;
+	}
+
+	for(i = 1; i < bufCount; i++)
+		pushSPSCQueue(&out->freeBufs, &out->buffers[i]);
+
+	if(pthread_create(&out->writer, NULL, asyncWriter, out) != 0)
+	{
+		destroySPSCQueue(&out->freeBufs);
+		destroySPSCQueue(&out->pending);
+		freeAsyncOutput(out, bufCount);
+		return EXIP_UNEXPECTED_ERROR;
+	}
+
+	strm->asyncOutput = out;
+	return EXIP_OK;
+}
+
+errorCode submitAsyncOutput(EXIStream* strm)
+{
+	AsyncOutput* out = strm->asyncOutput;
+	char leftOverBits = 0;
+	void* item;
+
+	// The byte at bufferIndx holds the bits of a partially written octet
+	if(strm->context.bufferIndx < strm->buffer.bufLen)
+		leftOverBits = strm->buffer.buf[strm->context.bufferIndx];
+
+	out->current->size = strm->context.bufferIndx;
+	pushSPSCQueue(&out->pending, out->current);
+
+	waitSPSCQueue(&out->freeBufs, 1);
+	popSPSCQueue(&out->freeBufs, &item);
+	out->current = (struct OutputBuffer*) item;
+
+	out->current->buf[0] = leftOverBits;
+	strm->buffer.buf = out->current->buf;
+	strm->context.bufferIndx = 0;
+
+	return EXIP_ATOMIC_LOAD(&out->writeErr);
+}
+
+errorCode closeAsyncOutput(EXIStream* strm, Index size)
+{
+	AsyncOutput* out = strm->asyncOutput;
+	errorCode writeErr;
+
+	if(size > 0)
+	{
+		out->current->size = size;
+		pushSPSCQueue(&out->pending, out->current);
+	}
+	pushSPSCQueue(&out->pending, NULL);
+
+	pthread_join(out->writer, NULL);
+	destroySPSCQueue(&out->freeBufs);
+	destroySPSCQueue(&out->pending);
+
+	writeErr = out->writeErr;
+	strm->buffer.buf = out->buffers[0].buf;
+	strm->context.bufferIndx = 0;
+	strm->asyncOutput = NULL;
+	freeAsyncOutput(out, out->bufCount);
+
+	return writeErr;
+}
+
+#endif /* EXIP_ASYNC_OUTPUT == ON */
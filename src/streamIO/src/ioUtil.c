@@ -16,6 +16,15 @@
  */
 
 #include "ioUtil.h"
+#include "asyncOutput.h"
+#include "readAhead.h"
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+/** The most significant bits of the octets in a 64-bit word */
+#define OCTET_HIGH_BITS 0x8080808080808080ULL
 
 void moveBitPointer(EXIStream* strm, unsigned int bitPositions)
 {
@@ -98,11 +107,120 @@ unsigned int log2INT(uint64_t val)
 	return r;
 }
 
+Index getAsciiRun(const unsigned char* src, unsigned char bitPointer, Index maxOctets, unsigned char* dst)
+{
+	Index i = 0;
+	uint64_t word;
+
+	if(bitPointer == 0)
+	{
+#if defined(__SSE2__)
+		while(i + 16 <= maxOctets)
+		{
+			int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) (src + i)));
+			if(mask != 0)
+			{
+				while((mask & 1) == 0)
+				{
+					mask = mask >> 1;
+					i++;
+				}
+				return i;
+			}
+			i += 16;
+		}
+#endif
+		while(i + sizeof(uint64_t) <= maxOctets)
+		{
+			memcpy(&word, src + i, sizeof(uint64_t));
+			if(word & OCTET_HIGH_BITS)
+				break;
+			i += sizeof(uint64_t);
+		}
+
+		while(i < maxOctets && src[i] < 0x80)
+			i++;
+	}
+	else
+	{
+		// Shift eight octets at a time into byte alignment
+		while(i + sizeof(uint64_t) <= maxOctets)
+		{
+			word = (READ_BE64(src + i) << bitPointer) | (src[i + 8] >> (8 - bitPointer));
+			if(word & OCTET_HIGH_BITS)
+				break;
+			WRITE_BE64(dst + i, word);
+			i += sizeof(uint64_t);
+		}
+
+		while(i < maxOctets)
+		{
+			unsigned char octet = (unsigned char) ((src[i] << bitPointer) | (src[i + 1] >> (8 - bitPointer)));
+			if(octet & 0x80)
+				break;
+			dst[i] = octet;
+			i++;
+		}
+	}
+
+	return i;
+}
+
+void getAlignedOctets(const unsigned char* src, unsigned char bitPointer, Index count, unsigned char* dst)
+{
+	Index i = 0;
+
+	if(bitPointer == 0)
+	{
+		memcpy(dst, src, count);
+		return;
+	}
+
+	while(i + sizeof(uint64_t) <= count)
+	{
+		WRITE_BE64(dst + i, (READ_BE64(src + i) << bitPointer) | (src[i + 8] >> (8 - bitPointer)));
+		i += sizeof(uint64_t);
+	}
+
+	for(; i < count; i++)
+		dst[i] = (unsigned char) ((src[i] << bitPointer) | (src[i + 1] >> (8 - bitPointer)));
+}
+
+void putShiftedOctets(const unsigned char* src, Index count, unsigned char bitPointer, unsigned char* dst)
+{
+	Index i = 0;
+	unsigned char carry = dst[0] & (unsigned char) (0xFF << (8 - bitPointer));
+
+	while(i + sizeof(uint64_t) <= count)
+	{
+		WRITE_BE64(dst + i, (READ_BE64(src + i) >> bitPointer) | ((uint64_t) carry << 56));
+		carry = (unsigned char) (src[i + 7] << (8 - bitPointer));
+		i += sizeof(uint64_t);
+	}
+
+	for(; i < count; i++)
+	{
+		dst[i] = carry | (src[i] >> bitPointer);
+		carry = (unsigned char) (src[i] << (8 - bitPointer));
+	}
+
+	dst[count] = carry;
+}
+
 errorCode readEXIChunkForParsing(EXIStream* strm, unsigned int numBytesToBeRead)
 {
 	Index bytesCopied = strm->buffer.bufContent - strm->context.bufferIndx;
 	Index bytesRead = 0;
 
+#if EXIP_READ_AHEAD == ON
+	if(IS_READ_AHEAD(strm))
+	{
+		if(nextReadAheadBlock(strm) != EXIP_OK || strm->buffer.bufContent < numBytesToBeRead)
+			return EXIP_UNEXPECTED_ERROR;
+		return EXIP_OK;
+	}
+#endif
+
 	if(strm->buffer.ioStrm.readWriteToStream == NULL)
 		return EXIP_BUFFER_END_REACHED;
 
@@ -119,7 +237,30 @@ errorCode readEXIChunkForParsing(EXIStream* strm, unsigned int numBytesToBeRead)
 	if(strm->buffer.bufContent < numBytesToBeRead)
 		return EXIP_UNEXPECTED_ERROR;
 
+	strm->context.bufferOffset += strm->context.bufferIndx;
+	strm->context.bufferIndx = 0;
+
+	return EXIP_OK;
+}
+
+errorCode seekEXIStream(EXIStream* strm, Index byteOffset)
+{
+	if(strm->bufferMapped)
+	{
+		if(byteOffset >= strm->buffer.bufContent)
+			return EXIP_INVALID_EXI_INPUT;
+
+		strm->context.bufferOffset = 0;
+		strm->context.bufferIndx = byteOffset;
+		return EXIP_OK;
+	}
+
+	strm->context.bufferOffset = byteOffset;
 	strm->context.bufferIndx = 0;
+	strm->buffer.bufContent = 0;
+
+	if(strm->buffer.ioStrm.readWriteToStream != NULL)
+		return readEXIChunkForParsing(strm, 1);
 
 	return EXIP_OK;
 }
@@ -129,6 +270,11 @@ errorCode writeEncodedEXIChunk(EXIStream* strm)
 	char leftOverBits;
 	Index numBytesWritten = 0;
 
+#if EXIP_ASYNC_OUTPUT == ON
+	if(IS_ASYNC_OUTPUT(strm))
+		return submitAsyncOutput(strm);
+#endif
+
 	if(strm->buffer.ioStrm.readWriteToStream == NULL)
 		return EXIP_BUFFER_END_REACHED;
 
@@ -0,0 +1,270 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file readAhead.c
+ * @brief Implementation of the read-ahead of the parsed EXI stream
+ * using POSIX threads
+ *
+ * @date Oct 16, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include "readAhead.h"
+
+#if EXIP_READ_AHEAD == ON
+
+#include <pthread.h>
+
+/**
+ * A block read by the reader thread. The input is stored after
+ * headRoom bytes that receive the unparsed octets of the previous block.
+ */
+struct ReadBlock
+{
+	char* mem;
+	Index size;
+};
+
+/**
+ * The blocks are passed between the reader thread and the parser through
+ * two rings of blockCount entries: the free blocks and the read ones in
+ * the order of the input. The hand-off happens once per block so a mutex
+ * and a condition variable are enough.
+ */
+struct ReadAhead
+{
+	pthread_t reader;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	/** The buffer of the application; restored by destroyReadAhead() */
+	char* appBuf;
+	/** The bytes in front of the data of a block: the largest unparsed tail (bufLen/2) */
+	Index headRoom;
+	Index bufLen;
+	unsigned int blockCount;
+	/** All blocks; freed by destroyReadAhead() */
+	char** pool;
+	/** The block that is parsed; NULL while parsing the application buffer */
+	char* current;
+	struct ReadBlock* ready;
+	unsigned int readyHead;
+	unsigned int readyCount;
+	char** freeBlocks;
+	unsigned int freeHead;
+	unsigned int freeCount;
+	/** Set by the reader when the input stream returns no data */
+	boolean inputEnd;
+	/** Set by destroyReadAhead() */
+	boolean stopping;
+	IOStream ioStrm;
+};
+
+static void* readAheadWorker(void* arg)
+{
+	ReadAhead* ra = (ReadAhead*) arg;
+	char* mem;
+	Index size;
+
+	pthread_mutex_lock(&ra->lock);
+	while(TRUE)
+	{
+		while(ra->freeCount == 0 && !ra->stopping)
+			pthread_cond_wait(&ra->cond, &ra->lock);
+
+		if(ra->stopping)
+			break;
+
+		mem = ra->freeBlocks[ra->freeHead];
+		ra->freeHead = (ra->freeHead + 1) % ra->blockCount;
+		ra->freeCount--;
+		pthread_mutex_unlock(&ra->lock);
+
+		size = ra->ioStrm.readWriteToStream(mem + ra->headRoom, ra->bufLen, ra->ioStrm.stream);
+
+		pthread_mutex_lock(&ra->lock);
+		if(size == 0)
+		{
+			ra->freeBlocks[(ra->freeHead + ra->freeCount) % ra->blockCount] = mem;
+			ra->freeCount++;
+			ra->inputEnd = TRUE;
+			pthread_cond_broadcast(&ra->cond);
+			break;
+		}
+
+		ra->ready[(ra->readyHead + ra->readyCount) % ra->blockCount].mem = mem;
+		ra->ready[(ra->readyHead + ra->readyCount) % ra->blockCount].size = size;
+		ra->readyCount++;
+		pthread_cond_broadcast(&ra->cond);
+	}
+	pthread_mutex_unlock(&ra->lock);
+
+	return NULL;
+}
+
+static void freeReadAhead(ReadAhead* ra, unsigned int allocated)
+{
+	unsigned int i;
+
+	if(ra->pool != NULL)
+	{
+		for(i = 0; i < allocated; i++)
+			EXIP_MFREE(ra->pool[i]);
+		EXIP_MFREE(ra->pool);
+	}
+	EXIP_MFREE(ra->ready);
+	EXIP_MFREE(ra->freeBlocks);
+	EXIP_MFREE(ra);
+}
+
+errorCode createReadAhead(EXIStream* strm, unsigned int blockCount)
+{
+	ReadAhead* ra;
+	unsigned int i;
+
+	if(blockCount < 2 || strm->buffer.ioStrm.readWriteToStream == NULL || strm->buffer.bufLen < 2)
+		return EXIP_INVALID_EXIP_CONFIGURATION;
+	if(strm->readAhead != NULL || strm->bufferMapped)
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	ra = (ReadAhead*) EXIP_MALLOC(sizeof(ReadAhead));
+	if(ra == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	ra->pool = (char**) EXIP_MALLOC(sizeof(char*)*blockCount);
+	ra->ready = (struct ReadBlock*) EXIP_MALLOC(sizeof(struct ReadBlock)*blockCount);
+	ra->freeBlocks = (char**) EXIP_MALLOC(sizeof(char*)*blockCount);
+	if(ra->pool == NULL || ra->ready == NULL || ra->freeBlocks == NULL)
+	{
+		freeReadAhead(ra, 0);
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+	}
+
+	ra->appBuf = strm->buffer.buf;
+	ra->bufLen = strm->buffer.bufLen;
+	ra->headRoom = strm->buffer.bufLen/2;
+	ra->blockCount = blockCount;
+	ra->current = NULL;
+	ra->readyHead = 0;
+	ra->readyCount = 0;
+	ra->freeHead = 0;
+	ra->freeCount = 0;
+	ra->inputEnd = FALSE;
+	ra->stopping = FALSE;
+	ra->ioStrm = strm->buffer.ioStrm;
+
+	for(i = 0; i < blockCount; i++)
+	{
+		ra->pool[i] = (char*) EXIP_MALLOC(ra->headRoom + ra->bufLen);
+		if(ra->pool[i] == NULL)
+		{
+			freeReadAhead(ra, i);
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		}
+		ra->freeBlocks[i] = ra->pool[i];
+		ra->freeCount++;
+	}
+
+	if(pthread_mutex_init(&ra->lock, NULL) != 0)
+	{
+		freeReadAhead(ra, blockCount);
+		return EXIP_UNEXPECTED_ERROR;
+	}
+	if(pthread_cond_init(&ra->cond, NULL) != 0)
+	{
+		pthread_mutex_destroy(&ra->lock);
+		freeReadAhead(ra, blockCount);
+		return EXIP_UNEXPECTED_ERROR;
+	}
+	if(pthread_create(&ra->reader, NULL, readAheadWorker, ra) != 0)
+	{
+		pthread_cond_destroy(&ra->cond);
+		pthread_mutex_destroy(&ra->lock);
+		freeReadAhead(ra, blockCount);
+		return EXIP_UNEXPECTED_ERROR;
+	}
+
+	strm->readAhead = ra;
+	return EXIP_OK;
+}
+
+errorCode nextReadAheadBlock(EXIStream* strm)
+{
+	ReadAhead* ra = strm->readAhead;
+	Index bytesCopied = 0;
+	struct ReadBlock next;
+	char* data;
+
+	if(strm->buffer.bufContent > strm->context.bufferIndx)
+		bytesCopied = strm->buffer.bufContent - strm->context.bufferIndx;
+
+	/* Checks for possible overlaps when copying the left Over Bits,
+	 * normally should not happen when the size of strm->buffer is set
+	 * reasonably (16 bytes or higher) */
+	if(bytesCopied > ra->headRoom)
+		return EXIP_INCONSISTENT_PROC_STATE;
+
+	pthread_mutex_lock(&ra->lock);
+	while(ra->readyCount == 0 && !ra->inputEnd)
+		pthread_cond_wait(&ra->cond, &ra->lock);
+
+	if(ra->readyCount == 0)
+	{
+		pthread_mutex_unlock(&ra->lock);
+		return EXIP_BUFFER_END_REACHED;
+	}
+
+	next = ra->ready[ra->readyHead];
+	ra->readyHead = (ra->readyHead + 1) % ra->blockCount;
+	ra->readyCount--;
+	pthread_mutex_unlock(&ra->lock);
+
+	data = next.mem + ra->headRoom - bytesCopied;
+	memcpy(data, strm->buffer.buf + strm->context.bufferIndx, bytesCopied);
+
+	// The previous block can be refilled only after its tail is copied
+	if(ra->current != NULL)
+	{
+		pthread_mutex_lock(&ra->lock);
+		ra->freeBlocks[(ra->freeHead + ra->freeCount) % ra->blockCount] = ra->current;
+		ra->freeCount++;
+		pthread_cond_broadcast(&ra->cond);
+		pthread_mutex_unlock(&ra->lock);
+	}
+	ra->current = next.mem;
+
+	strm->context.bufferOffset += strm->buffer.bufContent - bytesCopied;
+	strm->buffer.buf = data;
+	strm->buffer.bufContent = bytesCopied + next.size;
+	strm->context.bufferIndx = 0;
+
+	return EXIP_OK;
+}
+
+void destroyReadAhead(EXIStream* strm)
+{
+	ReadAhead* ra = strm->readAhead;
+
+	pthread_mutex_lock(&ra->lock);
+	ra->stopping = TRUE;
+	pthread_cond_broadcast(&ra->cond);
+	pthread_mutex_unlock(&ra->lock);
+
+	pthread_join(ra->reader, NULL);
+	pthread_cond_destroy(&ra->cond);
+	pthread_mutex_destroy(&ra->lock);
+
+	strm->buffer.buf = ra->appBuf;
+	strm->buffer.bufContent = 0;
+	strm->context.bufferIndx = 0;
+	strm->readAhead = NULL;
+	freeReadAhead(ra, ra->blockCount);
+}
+
+#endif /* EXIP_READ_AHEAD == ON */
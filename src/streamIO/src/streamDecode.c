@@ -18,6 +18,7 @@
 #include "streamDecode.h"
 #include "streamRead.h"
 #include "stringManipulate.h"
+#include "memManagement.h"
 #include "ioUtil.h"
 #include <math.h>
 
@@ -74,6 +75,37 @@ errorCode decodeUnsignedInteger(EXIStream* strm, UnsignedInteger* int_val)
 	*int_val = 0;
 
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, (">> (uint)"));
+
+	if(strm->context.bufferIndx + UNSIGNED_INT_MAX_OCTETS < strm->buffer.bufContent)
+	{
+		// The longest possible value is resident in the buffer: scan the octets directly
+		// without per-octet bounds checks. The extra byte in the condition above covers
+		// the spill-over of the last octet when the stream is not byte-aligned
+		unsigned char* buf = (unsigned char*) strm->buffer.buf + strm->context.bufferIndx;
+		unsigned char bp = strm->context.bitPointer;
+		Index octets = 0;
+
+		do
+		{
+			if(bp == 0)
+				tmp_byte_buf = buf[octets];
+			else
+				tmp_byte_buf = (unsigned char) ((buf[octets] << bp) | (buf[octets + 1] >> (8 - bp)));
+
+			*int_val += ((UnsignedInteger) (tmp_byte_buf & 0x7F)) << i;
+			i += 7;
+			octets++;
+		}
+		while((tmp_byte_buf & 0x80) && octets < UNSIGNED_INT_MAX_OCTETS);
+
+		strm->context.bufferIndx += octets;
+
+		if((tmp_byte_buf & 0x80) == 0)
+			return EXIP_OK;
+
+		// Longer than UnsignedInteger can hold - continue octet by octet below
+	}
+
 	do
 	{
 		TRY(readBits(strm, 8, &tmp_byte_buf));
@@ -92,11 +124,33 @@ errorCode decodeString(EXIStream* strm, String* string_val)
 	UnsignedInteger string_length = 0;
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, (">> (string)"));
 	TRY(decodeUnsignedInteger(strm, &string_length));
+	if(decodeStringReference(strm, (Index) string_length, string_val))
+		return EXIP_OK;
 	TRY(allocateStringMemoryManaged(&(string_val->str),(Index) string_length, &strm->memList));
 
 	return decodeStringOnly(strm,(Index)  string_length, string_val);
 }
 
+boolean decodeStringReference(EXIStream* strm, Index str_length, String* string_val)
+{
+	unsigned char* buf = (unsigned char*) strm->buffer.buf + strm->context.bufferIndx;
+
+	if(!strm->bufferMapped || strm->context.bitPointer != 0 || str_length == 0 ||
+			strm->buffer.bufContent - strm->context.bufferIndx < str_length)
+		return FALSE;
+
+	// Only 7-bit ASCII characters are represented by the same single
+	// octet in the stream and in a String
+	if(getAsciiRun(buf, 0, str_length, NULL) != str_length)
+		return FALSE;
+
+	string_val->str = (CharType*) buf;
+	string_val->length = str_length;
+	strm->context.bufferIndx += str_length;
+
+	return TRUE;
+}
+
 errorCode decodeStringOnly(EXIStream* strm, Index str_length, String* string_val)
 {
 	// Assume no Restricted Character Set is defined
@@ -108,14 +162,46 @@ errorCode decodeStringOnly(EXIStream* strm, Index str_length, String* string_val
 	Index i = 0;
 	Index writerPosition = 0;
 	UnsignedInteger tmp_code_point = 0;
+	unsigned char ascii[ASCII_RUN_CHUNK];
 
-	string_val->length = str_length;
+	// The capacity of the string; set to the actual length once decoded
+	string_val->length = str_length * CHAR_TYPE_MAX_UNITS;
 
-	for(i = 0; i < str_length; i++)
+	while(i < str_length)
 	{
-		TRY(decodeUnsignedInteger(strm, &tmp_code_point));
-		TRY(writeCharToString(string_val, (uint32_t) tmp_code_point, &writerPosition));
+		// The number of octets that are fully available in the buffer (including
+		// the spill-over byte when the stream is not byte-aligned)
+		Index run = 0;
+		unsigned char bp = strm->context.bitPointer;
+		unsigned char* buf = (unsigned char*) strm->buffer.buf + strm->context.bufferIndx;
+
+		if(strm->buffer.bufContent > strm->context.bufferIndx + (bp != 0))
+		{
+			run = strm->buffer.bufContent - strm->context.bufferIndx - (bp != 0);
+			if(run > str_length - i)
+				run = str_length - i;
+			if(bp != 0 && run > ASCII_RUN_CHUNK)
+				run = ASCII_RUN_CHUNK;
+
+			// Characters with code points below 0x80 are single octets
+			run = getAsciiRun(buf, bp, run, ascii);
+		}
+
+		if(run > 0)
+		{
+			TRY(writeAsciiToString(string_val, bp == 0 ? buf : ascii, run, &writerPosition));
+			strm->context.bufferIndx += run;
+			i += run;
+		}
+		else
+		{
+			TRY(decodeUnsignedInteger(strm, &tmp_code_point));
+			TRY(writeCharToString(string_val, (uint32_t) tmp_code_point, &writerPosition));
+			i++;
+		}
 	}
+	string_val->length = writerPosition;
+
 	return EXIP_OK;
 }
 
@@ -124,20 +210,58 @@ errorCode decodeBinary(EXIStream* strm, char** binary_val, Index* nbytes)
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 	UnsignedInteger length = 0;
 	unsigned int int_val = 0;
-	UnsignedInteger i = 0;
+	Index i = 0;
+	Index run;
 
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, (">> (binary)"));
 	TRY(decodeUnsignedInteger(strm, &length));
 	*nbytes = (Index) length;
-	(*binary_val) = (char*) EXIP_MALLOC(length); // This memory should be manually freed after the content handler is invoked
-	if((*binary_val) == NULL)
-		return EXIP_MEMORY_ALLOCATION_ERROR;
 
-	for(i = 0; i < length; i++)
+	if(strm->context.bitPointer == 0 && strm->buffer.bufContent - strm->context.bufferIndx >= length)
+	{
+		// Byte-aligned and fully in the buffer: no copy needed
+		*binary_val = strm->buffer.buf + strm->context.bufferIndx;
+		strm->context.bufferIndx += (Index) length;
+		return EXIP_OK;
+	}
+
+	if(strm->scratch.bufLen < length)
 	{
-		TRY_CATCH(readBits(strm, 8, &int_val), EXIP_MFREE(*binary_val));
-		(*binary_val)[i]=(char) int_val;
+		char* tmp_buf = (char*) EXIP_REALLOCATE(strm->allocator, strm->scratch.buf, (size_t) length);
+		if(tmp_buf == NULL)
+			return EXIP_MEMORY_ALLOCATION_ERROR;
+		strm->scratch.buf = tmp_buf;
+		strm->scratch.bufLen = (Index) length;
 	}
+	*binary_val = strm->scratch.buf;
+
+	while(i < length)
+	{
+		// The octets that are fully available in the buffer (including
+		// the spill-over byte when the stream is not byte-aligned)
+		run = 0;
+		if(strm->buffer.bufContent > strm->context.bufferIndx + (strm->context.bitPointer != 0))
+		{
+			run = strm->buffer.bufContent - strm->context.bufferIndx - (strm->context.bitPointer != 0);
+			if(run > length - i)
+				run = (Index) (length - i);
+		}
+
+		if(run > 0)
+		{
+			getAlignedOctets((unsigned char*) strm->buffer.buf + strm->context.bufferIndx, strm->context.bitPointer, run, (unsigned char*) (*binary_val) + i);
+			strm->context.bufferIndx += run;
+			i += run;
+		}
+		else
+		{
+			// Reads the next chunk of the stream if any
+			TRY(readBits(strm, 8, &int_val));
+			(*binary_val)[i] = (char) int_val;
+			i++;
+		}
+	}
+
 	return EXIP_OK;
 }
 
@@ -19,6 +19,7 @@
 #include "streamWrite.h"
 #include "stringManipulate.h"
 #include "ioUtil.h"
+#include "asyncOutput.h"
 #include <math.h>
 
 
@@ -64,21 +65,45 @@ errorCode encodeBoolean(EXIStream* strm, boolean bool_val)
 errorCode encodeUnsignedInteger(EXIStream* strm, UnsignedInteger int_val)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
-	unsigned int tmp_byte_buf = 0;
-	
+	unsigned char octets[UNSIGNED_INT_MAX_OCTETS];
+	unsigned int count = 0;
+	unsigned int i = 0;
+	unsigned int k;
+
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, (" Write %lu (unsigned)\n", (long unsigned int)int_val));
 	do
 	{
-		tmp_byte_buf = (unsigned int) (int_val & 0x7F);
+		octets[count] = (unsigned char) (int_val & 0x7F);
 		int_val = int_val >> 7;
 		if(int_val)
-			tmp_byte_buf |= 0x80;
+			octets[count] |= 0x80;
 
-		DEBUG_MSG(INFO, DEBUG_STREAM_IO, (">> 0x%.2X", tmp_byte_buf));
-		TRY(writeNBits(strm, 8, tmp_byte_buf));
+		DEBUG_MSG(INFO, DEBUG_STREAM_IO, (">> 0x%.2X", (unsigned int) octets[count]));
+		count++;
 	}
 	while(int_val);
 
+	if(strm->context.bitPointer == 0 && strm->context.bufferIndx + count < strm->buffer.bufLen)
+	{
+		// Byte-aligned and there is space left in the buffer: store the octets directly
+		memcpy(strm->buffer.buf + strm->context.bufferIndx, octets, count);
+		strm->context.bufferIndx += count;
+	}
+	else
+	{
+		// Up to four octets per writeNBits() call
+		while(i < count)
+		{
+			unsigned int bits_val = 0;
+
+			for(k = 0; k < 4 && i + k < count; k++)
+				bits_val = (bits_val << 8) | octets[i + k];
+
+			TRY(writeNBits(strm, (unsigned char) (8*k), bits_val));
+			i += k;
+		}
+	}
+
 	return EXIP_OK;
 }
 
@@ -88,9 +113,11 @@ errorCode encodeString(EXIStream* strm, const String* string_val)
 	//TODO: Handle the case when Restricted Character Set is defined
 
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Index UCSchars;
 
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, (" Prepare to write string"));
-	TRY(encodeUnsignedInteger(strm, (UnsignedInteger)(string_val->length)));
+	TRY(getUCSCharsNumber(string_val, &UCSchars));
+	TRY(encodeUnsignedInteger(strm, (UnsignedInteger) UCSchars));
 
 	return encodeStringOnly(strm, string_val);
 }
@@ -102,19 +129,53 @@ errorCode encodeStringOnly(EXIStream* strm, const String* string_val)
 
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 	uint32_t tmp_val = 0;
-	Index i = 0;
+	Index run;
 	Index readerPosition = 0;
+	unsigned char ascii[ASCII_RUN_CHUNK];
 #if DEBUG_STREAM_IO == ON && EXIP_DEBUG_LEVEL == INFO
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, ("\n Write string, len %u: ", (unsigned int) string_val->length));
 	printString(string_val);
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, ("\n"));
 #endif
-	
-	for(i = 0; i < string_val->length; i++)
+
+	while(readerPosition < string_val->length)
 	{
-		tmp_val = readCharFromString(string_val, &readerPosition);
+		// Characters with code points below 0x80 are encoded as single octets
+		if(strm->context.bitPointer == 0)
+		{
+			// Byte-aligned: copy the run straight into the free space of the buffer
+			run = 0;
+			if(strm->buffer.bufLen > strm->context.bufferIndx + 1)
+			{
+				run = strm->buffer.bufLen - strm->context.bufferIndx - 1;
+				run = readAsciiFromString(string_val, &readerPosition, run, (unsigned char*) strm->buffer.buf + strm->context.bufferIndx);
+				strm->context.bufferIndx += run;
+			}
+		}
+		else
+		{
+			unsigned int k = 0;
+
+			run = readAsciiFromString(string_val, &readerPosition, ASCII_RUN_CHUNK, ascii);
 
-		TRY(encodeUnsignedInteger(strm, (UnsignedInteger) tmp_val));
+			// Up to four octets per writeNBits() call
+			while(k < run)
+			{
+				unsigned int bits_val = ascii[k];
+				unsigned char nbits = 8;
+
+				for(k++; nbits < 32 && k < run; k++, nbits += 8)
+					bits_val = (bits_val << 8) | ascii[k];
+
+				TRY(writeNBits(strm, nbits, bits_val));
+			}
+		}
+
+		if(run == 0)
+		{
+			tmp_val = readCharFromString(string_val, &readerPosition);
+			TRY(encodeUnsignedInteger(strm, (UnsignedInteger) tmp_val));
+		}
 	}
 
 	return EXIP_OK;
@@ -124,13 +185,47 @@ errorCode encodeBinary(EXIStream* strm, char* binary_val, Index nbytes)
 {
 	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 	Index i = 0;
+	Index run;
 
 	TRY(encodeUnsignedInteger(strm, (UnsignedInteger) nbytes));
 
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, (" Write %u (binary bytes)\n", (unsigned int) nbytes));
-	for(i = 0; i < nbytes; i++)
+	while(i < nbytes)
 	{
-		TRY(writeNBits(strm, 8, (unsigned int) binary_val[i]));
+		// The free space in the buffer; the byte at bufferIndx is always
+		// kept as it holds the bits of a partially written octet
+		run = 0;
+		if(strm->buffer.bufLen > strm->context.bufferIndx + 1)
+			run = strm->buffer.bufLen - strm->context.bufferIndx - 1;
+
+		if(strm->context.bitPointer == 0 && nbytes - i >= strm->buffer.bufLen &&
+				strm->buffer.ioStrm.readWriteToStream != NULL && !IS_ASYNC_OUTPUT(strm))
+		{
+			// The rest does not fit even in an empty buffer: flush the buffer
+			// and write the octets directly to the output stream. Not done when
+			// the buffers are written in the background as the order would be lost
+			TRY(writeEncodedEXIChunk(strm));
+			if(strm->buffer.ioStrm.readWriteToStream(binary_val + i, nbytes - i, strm->buffer.ioStrm.stream) < nbytes - i)
+				return EXIP_UNEXPECTED_ERROR;
+			break;
+		}
+
+		if(run == 0)
+		{
+			TRY(writeEncodedEXIChunk(strm));
+			continue;
+		}
+
+		if(run > nbytes - i)
+			run = nbytes - i;
+
+		if(strm->context.bitPointer == 0)
+			memcpy(strm->buffer.buf + strm->context.bufferIndx, binary_val + i, run);
+		else
+			putShiftedOctets((unsigned char*) binary_val + i, run, strm->context.bitPointer, (unsigned char*) strm->buffer.buf + strm->context.bufferIndx);
+
+		strm->context.bufferIndx += run;
+		i += run;
 	}
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, ("\n"));
 	return EXIP_OK;
@@ -153,7 +248,7 @@ errorCode encodeIntegerValue(EXIStream* strm, Integer sint_val)
 		sign = 1;
 	}
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, (" Write %ld (signed)", (long int)sint_val));
-	TRY(writeNextBit(strm, sign));
+	TRY(encodeBoolean(strm, sign));
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, ("\n"));
 	return encodeUnsignedInteger(strm, uval);
 }
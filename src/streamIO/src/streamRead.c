@@ -17,6 +17,7 @@
 
 #include "streamRead.h"
 #include "ioUtil.h"
+#include "readAhead.h"
 
 const unsigned char BIT_MASK[] = {	(char) 0x00,	// 0b00000000
 									(char) 0x01,	// 0b00000001
@@ -32,14 +33,26 @@ errorCode readNextBit(EXIStream* strm, boolean* bit_val)
 {
 	if(strm->buffer.bufContent <= strm->context.bufferIndx) // the whole buffer is parsed! read another portion
 	{
-		strm->context.bitPointer = 0;
-		strm->context.bufferIndx = 0;
-		strm->buffer.bufContent = 0;
-		if(strm->buffer.ioStrm.readWriteToStream == NULL)
-			return EXIP_BUFFER_END_REACHED;
-		strm->buffer.bufContent = strm->buffer.ioStrm.readWriteToStream(strm->buffer.buf, strm->buffer.bufLen, strm->buffer.ioStrm.stream);
-		if(strm->buffer.bufContent == 0)
-			return EXIP_BUFFER_END_REACHED;
+#if EXIP_READ_AHEAD == ON
+		if(IS_READ_AHEAD(strm))
+		{
+			if(nextReadAheadBlock(strm) != EXIP_OK)
+				return EXIP_BUFFER_END_REACHED;
+			strm->context.bitPointer = 0;
+		}
+		else
+#endif
+		{
+			strm->context.bitPointer = 0;
+			strm->context.bufferOffset += strm->buffer.bufContent;
+			strm->context.bufferIndx = 0;
+			strm->buffer.bufContent = 0;
+			if(strm->buffer.ioStrm.readWriteToStream == NULL)
+				return EXIP_BUFFER_END_REACHED;
+			strm->buffer.bufContent = strm->buffer.ioStrm.readWriteToStream(strm->buffer.buf, strm->buffer.bufLen, strm->buffer.ioStrm.stream);
+			if(strm->buffer.bufContent == 0)
+				return EXIP_BUFFER_END_REACHED;
+		}
 	}
 
 	*bit_val = (strm->buffer.buf[strm->context.bufferIndx] & (1<<REVERSE_BIT_POSITION(strm->context.bitPointer))) != 0;
@@ -51,29 +64,40 @@ errorCode readNextBit(EXIStream* strm, boolean* bit_val)
 
 errorCode readBits(EXIStream* strm, unsigned char n, unsigned int* bits_val)
 {
-	unsigned int numBytesToBeRead = 1 + ((n + strm->context.bitPointer - 1) / 8);
-	unsigned int byteIndx = 1;
 	unsigned char *buf;
 
-	if(strm->buffer.bufContent < strm->context.bufferIndx + numBytesToBeRead)
+	if(strm->context.bufferIndx + sizeof(uint64_t) <= strm->buffer.bufContent)
 	{
-		// The buffer end is reached: there are fewer than n bits left unparsed
-		errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
-
-		TRY(readEXIChunkForParsing(strm, numBytesToBeRead));
+		// At least 8 bytes are left in the buffer: n (<= 32) bits plus the
+		// current bit offset always fit in one 64-bit big-endian window
+		buf = (unsigned char *) strm->buffer.buf + strm->context.bufferIndx;
+		*bits_val = (unsigned int) ((READ_BE64(buf) << strm->context.bitPointer) >> (64 - n));
 	}
+	else
+	{
+		unsigned int numBytesToBeRead = 1 + ((n + strm->context.bitPointer - 1) / 8);
+		unsigned int byteIndx = 1;
 
-	buf = (unsigned char *) strm->buffer.buf + strm->context.bufferIndx;
+		if(strm->buffer.bufContent < strm->context.bufferIndx + numBytesToBeRead)
+		{
+			// The buffer end is reached: there are fewer than n bits left unparsed
+			errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
 
-	*bits_val = (buf[0] & BIT_MASK[8 - strm->context.bitPointer])<<((numBytesToBeRead-1)*8);
+			TRY(readEXIChunkForParsing(strm, numBytesToBeRead));
+		}
 
-	while(byteIndx < numBytesToBeRead)
-	{
-		*bits_val += (unsigned int) (buf[byteIndx])<<((numBytesToBeRead-byteIndx-1)*8);
-		byteIndx++;
-	}
+		buf = (unsigned char *) strm->buffer.buf + strm->context.bufferIndx;
 
-	*bits_val = *bits_val >> (numBytesToBeRead*8 - n - strm->context.bitPointer);
+		*bits_val = (buf[0] & BIT_MASK[8 - strm->context.bitPointer])<<((numBytesToBeRead-1)*8);
+
+		while(byteIndx < numBytesToBeRead)
+		{
+			*bits_val += (unsigned int) (buf[byteIndx])<<((numBytesToBeRead-byteIndx-1)*8);
+			byteIndx++;
+		}
+
+		*bits_val = *bits_val >> (numBytesToBeRead*8 - n - strm->context.bitPointer);
+	}
 
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, (">> %d [0x%X] (%u bits)", *bits_val, *bits_val, n));
 
@@ -85,4 +109,3 @@ errorCode readBits(EXIStream* strm, unsigned char n, unsigned int* bits_val)
 
 	return EXIP_OK;
 }
-
@@ -17,6 +17,7 @@
 
 #include "streamWrite.h"
 #include "ioUtil.h"
+#include "asyncOutput.h"
 
 extern const unsigned char BIT_MASK[];
 
@@ -25,13 +26,24 @@ errorCode writeNextBit(EXIStream* strm, boolean bit_val)
 	if(strm->buffer.bufLen <= strm->context.bufferIndx) // the whole buffer is filled! flush it!
 	{
 		Index numBytesWritten = 0;
-		if(strm->buffer.ioStrm.readWriteToStream == NULL)
-			return EXIP_BUFFER_END_REACHED;
-		numBytesWritten = strm->buffer.ioStrm.readWriteToStream(strm->buffer.buf, strm->buffer.bufLen, strm->buffer.ioStrm.stream);
-		if(numBytesWritten < strm->buffer.bufLen)
-			return EXIP_BUFFER_END_REACHED;
-		strm->context.bitPointer = 0;
-		strm->context.bufferIndx = 0;
+#if EXIP_ASYNC_OUTPUT == ON
+		if(IS_ASYNC_OUTPUT(strm))
+		{
+			errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+			TRY(submitAsyncOutput(strm));
+			strm->context.bitPointer = 0;
+		}
+		else
+#endif
+		{
+			if(strm->buffer.ioStrm.readWriteToStream == NULL)
+				return EXIP_BUFFER_END_REACHED;
+			numBytesWritten = strm->buffer.ioStrm.readWriteToStream(strm->buffer.buf, strm->buffer.bufLen, strm->buffer.ioStrm.stream);
+			if(numBytesWritten < strm->buffer.bufLen)
+				return EXIP_BUFFER_END_REACHED;
+			strm->context.bitPointer = 0;
+			strm->context.bufferIndx = 0;
+		}
 	}
 
 	if(bit_val == FALSE)
@@ -39,41 +51,67 @@ errorCode writeNextBit(EXIStream* strm, boolean bit_val)
 	else
 		strm->buffer.buf[strm->context.bufferIndx] = strm->buffer.buf[strm->context.bufferIndx] | (1<<REVERSE_BIT_POSITION(strm->context.bitPointer));
 
-	moveBitPointer(strm, 1);
+	strm->context.bitPointer++;
+	if(strm->context.bitPointer == 8)
+	{
+		strm->context.bitPointer = 0;
+		strm->context.bufferIndx++;
+	}
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, ("  @%u:%u", (unsigned int) strm->context.bufferIndx, strm->context.bitPointer));
 	return EXIP_OK;
 }
 
 errorCode writeNBits(EXIStream* strm, unsigned char nbits, unsigned int bits_val)
 {
-	unsigned int numBitsWrite = 0; // Number of the bits written so far
-	unsigned char tmp = 0;
-	int bits_in_byte = 0; // Number of bits written in one iteration
-	unsigned int numBytesToBeWritten = ((unsigned int) nbits) / 8 + (8 - strm->context.bitPointer < nbits % 8 );
+	if(nbits == 0)
+		return EXIP_OK;
 
-	if(strm->buffer.bufLen <= strm->context.bufferIndx + numBytesToBeWritten)
+	if(strm->context.bufferIndx + sizeof(uint64_t) <= strm->buffer.bufLen)
 	{
-		// The buffer end is reached: there are fewer than nbits bits left in the buffer
-		// Flush the buffer if possible
-		errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+		// At least 8 bytes are left in the buffer: merge the value into one
+		// 64-bit big-endian window. The bits after the written ones are
+		// initialized with 0s the same way as in the byte-wise path below
+		unsigned char* buf = (unsigned char *) strm->buffer.buf + strm->context.bufferIndx;
+		uint64_t window = READ_BE64(buf) & ~(UINT64_MAX >> strm->context.bitPointer);
 
-		TRY(writeEncodedEXIChunk(strm));
-	}
+		window |= (((uint64_t) bits_val) << (64 - nbits)) >> strm->context.bitPointer;
+		WRITE_BE64(buf, window);
 
-	while(numBitsWrite < nbits)
+		nbits += strm->context.bitPointer;
+		strm->context.bufferIndx += nbits / 8;
+		strm->context.bitPointer = nbits % 8;
+	}
+	else
 	{
-		if((unsigned int)(nbits - numBitsWrite) <= (unsigned int)(8 - strm->context.bitPointer)) // The rest of the unwritten bits can be put in the current byte from the stream
-			bits_in_byte = nbits - numBitsWrite;
-		else // The rest of the unwritten bits are more than the bits in the current byte from the stream
-			bits_in_byte = 8 - strm->context.bitPointer;
-
-		tmp = (bits_val >> (nbits - numBitsWrite - bits_in_byte)) & BIT_MASK[bits_in_byte];
-		tmp = tmp << (8 - strm->context.bitPointer - bits_in_byte);
-		strm->buffer.buf[strm->context.bufferIndx] = strm->buffer.buf[strm->context.bufferIndx] & (~BIT_MASK[8 - strm->context.bitPointer]); // Initialize the unused bits with 0s
-		strm->buffer.buf[strm->context.bufferIndx] = strm->buffer.buf[strm->context.bufferIndx] | tmp;
-
-		numBitsWrite += bits_in_byte;
-		moveBitPointer(strm, bits_in_byte);
+		unsigned int numBitsWrite = 0; // Number of the bits written so far
+		unsigned char tmp = 0;
+		int bits_in_byte = 0; // Number of bits written in one iteration
+		unsigned int numBytesToBeWritten = ((unsigned int) nbits) / 8 + (8 - strm->context.bitPointer < nbits % 8 );
+
+		if(strm->buffer.bufLen <= strm->context.bufferIndx + numBytesToBeWritten)
+		{
+			// The buffer end is reached: there are fewer than nbits bits left in the buffer
+			// Flush the buffer if possible
+			errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+			TRY(writeEncodedEXIChunk(strm));
+		}
+
+		while(numBitsWrite < nbits)
+		{
+			if((unsigned int)(nbits - numBitsWrite) <= (unsigned int)(8 - strm->context.bitPointer)) // The rest of the unwritten bits can be put in the current byte from the stream
+				bits_in_byte = nbits - numBitsWrite;
+			else // The rest of the unwritten bits are more than the bits in the current byte from the stream
+				bits_in_byte = 8 - strm->context.bitPointer;
+
+			tmp = (bits_val >> (nbits - numBitsWrite - bits_in_byte)) & BIT_MASK[bits_in_byte];
+			tmp = tmp << (8 - strm->context.bitPointer - bits_in_byte);
+			strm->buffer.buf[strm->context.bufferIndx] = strm->buffer.buf[strm->context.bufferIndx] & (~BIT_MASK[8 - strm->context.bitPointer]); // Initialize the unused bits with 0s
+			strm->buffer.buf[strm->context.bufferIndx] = strm->buffer.buf[strm->context.bufferIndx] | tmp;
+
+			numBitsWrite += bits_in_byte;
+			moveBitPointer(strm, bits_in_byte);
+		}
 	}
 	DEBUG_MSG(INFO, DEBUG_STREAM_IO, ("  @%u:%u\n", (unsigned int) strm->context.bufferIndx, strm->context.bitPointer));
 
@@ -26,6 +26,25 @@
 #define DEFAULT_LN_ENTRIES_NUMBER    10
 #define DEFAULT_VX_ENTRIES_NUMBER    10
 
+/**
+ * The URI, local names and local value tables with more entries than this
+ * are indexed with a hash table on the first look-up (when HASH_TABLE_USE).
+ * Should be above the size of the tables of the static schemas shared
+ * between streams, e.g. the schema of the EXI options.
+ */
+#ifndef STRING_TABLE_INDEX_THRESHOLD
+# define STRING_TABLE_INDEX_THRESHOLD 64
+#endif
+
+/**
+ * The size in bytes of the chunks holding the strings of the value table.
+ * Increased to fit valueMaxLength and decreased when the whole value table
+ * fits in less.
+ */
+#ifndef VALUE_STRING_CHUNK_SIZE
+# define VALUE_STRING_CHUNK_SIZE 4096
+#endif
+
 // Get local name entry from pointer to URI table using QNameID
 #define GET_LN_P_URI_QNAME(uriTable, qnameID) ((uriTable)->uri[(qnameID).uriId].lnTable.ln[(qnameID).lnId])
 
@@ -49,17 +68,57 @@
  * @brief Creates fresh empty ValueTable (value partition of EXI string table)
  * This operation includes allocation of memory for DEFAULT_VALUE_ENTRIES_NUMBER number of value entries
  * @param[in, out] valueTable ValueTable string table partition
+ * @param[in] allocator the allocator of the table; NULL for EXIP_MALLOC
+ * @return Error handling code
+ */
+errorCode createValueTable(ValueTable* valueTable, const EXIPAllocator* allocator);
+
+/**
+ * @brief Frees the memory of a ValueTable created with createValueTable()
+ * including the value strings and the hash table index
+ * @param[in, out] valueTable ValueTable string table partition
+ */
+void destroyValueTable(ValueTable* valueTable);
+
+/**
+ * @brief Allocates the memory for a string to be added to the value table
+ * The memory is carved from the chunks of the value table and is reclaimed
+ * when the string is replaced after valuePartitionCapacity is reached.
+ * The part of the memory not used by the string is given back
+ * by addValueEntry() if no other string is allocated in between.
+ *
+ * @param[in, out] strm EXI stream with a value table
+ * @param[in] size the size of the string in CharType units
+ * @param[out] str the memory allocated
+ * @return Error handling code
+ */
+errorCode allocateValueString(EXIStream* strm, Index size, CharType** str);
+
+#if VALUE_CROSSTABLE_USE
+/**
+ * @brief Creates fresh empty VxTable (local value partition of EXI string table)
+ * This operation includes allocation of memory for DEFAULT_VX_ENTRIES_NUMBER number of entries
+ * @param[in, out] vxTable VxTable string table partition
+ * @param[in] allocator the allocator of the table; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode createValueTable(ValueTable* valueTable);
+errorCode createVxTable(VxTable* vxTable, const EXIPAllocator* allocator);
+
+/**
+ * @brief Frees the memory of a VxTable created with createVxTable()
+ * @param[in, out] vxTable VxTable string table partition
+ */
+void destroyVxTable(VxTable* vxTable);
+#endif
 
 /**
  * @brief Creates fresh empty PfxTable (prefix partition of EXI string table)
  * This operation includes allocation of memory for DEFAULT_PFX_ENTRIES_NUMBER number of prefix entries
  * @param[out] pfxTable Prefix string table partition
+ * @param[in] allocator the allocator of the table; NULL for EXIP_MALLOC
  * @return Error handling code
  */
-errorCode createPfxTable(PfxTable** pfxTable);
+errorCode createPfxTable(PfxTable** pfxTable, const EXIPAllocator* allocator);
 
 /**
  * @brief Add new row into the URI string table
@@ -85,7 +144,7 @@ errorCode addLnEntry(LnTable* lnTable, String lnStr, Index* lnEntryId);
  * @brief Add a new row into the Global ValueTable string table and Local value cross string table
  *
  * @param[in, out] strm EXI stream of bits
- * @param[in] valueStr The string representing this global value. The String can be allocated on the stack.
+ * @param[in] valueStr The string representing this global value allocated with allocateValueString()
  * @param[in] qnameID The URI:ln QNameID
  * @return Error handling code
  */
@@ -132,26 +191,40 @@ errorCode createUriTableEntries(UriTable* uriTable, boolean withSchema);
 
 /**
  * @brief Search the URI table for a particular string value
- * Implements full scan
+ * Implements full scan for tables up to STRING_TABLE_INDEX_THRESHOLD entries
+ * Hash search otherwise
  *
  * @param[in] uriTable URI table to be searched
  * @param[in] uriStr The string searched for
  * @param[out] uriEntryId If found, ID of the UriEntry with that string
- * @return FALSE-not found, TRUE found
+ * @param[out] found FALSE-not found, TRUE found
+ * @return Error handling code; EXIP_MEMORY_ALLOCATION_ERROR when the index cannot be created
  */
-boolean lookupUri(UriTable* uriTable, String uriStr, SmallIndex* uriEntryId);
+errorCode lookupUri(UriTable* uriTable, String uriStr, SmallIndex* uriEntryId, boolean* found);
 
 /**
  * @brief Search the local names table for a particular string value
- * Implements full scan
- * RCC 20120201: Try to optimize?
+ * Implements full scan for tables up to STRING_TABLE_INDEX_THRESHOLD entries
+ * Hash search otherwise
  *
  * @param[in] lnTable Local names table to be searched
  * @param[in] lnStr The local name string searched for
  * @param[out] lnEntryId if found, ID of the LnEntry with that string
- * @return FALSE-not found, TRUE found
+ * @param[out] found FALSE-not found, TRUE found
+ * @return Error handling code; EXIP_MEMORY_ALLOCATION_ERROR when the index cannot be created
+ */
+errorCode lookupLn(LnTable* lnTable, String lnStr, Index* lnEntryId, boolean* found);
+
+#if HASH_TABLE_USE
+/**
+ * @brief Frees the hash indexes of the URI table and of its local names tables
+ * Must be called before the entries of the tables are reordered or removed
+ * and before the tables are freed. The indexes are created again on demand.
+ *
+ * @param[in, out] uriTable URI table
  */
-boolean lookupLn(LnTable* lnTable, String lnStr, Index* lnEntryId);
+void destroyStringTableIndex(UriTable* uriTable);
+#endif
 
 /**
  * @brief Search the Prefix table for a particular string value
@@ -168,16 +241,17 @@ boolean lookupPfx(PfxTable* pfxTable, String pfxStr, SmallIndex* pfxEntryId);
 /**
  * @brief Search the value cross table for a particular string value
  * Search the value cross table (local partition of the value table) for a particular string value
- * Implements full scan
- * RCC 20120201: Try to optimize?
+ * Implements full scan for tables up to STRING_TABLE_INDEX_THRESHOLD entries
+ * Hash search otherwise
  *
  * @param[in] valueTable Global Value table - used to check the string values
  * @param[in] vxTable Value cross table - local partition of the Value table to be searched
  * @param[in] valueStr The string searched for
  * @param[out] vxEntryId if found, ID of the VxEntry with that string
- * @return FALSE-not found, TRUE found
+ * @param[out] found FALSE-not found, TRUE found
+ * @return Error handling code; EXIP_MEMORY_ALLOCATION_ERROR when the index cannot be created
  */
-boolean lookupVx(ValueTable* valueTable, VxTable* vxTable, String valueStr, Index* vxEntryId);
+errorCode lookupVx(ValueTable* valueTable, VxTable* vxTable, String valueStr, Index* vxEntryId, boolean* found);
 #endif
 
 /**
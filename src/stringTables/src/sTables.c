@@ -145,24 +145,325 @@ static const String URI_3_LN[] = {
 
 /********* END: String table default entries ***************/
 
-errorCode createValueTable(ValueTable* valueTable)
+#if HASH_TABLE_USE
+/**
+ * Adds a new entry of a URI, local names or local value table to the index
+ * of the table if there is one. If the entry cannot be added the index is
+ * dropped.
+ */
+static errorCode indexEntry(struct hashtable** hashTbl, String str, Index id)
+{
+	errorCode tmp_err_code;
+
+	if(*hashTbl == NULL)
+		return EXIP_OK;
+
+	tmp_err_code = hashtable_insert(*hashTbl, str, id);
+	if(tmp_err_code != EXIP_OK)
+	{
+		hashtable_destroy(*hashTbl);
+		*hashTbl = NULL;
+	}
+	return tmp_err_code;
+}
+
+/**
+ * The initial size of the index of entryCount entries; the index grows
+ * past MAX_HASH_TABLE_SIZE with the insertions
+ */
+static unsigned int indexSize(Index entryCount)
+{
+	if(entryCount > MAX_HASH_TABLE_SIZE/2)
+		return MAX_HASH_TABLE_SIZE;
+	return (unsigned int) (2*entryCount);
+}
+
+/**
+ * Creates the index of the URI table once it has more than
+ * STRING_TABLE_INDEX_THRESHOLD entries. For smaller tables the full scan
+ * is faster and the table is not indexed.
+ */
+static errorCode buildUriIndex(UriTable* uriTable)
 {
 	errorCode tmp_err_code;
+	SmallIndex i;
+
+	if(uriTable->hashTbl != NULL || uriTable->count <= STRING_TABLE_INDEX_THRESHOLD)
+		return EXIP_OK;
 
-	TRY(createDynArray(&valueTable->dynArray, sizeof(ValueEntry), DEFAULT_VALUE_ENTRIES_NUMBER));
+	uriTable->hashTbl = create_hashtable(indexSize(uriTable->count), stringHash, stringEqual, uriTable->dynArray.allocator);
+	if(uriTable->hashTbl == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	for(i = 0; i < uriTable->count; i++)
+		TRY(indexEntry(&uriTable->hashTbl, uriTable->uri[i].uriStr, i));
+
+	return EXIP_OK;
+}
+
+/** The same as buildUriIndex() for a local names table */
+static errorCode buildLnIndex(LnTable* lnTable)
+{
+	errorCode tmp_err_code;
+	Index i;
+
+	if(lnTable->hashTbl != NULL || lnTable->count <= STRING_TABLE_INDEX_THRESHOLD)
+		return EXIP_OK;
+
+	lnTable->hashTbl = create_hashtable(indexSize(lnTable->count), stringHash, stringEqual, lnTable->dynArray.allocator);
+	if(lnTable->hashTbl == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	for(i = 0; i < lnTable->count; i++)
+		TRY(indexEntry(&lnTable->hashTbl, lnTable->ln[i].lnStr, i));
+
+	return EXIP_OK;
+}
+
+#if VALUE_CROSSTABLE_USE
+/**
+ * The same as buildUriIndex() for a value partition. The entries
+ * removed from the partition still count for the scan but are not indexed.
+ */
+static errorCode buildVxIndex(ValueTable* valueTable, VxTable* vxTable)
+{
+	errorCode tmp_err_code;
+	Index i;
+	Index liveCount = 0;
+
+	if(vxTable->hashTbl != NULL || vxTable->count <= STRING_TABLE_INDEX_THRESHOLD)
+		return EXIP_OK;
+
+	for(i = 0; i < vxTable->count; i++)
+	{
+		if(vxTable->vx[i].globalId != INDEX_MAX)
+			liveCount++;
+	}
+
+	vxTable->hashTbl = create_hashtable(indexSize(liveCount), stringHash, stringEqual, vxTable->dynArray.allocator);
+	if(vxTable->hashTbl == NULL)
+		return EXIP_MEMORY_ALLOCATION_ERROR;
+
+	for(i = 0; i < vxTable->count; i++)
+	{
+		if(vxTable->vx[i].globalId != INDEX_MAX)
+			TRY(indexEntry(&vxTable->hashTbl, valueTable->value[vxTable->vx[i].globalId].valueStr, i));
+	}
+
+	return EXIP_OK;
+}
+#endif
+
+void destroyStringTableIndex(UriTable* uriTable)
+{
+	SmallIndex i;
+
+	if(uriTable->hashTbl != NULL)
+	{
+		hashtable_destroy(uriTable->hashTbl);
+		uriTable->hashTbl = NULL;
+	}
+
+	for(i = 0; i < uriTable->count; i++)
+	{
+		if(uriTable->uri[i].lnTable.hashTbl != NULL)
+		{
+			hashtable_destroy(uriTable->uri[i].lnTable.hashTbl);
+			uriTable->uri[i].lnTable.hashTbl = NULL;
+		}
+	}
+}
+#endif
+
+errorCode createValueTable(ValueTable* valueTable, const EXIPAllocator* allocator)
+{
+	errorCode tmp_err_code;
 
 	valueTable->globalId = 0;
 #if HASH_TABLE_USE
 	valueTable->hashTbl = NULL;
+#endif
+	valueTable->oldestChunk = NULL;
+	valueTable->newestChunk = NULL;
+	valueTable->freeChunks = NULL;
+	valueTable->chunkSize = 0;
+	valueTable->lastString = NULL;
+
+	TRY(createDynArray(&valueTable->dynArray, sizeof(ValueEntry), DEFAULT_VALUE_ENTRIES_NUMBER, allocator));
+
+	return EXIP_OK;
+}
+
+void destroyValueTable(ValueTable* valueTable)
+{
+	const EXIPAllocator* allocator;
+	ValueChunk* chunk;
+
+#if HASH_TABLE_USE
+	if(valueTable->hashTbl != NULL)
+	{
+		hashtable_destroy(valueTable->hashTbl);
+		valueTable->hashTbl = NULL;
+	}
+#endif
+	if(valueTable->value == NULL)
+		return;
+
+	allocator = valueTable->dynArray.allocator;
+	destroyDynArray(&valueTable->dynArray);
+	valueTable->value = NULL;
+	valueTable->count = 0;
+
+	while(valueTable->oldestChunk != NULL)
+	{
+		chunk = valueTable->oldestChunk;
+		valueTable->oldestChunk = chunk->next;
+		EXIP_RELEASE(allocator, chunk);
+	}
+	while(valueTable->freeChunks != NULL)
+	{
+		chunk = valueTable->freeChunks;
+		valueTable->freeChunks = chunk->next;
+		EXIP_RELEASE(allocator, chunk);
+	}
+	valueTable->newestChunk = NULL;
+}
+
+#define CHUNK_DATA(chunk) ((unsigned char*) ((chunk) + 1))
+
+/**
+ * The chunks fit the longest value string allowed and are not
+ * larger than needed for the whole value table
+ */
+static Index getValueChunkSize(EXIOptions* opts)
+{
+	Index maxString;
+
+	// Unbounded or too long strings get chunks of their own
+	if(opts->valueMaxLength == 0 || opts->valueMaxLength == INDEX_MAX ||
+			opts->valueMaxLength > (INDEX_MAX - sizeof(ValueChunk))/(sizeof(CharType)*CHAR_TYPE_MAX_UNITS))
+		return VALUE_STRING_CHUNK_SIZE;
+
+	maxString = sizeof(CharType)*CHAR_TYPE_MAX_UNITS*opts->valueMaxLength;
+	if(maxString > VALUE_STRING_CHUNK_SIZE)
+		return maxString;
+	if(opts->valuePartitionCapacity < VALUE_STRING_CHUNK_SIZE/maxString)
+		return opts->valuePartitionCapacity*maxString;
+
+	return VALUE_STRING_CHUNK_SIZE;
+}
+
+errorCode allocateValueString(EXIStream* strm, Index size, CharType** str)
+{
+	ValueTable* valueTable = &strm->valueTable;
+	ValueChunk* chunk = valueTable->newestChunk;
+	Index bytes = sizeof(CharType)*size;
+
+	if(valueTable->chunkSize == 0)
+		valueTable->chunkSize = getValueChunkSize(&strm->header.opts);
+
+	if(chunk == NULL || chunk->size - chunk->used < bytes)
+	{
+		if(bytes <= valueTable->chunkSize && valueTable->freeChunks != NULL)
+		{
+			chunk = valueTable->freeChunks;
+			valueTable->freeChunks = chunk->next;
+		}
+		else
+		{
+			// Strings longer than the chunks get a chunk of their own
+			Index chunkSize = bytes > valueTable->chunkSize ? bytes : valueTable->chunkSize;
+
+			chunk = (ValueChunk*) EXIP_ALLOCATE(valueTable->dynArray.allocator, sizeof(ValueChunk) + chunkSize);
+			if(chunk == NULL)
+				return EXIP_MEMORY_ALLOCATION_ERROR;
+			chunk->size = chunkSize;
+		}
+
+		chunk->next = NULL;
+		chunk->used = 0;
+		chunk->live = 0;
+		if(valueTable->newestChunk == NULL)
+			valueTable->oldestChunk = chunk;
+		else
+			valueTable->newestChunk->next = chunk;
+		valueTable->newestChunk = chunk;
+	}
+
+	*str = (CharType*) (CHUNK_DATA(chunk) + chunk->used);
+	chunk->used += bytes;
+	chunk->live++;
+	valueTable->lastString = *str;
+
+	return EXIP_OK;
+}
+
+/**
+ * Releases the memory of an evicted value string. The chunks are searched
+ * from the oldest one that holds the string unless the value table was
+ * restored out of order. An emptied chunk is reused for the next strings.
+ */
+static void releaseValueString(ValueTable* valueTable, CharType* str)
+{
+	ValueChunk* prev = NULL;
+	ValueChunk* chunk = valueTable->oldestChunk;
+	unsigned char* ptr = (unsigned char*) str;
+
+	while(chunk != NULL && (ptr < CHUNK_DATA(chunk) || ptr >= CHUNK_DATA(chunk) + chunk->used))
+	{
+		prev = chunk;
+		chunk = chunk->next;
+	}
+
+	if(chunk == NULL || --chunk->live > 0)
+		return;
+
+	if(prev == NULL)
+		valueTable->oldestChunk = chunk->next;
+	else
+		prev->next = chunk->next;
+	if(valueTable->newestChunk == chunk)
+		valueTable->newestChunk = prev;
+
+	if(chunk->size == valueTable->chunkSize)
+	{
+		chunk->next = valueTable->freeChunks;
+		valueTable->freeChunks = chunk;
+	}
+	else
+		EXIP_RELEASE(valueTable->dynArray.allocator, chunk);
+}
+
+#if VALUE_CROSSTABLE_USE
+errorCode createVxTable(VxTable* vxTable, const EXIPAllocator* allocator)
+{
+	errorCode tmp_err_code;
+
+	TRY(createDynArray(&vxTable->dynArray, sizeof(VxEntry), DEFAULT_VX_ENTRIES_NUMBER, allocator));
+#if HASH_TABLE_USE
+	vxTable->hashTbl = NULL;
 #endif
 	return EXIP_OK;
 }
 
-errorCode createPfxTable(PfxTable** pfxTable)
+void destroyVxTable(VxTable* vxTable)
+{
+#if HASH_TABLE_USE
+	if(vxTable->hashTbl != NULL)
+	{
+		hashtable_destroy(vxTable->hashTbl);
+		vxTable->hashTbl = NULL;
+	}
+#endif
+	destroyDynArray(&vxTable->dynArray);
+}
+#endif
+
+errorCode createPfxTable(PfxTable** pfxTable, const EXIPAllocator* allocator)
 {
 	// Due to the small size of the prefix table, there is no need to 
 	// use a DynArray
-	(*pfxTable) = (PfxTable*) EXIP_MALLOC(sizeof(PfxTable));
+	(*pfxTable) = (PfxTable*) EXIP_ALLOCATE(allocator, sizeof(PfxTable));
 	if(*pfxTable == NULL)
 		return EXIP_MEMORY_ALLOCATION_ERROR;
 
@@ -184,7 +485,11 @@ errorCode addUriEntry(UriTable* uriTable, String uriStr, SmallIndex* uriEntryId)
 	uriEntry->pfxTable = NULL;
 	// Create local names table for this URI
 	// TODO RCC 20120201: Should this be separate (empty string URI has no local names)?
-	TRY(createDynArray(&uriEntry->lnTable.dynArray, sizeof(LnEntry), DEFAULT_LN_ENTRIES_NUMBER));
+	TRY(createDynArray(&uriEntry->lnTable.dynArray, sizeof(LnEntry), DEFAULT_LN_ENTRIES_NUMBER, uriTable->dynArray.allocator));
+#if HASH_TABLE_USE
+	uriEntry->lnTable.hashTbl = NULL;
+	TRY(indexEntry(&uriTable->hashTbl, uriStr, uriLEntryId));
+#endif
 
 	*uriEntryId = (SmallIndex)uriLEntryId;
 	return EXIP_OK;
@@ -204,6 +509,9 @@ errorCode addLnEntry(LnTable* lnTable, String lnStr, Index* lnEntryId)
 #if VALUE_CROSSTABLE_USE
 	// The Vx table is created on-demand (additions to value cross table are done when a value is inserted in the value table)
 	lnEntry->vxTable = NULL;
+#endif
+#if HASH_TABLE_USE
+	TRY(indexEntry(&lnTable->hashTbl, lnStr, *lnEntryId));
 #endif
 	return EXIP_OK;
 }
@@ -231,7 +539,7 @@ errorCode addValueEntry(EXIStream* strm, String valueStr, QNameID qnameID)
 				return EXIP_MEMORY_ALLOCATION_ERROR;
 
 			// First value entry - create the vxTable
-			TRY(createDynArray(&lnEntry->vxTable->dynArray, sizeof(VxEntry), DEFAULT_VX_ENTRIES_NUMBER));
+			TRY(createVxTable(lnEntry->vxTable, strm->allocator));
 		}
 
 		assert(lnEntry->vxTable->vx);
@@ -252,9 +560,17 @@ errorCode addValueEntry(EXIStream* strm, String valueStr, QNameID qnameID)
 		valueEntry = &strm->valueTable.value[strm->valueTable.globalId];
 
 #if VALUE_CROSSTABLE_USE
-		assert(GET_LN_URI_QNAME(strm->schema->uriTable, valueEntry->locValuePartition.forQNameId).vxTable);
-		// Null out the existing cross table entry
-		GET_LN_URI_QNAME(strm->schema->uriTable, valueEntry->locValuePartition.forQNameId).vxTable->vx[valueEntry->locValuePartition.vxEntryId].globalId = INDEX_MAX;
+		{
+			VxTable* vxTable = GET_LN_URI_QNAME(strm->schema->uriTable, valueEntry->locValuePartition.forQNameId).vxTable;
+
+			assert(vxTable);
+			// Null out the existing cross table entry
+			vxTable->vx[valueEntry->locValuePartition.vxEntryId].globalId = INDEX_MAX;
+# if HASH_TABLE_USE
+			if(vxTable->hashTbl != NULL)
+				hashtable_remove(vxTable->hashTbl, valueEntry->valueStr);
+# endif
+		}
 #endif
 
 #if HASH_TABLE_USE
@@ -264,8 +580,8 @@ errorCode addValueEntry(EXIStream* strm, String valueStr, QNameID qnameID)
 			hashtable_remove(strm->valueTable.hashTbl, valueEntry->valueStr);
 		}
 #endif
-		// Free the memory allocated by the previous string entry
-		EXIP_MFREE(valueEntry->valueStr.str);
+		// Release the memory of the previous string entry
+		releaseValueString(&strm->valueTable, valueEntry->valueStr.str);
 	}
 	else
 	{
@@ -274,11 +590,20 @@ errorCode addValueEntry(EXIStream* strm, String valueStr, QNameID qnameID)
 		TRY(addEmptyDynEntry(&strm->valueTable.dynArray, (void**)&valueEntry, &valueEntryId));
 	}
 
+	// Give back the memory allocated for the string but not used
+	if(valueStr.str == strm->valueTable.lastString && strm->valueTable.newestChunk != NULL)
+		strm->valueTable.newestChunk->used = ((unsigned char*) valueStr.str - CHUNK_DATA(strm->valueTable.newestChunk)) + sizeof(CharType)*valueStr.length;
+	strm->valueTable.lastString = NULL;
+
 	// Set the value entry fields
 	valueEntry->valueStr = valueStr;
 #if VALUE_CROSSTABLE_USE
 	valueEntry->locValuePartition.forQNameId = qnameID;
 	valueEntry->locValuePartition.vxEntryId = vxEntryId;
+# if HASH_TABLE_USE
+	// After the evicted value is removed as it might be the same string
+	TRY(indexEntry(&GET_LN_URI_QNAME(strm->schema->uriTable, qnameID).vxTable->hashTbl, valueStr, vxEntryId));
+# endif
 #endif
 
 #if HASH_TABLE_USE
@@ -331,7 +656,7 @@ errorCode createUriTableEntry(UriTable* uriTable, const String uri, int createPf
 	if(createPfx)
 	{
 		// Create the URI's prefix table and add the default prefix
-		TRY(createPfxTable(&uriEntry->pfxTable));
+		TRY(createPfxTable(&uriEntry->pfxTable, uriTable->dynArray.allocator));
 		TRY(addPfxEntry(uriEntry->pfxTable, pfx, &pfxEntryId));
 	}
 
@@ -388,39 +713,80 @@ errorCode createUriTableEntries(UriTable* uriTable, boolean withSchema)
 	return EXIP_OK;
 }
 
-boolean lookupUri(UriTable* uriTable, String uriStr, SmallIndex* uriEntryId)
+errorCode lookupUri(UriTable* uriTable, String uriStr, SmallIndex* uriEntryId, boolean* found)
 {
 	SmallIndex i;
 
+	*found = FALSE;
 	if(uriTable == NULL)
-		return FALSE;
+		return EXIP_OK;
+
+#if HASH_TABLE_USE
+	{
+		errorCode tmp_err_code;
+
+		TRY(buildUriIndex(uriTable));
+		if(uriTable->hashTbl != NULL)
+		{
+			Index id = hashtable_search(uriTable->hashTbl, uriStr);
+			if(id != INDEX_MAX)
+			{
+				*uriEntryId = (SmallIndex) id;
+				*found = TRUE;
+			}
+			return EXIP_OK;
+		}
+	}
+#endif
 
 	for(i = 0; i < uriTable->count; i++)
 	{
 		if(stringEqual(uriTable->uri[i].uriStr, uriStr))
 		{
 			*uriEntryId = i;
-			return TRUE;
+			*found = TRUE;
+			return EXIP_OK;
 		}
 	}
-	return FALSE;
+	return EXIP_OK;
 }
 
-boolean lookupLn(LnTable* lnTable, String lnStr, Index* lnEntryId)
+errorCode lookupLn(LnTable* lnTable, String lnStr, Index* lnEntryId, boolean* found)
 {
 	Index i;
 
+	*found = FALSE;
 	if(lnTable == NULL)
-		return FALSE;
+		return EXIP_OK;
+
+#if HASH_TABLE_USE
+	{
+		errorCode tmp_err_code;
+
+		TRY(buildLnIndex(lnTable));
+		if(lnTable->hashTbl != NULL)
+		{
+			i = hashtable_search(lnTable->hashTbl, lnStr);
+			if(i != INDEX_MAX)
+			{
+				*lnEntryId = i;
+				*found = TRUE;
+			}
+			return EXIP_OK;
+		}
+	}
+#endif
+
 	for(i = 0; i < lnTable->count; i++)
 	{
 		if(stringEqual(lnTable->ln[i].lnStr, lnStr))
 		{
 			*lnEntryId = i;
-			return TRUE;
+			*found = TRUE;
+			return EXIP_OK;
 		}
 	}
-	return FALSE;
+	return EXIP_OK;
 }
 
 boolean lookupPfx(PfxTable* pfxTable, String pfxStr, SmallIndex* pfxEntryId)
@@ -442,14 +808,33 @@ boolean lookupPfx(PfxTable* pfxTable, String pfxStr, SmallIndex* pfxEntryId)
 }
 
 #if VALUE_CROSSTABLE_USE
-boolean lookupVx(ValueTable* valueTable, VxTable* vxTable, String valueStr, Index* vxEntryId)
+errorCode lookupVx(ValueTable* valueTable, VxTable* vxTable, String valueStr, Index* vxEntryId, boolean* found)
 {
 	Index i;
 	VxEntry* vxEntry;
 	ValueEntry* valueEntry;
 
+	*found = FALSE;
 	if(vxTable == NULL || vxTable->vx == NULL)
-		return FALSE;
+		return EXIP_OK;
+
+#if HASH_TABLE_USE
+	{
+		errorCode tmp_err_code;
+
+		TRY(buildVxIndex(valueTable, vxTable));
+		if(vxTable->hashTbl != NULL)
+		{
+			i = hashtable_search(vxTable->hashTbl, valueStr);
+			if(i != INDEX_MAX)
+			{
+				*vxEntryId = i;
+				*found = TRUE;
+			}
+			return EXIP_OK;
+		}
+	}
+#endif
 
 	for(i = 0; i < vxTable->count; i++)
 	{
@@ -460,10 +845,11 @@ boolean lookupVx(ValueTable* valueTable, VxTable* vxTable, String valueStr, Inde
 		if(stringEqual(valueEntry->valueStr, valueStr))
 		{
 			*vxEntryId = i;
-			return TRUE;
+			*found = TRUE;
+			return EXIP_OK;
 		}
 	}
-	return FALSE;
+	return EXIP_OK;
 }
 #endif
 
@@ -40,8 +40,12 @@ START_TEST (test_decodeHeader)
 	testStream.buffer.bufLen = 3;
 	testStream.buffer.bufContent = 3;
 	testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+	testStream.readAhead = NULL;
+#endif
 	testStream.buffer.ioStrm.stream = NULL;
-	initAllocList(&testStream.memList);
+	testStream.allocator = NULL;
+	initAllocList(&testStream.memList, NULL);
 	makeDefaultOpts(&testStream.header.opts);
 
 	err = decodeHeader(&testStream, TRUE);
@@ -70,7 +74,13 @@ START_TEST (test_decodeHeader)
 	testStream2.buffer.bufLen = 7;
 	testStream2.buffer.bufContent = 7;
 	testStream2.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+	testStream2.readAhead = NULL;
+#endif
 	testStream2.buffer.ioStrm.stream = NULL;
+	testStream2.allocator = NULL;
+	initAllocList(&testStream2.memList, NULL);
+	makeDefaultOpts(&testStream2.header.opts);
 
 	err = decodeHeader(&testStream2, TRUE);
 	fail_unless (err == EXIP_OK, "decodeHeader returns error code %d", err);
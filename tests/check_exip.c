@@ -17,12 +17,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include "procTypes.h"
 #include "EXISerializer.h"
 #include "EXIParser.h"
 #include "stringManipulate.h"
 #include "grammarGenerator.h"
+#include "memManagement.h"
 
 #define MAX_PATH_LEN 200
 #define OUTPUT_BUFFER_SIZE 2000
@@ -851,6 +853,1761 @@ errorCode encodeWithDynamicTypes(char* buf, int buf_size, int *strmSize)
 }
 
 
+struct mappedAppData
+{
+	const char* mapStart;
+	const char* mapEnd;
+	unsigned int referencedStrings;
+	unsigned int strings;
+};
+
+static errorCode mapped_startElement(QName qname, void* app_data)
+{
+	struct mappedAppData* appD = (struct mappedAppData*) app_data;
+	if(qname.localName->str >= appD->mapStart && qname.localName->str < appD->mapEnd)
+		appD->referencedStrings++;
+	appD->strings++;
+	return EXIP_OK;
+}
+
+static errorCode mapped_stringData(const String value, void* app_data)
+{
+	struct mappedAppData* appD = (struct mappedAppData*) app_data;
+	if(value.str >= appD->mapStart && value.str < appD->mapEnd)
+		appD->referencedStrings++;
+	appD->strings++;
+	return EXIP_OK;
+}
+
+/**
+ * Parsing of a byte-aligned EXI stream that is entirely in memory:
+ * local names and values that are not added to the value table are
+ * referenced in the input instead of copied.
+ */
+START_TEST (test_mapped_input)
+{
+	const String NS_EMPTY = {NULL, 0};
+	const String ELEM_LOG = {"log", 3};
+	const String ELEM_ENTRY = {"entry", 5};
+	const String VALUE_SHORT = {"boot", 4};
+	const String VALUE_LONG = {"a value which is longer than valueMaxLength", 43};
+
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	EXIStream testStrm;
+	Parser testParser;
+	String uri;
+	String ln;
+	QName qname = {&uri, &ln, NULL};
+	char buf[OUTPUT_BUFFER_SIZE];
+	BinaryBuffer buffer;
+	EXITypeClass valueType;
+	struct mappedAppData appD;
+	Index strmSize;
+	int i;
+
+	buffer.buf = buf;
+	buffer.bufLen = OUTPUT_BUFFER_SIZE;
+	buffer.bufContent = 0;
+	buffer.ioStrm.readWriteToStream = NULL;
+	buffer.ioStrm.stream = NULL;
+
+	serialize.initHeader(&testStrm);
+	testStrm.header.has_options = TRUE;
+	SET_ALIGNMENT(testStrm.header.opts.enumOpt, BYTE_ALIGNMENT);
+	testStrm.header.opts.valueMaxLength = 10;
+
+	tmp_err_code = serialize.initStream(&testStrm, buffer, NULL);
+	fail_unless (tmp_err_code == EXIP_OK, "initStream returns an error code %d", tmp_err_code);
+	tmp_err_code += serialize.exiHeader(&testStrm);
+	tmp_err_code += serialize.startDocument(&testStrm);
+	qname.uri = &NS_EMPTY;
+	qname.localName = &ELEM_LOG;
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <log>
+	for(i = 0; i < 3; i++)
+	{
+		qname.localName = &ELEM_ENTRY;
+		tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <entry>
+		tmp_err_code += serialize.stringData(&testStrm, i == 1 ? VALUE_SHORT : VALUE_LONG);
+		tmp_err_code += serialize.endElement(&testStrm); // </entry>
+	}
+	tmp_err_code += serialize.endElement(&testStrm); // </log>
+	tmp_err_code += serialize.endDocument(&testStrm);
+	fail_unless (tmp_err_code == EXIP_OK, "serialization ended with error code %d", tmp_err_code);
+	strmSize = testStrm.context.bufferIndx + (testStrm.context.bitPointer != 0);
+	tmp_err_code = serialize.closeEXIStream(&testStrm);
+	fail_unless (tmp_err_code == EXIP_OK, "serialize.closeEXIStream ended with error code %d", tmp_err_code);
+
+	appD.mapStart = buf;
+	appD.mapEnd = buf + strmSize;
+	appD.referencedStrings = 0;
+	appD.strings = 0;
+
+	tmp_err_code = initParserMapped(&testParser, buf, strmSize, &appD);
+	fail_unless (tmp_err_code == EXIP_OK, "initParserMapped returns an error code %d", tmp_err_code);
+	testParser.handler.startElement = mapped_startElement;
+	testParser.handler.stringData = mapped_stringData;
+
+	tmp_err_code = parseHeader(&testParser, FALSE);
+	fail_unless (tmp_err_code == EXIP_OK, "parsing the header returns an error code %d", tmp_err_code);
+	tmp_err_code = setSchema(&testParser, NULL);
+	fail_unless (tmp_err_code == EXIP_OK, "setSchema() returns an error code %d", tmp_err_code);
+	fail_unless (pushEXIData(buf, 1, &testParser) == EXIP_INCONSISTENT_PROC_STATE, "pushEXIData() accepts data for a mapped input");
+
+	while(tmp_err_code == EXIP_OK)
+	{
+		tmp_err_code = parseNext(&testParser);
+	}
+
+	destroyParser(&testParser);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "Error during parsing of the EXI body %d", tmp_err_code);
+	fail_unless (appD.strings == 7, "%d strings are parsed instead of 7", appD.strings);
+	// All four local names (the string table entries reference the input) and the two long values
+	fail_unless (appD.referencedStrings == 6, "%d strings are referenced in the input instead of 6", appD.referencedStrings);
+
+	// A truncated mapped stream cannot be completed with pushEXIData()
+	tmp_err_code = initParserMapped(&testParser, buf, strmSize - 8, NULL);
+	fail_unless (tmp_err_code == EXIP_OK, "initParserMapped returns an error code %d", tmp_err_code);
+	tmp_err_code = parseHeader(&testParser, FALSE);
+	tmp_err_code += setSchema(&testParser, NULL);
+	fail_unless (tmp_err_code == EXIP_OK, "parsing the header returns an error code %d", tmp_err_code);
+	while(tmp_err_code == EXIP_OK)
+	{
+		tmp_err_code = parseNext(&testParser);
+	}
+	destroyParser(&testParser);
+	fail_unless (tmp_err_code == EXIP_INVALID_EXI_INPUT, "Parsing of a truncated mapped stream returns %d", tmp_err_code);
+}
+END_TEST
+
+#if EXIP_ASYNC_OUTPUT == ON
+
+#include <pthread.h>
+#include <sched.h>
+#include "spscQueue.h"
+
+#define ASYNC_SINK_SIZE 8192
+#define ASYNC_BUFFER_SIZE 32
+
+struct asyncSink
+{
+	char data[ASYNC_SINK_SIZE];
+	size_t size;
+	unsigned int writes;
+};
+
+static size_t writeAsyncSink(void* buf, size_t size, void* stream)
+{
+	struct asyncSink* sink = (struct asyncSink*) stream;
+	if(sink->size + size > ASYNC_SINK_SIZE)
+		return 0;
+	memcpy(sink->data + sink->size, buf, size);
+	sink->size += size;
+	sink->writes++;
+	return size;
+}
+
+/** Encodes a schema-less document of 200 elements through buffers of ASYNC_BUFFER_SIZE bytes */
+static errorCode encodeAsyncDoc(struct asyncSink* sink, unsigned int bufCount)
+{
+	const String NS_EMPTY = {NULL, 0};
+	const String ELEM_LOG = {"log", 3};
+	const String ELEM_ENTRY = {"entry", 5};
+	const String VALUE = {"value of the entry", 18};
+	errorCode tmp_err_code = EXIP_OK;
+	EXIStream testStrm;
+	QName qname = {&NS_EMPTY, &ELEM_LOG, NULL};
+	char buf[ASYNC_BUFFER_SIZE];
+	BinaryBuffer buffer;
+	EXITypeClass valueType;
+	int i;
+
+	sink->size = 0;
+	sink->writes = 0;
+	buffer.buf = buf;
+	buffer.bufLen = ASYNC_BUFFER_SIZE;
+	buffer.bufContent = 0;
+	buffer.ioStrm.readWriteToStream = writeAsyncSink;
+	buffer.ioStrm.stream = sink;
+
+	serialize.initHeader(&testStrm);
+	TRY(serialize.initStream(&testStrm, buffer, NULL));
+	if(bufCount > 1)
+		TRY(enableAsyncOutput(&testStrm, bufCount));
+	tmp_err_code += serialize.exiHeader(&testStrm);
+	tmp_err_code += serialize.startDocument(&testStrm);
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <log>
+	for(i = 0; i < 200; i++)
+	{
+		qname.localName = &ELEM_ENTRY;
+		tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <entry>
+		// Every fifth value is new, the others are value table hits
+		tmp_err_code += serialize.stringData(&testStrm, i % 5 == 0 ? VALUE : ELEM_ENTRY);
+		tmp_err_code += serialize.endElement(&testStrm); // </entry>
+	}
+	tmp_err_code += serialize.endElement(&testStrm); // </log>
+	tmp_err_code += serialize.endDocument(&testStrm);
+	if(tmp_err_code != EXIP_OK)
+	{
+		serialize.closeEXIStream(&testStrm);
+		return tmp_err_code;
+	}
+	TRY(serialize.closeEXIStream(&testStrm));
+	if(testStrm.buffer.buf != buf)
+		return EXIP_UNEXPECTED_ERROR;
+
+	return EXIP_OK;
+}
+
+/**
+ * Double-buffered output written by a background thread
+ * produces the same stream as the synchronous output.
+ */
+START_TEST (test_async_output)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	struct asyncSink syncOut;
+	struct asyncSink asyncOut;
+	unsigned int bufCount;
+
+	tmp_err_code = encodeAsyncDoc(&syncOut, 1);
+	fail_unless (tmp_err_code == EXIP_OK, "synchronous encoding returns an error code %d", tmp_err_code);
+	fail_unless (syncOut.writes > 10, "the output is written in %u chunks only", syncOut.writes);
+
+	for(bufCount = 2; bufCount <= 4; bufCount++)
+	{
+		tmp_err_code = encodeAsyncDoc(&asyncOut, bufCount);
+		fail_unless (tmp_err_code == EXIP_OK, "encoding with %u buffers returns an error code %d", bufCount, tmp_err_code);
+		fail_unless (asyncOut.size == syncOut.size, "%u bytes are written with %u buffers instead of %u",
+					(unsigned int) asyncOut.size, bufCount, (unsigned int) syncOut.size);
+		fail_unless (memcmp(asyncOut.data, syncOut.data, syncOut.size) == 0, "the stream written with %u buffers differs", bufCount);
+	}
+}
+END_TEST
+
+#define SPSC_TEST_ITEMS 100000
+
+static void* spscProducer(void* arg)
+{
+	SPSCQueue* queue = (SPSCQueue*) arg;
+	size_t i;
+
+	for(i = 1; i <= SPSC_TEST_ITEMS; i++)
+	{
+		while(!pushSPSCQueue(queue, (void*) i))
+			sched_yield();
+	}
+	return NULL;
+}
+
+/**
+ * The items pushed by a producer thread through a queue shorter than
+ * the stream of items are popped in order and none is lost
+ */
+START_TEST (test_spsc_queue)
+{
+	SPSCQueue queue;
+	pthread_t producer;
+	void* item = NULL;
+	size_t expected;
+
+	fail_unless (createSPSCQueue(&queue, 3) == EXIP_OK, "createSPSCQueue fails");
+	fail_unless (popSPSCQueue(&queue, &item) == FALSE, "an item is popped from an empty queue");
+	fail_unless (pthread_create(&producer, NULL, spscProducer, &queue) == 0, "the producer is not started");
+
+	for(expected = 1; expected <= SPSC_TEST_ITEMS; expected++)
+	{
+		// Every other pop waits for two items to cover the wait for several
+		waitSPSCQueue(&queue, (expected % 2 == 0 && expected < SPSC_TEST_ITEMS) ? 2 : 1);
+		fail_unless (popSPSCQueue(&queue, &item), "item %lu is not in the queue", (unsigned long) expected);
+		fail_unless ((size_t) item == expected, "item %lu is popped instead of %lu", (unsigned long) (size_t) item, (unsigned long) expected);
+	}
+
+	pthread_join(producer, NULL);
+	fail_unless (popSPSCQueue(&queue, &item) == FALSE, "an item is popped after the last one");
+	destroySPSCQueue(&queue);
+}
+END_TEST
+
+#endif /* EXIP_ASYNC_OUTPUT == ON */
+
+#if EXIP_READ_AHEAD == ON
+
+#define READ_AHEAD_STRM_SIZE 8192
+#define READ_AHEAD_BUFFER_SIZE 64
+
+struct readAheadInput
+{
+	const char* data;
+	size_t size;
+	size_t pos;
+	/** Bytes returned per read; odd so that the blocks split the values */
+	size_t chunk;
+};
+
+struct readAheadAppData
+{
+	unsigned int elements;
+	unsigned int valueChars;
+};
+
+static size_t readAheadInputStream(void* buf, size_t size, void* stream)
+{
+	struct readAheadInput* in = (struct readAheadInput*) stream;
+	if(size > in->chunk)
+		size = in->chunk;
+	if(size > in->size - in->pos)
+		size = in->size - in->pos;
+	memcpy(buf, in->data + in->pos, size);
+	in->pos += size;
+	return size;
+}
+
+static errorCode readAhead_startElement(QName qname, void* app_data)
+{
+	((struct readAheadAppData*) app_data)->elements++;
+	return EXIP_OK;
+}
+
+static errorCode readAhead_stringData(const String value, void* app_data)
+{
+	((struct readAheadAppData*) app_data)->valueChars += value.length;
+	return EXIP_OK;
+}
+
+/** Parses the stream in strmData through buffers of READ_AHEAD_BUFFER_SIZE bytes */
+static errorCode parseReadAhead(const char* strmData, size_t strmSize, unsigned int blockCount, struct readAheadAppData* appD)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Parser testParser;
+	char buf[READ_AHEAD_BUFFER_SIZE];
+	BinaryBuffer buffer;
+	struct readAheadInput in;
+
+	in.data = strmData;
+	in.size = strmSize;
+	in.pos = 0;
+	in.chunk = 37;
+	appD->elements = 0;
+	appD->valueChars = 0;
+
+	buffer.buf = buf;
+	buffer.bufLen = READ_AHEAD_BUFFER_SIZE;
+	buffer.bufContent = 0;
+	buffer.ioStrm.readWriteToStream = readAheadInputStream;
+	buffer.ioStrm.stream = &in;
+
+	TRY(initParser(&testParser, buffer, appD));
+	testParser.handler.startElement = readAhead_startElement;
+	testParser.handler.stringData = readAhead_stringData;
+	if(blockCount > 1)
+		TRY_CATCH(enableReadAhead(&testParser, blockCount), destroyParser(&testParser));
+
+	TRY_CATCH(parseHeader(&testParser, TRUE), destroyParser(&testParser));
+	if(blockCount > 1 && pushEXIData(buf, 1, &testParser) != EXIP_INCONSISTENT_PROC_STATE)
+		tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	else
+		tmp_err_code = setSchema(&testParser, NULL);
+
+	while(tmp_err_code == EXIP_OK)
+	{
+		tmp_err_code = parseNext(&testParser);
+	}
+
+	destroyParser(&testParser);
+	return tmp_err_code;
+}
+
+/**
+ * Parsing with the input read ahead by a background thread
+ * produces the same events as the synchronous input.
+ */
+START_TEST (test_read_ahead)
+{
+	const String NS_EMPTY = {NULL, 0};
+	const String ELEM_LOG = {"log", 3};
+	const String ELEM_ENTRY = {"entry", 5};
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	EXIStream testStrm;
+	QName qname = {&NS_EMPTY, &ELEM_LOG, NULL};
+	char strmData[READ_AHEAD_STRM_SIZE];
+	char value[40];
+	String chVal;
+	BinaryBuffer buffer;
+	EXITypeClass valueType;
+	Index strmSize;
+	struct readAheadAppData syncApp;
+	struct readAheadAppData readAheadApp;
+	unsigned int blockCount;
+	int i;
+
+	buffer.buf = strmData;
+	buffer.bufLen = READ_AHEAD_STRM_SIZE;
+	buffer.bufContent = 0;
+	buffer.ioStrm.readWriteToStream = NULL;
+	buffer.ioStrm.stream = NULL;
+
+	serialize.initHeader(&testStrm);
+	tmp_err_code = serialize.initStream(&testStrm, buffer, NULL);
+	fail_unless (tmp_err_code == EXIP_OK, "initStream returns an error code %d", tmp_err_code);
+	tmp_err_code += serialize.exiHeader(&testStrm);
+	tmp_err_code += serialize.startDocument(&testStrm);
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <log>
+	for(i = 0; i < 150; i++)
+	{
+		qname.localName = &ELEM_ENTRY;
+		tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <entry>
+		sprintf(value, "entry number %d of the log", i);
+		chVal.str = value;
+		chVal.length = strlen(value);
+		tmp_err_code += serialize.stringData(&testStrm, chVal);
+		tmp_err_code += serialize.endElement(&testStrm); // </entry>
+	}
+	tmp_err_code += serialize.endElement(&testStrm); // </log>
+	tmp_err_code += serialize.endDocument(&testStrm);
+	fail_unless (tmp_err_code == EXIP_OK, "serialization ended with error code %d", tmp_err_code);
+	strmSize = testStrm.context.bufferIndx + (testStrm.context.bitPointer != 0);
+	tmp_err_code = serialize.closeEXIStream(&testStrm);
+	fail_unless (tmp_err_code == EXIP_OK, "serialize.closeEXIStream ended with error code %d", tmp_err_code);
+
+	tmp_err_code = parseReadAhead(strmData, strmSize, 1, &syncApp);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "synchronous parsing returns an error code %d", tmp_err_code);
+	fail_unless (syncApp.elements == 151, "%u elements are parsed instead of 151", syncApp.elements);
+
+	for(blockCount = 2; blockCount <= 4; blockCount++)
+	{
+		tmp_err_code = parseReadAhead(strmData, strmSize, blockCount, &readAheadApp);
+		fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "parsing with %u blocks returns an error code %d", blockCount, tmp_err_code);
+		fail_unless (readAheadApp.elements == syncApp.elements && readAheadApp.valueChars == syncApp.valueChars,
+					"%u elements and %u value characters are parsed with %u blocks", readAheadApp.elements, readAheadApp.valueChars, blockCount);
+	}
+
+	// A truncated stream ends with an error instead of waiting for more input
+	tmp_err_code = parseReadAhead(strmData, strmSize - 16, 3, &readAheadApp);
+	fail_unless (tmp_err_code != EXIP_OK && tmp_err_code != EXIP_PARSING_COMPLETE, "parsing of a truncated stream returns %d", tmp_err_code);
+}
+END_TEST
+
+#endif /* EXIP_READ_AHEAD == ON */
+
+#define COMPRESSION_STRM_SIZE 16384
+
+struct compressionAppData
+{
+	unsigned int elements;
+	unsigned int attributes;
+	unsigned int values;
+	/** Depends on the order of the value characters */
+	unsigned long hash;
+};
+
+static errorCode compression_startElement(QName qname, void* app_data)
+{
+	((struct compressionAppData*) app_data)->elements++;
+	return EXIP_OK;
+}
+
+static errorCode compression_attribute(QName qname, void* app_data)
+{
+	((struct compressionAppData*) app_data)->attributes++;
+	return EXIP_OK;
+}
+
+static errorCode compression_stringData(const String value, void* app_data)
+{
+	struct compressionAppData* appD = (struct compressionAppData*) app_data;
+	Index i;
+
+	appD->values++;
+	for(i = 0; i < value.length; i++)
+		appD->hash = 31*appD->hash + (unsigned char) value.str[i];
+	return EXIP_OK;
+}
+
+/**
+ * Encodes a schema-less document of entryCount elements, each with an
+ * attribute and character data, into strmData and parses it back into appD.
+ * mode is COMPRESSION or one of the alignment options. The encoder and
+ * the parser take their memory from allocator.
+ */
+static errorCode compressionRoundTrip(unsigned char mode, uint32_t blockSize, int entryCount, char* strmData, Index* strmSize, struct compressionAppData* appD,
+		const EXIPAllocator* allocator)
+{
+	const String NS_EMPTY = {NULL, 0};
+	const String ELEM_LOG = {"log", 3};
+	const String ELEM_ENTRY = {"entry", 5};
+	const String ATTR_ID = {"id", 2};
+	errorCode tmp_err_code = EXIP_OK;
+	EXIStream testStrm;
+	Parser testParser;
+	QName qname = {&NS_EMPTY, &ELEM_LOG, NULL};
+	char value[40];
+	String chVal;
+	BinaryBuffer buffer;
+	EXITypeClass valueType;
+	int i;
+
+	buffer.buf = strmData;
+	buffer.bufLen = COMPRESSION_STRM_SIZE;
+	buffer.bufContent = 0;
+	buffer.ioStrm.readWriteToStream = NULL;
+	buffer.ioStrm.stream = NULL;
+
+	serialize.initHeader(&testStrm);
+	testStrm.header.has_options = TRUE;
+	if(mode == COMPRESSION)
+		SET_COMPRESSION(testStrm.header.opts.enumOpt);
+	else
+		SET_ALIGNMENT(testStrm.header.opts.enumOpt, mode);
+	testStrm.header.opts.blockSize = blockSize;
+	TRY(initStreamAllocator(&testStrm, buffer, NULL, allocator));
+	tmp_err_code += serialize.exiHeader(&testStrm);
+	tmp_err_code += serialize.startDocument(&testStrm);
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <log>
+	for(i = 0; i < entryCount && tmp_err_code == EXIP_OK; i++)
+	{
+		qname.localName = &ELEM_ENTRY;
+		tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <entry>
+		qname.localName = &ATTR_ID;
+		tmp_err_code += serialize.attribute(&testStrm, qname, TRUE, &valueType); // id="..."
+		sprintf(value, "%d", i % 7);
+		chVal.str = value;
+		chVal.length = strlen(value);
+		tmp_err_code += serialize.stringData(&testStrm, chVal);
+		sprintf(value, "entry number %d of the log", i);
+		chVal.length = strlen(value);
+		tmp_err_code += serialize.stringData(&testStrm, chVal);
+		tmp_err_code += serialize.endElement(&testStrm); // </entry>
+	}
+	tmp_err_code += serialize.endElement(&testStrm); // </log>
+	tmp_err_code += serialize.endDocument(&testStrm);
+	if(tmp_err_code != EXIP_OK)
+	{
+		serialize.closeEXIStream(&testStrm);
+		return tmp_err_code;
+	}
+	*strmSize = testStrm.buffer.bufContent;
+	TRY(serialize.closeEXIStream(&testStrm));
+
+	buffer.bufContent = *strmSize;
+	appD->elements = 0;
+	appD->attributes = 0;
+	appD->values = 0;
+	appD->hash = 0;
+
+	TRY(initParserAllocator(&testParser, buffer, appD, allocator));
+	testParser.handler.startElement = compression_startElement;
+	testParser.handler.attribute = compression_attribute;
+	testParser.handler.stringData = compression_stringData;
+
+	TRY_CATCH(parseHeader(&testParser, FALSE), destroyParser(&testParser));
+	tmp_err_code = setSchema(&testParser, NULL);
+	while(tmp_err_code == EXIP_OK)
+	{
+		tmp_err_code = parseNext(&testParser);
+	}
+
+	destroyParser(&testParser);
+	return tmp_err_code;
+}
+
+/**
+ * Pre-compression: the values of an element are written one after
+ * the other and the events are the same as with the bit-packed stream.
+ */
+START_TEST (test_pre_compression)
+{
+	const char GROUPED_VALUES[] = "entry number 0 of the log\x1B" "entry number 1 of the log";
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char plainData[COMPRESSION_STRM_SIZE];
+	char preCompressedData[COMPRESSION_STRM_SIZE];
+	struct compressionAppData plainApp;
+	struct compressionAppData preCompressedApp;
+	Index plainSize;
+	Index preCompressedSize;
+	// A single block, several blocks
+	const uint32_t blockSize[2] = {1000000, 130};
+	boolean grouped;
+	Index j;
+	int i;
+
+	tmp_err_code = compressionRoundTrip(BIT_PACKED, 1000000, 200, plainData, &plainSize, &plainApp, NULL);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "bit-packed round trip returns an error code %d", tmp_err_code);
+
+	for(i = 0; i < 2; i++)
+	{
+		tmp_err_code = compressionRoundTrip(PRE_COMPRESSION, blockSize[i], 200, preCompressedData, &preCompressedSize, &preCompressedApp, NULL);
+		fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "pre-compression round trip %d returns an error code %d", i, tmp_err_code);
+		fail_unless (preCompressedApp.elements == plainApp.elements && preCompressedApp.attributes == plainApp.attributes &&
+					preCompressedApp.values == plainApp.values && preCompressedApp.hash == plainApp.hash,
+					"the events of pre-compression round trip %d differ: %u elements, %u attributes, %u values",
+					i, preCompressedApp.elements, preCompressedApp.attributes, preCompressedApp.values);
+
+		// The first two character data values are next to each other (the length of the second one is 25 + 2)
+		grouped = FALSE;
+		for(j = 0; j + sizeof(GROUPED_VALUES) - 1 <= preCompressedSize && !grouped; j++)
+			grouped = memcmp(preCompressedData + j, GROUPED_VALUES, sizeof(GROUPED_VALUES) - 1) == 0;
+		fail_unless (grouped, "the values of round trip %d are not in the channel of their element", i);
+	}
+}
+END_TEST
+
+struct countingAllocator
+{
+	unsigned int allocations;
+	unsigned int live;
+};
+
+static void* counting_allocate(void* context, size_t size)
+{
+	struct countingAllocator* c = (struct countingAllocator*) context;
+	void* ptr = malloc(size);
+
+	if(ptr != NULL)
+	{
+		c->allocations++;
+		c->live++;
+	}
+	return ptr;
+}
+
+static void* counting_reallocate(void* context, void* ptr, size_t size)
+{
+	struct countingAllocator* c = (struct countingAllocator*) context;
+	void* newPtr = realloc(ptr, size);
+
+	if(newPtr != NULL && ptr == NULL)
+	{
+		c->allocations++;
+		c->live++;
+	}
+	return newPtr;
+}
+
+static void counting_release(void* context, void* ptr)
+{
+	((struct countingAllocator*) context)->live--;
+	free(ptr);
+}
+
+/**
+ * The memory of the encoder and of the parser goes through the allocator
+ * given at initialization and all of it is given back when they are closed.
+ */
+START_TEST (test_allocator)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char plainData[COMPRESSION_STRM_SIZE];
+	char strmData[COMPRESSION_STRM_SIZE];
+	struct compressionAppData plainApp;
+	struct compressionAppData appD;
+	struct countingAllocator counter;
+	EXIPAllocator allocator = {counting_allocate, counting_reallocate, counting_release, NULL};
+	Index plainSize;
+	Index strmSize;
+#if EXIP_COMPRESSION == ON
+	const unsigned char mode[3] = {BIT_PACKED, PRE_COMPRESSION, COMPRESSION};
+	const int modeCount = 3;
+#else
+	const unsigned char mode[2] = {BIT_PACKED, PRE_COMPRESSION};
+	const int modeCount = 2;
+#endif
+	int i;
+
+	allocator.context = &counter;
+
+	tmp_err_code = compressionRoundTrip(BIT_PACKED, 1000000, 200, plainData, &plainSize, &plainApp, NULL);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "round trip without an allocator returns an error code %d", tmp_err_code);
+
+	for(i = 0; i < modeCount; i++)
+	{
+		counter.allocations = 0;
+		counter.live = 0;
+		tmp_err_code = compressionRoundTrip(mode[i], 130, 200, strmData, &strmSize, &appD, &allocator);
+		fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "round trip %d with an allocator returns an error code %d", i, tmp_err_code);
+		fail_unless (appD.elements == plainApp.elements && appD.attributes == plainApp.attributes &&
+					appD.values == plainApp.values && appD.hash == plainApp.hash,
+					"the events of round trip %d with an allocator differ", i);
+		fail_unless (counter.allocations > 0, "the allocator of round trip %d is not used", i);
+		fail_unless (counter.live == 0, "%u blocks of round trip %d are not given back to the allocator", counter.live, i);
+	}
+}
+END_TEST
+
+/* The hash table of the value table of the encoder is in the region:
+ * INITIAL_HASH_TABLE_SIZE rounded up to a power of two, of up to 32 bytes each */
+#define REGION_SIZE (65536 + 64*INITIAL_HASH_TABLE_SIZE)
+
+/** The memory of the streams of test_memory_region */
+static char region[REGION_SIZE];
+
+/**
+ * Encodes a schema-less document of entryCount elements into strmData
+ * with the stream memory carved from the first regionSize bytes of region
+ */
+static errorCode regionEncode(size_t regionSize, int entryCount, char* strmData, Index* strmSize, size_t* peak)
+{
+	const String NS_EMPTY = {NULL, 0};
+	const String ELEM_LOG = {"log", 3};
+	const String ELEM_ENTRY = {"entry", 5};
+	const String ATTR_ID = {"id", 2};
+	errorCode tmp_err_code = EXIP_OK;
+	EXIStream testStrm;
+	QName qname = {&NS_EMPTY, &ELEM_LOG, NULL};
+	char value[40];
+	String chVal;
+	BinaryBuffer buffer;
+	EXITypeClass valueType;
+	int i;
+
+	buffer.buf = strmData;
+	buffer.bufLen = COMPRESSION_STRM_SIZE;
+	buffer.bufContent = 0;
+	buffer.ioStrm.readWriteToStream = NULL;
+	buffer.ioStrm.stream = NULL;
+
+	serialize.initHeader(&testStrm);
+	testStrm.header.has_options = TRUE;
+	TRY(initStreamRegion(&testStrm, buffer, NULL, region, regionSize));
+	tmp_err_code = serialize.exiHeader(&testStrm);
+	if(tmp_err_code == EXIP_OK)
+		tmp_err_code = serialize.startDocument(&testStrm);
+	if(tmp_err_code == EXIP_OK)
+		tmp_err_code = serialize.startElement(&testStrm, qname, &valueType); // <log>
+	for(i = 0; i < entryCount && tmp_err_code == EXIP_OK; i++)
+	{
+		qname.localName = &ELEM_ENTRY;
+		tmp_err_code = serialize.startElement(&testStrm, qname, &valueType); // <entry>
+		qname.localName = &ATTR_ID;
+		if(tmp_err_code == EXIP_OK)
+			tmp_err_code = serialize.attribute(&testStrm, qname, TRUE, &valueType); // id="..."
+		sprintf(value, "entry number %d of the log", i);
+		chVal.str = value;
+		chVal.length = strlen(value);
+		if(tmp_err_code == EXIP_OK)
+			tmp_err_code = serialize.stringData(&testStrm, chVal);
+		if(tmp_err_code == EXIP_OK)
+			tmp_err_code = serialize.endElement(&testStrm); // </entry>
+	}
+	if(tmp_err_code == EXIP_OK)
+		tmp_err_code = serialize.endElement(&testStrm); // </log>
+	if(tmp_err_code == EXIP_OK)
+		tmp_err_code = serialize.endDocument(&testStrm);
+	*strmSize = testStrm.buffer.bufContent;
+	getStreamRegionPeak(&testStrm, peak);
+	serialize.closeEXIStream(&testStrm);
+
+	return tmp_err_code;
+}
+
+/**
+ * Zero-heap mode: the encoder and the parser run within a memory region
+ * of the caller, the size reported for it is enough for the same stream
+ * and a smaller region is reported as an allocation error.
+ */
+START_TEST (test_memory_region)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char strmData[COMPRESSION_STRM_SIZE];
+	Index strmSize;
+	Parser testParser;
+	BinaryBuffer buffer;
+	struct compressionAppData appD;
+	size_t peak;
+	size_t parserPeak;
+	EXIStream testStrm;
+
+	tmp_err_code = regionEncode(REGION_SIZE, 50, strmData, &strmSize, &peak);
+	fail_unless (tmp_err_code == EXIP_OK, "serialization in a region returns an error code %d", tmp_err_code);
+	fail_unless (peak > 0 && peak <= REGION_SIZE, "the region peak of the encoder is %lu", (unsigned long) peak);
+
+	// The region is set up again so the same stream fits in the peak
+	tmp_err_code = regionEncode(peak, 50, strmData, &strmSize, &peak);
+	fail_unless (tmp_err_code == EXIP_OK, "serialization in a region of the peak size returns an error code %d", tmp_err_code);
+	tmp_err_code = regionEncode(peak/2, 50, strmData, &strmSize, &peak);
+	fail_unless (tmp_err_code == EXIP_MEMORY_ALLOCATION_ERROR, "serialization in a too small region returns %d", tmp_err_code);
+	tmp_err_code = regionEncode(REGION_SIZE, 50, strmData, &strmSize, &peak);
+	fail_unless (tmp_err_code == EXIP_OK, "serialization in a region returns an error code %d", tmp_err_code);
+
+	buffer.buf = strmData;
+	buffer.bufLen = COMPRESSION_STRM_SIZE;
+	buffer.bufContent = strmSize;
+	buffer.ioStrm.readWriteToStream = NULL;
+	buffer.ioStrm.stream = NULL;
+	appD.elements = 0;
+	appD.attributes = 0;
+	appD.values = 0;
+	appD.hash = 0;
+
+	tmp_err_code = initParserRegion(&testParser, buffer, &appD, region, REGION_SIZE);
+	fail_unless (tmp_err_code == EXIP_OK, "initParserRegion returns an error code %d", tmp_err_code);
+	testParser.handler.startElement = compression_startElement;
+	testParser.handler.attribute = compression_attribute;
+	testParser.handler.stringData = compression_stringData;
+	tmp_err_code = parseHeader(&testParser, FALSE);
+	fail_unless (tmp_err_code == EXIP_OK, "parsing the header returns an error code %d", tmp_err_code);
+	tmp_err_code = setSchema(&testParser, NULL);
+	while(tmp_err_code == EXIP_OK)
+	{
+		tmp_err_code = parseNext(&testParser);
+	}
+	fail_unless (getParserRegionPeak(&testParser, &parserPeak) == EXIP_OK && parserPeak <= REGION_SIZE,
+				"the region peak of the parser is not available");
+	destroyParser(&testParser);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "parsing in a region returns an error code %d", tmp_err_code);
+	fail_unless (appD.elements == 51 && appD.attributes == 50 && appD.values == 50,
+				"%u elements, %u attributes and %u values are parsed from the region", appD.elements, appD.attributes, appD.values);
+
+	// Not enough for the state of the region
+	serialize.initHeader(&testStrm);
+	tmp_err_code = initStreamRegion(&testStrm, buffer, NULL, region, 4);
+	fail_unless (tmp_err_code == EXIP_MEMORY_ALLOCATION_ERROR, "initStreamRegion accepts a region of 4 bytes");
+	tmp_err_code = initStream(&testStrm, buffer, NULL);
+	fail_unless (tmp_err_code == EXIP_OK && getStreamRegionPeak(&testStrm, &peak) == EXIP_INVALID_EXIP_CONFIGURATION,
+				"a stream on the heap reports the peak of a region");
+	serialize.closeEXIStream(&testStrm);
+}
+END_TEST
+
+/** The final size of the arrays of test_memory_region_growth */
+#define REGION_ARRAY_SIZE 4096
+
+/**
+ * Two arrays growing in turns within a region: each of them is moved when
+ * it grows as the other one is allocated after it. The space they leave
+ * behind must stay proportional to their size.
+ */
+START_TEST (test_memory_region_growth)
+{
+	const EXIPAllocator* allocator;
+	char* arrays[2] = {NULL, NULL};
+	size_t size;
+	size_t peak;
+	int i;
+
+	fail_unless (initMemoryRegion(region, REGION_SIZE, &allocator) == EXIP_OK);
+
+	for(size = 64; size <= REGION_ARRAY_SIZE; size += 64)
+	{
+		for(i = 0; i < 2; i++)
+		{
+			char* ptr = (char*) EXIP_REALLOCATE(allocator, arrays[i], size);
+			fail_unless (ptr != NULL, "array %d cannot grow to %lu bytes", i, (unsigned long) size);
+			memset(ptr + size - 64, 'a' + i, 64);
+			arrays[i] = ptr;
+		}
+	}
+
+	for(i = 0; i < 2; i++)
+	{
+		for(size = 0; size < REGION_ARRAY_SIZE; size++)
+			fail_unless (arrays[i][size] == 'a' + i, "byte %lu of array %d is lost", (unsigned long) size, i);
+	}
+
+	fail_unless (getMemoryRegionPeak(allocator, &peak) == EXIP_OK);
+	fail_unless (peak <= 2*4*REGION_ARRAY_SIZE, "the region peak of two arrays of %d bytes is %lu", REGION_ARRAY_SIZE, (unsigned long) peak);
+
+	allocator->release(allocator->context, NULL);
+	EXIP_RELEASE(allocator, arrays[1]);
+	EXIP_RELEASE(allocator, arrays[0]);
+
+	// The space left behind by the moves is given back as well
+	arrays[0] = (char*) EXIP_ALLOCATE(allocator, REGION_SIZE - 1024);
+	fail_unless (arrays[0] != NULL, "the released blocks are not given back to the region");
+	EXIP_RELEASE(allocator, arrays[0]);
+}
+END_TEST
+
+/**
+ * Blocks released out of order are given back to the region once the
+ * blocks allocated after them are released too.
+ */
+START_TEST (test_memory_region_release)
+{
+	const EXIPAllocator* allocator;
+	void* blocks[3];
+	void* ptr;
+	int i;
+
+	fail_unless (initMemoryRegion(region, REGION_SIZE, &allocator) == EXIP_OK);
+
+	for(i = 0; i < 3; i++)
+	{
+		blocks[i] = EXIP_ALLOCATE(allocator, REGION_SIZE/4);
+		fail_unless (blocks[i] != NULL, "block %d cannot be allocated", i);
+	}
+
+	EXIP_RELEASE(allocator, blocks[1]);
+	EXIP_RELEASE(allocator, blocks[0]);
+	ptr = EXIP_ALLOCATE(allocator, REGION_SIZE/4);
+	fail_unless (ptr == NULL, "a block released before the last one is reused");
+
+	EXIP_RELEASE(allocator, blocks[2]);
+	ptr = EXIP_ALLOCATE(allocator, 3*(REGION_SIZE/4));
+	fail_unless (ptr == blocks[0], "the blocks released out of order are not given back to the region");
+	EXIP_RELEASE(allocator, ptr);
+}
+END_TEST
+
+#if EXIP_COMPRESSION == ON
+
+/**
+ * EXI compression: the events of the decoded stream are the same as
+ * with the bit-packed stream regardless of the number of values in
+ * the channels and of the number of blocks.
+ */
+START_TEST (test_compression)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char plainData[COMPRESSION_STRM_SIZE];
+	char compressedData[COMPRESSION_STRM_SIZE];
+	struct compressionAppData plainApp;
+	struct compressionAppData compressedApp;
+	Index plainSize;
+	Index compressedSize;
+	// Up to CHANNEL_SMALL_VALUES values, large channels, several blocks, a single value per block
+	const int entryCount[4] = {30, 200, 200, 5};
+	const uint32_t blockSize[4] = {1000000, 1000000, 130, 1};
+	int i;
+
+	for(i = 0; i < 4; i++)
+	{
+		tmp_err_code = compressionRoundTrip(BIT_PACKED, 1000000, entryCount[i], plainData, &plainSize, &plainApp, NULL);
+		fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "bit-packed round trip %d returns an error code %d", i, tmp_err_code);
+		fail_unless (plainApp.elements == (unsigned int) entryCount[i] + 1, "%u elements are parsed instead of %d", plainApp.elements, entryCount[i] + 1);
+
+		tmp_err_code = compressionRoundTrip(COMPRESSION, blockSize[i], entryCount[i], compressedData, &compressedSize, &compressedApp, NULL);
+		fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "compressed round trip %d returns an error code %d", i, tmp_err_code);
+		fail_unless (compressedApp.elements == plainApp.elements && compressedApp.attributes == plainApp.attributes &&
+					compressedApp.values == plainApp.values && compressedApp.hash == plainApp.hash,
+					"the events of compressed round trip %d differ: %u elements, %u attributes, %u values",
+					i, compressedApp.elements, compressedApp.attributes, compressedApp.values);
+
+		if(i == 1)
+			fail_unless (compressedSize < plainSize, "the compressed stream is %u bytes and the bit-packed one %u bytes",
+						(unsigned int) compressedSize, (unsigned int) plainSize);
+	}
+}
+END_TEST
+
+#endif /* EXIP_COMPRESSION == ON */
+
+#if EXIP_PIPELINE == ON
+
+#define PIPELINE_BUFFER_SIZE 64
+#define PIPELINE_PUSH_SIZE 16
+
+/** Stops the parsing at the 50th value */
+static errorCode pipeline_stopStringData(const String value, void* app_data)
+{
+	compression_stringData(value, app_data);
+	if(((struct compressionAppData*) app_data)->values == 50)
+		return EXIP_HANDLER_STOP;
+	return EXIP_OK;
+}
+
+/**
+ * Parses the stream in strmData pushing it in chunks of PIPELINE_PUSH_SIZE bytes.
+ * The events of an item that is parsed again after pushEXIData() are passed
+ * to the handler only once.
+ */
+static errorCode parsePipelined(const char* strmData, Index strmSize, unsigned int batchCount, boolean stop, struct compressionAppData* appD)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Parser testParser;
+	char buf[PIPELINE_BUFFER_SIZE];
+	BinaryBuffer buffer;
+	Index pushed = PIPELINE_BUFFER_SIZE;
+	Index pushSize;
+
+	memcpy(buf, strmData, PIPELINE_BUFFER_SIZE);
+	buffer.buf = buf;
+	buffer.bufLen = PIPELINE_BUFFER_SIZE;
+	buffer.bufContent = PIPELINE_BUFFER_SIZE;
+	buffer.ioStrm.readWriteToStream = NULL;
+	buffer.ioStrm.stream = NULL;
+	appD->elements = 0;
+	appD->attributes = 0;
+	appD->values = 0;
+	appD->hash = 0;
+
+	TRY(initParser(&testParser, buffer, appD));
+	testParser.handler.startElement = compression_startElement;
+	testParser.handler.attribute = compression_attribute;
+	testParser.handler.stringData = stop ? pipeline_stopStringData : compression_stringData;
+	TRY_CATCH(enablePipeline(&testParser, batchCount), destroyParser(&testParser));
+
+	TRY_CATCH(parseHeader(&testParser, FALSE), destroyParser(&testParser));
+	tmp_err_code = setSchema(&testParser, NULL);
+	while(tmp_err_code == EXIP_OK || (tmp_err_code == EXIP_BUFFER_END_REACHED && pushed < strmSize))
+	{
+		if(tmp_err_code == EXIP_BUFFER_END_REACHED)
+		{
+			pushSize = strmSize - pushed < PIPELINE_PUSH_SIZE ? strmSize - pushed : PIPELINE_PUSH_SIZE;
+			tmp_err_code = pushEXIData((char*) strmData + pushed, pushSize, &testParser);
+			pushed += pushSize;
+			if(tmp_err_code != EXIP_OK)
+				break;
+		}
+		tmp_err_code = parseNext(&testParser);
+	}
+
+	destroyParser(&testParser);
+	return tmp_err_code;
+}
+
+/**
+ * Pipelined parsing passes the same events to the handler as
+ * the synchronous parsing and stops at an error of the handler.
+ */
+START_TEST (test_pipeline)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char strmData[COMPRESSION_STRM_SIZE];
+	struct compressionAppData syncApp;
+	struct compressionAppData pipelinedApp;
+	Index strmSize;
+	unsigned int batchCount;
+
+	// The whole stream is in the buffer of the synchronous parsing
+	tmp_err_code = compressionRoundTrip(BIT_PACKED, 1000000, 200, strmData, &strmSize, &syncApp, NULL);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "synchronous round trip returns an error code %d", tmp_err_code);
+	fail_unless (syncApp.elements == 201, "%u elements are parsed instead of 201", syncApp.elements);
+
+	for(batchCount = 2; batchCount <= 3; batchCount++)
+	{
+		tmp_err_code = parsePipelined(strmData, strmSize, batchCount, FALSE, &pipelinedApp);
+		fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "parsing with %u batches returns an error code %d", batchCount, tmp_err_code);
+		fail_unless (pipelinedApp.elements == syncApp.elements && pipelinedApp.attributes == syncApp.attributes &&
+					pipelinedApp.values == syncApp.values && pipelinedApp.hash == syncApp.hash,
+					"%u elements, %u attributes and %u values are parsed with %u batches",
+					pipelinedApp.elements, pipelinedApp.attributes, pipelinedApp.values, batchCount);
+	}
+
+	// No callbacks after the one that stops the parsing
+	tmp_err_code = parsePipelined(strmData, strmSize, 2, TRUE, &pipelinedApp);
+	fail_unless (tmp_err_code == EXIP_HANDLER_STOP, "stopped parsing returns an error code %d", tmp_err_code);
+	fail_unless (pipelinedApp.values == 50, "%u values are passed to the handler instead of 50", pipelinedApp.values);
+}
+END_TEST
+
+#endif /* EXIP_PIPELINE == ON */
+
+#define SC_STRM_SIZE 1024
+
+/** The state of the encoder around a self-contained element */
+struct scPositions
+{
+	Index valuesBefore;
+	Index valuesInside;
+	Index valuesAfter;
+	Index valuesEnd;
+	SmallIndex urisBefore;
+	SmallIndex urisAfter;
+	/** The position right after selfContained() */
+	Index startIndx;
+	unsigned int startBit;
+	/** The position after the end of the self-contained element */
+	Index endIndx;
+	unsigned int endBit;
+};
+
+/**
+ * Encodes <root> with itemCount <item>v</item> elements followed by
+ * the self-contained <rec id="v"><x>v</x><x>w</x></rec> and <item>v</item>
+ */
+static errorCode encodeSelfContained(int itemCount, char* strmData, struct scPositions* pos)
+{
+	const String NS_EMPTY = {NULL, 0};
+	const String NS_REC = {"urn:rec", 7};
+	const String ELEM_ROOT = {"root", 4};
+	const String ELEM_ITEM = {"item", 4};
+	const String ELEM_REC = {"rec", 3};
+	const String ELEM_X = {"x", 1};
+	const String ATTR_ID = {"id", 2};
+	const String VALUE_V = {"v", 1};
+	const String VALUE_W = {"w", 1};
+	errorCode tmp_err_code = EXIP_OK;
+	EXIStream testStrm;
+	QName qname = {&NS_EMPTY, &ELEM_ROOT, NULL};
+	BinaryBuffer buffer;
+	EXITypeClass valueType;
+	int i;
+
+	buffer.buf = strmData;
+	buffer.bufLen = SC_STRM_SIZE;
+	buffer.bufContent = 0;
+	buffer.ioStrm.readWriteToStream = NULL;
+	buffer.ioStrm.stream = NULL;
+
+	serialize.initHeader(&testStrm);
+	testStrm.header.has_options = TRUE;
+	SET_SELF_CONTAINED(testStrm.header.opts.enumOpt);
+	TRY(serialize.initStream(&testStrm, buffer, NULL));
+	tmp_err_code += serialize.exiHeader(&testStrm);
+	tmp_err_code += serialize.startDocument(&testStrm);
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <root>
+	qname.localName = &ELEM_ITEM;
+	for(i = 0; i < itemCount; i++)
+	{
+		tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <item>
+		tmp_err_code += serialize.stringData(&testStrm, VALUE_V);
+		tmp_err_code += serialize.endElement(&testStrm); // </item>
+	}
+	pos->valuesBefore = testStrm.valueTable.count;
+	pos->urisBefore = testStrm.schema->uriTable.count;
+
+	qname.localName = &ELEM_REC;
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <rec>
+	tmp_err_code += serialize.selfContained(&testStrm);
+	pos->valuesInside = testStrm.valueTable.count;
+	pos->startIndx = testStrm.context.bufferIndx;
+	pos->startBit = testStrm.context.bitPointer;
+	qname.localName = &ATTR_ID;
+	tmp_err_code += serialize.attribute(&testStrm, qname, TRUE, &valueType); // id="v"
+	tmp_err_code += serialize.stringData(&testStrm, VALUE_V);
+	qname.uri = &NS_REC;
+	qname.localName = &ELEM_X;
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <x>
+	tmp_err_code += serialize.stringData(&testStrm, VALUE_V);
+	tmp_err_code += serialize.endElement(&testStrm); // </x>
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <x>
+	tmp_err_code += serialize.stringData(&testStrm, VALUE_W);
+	tmp_err_code += serialize.endElement(&testStrm); // </x>
+	tmp_err_code += serialize.endElement(&testStrm); // </rec>
+	pos->endIndx = testStrm.context.bufferIndx;
+	pos->endBit = testStrm.context.bitPointer;
+	pos->valuesAfter = testStrm.valueTable.count;
+	pos->urisAfter = testStrm.schema->uriTable.count;
+
+	qname.uri = &NS_EMPTY;
+	qname.localName = &ELEM_ITEM;
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <item>
+	tmp_err_code += serialize.stringData(&testStrm, VALUE_V);
+	tmp_err_code += serialize.endElement(&testStrm); // </item>
+	pos->valuesEnd = testStrm.valueTable.count;
+	tmp_err_code += serialize.endElement(&testStrm); // </root>
+	tmp_err_code += serialize.endDocument(&testStrm);
+	if(tmp_err_code != EXIP_OK)
+	{
+		serialize.closeEXIStream(&testStrm);
+		return tmp_err_code;
+	}
+
+	return serialize.closeEXIStream(&testStrm);
+}
+
+/**
+ * Self-contained elements: the content starts at a byte boundary and is
+ * encoded the same way regardless of what precedes it; the string tables
+ * of the document are restored after the element.
+ */
+START_TEST (test_self_contained)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char strmData[2][SC_STRM_SIZE];
+	struct scPositions pos[2];
+	Index bits[2];
+	int i;
+
+	for(i = 0; i < 2; i++)
+	{
+		tmp_err_code = encodeSelfContained(1 + 2*i, strmData[i], &pos[i]);
+		fail_unless (tmp_err_code == EXIP_OK, "encoding %d returns an error code %d", i, tmp_err_code);
+		fail_unless (pos[i].valuesInside == 0, "the value table is not reset: %u values", (unsigned int) pos[i].valuesInside);
+		fail_unless (pos[i].valuesAfter == pos[i].valuesBefore && pos[i].urisAfter == pos[i].urisBefore,
+					"the string tables are not restored: %u values, %u URIs", (unsigned int) pos[i].valuesAfter, (unsigned int) pos[i].urisAfter);
+		// "v" is found in the restored value table
+		fail_unless (pos[i].valuesEnd == pos[i].valuesAfter, "the value after the self-contained element is added again");
+		bits[i] = 8*(pos[i].endIndx - pos[i].startIndx) + pos[i].endBit - pos[i].startBit;
+	}
+
+	fail_unless (pos[0].startBit == pos[1].startBit && bits[0] == bits[1],
+				"the self-contained elements are encoded differently: %u and %u bits",
+				(unsigned int) bits[0], (unsigned int) bits[1]);
+	fail_unless (memcmp(strmData[0] + pos[0].startIndx + 1, strmData[1] + pos[1].startIndx + 1, pos[0].endIndx - pos[0].startIndx - 1) == 0,
+				"the content of the self-contained elements differ");
+}
+END_TEST
+
+#define CHECKPOINT_BUFFER_SIZE 64
+#define CHECKPOINT_LOG_SIZE 32768
+
+/** An EXI stream in memory read as an input stream */
+struct checkpointInput
+{
+	const char* data;
+	size_t size;
+	size_t pos;
+};
+
+/** The parsed events as text; also used as the side-car of the checkpoints */
+struct checkpointLog
+{
+	char text[CHECKPOINT_LOG_SIZE];
+	size_t len;
+};
+
+static size_t readCheckpointInput(void* buf, size_t size, void* stream)
+{
+	struct checkpointInput* in = (struct checkpointInput*) stream;
+
+	if(size > in->size - in->pos)
+		size = in->size - in->pos;
+	memcpy(buf, in->data + in->pos, size);
+	in->pos += size;
+	return size;
+}
+
+static size_t writeCheckpointLog(void* buf, size_t size, void* stream)
+{
+	struct checkpointLog* log = (struct checkpointLog*) stream;
+
+	if(size > CHECKPOINT_LOG_SIZE - log->len)
+		return 0;
+	memcpy(log->text + log->len, buf, size);
+	log->len += size;
+	return size;
+}
+
+static void appendCheckpointLog(struct checkpointLog* log, char tag, const String* str)
+{
+	writeCheckpointLog(&tag, 1, log);
+	if(str != NULL)
+		writeCheckpointLog(str->str, str->length, log);
+}
+
+static errorCode checkpoint_startElement(QName qname, void* app_data)
+{
+	appendCheckpointLog((struct checkpointLog*) app_data, '<', qname.localName);
+	return EXIP_OK;
+}
+
+static errorCode checkpoint_endElement(void* app_data)
+{
+	appendCheckpointLog((struct checkpointLog*) app_data, '>', NULL);
+	return EXIP_OK;
+}
+
+static errorCode checkpoint_attribute(QName qname, void* app_data)
+{
+	appendCheckpointLog((struct checkpointLog*) app_data, '@', qname.localName);
+	return EXIP_OK;
+}
+
+static errorCode checkpoint_stringData(const String value, void* app_data)
+{
+	appendCheckpointLog((struct checkpointLog*) app_data, '=', &value);
+	return EXIP_OK;
+}
+
+/**
+ * Parses the stream into log. The input is read CHECKPOINT_BUFFER_SIZE bytes at
+ * a time unless mapped. Checkpoints are written to sideCar if not NULL;
+ * the parsing is resumed from checkpoint if not NULL.
+ */
+static errorCode parseWithCheckpoints(const char* strmData, size_t strmSize, boolean mapped, struct checkpointLog* sideCar,
+										const char* checkpoint, Index checkpointSize, struct checkpointLog* log)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Parser testParser;
+	char buf[CHECKPOINT_BUFFER_SIZE];
+	BinaryBuffer buffer;
+	struct checkpointInput input;
+	IOStream sideCarStrm;
+	Index byteOffset;
+	Index elementCount;
+
+	input.data = strmData;
+	input.size = strmSize;
+	input.pos = 0;
+	log->len = 0;
+
+	if(mapped)
+	{
+		TRY(initParserMapped(&testParser, strmData, strmSize, log));
+	}
+	else
+	{
+		buffer.buf = buf;
+		buffer.bufLen = CHECKPOINT_BUFFER_SIZE;
+		buffer.bufContent = 0;
+		buffer.ioStrm.readWriteToStream = readCheckpointInput;
+		buffer.ioStrm.stream = &input;
+		TRY(initParser(&testParser, buffer, log));
+	}
+	testParser.handler.startElement = checkpoint_startElement;
+	testParser.handler.endElement = checkpoint_endElement;
+	testParser.handler.attribute = checkpoint_attribute;
+	testParser.handler.stringData = checkpoint_stringData;
+
+	TRY_CATCH(parseHeader(&testParser, FALSE), destroyParser(&testParser));
+	TRY_CATCH(setSchema(&testParser, NULL), destroyParser(&testParser));
+
+	if(sideCar != NULL)
+	{
+		sideCar->len = 0;
+		sideCarStrm.readWriteToStream = writeCheckpointLog;
+		sideCarStrm.stream = sideCar;
+		TRY_CATCH(enableCheckpoints(&testParser, 100, 7, sideCarStrm), destroyParser(&testParser));
+	}
+
+	if(checkpoint != NULL)
+	{
+		// Continue the input from the byte of the checkpoint
+		TRY_CATCH(getCheckpointPosition(checkpoint, checkpointSize, &byteOffset, &elementCount), destroyParser(&testParser));
+		input.pos = byteOffset;
+		TRY_CATCH(restoreCheckpoint(&testParser, checkpoint, checkpointSize), destroyParser(&testParser));
+	}
+
+	while(tmp_err_code == EXIP_OK)
+	{
+		tmp_err_code = parseNext(&testParser);
+	}
+
+	destroyParser(&testParser);
+	return tmp_err_code;
+}
+
+/**
+ * Checkpoints: the parsing resumed from each checkpoint gives the
+ * events that follow it in the whole stream, with the input mapped
+ * or read from the offset of the checkpoint.
+ */
+START_TEST (test_checkpoints)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char strmData[COMPRESSION_STRM_SIZE];
+	struct compressionAppData appD;
+	Index strmSize;
+	static struct checkpointLog sideCar;
+	static struct checkpointLog fullLog;
+	static struct checkpointLog log;
+	const unsigned char* record;
+	Index recordSize;
+	Index pos = 0;
+	Index byteOffset;
+	Index elementCount;
+	Index prevOffset = 0;
+	Index elements;
+	unsigned int checkpointCount = 0;
+	size_t i;
+	int mapped;
+
+	tmp_err_code = compressionRoundTrip(BIT_PACKED, 1000000, 60, strmData, &strmSize, &appD, NULL);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "encoding returns an error code %d", tmp_err_code);
+
+	tmp_err_code = parseWithCheckpoints(strmData, strmSize, FALSE, &sideCar, NULL, 0, &fullLog);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "parsing with checkpoints returns an error code %d", tmp_err_code);
+
+	while(pos + 4 <= sideCar.len)
+	{
+		record = (const unsigned char*) sideCar.text + pos;
+		recordSize = ((Index) record[0] << 24) | ((Index) record[1] << 16) | ((Index) record[2] << 8) | record[3];
+		fail_unless (pos + 4 + recordSize <= sideCar.len, "checkpoint %u is truncated", checkpointCount);
+
+		tmp_err_code = getCheckpointPosition((const char*) record + 4, recordSize, &byteOffset, &elementCount);
+		fail_unless (tmp_err_code == EXIP_OK, "getCheckpointPosition returns an error code %d", tmp_err_code);
+		fail_unless (byteOffset > prevOffset && byteOffset < strmSize, "checkpoint %u is at byte %u", checkpointCount, (unsigned int) byteOffset);
+		prevOffset = byteOffset;
+
+		for(mapped = 0; mapped < 2; mapped++)
+		{
+			tmp_err_code = parseWithCheckpoints(strmData, strmSize, mapped, NULL, (const char*) record + 4, recordSize, &log);
+			fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "parsing from checkpoint %u returns an error code %d", checkpointCount, tmp_err_code);
+			fail_unless (log.len <= fullLog.len && memcmp(fullLog.text + fullLog.len - log.len, log.text, log.len) == 0,
+						"the events after checkpoint %u differ", checkpointCount);
+		}
+
+		elements = 0;
+		for(i = 0; i < fullLog.len - log.len; i++)
+		{
+			if(fullLog.text[i] == '<')
+				elements++;
+		}
+		fail_unless (elements == elementCount, "checkpoint %u is after %u elements instead of %u",
+					checkpointCount, (unsigned int) elements, (unsigned int) elementCount);
+
+		pos += 4 + recordSize;
+		checkpointCount++;
+	}
+
+	fail_unless (pos == sideCar.len, "the side-car ends with a partial checkpoint");
+	fail_unless (checkpointCount >= 5, "only %u checkpoints are written", checkpointCount);
+}
+END_TEST
+
+#define SC_RECORDS 24
+#define SC_RECORDS_STRM_SIZE 4096
+#define SC_ELEMENT_LOG_SIZE 64
+
+/**
+ * Encodes <root> with recCount self-contained <rec id="r(i%3)"><x>v(i)</x><x>w</x></rec>
+ * each followed by <item>i</item>
+ */
+static errorCode encodeSelfContainedRecords(int recCount, char* strmData, Index* strmSize)
+{
+	const String NS_EMPTY = {NULL, 0};
+	const String ELEM_ROOT = {"root", 4};
+	const String ELEM_ITEM = {"item", 4};
+	const String ELEM_REC = {"rec", 3};
+	const String ELEM_X = {"x", 1};
+	const String ATTR_ID = {"id", 2};
+	const String VALUE_W = {"w", 1};
+	errorCode tmp_err_code = EXIP_OK;
+	EXIStream testStrm;
+	QName qname = {&NS_EMPTY, &ELEM_ROOT, NULL};
+	BinaryBuffer buffer;
+	EXITypeClass valueType;
+	char valueBuf[16];
+	String value;
+	int i;
+
+	buffer.buf = strmData;
+	buffer.bufLen = SC_RECORDS_STRM_SIZE;
+	buffer.bufContent = 0;
+	buffer.ioStrm.readWriteToStream = NULL;
+	buffer.ioStrm.stream = NULL;
+
+	serialize.initHeader(&testStrm);
+	testStrm.header.has_options = TRUE;
+	SET_SELF_CONTAINED(testStrm.header.opts.enumOpt);
+	TRY(serialize.initStream(&testStrm, buffer, NULL));
+	tmp_err_code += serialize.exiHeader(&testStrm);
+	tmp_err_code += serialize.startDocument(&testStrm);
+	tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <root>
+	value.str = valueBuf;
+	for(i = 0; i < recCount; i++)
+	{
+		qname.localName = &ELEM_REC;
+		tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <rec>
+		tmp_err_code += serialize.selfContained(&testStrm);
+		qname.localName = &ATTR_ID;
+		tmp_err_code += serialize.attribute(&testStrm, qname, TRUE, &valueType); // id="r(i%3)"
+		value.length = sprintf(valueBuf, "r%d", i % 3);
+		tmp_err_code += serialize.stringData(&testStrm, value);
+		qname.localName = &ELEM_X;
+		tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <x>
+		value.length = sprintf(valueBuf, "v%d", i);
+		tmp_err_code += serialize.stringData(&testStrm, value);
+		tmp_err_code += serialize.endElement(&testStrm); // </x>
+		tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <x>
+		tmp_err_code += serialize.stringData(&testStrm, VALUE_W);
+		tmp_err_code += serialize.endElement(&testStrm); // </x>
+		tmp_err_code += serialize.endElement(&testStrm); // </rec>
+
+		qname.localName = &ELEM_ITEM;
+		tmp_err_code += serialize.startElement(&testStrm, qname, &valueType); // <item>
+		value.length = sprintf(valueBuf, "%d", i);
+		tmp_err_code += serialize.stringData(&testStrm, value);
+		tmp_err_code += serialize.endElement(&testStrm); // </item>
+	}
+	tmp_err_code += serialize.endElement(&testStrm); // </root>
+	tmp_err_code += serialize.endDocument(&testStrm);
+	*strmSize = testStrm.context.bufferIndx + 1;
+	if(tmp_err_code != EXIP_OK)
+	{
+		serialize.closeEXIStream(&testStrm);
+		return tmp_err_code;
+	}
+
+	return serialize.closeEXIStream(&testStrm);
+}
+
+/** The events of the element i of encodeSelfContainedRecords() as parsed into a checkpointLog */
+static int printRecordLog(char* buf, int i)
+{
+	return sprintf(buf, "<rec@id=r%d<x=v%d><x=w>>", i % 3, i);
+}
+
+/** The parsed events and the offsets of the self-contained elements */
+struct scParseLog
+{
+	struct checkpointLog log;
+	Parser* parser;
+	Index offsets[SC_RECORDS];
+	unsigned int offsetCount;
+};
+
+static errorCode sc_selfContained(void* app_data)
+{
+	struct scParseLog* scLog = (struct scParseLog*) app_data;
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+
+	if(scLog->offsetCount == SC_RECORDS)
+		return EXIP_OUT_OF_BOUND_BUFFER;
+	TRY(getSelfContainedOffset(scLog->parser, &scLog->offsets[scLog->offsetCount]));
+	scLog->offsetCount++;
+	appendCheckpointLog(&scLog->log, '!', NULL);
+
+	return EXIP_OK;
+}
+
+/**
+ * Parses the stream into scLog. The input is read CHECKPOINT_BUFFER_SIZE
+ * bytes at a time unless mapped. The parsing starts at the self-contained
+ * element at seekOffset unless it is INDEX_MAX.
+ */
+static errorCode parseSelfContainedLog(const char* strmData, Index strmSize, boolean mapped, Index seekOffset, struct scParseLog* scLog)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	Parser testParser;
+	char buf[CHECKPOINT_BUFFER_SIZE];
+	BinaryBuffer buffer;
+	struct checkpointInput input;
+
+	input.data = strmData;
+	input.size = strmSize;
+	input.pos = 0;
+	scLog->log.len = 0;
+	scLog->parser = &testParser;
+	scLog->offsetCount = 0;
+
+	if(mapped)
+	{
+		TRY(initParserMapped(&testParser, strmData, strmSize, scLog));
+	}
+	else
+	{
+		buffer.buf = buf;
+		buffer.bufLen = CHECKPOINT_BUFFER_SIZE;
+		buffer.bufContent = 0;
+		buffer.ioStrm.readWriteToStream = readCheckpointInput;
+		buffer.ioStrm.stream = &input;
+		TRY(initParser(&testParser, buffer, scLog));
+	}
+	testParser.handler.startElement = checkpoint_startElement;
+	testParser.handler.endElement = checkpoint_endElement;
+	testParser.handler.attribute = checkpoint_attribute;
+	testParser.handler.stringData = checkpoint_stringData;
+	testParser.handler.selfContained = sc_selfContained;
+
+	TRY_CATCH(parseHeader(&testParser, FALSE), destroyParser(&testParser));
+	TRY_CATCH(setSchema(&testParser, NULL), destroyParser(&testParser));
+
+	if(seekOffset != INDEX_MAX)
+	{
+		// Continue the input from the byte of the element
+		input.pos = seekOffset;
+		TRY_CATCH(seekSelfContained(&testParser, seekOffset), destroyParser(&testParser));
+	}
+
+	while(tmp_err_code == EXIP_OK)
+	{
+		tmp_err_code = parseNext(&testParser);
+	}
+
+	destroyParser(&testParser);
+	return tmp_err_code;
+}
+
+/**
+ * Self-contained elements are parsed with the string tables reset for their
+ * content and restored after them, and each one can be parsed on its own
+ * from the offset of its content.
+ */
+START_TEST (test_self_contained_parsing)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char strmData[SC_RECORDS_STRM_SIZE];
+	Index strmSize;
+	static struct scParseLog scLog;
+	static char expected[CHECKPOINT_LOG_SIZE];
+	char element[SC_ELEMENT_LOG_SIZE];
+	Index offsets[SC_RECORDS];
+	int len = 0;
+	int i;
+	int elementLen;
+	int mapped;
+
+	tmp_err_code = encodeSelfContainedRecords(SC_RECORDS, strmData, &strmSize);
+	fail_unless (tmp_err_code == EXIP_OK, "encoding returns an error code %d", tmp_err_code);
+
+	len += sprintf(expected + len, "<root");
+	for(i = 0; i < SC_RECORDS; i++)
+	{
+		len += sprintf(expected + len, "<rec!@id=r%d<x=v%d><x=w>><item=%d>", i % 3, i, i);
+	}
+	len += sprintf(expected + len, ">");
+
+	for(mapped = 0; mapped < 2; mapped++)
+	{
+		tmp_err_code = parseSelfContainedLog(strmData, strmSize, mapped, INDEX_MAX, &scLog);
+		fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "parsing returns an error code %d", tmp_err_code);
+		fail_unless (scLog.log.len == (size_t) len && memcmp(scLog.log.text, expected, len) == 0,
+					"unexpected events: %.*s", (int) scLog.log.len, scLog.log.text);
+		fail_unless (scLog.offsetCount == SC_RECORDS, "%u self-contained elements", scLog.offsetCount);
+	}
+	memcpy(offsets, scLog.offsets, sizeof(offsets));
+
+	for(i = 0; i < SC_RECORDS; i++)
+	{
+		fail_unless (i == 0 || offsets[i] > offsets[i - 1], "offset %d is not after the previous one", i);
+		elementLen = printRecordLog(element, i);
+		for(mapped = 0; mapped < 2; mapped++)
+		{
+			tmp_err_code = parseSelfContainedLog(strmData, strmSize, mapped, offsets[i], &scLog);
+			fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "parsing element %d returns an error code %d", i, tmp_err_code);
+			fail_unless (scLog.log.len == (size_t) elementLen && memcmp(scLog.log.text, element, elementLen) == 0,
+						"unexpected events of element %d: %.*s", i, (int) scLog.log.len, scLog.log.text);
+		}
+	}
+}
+END_TEST
+
+#if EXIP_PARALLEL_SC == ON
+
+/**
+ * The self-contained elements parsed by worker threads: passed to the
+ * handler in the order of offsets or one element at a time as completed.
+ */
+START_TEST (test_parallel_self_contained)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char strmData[SC_RECORDS_STRM_SIZE];
+	Index strmSize;
+	static struct scParseLog scLog;
+	static struct checkpointLog ordered;
+	static struct checkpointLog unordered[SC_RECORDS];
+	static char expected[CHECKPOINT_LOG_SIZE];
+	char element[SC_ELEMENT_LOG_SIZE];
+	void* app_data[SC_RECORDS];
+	ContentHandler handler;
+	unsigned int threads;
+	int len;
+	int elementLen;
+	int i;
+
+	tmp_err_code = encodeSelfContainedRecords(SC_RECORDS, strmData, &strmSize);
+	fail_unless (tmp_err_code == EXIP_OK, "encoding returns an error code %d", tmp_err_code);
+	tmp_err_code = parseSelfContainedLog(strmData, strmSize, TRUE, INDEX_MAX, &scLog);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "parsing returns an error code %d", tmp_err_code);
+
+	len = 0;
+	for(i = 0; i < SC_RECORDS; i++)
+		len += printRecordLog(expected + len, i);
+
+	initContentHandler(&handler);
+	handler.startElement = checkpoint_startElement;
+	handler.endElement = checkpoint_endElement;
+	handler.attribute = checkpoint_attribute;
+	handler.stringData = checkpoint_stringData;
+
+	for(threads = 1; threads <= 4; threads += 3)
+	{
+		ordered.len = 0;
+		for(i = 0; i < SC_RECORDS; i++)
+			app_data[i] = &ordered;
+		tmp_err_code = parseSelfContainedParallel(strmData, strmSize, scLog.offsets, SC_RECORDS, threads, TRUE, &handler, app_data);
+		fail_unless (tmp_err_code == EXIP_OK, "ordered parsing with %u threads returns an error code %d", threads, tmp_err_code);
+		fail_unless (ordered.len == (size_t) len && memcmp(ordered.text, expected, len) == 0,
+					"unexpected events with %u threads: %.*s", threads, (int) ordered.len, ordered.text);
+
+		for(i = 0; i < SC_RECORDS; i++)
+		{
+			unordered[i].len = 0;
+			app_data[i] = &unordered[i];
+		}
+		tmp_err_code = parseSelfContainedParallel(strmData, strmSize, scLog.offsets, SC_RECORDS, threads, FALSE, &handler, app_data);
+		fail_unless (tmp_err_code == EXIP_OK, "unordered parsing with %u threads returns an error code %d", threads, tmp_err_code);
+		for(i = 0; i < SC_RECORDS; i++)
+		{
+			elementLen = printRecordLog(element, i);
+			fail_unless (unordered[i].len == (size_t) elementLen && memcmp(unordered[i].text, element, elementLen) == 0,
+						"unexpected events of element %d with %u threads", i, threads);
+		}
+	}
+
+	// An offset that is not of a self-contained element
+	scLog.offsets[SC_RECORDS - 1] = strmSize + 1;
+	tmp_err_code = parseSelfContainedParallel(strmData, strmSize, scLog.offsets, SC_RECORDS, 2, TRUE, &handler, app_data);
+	fail_unless (tmp_err_code != EXIP_OK, "an invalid offset is accepted");
+
+	// A stream with schema-informed grammars
+	{
+		char* schemafname[1] = {"exip/schema_demo.exi"};
+		EXIPSchema schema;
+		EXIStream testStrm;
+		BinaryBuffer buffer;
+
+		parseSchema(schemafname, 1, &schema);
+		buffer.buf = strmData;
+		buffer.bufLen = SC_RECORDS_STRM_SIZE;
+		buffer.bufContent = 0;
+		buffer.ioStrm.readWriteToStream = NULL;
+		buffer.ioStrm.stream = NULL;
+
+		serialize.initHeader(&testStrm);
+		testStrm.header.has_options = TRUE;
+		SET_SELF_CONTAINED(testStrm.header.opts.enumOpt);
+		testStrm.header.opts.schemaIDMode = SCHEMA_ID_SET;
+		asciiToString("schema_demo", &testStrm.header.opts.schemaID, NULL, FALSE);
+		tmp_err_code = serialize.initStream(&testStrm, buffer, &schema);
+		fail_unless (tmp_err_code == EXIP_OK, "initStream returns an error code %d", tmp_err_code);
+		tmp_err_code = serialize.exiHeader(&testStrm);
+		fail_unless (tmp_err_code == EXIP_OK, "exiHeader returns an error code %d", tmp_err_code);
+		strmSize = testStrm.context.bufferIndx + 1;
+		serialize.closeEXIStream(&testStrm);
+
+		scLog.offsets[0] = strmSize;
+		tmp_err_code = parseSelfContainedParallel(strmData, strmSize, scLog.offsets, 1, 2, TRUE, &handler, NULL);
+		fail_unless (tmp_err_code == EXIP_NOT_IMPLEMENTED_YET, "a schema-informed stream returns an error code %d", tmp_err_code);
+		destroySchema(&schema);
+	}
+}
+END_TEST
+
+/** The rounds of test_parallel_self_contained_threads */
+#define SC_PARALLEL_ROUNDS 8
+
+/**
+ * More workers than elements ahead of the handler, for several rounds:
+ * the workers must not write to anything they share (run it with
+ * -fsanitize=thread to check).
+ */
+START_TEST (test_parallel_self_contained_threads)
+{
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	char strmData[SC_RECORDS_STRM_SIZE];
+	Index strmSize;
+	static struct scParseLog scLog;
+	static struct checkpointLog ordered;
+	static char expected[CHECKPOINT_LOG_SIZE];
+	void* app_data[SC_RECORDS];
+	ContentHandler handler;
+	int round;
+	int len;
+	int i;
+
+	tmp_err_code = encodeSelfContainedRecords(SC_RECORDS, strmData, &strmSize);
+	fail_unless (tmp_err_code == EXIP_OK, "encoding returns an error code %d", tmp_err_code);
+	tmp_err_code = parseSelfContainedLog(strmData, strmSize, TRUE, INDEX_MAX, &scLog);
+	fail_unless (tmp_err_code == EXIP_PARSING_COMPLETE, "parsing returns an error code %d", tmp_err_code);
+
+	len = 0;
+	for(i = 0; i < SC_RECORDS; i++)
+		len += printRecordLog(expected + len, i);
+
+	initContentHandler(&handler);
+	handler.startElement = checkpoint_startElement;
+	handler.endElement = checkpoint_endElement;
+	handler.attribute = checkpoint_attribute;
+	handler.stringData = checkpoint_stringData;
+	for(i = 0; i < SC_RECORDS; i++)
+		app_data[i] = &ordered;
+
+	for(round = 0; round < SC_PARALLEL_ROUNDS; round++)
+	{
+		ordered.len = 0;
+		tmp_err_code = parseSelfContainedParallel(strmData, strmSize, scLog.offsets, SC_RECORDS, 8, TRUE, &handler, app_data);
+		fail_unless (tmp_err_code == EXIP_OK, "round %d returns an error code %d", round, tmp_err_code);
+		fail_unless (ordered.len == (size_t) len && memcmp(ordered.text, expected, len) == 0,
+					"unexpected events in round %d: %.*s", round, (int) ordered.len, ordered.text);
+	}
+}
+END_TEST
+
+#endif /* EXIP_PARALLEL_SC == ON */
+
 /* END: SchemaLess tests */
 
 #define OUTPUT_BUFFER_SIZE_LARGE_DOC 20000
@@ -1377,6 +3134,32 @@ Suite* exip_suite(void)
 		tcase_add_test (tc_SchLess, test_value_part_zero);
 		tcase_add_test (tc_SchLess, test_recursive_defs);
 		tcase_add_test (tc_SchLess, test_built_in_dynamic_types);
+		tcase_add_test (tc_SchLess, test_mapped_input);
+#if EXIP_ASYNC_OUTPUT == ON
+		tcase_add_test (tc_SchLess, test_async_output);
+		tcase_add_test (tc_SchLess, test_spsc_queue);
+#endif
+#if EXIP_READ_AHEAD == ON
+		tcase_add_test (tc_SchLess, test_read_ahead);
+#endif
+		tcase_add_test (tc_SchLess, test_pre_compression);
+		tcase_add_test (tc_SchLess, test_allocator);
+		tcase_add_test (tc_SchLess, test_memory_region);
+		tcase_add_test (tc_SchLess, test_memory_region_growth);
+		tcase_add_test (tc_SchLess, test_memory_region_release);
+#if EXIP_COMPRESSION == ON
+		tcase_add_test (tc_SchLess, test_compression);
+#endif
+#if EXIP_PIPELINE == ON
+		tcase_add_test (tc_SchLess, test_pipeline);
+#endif
+		tcase_add_test (tc_SchLess, test_self_contained);
+		tcase_add_test (tc_SchLess, test_checkpoints);
+		tcase_add_test (tc_SchLess, test_self_contained_parsing);
+#if EXIP_PARALLEL_SC == ON
+		tcase_add_test (tc_SchLess, test_parallel_self_contained);
+		tcase_add_test (tc_SchLess, test_parallel_self_contained_threads);
+#endif
 		suite_add_tcase (s, tc_SchLess);
 	}
 	{
@@ -32,7 +32,7 @@ START_TEST (test_createDocGrammar)
 	buf[0] = (char) 0xD4; /* 0b11010100 */
 	buf[1] = (char) 0x60; /* 0b01100000 */
 
-	initAllocList(&schema.memList);
+	initAllocList(&schema.memList, NULL);
 
 	testStream.context.bitPointer = 0;
 	makeDefaultOpts(&testStream.header.opts);
@@ -42,7 +42,8 @@ START_TEST (test_createDocGrammar)
 	testStream.buffer.ioStrm.readWriteToStream = NULL;
 	testStream.buffer.ioStrm.stream = NULL;
 	testStream.context.bufferIndx = 0;
-	initAllocList(&testStream.memList);
+	testStream.allocator = NULL;
+	initAllocList(&testStream.memList, NULL);
 
 	err = createDocGrammar(&schema, NULL, 0);
 
@@ -61,19 +62,24 @@ START_TEST (test_processNextProduction)
 	EXIPSchema schema;
 	QNameID emptyQnameID = {URI_MAX, LN_MAX};
 
-	initAllocList(&strm.memList);
-	initAllocList(&schema.memList);
+	strm.gStack = NULL;
+	strm.gStackPool.freeNode = NULL;
+	strm.gStackPool.block = NULL;
+	strm.allocator = NULL;
+	initAllocList(&strm.memList, NULL);
+	initAllocList(&schema.memList, NULL);
 
 	err = createDocGrammar(&schema, NULL, 0);
 	fail_unless (err == EXIP_OK, "createDocGrammar returns an error code %d", err);
 
-	err = pushGrammar(&strm.gStack, emptyQnameID, &schema.docGrammar);
+	err = pushGrammar(&strm, emptyQnameID, &schema.docGrammar);
 	fail_unless (err == EXIP_OK, "pushGrammar returns an error code %d", err);
 
 	strm.gStack->currNonTermID = 4;
 	err = processNextProduction(&strm, &nonTermID_out, &handler, NULL);
 	fail_unless (err == EXIP_INCONSISTENT_PROC_STATE, "processNextProduction does not return the correct error code");
 
+	destroyGrammarStack(&strm);
 	freeAllocList(&strm.memList);
 	freeAllocList(&schema.memList);
 }
@@ -82,14 +88,17 @@ END_TEST
 START_TEST (test_pushGrammar)
 {
 	errorCode err = EXIP_UNEXPECTED_ERROR;
-	EXIGrammarStack* testGrStack = NULL;
 	EXIStream strm;
 	EXIGrammar testElementGrammar;
 	EXIGrammar testElementGrammar1;
 	QNameID emptyQnameID = {URI_MAX, LN_MAX};
 
 	makeDefaultOpts(&strm.header.opts);
-	initAllocList(&strm.memList);
+	strm.gStack = NULL;
+	strm.gStackPool.freeNode = NULL;
+	strm.gStackPool.block = NULL;
+	strm.allocator = NULL;
+	initAllocList(&strm.memList, NULL);
 
 #if BUILD_IN_GRAMMARS_USE
 	err = createBuiltInElementGrammar(&testElementGrammar1, &strm);
@@ -99,15 +108,16 @@ START_TEST (test_pushGrammar)
 	fail_if(err != EXIP_OK);
 #endif
 
-	err = pushGrammar(&testGrStack, emptyQnameID, &testElementGrammar1);
+	err = pushGrammar(&strm, emptyQnameID, &testElementGrammar1);
 	fail_unless (err == EXIP_OK, "pushGrammar returns error code %d", err);
-	fail_if(testGrStack->nextInStack != NULL);
+	fail_if(strm.gStack->nextInStack != NULL);
 
-	err = pushGrammar(&testGrStack, emptyQnameID, &testElementGrammar);
+	err = pushGrammar(&strm, emptyQnameID, &testElementGrammar);
 	fail_unless (err == EXIP_OK, "pushGrammar returns error code %d", err);
-	fail_if(testGrStack->nextInStack == NULL);
-	fail_if(testGrStack->nextInStack->grammar != &testElementGrammar1);
+	fail_if(strm.gStack->nextInStack == NULL);
+	fail_if(strm.gStack->nextInStack->grammar != &testElementGrammar1);
 
+	destroyGrammarStack(&strm);
 	freeAllocList(&strm.memList);
 }
 END_TEST
@@ -115,14 +125,18 @@ END_TEST
 START_TEST (test_popGrammar)
 {
 	errorCode err = EXIP_UNEXPECTED_ERROR;
-	EXIGrammarStack* testGrStack = NULL;
+	EXIGrammarStack* top;
 	EXIGrammar testElementGrammar1;
 	EXIStream strm;
 	EXIGrammar testElementGrammar;
 	QNameID emptyQnameID = {URI_MAX, LN_MAX};
 
 	makeDefaultOpts(&strm.header.opts);
-	initAllocList(&strm.memList);
+	strm.gStack = NULL;
+	strm.gStackPool.freeNode = NULL;
+	strm.gStackPool.block = NULL;
+	strm.allocator = NULL;
+	initAllocList(&strm.memList, NULL);
 
 #if BUILD_IN_GRAMMARS_USE
 	err = createBuiltInElementGrammar(&testElementGrammar1, &strm);
@@ -132,15 +146,78 @@ START_TEST (test_popGrammar)
 	fail_if(err != EXIP_OK);
 #endif
 
-	err = pushGrammar(&testGrStack, emptyQnameID, &testElementGrammar1);
+	err = pushGrammar(&strm, emptyQnameID, &testElementGrammar1);
 	fail_unless (err == EXIP_OK, "pushGrammar returns error code %d", err);
 
-	err = pushGrammar(&testGrStack, emptyQnameID, &testElementGrammar);
+	err = pushGrammar(&strm, emptyQnameID, &testElementGrammar);
 	fail_unless (err == EXIP_OK, "pushGrammar returns error code %d", err);
-	fail_if(testGrStack->nextInStack == NULL);
+	fail_if(strm.gStack->nextInStack == NULL);
+	top = strm.gStack;
 
-	popGrammar(&testGrStack);
-	fail_if(testGrStack->nextInStack != NULL);
+	popGrammar(&strm);
+	fail_if(strm.gStack->nextInStack != NULL);
+	fail_if(strm.gStack->grammar != &testElementGrammar1);
+
+	// The popped node is the next one to be pushed
+	err = pushGrammar(&strm, emptyQnameID, &testElementGrammar);
+	fail_unless (err == EXIP_OK, "pushGrammar returns error code %d", err);
+	fail_unless(strm.gStack == top, "The popped node of the grammar stack is not reused");
+
+	destroyGrammarStack(&strm);
+	fail_if(strm.gStack != NULL);
+	freeAllocList(&strm.memList);
+}
+END_TEST
+
+START_TEST (test_grammarStackPool)
+{
+	errorCode err = EXIP_UNEXPECTED_ERROR;
+	EXIStream strm;
+	EXIGrammar testElementGrammar;
+	EXIGrammarStack* node;
+	QNameID emptyQnameID = {URI_MAX, LN_MAX};
+	Index depth = 3*GRAMMAR_STACK_DEPTH;
+	Index i;
+
+	strm.allocator = NULL;
+	strm.gStack = NULL;
+	strm.gStackPool.freeNode = NULL;
+	strm.gStackPool.block = NULL;
+
+	for(i = 0; i < depth; i++)
+	{
+		err = pushGrammar(&strm, emptyQnameID, &testElementGrammar);
+		fail_unless (err == EXIP_OK, "pushGrammar returns error code %d", err);
+	}
+
+	// The first block is filled before the second one is allocated
+	fail_if(strm.gStackPool.block == NULL || strm.gStackPool.block->nextBlock == NULL);
+	fail_unless(strm.gStackPool.block->nextBlock->nextBlock == NULL, "Too many blocks of grammar stack nodes");
+	fail_unless(strm.gStackPool.block->count == 2*GRAMMAR_STACK_DEPTH, "The blocks of the grammar stack are not doubled");
+
+	// The nodes of an element and its parent are next to each other
+	node = strm.gStack;
+	for(i = 0; i < depth - 1; i++)
+	{
+		if(i != 2*GRAMMAR_STACK_DEPTH - 1)
+			fail_unless(node->nextInStack == node - 1, "The grammar stack nodes are not consecutive at depth %d", (int) i);
+		node = node->nextInStack;
+	}
+	fail_unless(node->nextInStack == NULL);
+
+	while(strm.gStack != NULL)
+		popGrammar(&strm);
+
+	// No new blocks when the stack grows again
+	for(i = 0; i < depth; i++)
+	{
+		err = pushGrammar(&strm, emptyQnameID, &testElementGrammar);
+		fail_unless (err == EXIP_OK, "pushGrammar returns error code %d", err);
+	}
+	fail_unless(strm.gStackPool.block->nextBlock->nextBlock == NULL, "The grammar stack nodes are not reused");
+
+	destroyGrammarStack(&strm);
+	fail_if(strm.gStack != NULL || strm.gStackPool.block != NULL || strm.gStackPool.freeNode != NULL);
 }
 END_TEST
 
@@ -152,7 +229,8 @@ START_TEST (test_createBuiltInElementGrammar)
 	EXIStream strm;
 
 	makeDefaultOpts(&strm.header.opts);
-	initAllocList(&strm.memList);
+	strm.allocator = NULL;
+	initAllocList(&strm.memList, NULL);
 
 	err = createBuiltInElementGrammar(&testElementGrammar, &strm);
 	fail_unless (err == EXIP_OK, "createBuildInElementGrammar returns error code %d", err);
@@ -183,7 +261,7 @@ START_TEST (test_insertZeroProduction)
 	rule.prodDim = 1;
 	rule.production = prod0Arr;
 
-	tmp_err_code = insertZeroProduction(&rule, EVENT_CH, 5, &qname, FALSE);
+	tmp_err_code = insertZeroProduction(&rule, EVENT_CH, 5, &qname, FALSE, NULL);
 	fail_unless (tmp_err_code == EXIP_OK, "insertZeroProduction returns an error code %d", tmp_err_code);
 	fail_unless (rule.pCount == 1);
 }
@@ -203,6 +281,7 @@ Suite * grammar_suite (void)
 	  tcase_add_test (tc_gGrammars, test_processNextProduction);
 	  tcase_add_test (tc_gGrammars, test_pushGrammar);
 	  tcase_add_test (tc_gGrammars, test_popGrammar);
+	  tcase_add_test (tc_gGrammars, test_grammarStackPool);
 #if BUILD_IN_GRAMMARS_USE
 	  tcase_add_test (tc_gGrammars, test_createBuiltInElementGrammar);
 #endif
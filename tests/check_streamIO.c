@@ -17,6 +17,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include "streamRead.h"
 #include "streamWrite.h"
@@ -45,9 +46,13 @@ START_TEST (test_readNextBit)
   testStream.buffer.bufLen = 2;
   testStream.buffer.bufContent = 2;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = readNextBit(&testStream, &bit_val);
 
@@ -100,9 +105,13 @@ START_TEST (test_readBits)
   testStream.buffer.bufLen = 2;
   testStream.buffer.bufContent = 2;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = readBits(&testStream, 4, &bits_val);
 
@@ -130,6 +139,62 @@ START_TEST (test_readBits)
 }
 END_TEST
 
+START_TEST (test_readBitsWindow)
+{
+  EXIStream testStream;
+  char buf[10] = {(char) 0xD4, (char) 0x60, (char) 0xFF, (char) 0x01, (char) 0x80,
+		  (char) 0x00, (char) 0xAA, (char) 0x55, (char) 0x0F, (char) 0xF0};
+  unsigned int bits_val = 0;
+  errorCode err = EXIP_UNEXPECTED_ERROR;
+
+  testStream.context.bitPointer = 0;
+  testStream.buffer.buf = buf;
+  testStream.buffer.bufLen = 10;
+  testStream.buffer.bufContent = 10;
+  testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
+  testStream.buffer.ioStrm.stream = NULL;
+  testStream.context.bufferIndx = 0;
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
+
+  err = readBits(&testStream, 4, &bits_val);
+
+  fail_unless (err == EXIP_OK && bits_val == 0xD,
+	       "The bits 1101 from the stream are read as %d", bits_val);
+
+  // 32 bits starting at bit offset 4 of the first byte
+  err = readBits(&testStream, 32, &bits_val);
+
+  fail_unless (err == EXIP_OK && bits_val == 0x460FF018,
+	       "32 bits read at offset 4 are read as 0x%X", bits_val);
+  fail_unless (testStream.context.bitPointer == 4 && testStream.context.bufferIndx == 4,
+	       "The readBits function did not move the bit Pointer of the stream correctly");
+
+  // Last position served by the 64-bit window
+  testStream.context.bufferIndx = 2;
+  testStream.context.bitPointer = 3;
+  err = readBits(&testStream, 30, &bits_val);
+
+  fail_unless (err == EXIP_OK && bits_val == 0x3E030001,
+	       "30 bits read at 2:3 are read as 0x%X", bits_val);
+  fail_unless (testStream.context.bitPointer == 1 && testStream.context.bufferIndx == 6,
+	       "The readBits function did not move the bit Pointer of the stream correctly");
+
+  // Fewer than 8 bytes left: the byte-wise path is used
+  testStream.context.bufferIndx = 5;
+  testStream.context.bitPointer = 3;
+  err = readBits(&testStream, 30, &bits_val);
+
+  fail_unless (err == EXIP_OK && bits_val == 0x154AA1F,
+	       "30 bits read at 5:3 are read as 0x%X", bits_val);
+  fail_unless (testStream.context.bitPointer == 1 && testStream.context.bufferIndx == 9,
+	       "The readBits function did not move the bit Pointer of the stream correctly");
+}
+END_TEST
+
 /* END: streamRead tests */
 
 /* BEGIN: streamWrite tests */
@@ -148,9 +213,13 @@ START_TEST (test_writeNextBit)
   testStream.buffer.bufLen = 2;
   testStream.buffer.bufContent = 2;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+  testStream.asyncOutput = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = writeNextBit(&testStream, 1);
 
@@ -199,10 +268,14 @@ START_TEST (test_writeNBits)
   testStream.buffer.buf = buf;
   testStream.buffer.bufLen = 2;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+  testStream.asyncOutput = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.buffer.bufContent = 2;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = writeNBits(&testStream, 7, 19);
 
@@ -236,6 +309,54 @@ START_TEST (test_writeNBits)
 }
 END_TEST
 
+START_TEST (test_writeNBitsWindow)
+{
+  EXIStream testStream;
+  char buf[12];
+  unsigned int bits_val = 0;
+  errorCode err = EXIP_UNEXPECTED_ERROR;
+
+  memset(buf, 0xFF, 12);
+  testStream.context.bitPointer = 0;
+  testStream.buffer.buf = buf;
+  testStream.buffer.bufLen = 12;
+  testStream.buffer.bufContent = 12;
+  testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+  testStream.asyncOutput = NULL;
+#endif
+  testStream.buffer.ioStrm.stream = NULL;
+  testStream.context.bufferIndx = 0;
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
+
+  err = writeNBits(&testStream, 4, 5);
+  fail_unless (err == EXIP_OK, "writeNBits returns error code %d", err);
+
+  // Only the lowest nbits of the value must be written
+  err = writeNBits(&testStream, 32, 0x12345678);
+  fail_unless (err == EXIP_OK, "writeNBits returns error code %d", err);
+  fail_unless (testStream.context.bitPointer == 4 && testStream.context.bufferIndx == 4,
+	       "The writeNBits function did not move the bit Pointer of the stream correctly");
+
+  err = writeNBits(&testStream, 3, 0xFFFFFFFA);
+  fail_unless (err == EXIP_OK, "writeNBits returns error code %d", err);
+
+  fail_unless ((unsigned char) buf[0] == 0x51 && (unsigned char) buf[1] == 0x23 &&
+		  (unsigned char) buf[2] == 0x45 && (unsigned char) buf[3] == 0x67 &&
+		  (unsigned char) buf[4] == 0x84, "writeNBits function doesn't write correctly");
+
+  testStream.context.bufferIndx = 0;
+  testStream.context.bitPointer = 0;
+  err = readBits(&testStream, 4, &bits_val);
+  fail_unless (err == EXIP_OK && bits_val == 5, "Read back 0x%X instead of 0x5", bits_val);
+  err = readBits(&testStream, 32, &bits_val);
+  fail_unless (err == EXIP_OK && bits_val == 0x12345678, "Read back 0x%X instead of 0x12345678", bits_val);
+  err = readBits(&testStream, 3, &bits_val);
+  fail_unless (err == EXIP_OK && bits_val == 2, "Read back 0x%X instead of 0x2", bits_val);
+}
+END_TEST
+
 /* END: streamWrite tests */
 
 /* BEGIN: streamDecode tests */
@@ -257,9 +378,13 @@ START_TEST (test_decodeNBitUnsignedInteger)
   testStream.buffer.bufLen = 2;
   testStream.buffer.bufContent = 2;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = decodeNBitUnsignedInteger(&testStream, 6, &bit_val);
 
@@ -289,9 +414,13 @@ START_TEST (test_decodeBoolean)
   testStream.buffer.bufLen = 2;
   testStream.buffer.bufContent = 2;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = decodeBoolean(&testStream, &bit_val);
 
@@ -321,9 +450,13 @@ START_TEST (test_decodeUnsignedInteger)
   testStream.buffer.bufLen = 3;
   testStream.buffer.bufContent = 3;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = decodeUnsignedInteger(&testStream, &bit_val);
 
@@ -349,6 +482,7 @@ START_TEST (test_decodeString)
   errorCode err = EXIP_UNEXPECTED_ERROR;
 
   testStream.context.bitPointer = 0;
+  testStream.bufferMapped = FALSE;
   makeDefaultOpts(&testStream.header.opts);
 
   buf[0] = (char) 0x02; /* 0b00000010 */
@@ -359,9 +493,13 @@ START_TEST (test_decodeString)
   testStream.buffer.bufLen = 4;
   testStream.buffer.bufContent = 4;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
   bit_val.length = 0;
   bit_val.str = cht;
 
@@ -415,8 +553,12 @@ START_TEST (test_decodeBinary)
   testStream.buffer.bufLen = 20;
   testStream.buffer.bufContent = 20;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
   for(i=0;i<20;i++) testbuf[i]=buf[i];
 
   testStream.context.bufferIndx = 0;
@@ -474,6 +616,77 @@ START_TEST (test_decodeBinary)
 }
 END_TEST
 
+START_TEST (test_decodeBinaryShifted)
+{
+  EXIStream testStream;
+  char buf[64];
+  char* res;
+  Index bytes = 0;
+  errorCode err = EXIP_UNEXPECTED_ERROR;
+  unsigned int bits_val;
+  int i;
+
+  makeDefaultOpts(&testStream.header.opts);
+  memset(buf, 0, 64);
+  testStream.buffer.buf = buf;
+  testStream.buffer.bufLen = 64;
+  testStream.buffer.bufContent = 64;
+  testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
+  testStream.buffer.ioStrm.stream = NULL;
+  testStream.context.bufferIndx = 0;
+  testStream.context.bitPointer = 0;
+  testStream.scratch.buf = NULL;
+  testStream.scratch.bufLen = 0;
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
+
+  // Two binary values of 21 octets: byte-aligned and shifted with 3 bits
+  for(i = 0; i < 2; i++)
+  {
+    int j;
+    if(i == 1)
+    {
+      err = writeNBits(&testStream, 3, 5);
+      fail_unless (err == EXIP_OK, "writeNBits returns error code %d", err);
+    }
+    err = encodeUnsignedInteger(&testStream, 21);
+    fail_unless (err == EXIP_OK, "encodeUnsignedInteger returns error code %d", err);
+    for(j = 0; j < 21; j++)
+    {
+      err = writeNBits(&testStream, 8, (unsigned int) (0xF0 ^ (j * 37)) & 0xFF);
+      fail_unless (err == EXIP_OK, "writeNBits returns error code %d", err);
+    }
+  }
+
+  testStream.context.bufferIndx = 0;
+  testStream.context.bitPointer = 0;
+
+  err = decodeBinary(&testStream, &res, &bytes);
+  fail_unless (err == EXIP_OK, "decodeBinary returns error code %d", err);
+  fail_unless (bytes == 21, "The length of the binary content is read as %d (actual : %d)", bytes, 21);
+  fail_unless (res == buf + 1, "The byte-aligned binary content is not referenced in the buffer");
+  fail_unless (testStream.scratch.buf == NULL, "The byte-aligned binary content is copied");
+
+  err = readBits(&testStream, 3, &bits_val);
+  fail_unless (err == EXIP_OK && bits_val == 5, "readBits returns error code %d", err);
+
+  err = decodeBinary(&testStream, &res, &bytes);
+  fail_unless (err == EXIP_OK, "decodeBinary returns error code %d", err);
+  fail_unless (bytes == 21, "The length of the binary content is read as %d (actual : %d)", bytes, 21);
+  fail_unless (res == testStream.scratch.buf, "The shifted binary content is not copied in the scratch buffer");
+  for(i = 0; i < 21; i++)
+    fail_unless ((unsigned char) res[i] == ((0xF0 ^ (i * 37)) & 0xFF), "The shifted binary content is read wrongly at %d", i);
+  fail_unless (testStream.context.bitPointer == 3 && testStream.context.bufferIndx == 44,
+	       "The decodeBinary function did not move the bit Pointer of the stream correctly");
+
+  freeAllocList(&testStream.memList);
+  EXIP_MFREE(testStream.scratch.buf);
+}
+END_TEST
+
 START_TEST (test_decodeFloat)
 {
 	EXIStream testStream;
@@ -494,10 +707,14 @@ START_TEST (test_decodeFloat)
 	testStream.buffer.bufLen = 3;
 	testStream.buffer.bufContent = 3;
 	testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+	testStream.readAhead = NULL;
+#endif
 	testStream.buffer.ioStrm.stream = NULL;
 	testStream.context.bufferIndx = 0;
 	testStream.context.bitPointer = 0;
-	initAllocList(&testStream.memList);
+	testStream.allocator = NULL;
+	initAllocList(&testStream.memList, NULL);
 
 	err = decodeFloatValue(&testStream, &fl_val);
 
@@ -544,9 +761,13 @@ START_TEST (test_decodeIntegerValue)
   testStream.buffer.bufLen = 3;
   testStream.buffer.bufContent = 3;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = decodeIntegerValue(&testStream, &bit_val);
 
@@ -600,10 +821,14 @@ START_TEST (test_decodeDecimalValue)
 	testStream.buffer.bufLen = 3;
 	testStream.buffer.bufContent = 3;
 	testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+	testStream.readAhead = NULL;
+#endif
 	testStream.buffer.ioStrm.stream = NULL;
 	testStream.context.bufferIndx = 0;
 	testStream.context.bitPointer = 0;
-	initAllocList(&testStream.memList);
+	testStream.allocator = NULL;
+	initAllocList(&testStream.memList, NULL);
 
 	err = decodeDecimalValue(&testStream, &dec_val);
 
@@ -640,7 +865,8 @@ START_TEST (test_encodeNBitUnsignedInteger)
   testStream.buffer.ioStrm.readWriteToStream = NULL;
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = encodeNBitUnsignedInteger(&testStream, 9, 412);
 
@@ -675,7 +901,8 @@ START_TEST (test_encodeBoolean)
   testStream.buffer.ioStrm.readWriteToStream = NULL;
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = encodeBoolean(&testStream, 1);
 
@@ -720,7 +947,8 @@ START_TEST (test_encodeUnsignedInteger)
   testStream.buffer.ioStrm.readWriteToStream = NULL;
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
 
   err = encodeUnsignedInteger(&testStream, 421);
 
@@ -761,6 +989,66 @@ START_TEST (test_encodeUnsignedInteger)
 END_TEST
 
 
+START_TEST (test_unsignedIntegerRoundTrip)
+{
+  EXIStream testStream;
+  char buf[64];
+  UnsignedInteger values[6] = {0, 127, 128, 16384, 0x123456789ULL, 0x8000000000000005ULL};
+  UnsignedInteger int_val = 0;
+  errorCode err = EXIP_UNEXPECTED_ERROR;
+  unsigned int i;
+
+  makeDefaultOpts(&testStream.header.opts);
+  memset(buf, 0, 64);
+  testStream.buffer.buf = buf;
+  testStream.buffer.bufLen = 64;
+  testStream.buffer.bufContent = 64;
+  testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
+  testStream.buffer.ioStrm.stream = NULL;
+  testStream.context.bufferIndx = 0;
+  testStream.context.bitPointer = 0;
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
+
+  // Byte-aligned values followed by values shifted with 3 bits
+  for(i = 0; i < 6; i++)
+  {
+    err = encodeUnsignedInteger(&testStream, values[i]);
+    fail_unless (err == EXIP_OK, "encodeUnsignedInteger returns error code %d", err);
+  }
+  err = writeNBits(&testStream, 3, 5);
+  fail_unless (err == EXIP_OK, "writeNBits returns error code %d", err);
+  for(i = 0; i < 6; i++)
+  {
+    err = encodeUnsignedInteger(&testStream, values[i]);
+    fail_unless (err == EXIP_OK, "encodeUnsignedInteger returns error code %d", err);
+  }
+  fail_unless (testStream.context.bitPointer == 3 && testStream.context.bufferIndx == 44,
+	       "The encodeUnsignedInteger function did not move the bit Pointer of the stream correctly");
+
+  testStream.context.bufferIndx = 0;
+  testStream.context.bitPointer = 0;
+
+  for(i = 0; i < 12; i++)
+  {
+    if(i == 6)
+    {
+      unsigned int bits_val = 0;
+      err = readBits(&testStream, 3, &bits_val);
+      fail_unless (err == EXIP_OK && bits_val == 5, "readBits returns error code %d", err);
+    }
+    err = decodeUnsignedInteger(&testStream, &int_val);
+    fail_unless (err == EXIP_OK, "decodeUnsignedInteger returns error code %d", err);
+    fail_unless (int_val == values[i % 6], "The UnsignedInteger %d is decoded incorrectly", i);
+  }
+  fail_unless (testStream.context.bitPointer == 3 && testStream.context.bufferIndx == 44,
+	       "The decodeUnsignedInteger function did not move the bit Pointer of the stream correctly");
+}
+END_TEST
+
 START_TEST (test_encodeString)
 {
   EXIStream testStream;
@@ -776,11 +1064,15 @@ START_TEST (test_encodeString)
   buf[1] = (char) 0x65; /* 0b01100101 */
   buf[2] = (char) 0x64; /* 0b01010100 */
   buf[3] = (char) 0x62; /* 0b01010010 */
-  initAllocList(&testStream.memList);
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
   testStream.buffer.buf = buf;
   testStream.buffer.bufLen = 50;
   testStream.buffer.bufContent = 50;
   testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+  testStream.asyncOutput = NULL;
+#endif
   testStream.buffer.ioStrm.stream = NULL;
   testStream.context.bufferIndx = 0;
   asciiToString("TEST encodeString()", &testStr, &testStream.memList, FALSE);
@@ -803,6 +1095,92 @@ START_TEST (test_encodeString)
 }
 END_TEST
 
+START_TEST (test_stringRoundTrip)
+{
+  EXIStream testStream;
+  char buf[512];
+  char text[151];
+  String testStr;
+  String decodedStr;
+  String mixedStr;
+  Index writerPosition = 0;
+  Index encodedIndx;
+  errorCode err = EXIP_UNEXPECTED_ERROR;
+  unsigned int i;
+
+  makeDefaultOpts(&testStream.header.opts);
+  memset(buf, 0, 512);
+  testStream.buffer.buf = buf;
+  testStream.buffer.bufLen = 512;
+  testStream.buffer.bufContent = 512;
+  testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+  testStream.asyncOutput = NULL;
+#endif
+#if EXIP_READ_AHEAD == ON
+  testStream.readAhead = NULL;
+#endif
+  testStream.buffer.ioStrm.stream = NULL;
+  testStream.context.bufferIndx = 0;
+  testStream.context.bitPointer = 0;
+  testStream.bufferMapped = FALSE;
+  testStream.allocator = NULL;
+  initAllocList(&testStream.memList, NULL);
+
+  // Longer than ASCII_RUN_CHUNK so that the unaligned runs are split
+  for(i = 0; i < 150; i++)
+    text[i] = (char) ('!' + i % 90);
+  text[150] = '\0';
+  asciiToString(text, &testStr, &testStream.memList, FALSE);
+
+  // Byte-aligned string followed by the same string shifted with 5 bits
+  err = encodeString(&testStream, &testStr);
+  fail_unless (err == EXIP_OK, "encodeString returns error code %d", err);
+  err = writeNBits(&testStream, 5, 0x15);
+  fail_unless (err == EXIP_OK, "writeNBits returns error code %d", err);
+  err = encodeString(&testStream, &testStr);
+  fail_unless (err == EXIP_OK, "encodeString returns error code %d", err);
+
+  // A string mixing ASCII runs with a multi-octet code point
+  err = allocateStringMemoryManaged(&mixedStr.str, 21, &testStream.memList);
+  fail_unless (err == EXIP_OK, "allocateStringMemoryManaged returns error code %d", err);
+  mixedStr.length = 21*CHAR_TYPE_MAX_UNITS;
+  for(i = 0; i < 21; i++)
+  {
+    err = writeCharToString(&mixedStr, i == 10 ? 0xE9 : 'a' + i, &writerPosition);
+    fail_unless (err == EXIP_OK, "writeCharToString returns error code %d", err);
+  }
+  mixedStr.length = writerPosition;
+  err = encodeString(&testStream, &mixedStr);
+  fail_unless (err == EXIP_OK, "encodeString returns error code %d", err);
+  fail_unless (testStream.context.bitPointer == 5 && testStream.context.bufferIndx > 304,
+	       "The encodeString function did not move the bit Pointer of the stream correctly");
+  encodedIndx = testStream.context.bufferIndx;
+
+  testStream.context.bufferIndx = 0;
+  testStream.context.bitPointer = 0;
+
+  for(i = 0; i < 2; i++)
+  {
+    if(i == 1)
+    {
+      unsigned int bits_val = 0;
+      err = readBits(&testStream, 5, &bits_val);
+      fail_unless (err == EXIP_OK && bits_val == 0x15, "readBits returns error code %d", err);
+    }
+    err = decodeString(&testStream, &decodedStr);
+    fail_unless (err == EXIP_OK, "decodeString returns error code %d", err);
+    fail_unless (stringEqual(decodedStr, testStr), "The String %d is decoded incorrectly", i);
+  }
+
+  err = decodeString(&testStream, &decodedStr);
+  fail_unless (err == EXIP_OK, "decodeString returns error code %d", err);
+  fail_unless (stringEqual(decodedStr, mixedStr), "The mixed String is decoded incorrectly");
+  fail_unless (testStream.context.bitPointer == 5 && testStream.context.bufferIndx == encodedIndx,
+	       "The decodeString function did not move the bit Pointer of the stream correctly");
+}
+END_TEST
+
 START_TEST (test_encodeBinary)
 {
 	EXIStream testStream;
@@ -817,11 +1195,15 @@ START_TEST (test_encodeBinary)
 	bin_data[2] = (char) 0xD4; /* 0b11010100 */
 	bin_data[3] = (char) 0x5A; /* 0b01011010 */
 	bin_data[4] = (char) 0xD7; /* 0b11010111 */
-	initAllocList(&testStream.memList);
+	testStream.allocator = NULL;
+	initAllocList(&testStream.memList, NULL);
 	testStream.buffer.buf = buf;
 	testStream.buffer.bufLen = 50;
 	testStream.buffer.bufContent = 50;
 	testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+	testStream.asyncOutput = NULL;
+#endif
 	testStream.buffer.ioStrm.stream = NULL;
 	testStream.context.bufferIndx = 0;
 	testStream.context.bitPointer = 0;
@@ -844,6 +1226,95 @@ START_TEST (test_encodeBinary)
 }
 END_TEST
 
+static char binaryOutput[256];
+static size_t binaryOutputSize = 0;
+
+static size_t writeBinaryOutput(void* buf, size_t size, void* stream)
+{
+	memcpy(binaryOutput + binaryOutputSize, buf, size);
+	binaryOutputSize += size;
+	return size;
+}
+
+START_TEST (test_encodeBinaryBulk)
+{
+	EXIStream testStream;
+	char buf[64];
+	char smallBuf[16];
+	char bin_data[100];
+	char* res;
+	Index bytes = 0;
+	unsigned int bits_val;
+	errorCode err = EXIP_UNEXPECTED_ERROR;
+	int i;
+
+	makeDefaultOpts(&testStream.header.opts);
+	for(i = 0; i < 100; i++)
+		bin_data[i] = (char) (0xA5 ^ (i * 29));
+
+	testStream.allocator = NULL;
+	initAllocList(&testStream.memList, NULL);
+	memset(buf, 0, 64);
+	testStream.buffer.buf = buf;
+	testStream.buffer.bufLen = 64;
+	testStream.buffer.bufContent = 64;
+	testStream.buffer.ioStrm.readWriteToStream = NULL;
+#if EXIP_ASYNC_OUTPUT == ON
+	testStream.asyncOutput = NULL;
+#endif
+	testStream.buffer.ioStrm.stream = NULL;
+	testStream.context.bufferIndx = 0;
+	testStream.context.bitPointer = 0;
+	testStream.scratch.buf = NULL;
+	testStream.scratch.bufLen = 0;
+
+	// Binary value shifted with 5 bits followed by a byte-aligned one
+	err = writeNBits(&testStream, 5, 0x15);
+	fail_unless (err == EXIP_OK, "writeNBits returns error code %d", err);
+	err = encodeBinary(&testStream, bin_data, 21);
+	fail_unless (err == EXIP_OK, "encodeBinary returns error code %d", err);
+	err = writeNBits(&testStream, 3, 0x02);
+	fail_unless (err == EXIP_OK, "writeNBits returns error code %d", err);
+	err = encodeBinary(&testStream, bin_data + 21, 21);
+	fail_unless (err == EXIP_OK, "encodeBinary returns error code %d", err);
+	fail_unless (testStream.context.bitPointer == 0 && testStream.context.bufferIndx == 45,
+			   "The encodeBinary function did not move the bit Pointer of the stream correctly");
+
+	testStream.context.bufferIndx = 0;
+	testStream.context.bitPointer = 0;
+
+	err = readBits(&testStream, 5, &bits_val);
+	fail_unless (err == EXIP_OK && bits_val == 0x15, "readBits returns error code %d", err);
+	err = decodeBinary(&testStream, &res, &bytes);
+	fail_unless (err == EXIP_OK && bytes == 21, "decodeBinary returns error code %d", err);
+	fail_unless (memcmp(res, bin_data, 21) == 0, "The shifted binary content is encoded wrongly");
+	err = readBits(&testStream, 3, &bits_val);
+	fail_unless (err == EXIP_OK && bits_val == 0x02, "readBits returns error code %d", err);
+	err = decodeBinary(&testStream, &res, &bytes);
+	fail_unless (err == EXIP_OK && bytes == 21, "decodeBinary returns error code %d", err);
+	fail_unless (memcmp(res, bin_data + 21, 21) == 0, "The byte-aligned binary content is encoded wrongly");
+
+	// A binary value larger than the buffer is written directly to the output stream
+	binaryOutputSize = 0;
+	testStream.buffer.buf = smallBuf;
+	testStream.buffer.bufLen = 16;
+	testStream.buffer.bufContent = 16;
+	testStream.buffer.ioStrm.readWriteToStream = writeBinaryOutput;
+	testStream.context.bufferIndx = 0;
+	testStream.context.bitPointer = 0;
+
+	err = encodeBinary(&testStream, bin_data, 100);
+	fail_unless (err == EXIP_OK, "encodeBinary returns error code %d", err);
+	fail_unless (testStream.context.bitPointer == 0 && testStream.context.bufferIndx == 0,
+			   "The encodeBinary function did not move the bit Pointer of the stream correctly");
+	fail_unless (binaryOutputSize == 101 && binaryOutput[0] == 100 && memcmp(binaryOutput + 1, bin_data, 100) == 0,
+			   "The binary content is not written to the output stream correctly");
+
+	freeAllocList(&testStream.memList);
+	EXIP_MFREE(testStream.scratch.buf);
+}
+END_TEST
+
 START_TEST (test_encodeFloatValue)
 {
 	EXIStream testStream;
@@ -865,7 +1336,8 @@ START_TEST (test_encodeFloatValue)
 	testStream.buffer.ioStrm.stream = NULL;
 	testStream.context.bufferIndx = 0;
 	testStream.context.bitPointer = 0;
-	initAllocList(&testStream.memList);
+	testStream.allocator = NULL;
+	initAllocList(&testStream.memList, NULL);
 
 	err = encodeFloatValue(&testStream, test_val);
 
@@ -906,7 +1378,8 @@ START_TEST (test_encodeIntegerValue)
 	testStream.buffer.ioStrm.stream = NULL;
 	testStream.context.bufferIndx = 0;
 	testStream.context.bitPointer = 0;
-	initAllocList(&testStream.memList);
+	testStream.allocator = NULL;
+	initAllocList(&testStream.memList, NULL);
 
 	err = encodeIntegerValue(&testStream, -913);
 
@@ -950,7 +1423,8 @@ START_TEST (test_encodeDecimalValue)
 	testStream.buffer.ioStrm.stream = NULL;
 	testStream.context.bufferIndx = 0;
 	testStream.context.bitPointer = 0;
-	initAllocList(&testStream.memList);
+	testStream.allocator = NULL;
+	initAllocList(&testStream.memList, NULL);
 
 	err = encodeDecimalValue(&testStream, res);
 
@@ -1024,6 +1498,149 @@ END_TEST
 
 /* END: ioUtil tests */
 
+#if CHAR_TYPE_MAX_UNITS == 4
+
+/* BEGIN: UTF-8 string tests */
+
+START_TEST (test_utf8Invalid)
+{
+	const char* invalid[] = {
+		"\xC0\xAF",              // overlong '/' in two octets
+		"\xC1\xBF",              // overlong U+007F
+		"\xE0\x80\xAF",          // overlong '/' in three octets
+		"\xF0\x82\x82\xAC",      // overlong U+20AC in four octets
+		"\xED\xA0\x80",          // surrogate U+D800
+		"\xED\xBF\xBF",          // surrogate U+DFFF
+		"\xF4\x90\x80\x80",      // U+110000
+		"\xF5\x80\x80\x80",      // lead octet above U+10FFFF
+		"\x80",                  // continuation without a lead octet
+		"ab\xC3\x28",            // missing continuation
+		"ab\xE2\x82",            // truncated three-octet sequence
+		"abcdefghijklmnopq\xF0\x9D\x84" // truncated after an ASCII run
+	};
+	const char* valid[] = {
+		"\xC2\x80",              // U+0080
+		"\xED\x9F\xBF",          // U+D7FF
+		"\xEE\x80\x80",          // U+E000
+		"\xEF\xBF\xBF",          // U+FFFF
+		"\xF4\x8F\xBF\xBF"       // U+10FFFF
+	};
+	String str;
+	Index chars;
+	errorCode err = EXIP_UNEXPECTED_ERROR;
+	unsigned int i;
+
+	for(i = 0; i < sizeof(invalid)/sizeof(invalid[0]); i++)
+	{
+		asciiToString(invalid[i], &str, NULL, FALSE);
+		err = getUCSCharsNumber(&str, &chars);
+		fail_unless (err == EXIP_INVALID_STRING_OPERATION, "getUCSCharsNumber accepts the invalid sequence %u", i);
+	}
+
+	for(i = 0; i < sizeof(valid)/sizeof(valid[0]); i++)
+	{
+		asciiToString(valid[i], &str, NULL, FALSE);
+		err = getUCSCharsNumber(&str, &chars);
+		fail_unless (err == EXIP_OK && chars == 1, "getUCSCharsNumber rejects the valid sequence %u", i);
+	}
+}
+END_TEST
+
+START_TEST (test_utf8CharsNumber)
+{
+	String str;
+	Index chars = 0;
+	errorCode err = EXIP_UNEXPECTED_ERROR;
+
+	// One character of each length: 1 + 2 + 3 + 4 + 1 octets
+	asciiToString("a\xC3\xB1\xE2\x82\xAC\xF0\x9D\x84\x9Ez", &str, NULL, FALSE);
+	err = getUCSCharsNumber(&str, &chars);
+	fail_unless (err == EXIP_OK, "getUCSCharsNumber returns error code %d", err);
+	fail_unless (str.length == 11 && chars == 5, "%u characters are counted in 11 octets", (unsigned int) chars);
+
+	// Multi-byte sequences between ASCII runs longer than the scanned chunks
+	asciiToString("0123456789abcdefghij\xC3\xA9" "0123456789abcdefghij\xE2\x82\xAC" "0123456789", &str, NULL, FALSE);
+	err = getUCSCharsNumber(&str, &chars);
+	fail_unless (err == EXIP_OK, "getUCSCharsNumber returns error code %d", err);
+	fail_unless (chars == 52, "%u characters are counted instead of 52", (unsigned int) chars);
+
+	getEmptyString(&str);
+	err = getUCSCharsNumber(&str, &chars);
+	fail_unless (err == EXIP_OK && chars == 0, "getUCSCharsNumber of the empty string returns %u", (unsigned int) chars);
+}
+END_TEST
+
+START_TEST (test_utf8RoundTrip)
+{
+	const uint32_t codePoints[] = {0x68, 0xE9, 0x6C, 0x6C, 0x6F, 0x20, 0x20AC, 0x20, 0x1D11E, 0x10FFFF};
+	String str;
+	String rebuilt;
+	Index readerPosition = 0;
+	Index writerPosition = 0;
+	AllocList memList;
+	errorCode err = EXIP_UNEXPECTED_ERROR;
+	unsigned int i;
+
+	initAllocList(&memList, NULL);
+
+	// "h\u00E9llo \u20AC \U0001D11E" followed by U+10FFFF
+	err = asciiToString("h\xC3\xA9llo \xE2\x82\xAC \xF0\x9D\x84\x9E\xF4\x8F\xBF\xBF", &str, &memList, TRUE);
+	fail_unless (err == EXIP_OK, "asciiToString returns error code %d", err);
+
+	err = allocateStringMemoryManaged(&rebuilt.str, 10, &memList);
+	fail_unless (err == EXIP_OK, "allocateStringMemoryManaged returns error code %d", err);
+	rebuilt.length = 10*CHAR_TYPE_MAX_UNITS;
+
+	for(i = 0; i < sizeof(codePoints)/sizeof(codePoints[0]); i++)
+	{
+		uint32_t code_point = readCharFromString(&str, &readerPosition);
+		fail_unless (code_point == codePoints[i], "character %u is read as U+%X", i, code_point);
+		err = writeCharToString(&rebuilt, code_point, &writerPosition);
+		fail_unless (err == EXIP_OK, "writeCharToString returns error code %d", err);
+	}
+	fail_unless (readerPosition == str.length, "%u of %u octets are read", (unsigned int) readerPosition, (unsigned int) str.length);
+
+	rebuilt.length = writerPosition;
+	fail_unless (stringEqual(str, rebuilt), "The characters are not written back to the same string");
+
+	freeAllocList(&memList);
+}
+END_TEST
+
+/* The string tables of the schemas are sorted in the order of the code points */
+START_TEST (test_utf8Compare)
+{
+	// "ab", "zeta", "\u00E9t\u00E9", "\u00E9t\u00E9s", "\u03B1", "\U0001D11E"
+	char* names[] = {"ab", "zeta", "\xC3\xA9t\xC3\xA9", "\xC3\xA9t\xC3\xA9s", "\xCE\xB1", "\xF0\x9D\x84\x9E"};
+	const unsigned int count = sizeof(names)/sizeof(names[0]);
+	String str1;
+	String str2;
+	unsigned int i;
+	unsigned int j;
+
+	for(i = 0; i < count; i++)
+	{
+		str1.str = names[i];
+		str1.length = strlen(names[i]);
+		for(j = 0; j < count; j++)
+		{
+			str2.str = names[j];
+			str2.length = strlen(names[j]);
+			if(i < j)
+				fail_unless (stringCompare(str1, str2) < 0, "name %u is not before name %u", i, j);
+			else if(i > j)
+				fail_unless (stringCompare(str1, str2) > 0, "name %u is not after name %u", i, j);
+			else
+				fail_unless (stringCompare(str1, str2) == 0, "name %u is not equal to itself", i);
+		}
+	}
+}
+END_TEST
+
+/* END: UTF-8 string tests */
+
+#endif /* CHAR_TYPE_MAX_UNITS == 4 */
+
 
 
 Suite * streamIO_suite (void)
@@ -1035,6 +1652,7 @@ Suite * streamIO_suite (void)
 	  TCase *tc_sRead = tcase_create ("StreamRead");
 	  tcase_add_test (tc_sRead, test_readNextBit);
 	  tcase_add_test (tc_sRead, test_readBits);
+	  tcase_add_test (tc_sRead, test_readBitsWindow);
 	  suite_add_tcase (s, tc_sRead);
   }
 
@@ -1043,6 +1661,7 @@ Suite * streamIO_suite (void)
 	  TCase *tc_sWrite = tcase_create ("StreamWrite");
 	  tcase_add_test (tc_sWrite, test_writeNextBit);
 	  tcase_add_test (tc_sWrite, test_writeNBits);
+	  tcase_add_test (tc_sWrite, test_writeNBitsWindow);
 	  suite_add_tcase (s, tc_sWrite);
   }
 
@@ -1054,6 +1673,7 @@ Suite * streamIO_suite (void)
 	  tcase_add_test (tc_sDecode, test_decodeUnsignedInteger);
 	  tcase_add_test (tc_sDecode, test_decodeString);
 	  tcase_add_test (tc_sDecode, test_decodeBinary);
+	  tcase_add_test (tc_sDecode, test_decodeBinaryShifted);
 	  tcase_add_test (tc_sDecode, test_decodeFloat);
 	  tcase_add_test (tc_sDecode, test_decodeIntegerValue);
 	  tcase_add_test (tc_sDecode, test_decodeDecimalValue);
@@ -1066,8 +1686,11 @@ Suite * streamIO_suite (void)
 	  tcase_add_test (tc_sEncode, test_encodeNBitUnsignedInteger);
 	  tcase_add_test (tc_sEncode, test_encodeBoolean);
 	  tcase_add_test (tc_sEncode, test_encodeUnsignedInteger);
+	  tcase_add_test (tc_sEncode, test_unsignedIntegerRoundTrip);
 	  tcase_add_test (tc_sEncode, test_encodeString);
+	  tcase_add_test (tc_sEncode, test_stringRoundTrip);
 	  tcase_add_test (tc_sEncode, test_encodeBinary);
+	  tcase_add_test (tc_sEncode, test_encodeBinaryBulk);
 	  tcase_add_test (tc_sEncode, test_encodeFloatValue);
 	  tcase_add_test (tc_sEncode, test_encodeIntegerValue);
 	  tcase_add_test (tc_sEncode, test_encodeDecimalValue);
@@ -1083,6 +1706,18 @@ Suite * streamIO_suite (void)
 	  suite_add_tcase (s, tc_ioUtil);
   }
 
+#if CHAR_TYPE_MAX_UNITS == 4
+  {
+	  /* UTF-8 strings test case */
+	  TCase *tc_utf8 = tcase_create ("UTF8Strings");
+	  tcase_add_test (tc_utf8, test_utf8Invalid);
+	  tcase_add_test (tc_utf8, test_utf8CharsNumber);
+	  tcase_add_test (tc_utf8, test_utf8RoundTrip);
+	  tcase_add_test (tc_utf8, test_utf8Compare);
+	  suite_add_tcase (s, tc_utf8);
+  }
+#endif
+
   return s;
 }
 
@@ -310,7 +310,7 @@ START_TEST (test_acceptance_for_A_01)
 	// III: Initialize the parsing data and hook the callback handlers to the parser object
 	parsingData.eventCount = 0;
 	parsingData.expectAttributeData = 0;
-	if (EXIP_OK != initAllocList(&parsingData.allocList))
+	if (EXIP_OK != initAllocList(&parsingData.allocList, NULL))
 		fail("Memory allocation error!");
 
 
@@ -472,7 +472,7 @@ START_TEST (test_acceptance_for_A_01_exip1)
 	// III: Initialize the parsing data and hook the callback handlers to the parser object
 	parsingData.eventCount = 0;
 	parsingData.expectAttributeData = 0;
-	if (EXIP_OK != initAllocList(&parsingData.allocList))
+	if (EXIP_OK != initAllocList(&parsingData.allocList, NULL))
 		fail("Memory allocation error!");
 
 	testParser.handler.fatalError    = sample_fatalError;
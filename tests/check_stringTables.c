@@ -16,11 +16,15 @@
  */
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <check.h>
 #include "sTables.h"
 #include "stringManipulate.h"
 #include "memManagement.h"
 #include "dynamicArray.h"
+#include "hashtable.h"
+#include "hashtable_private.h"
 
 /* BEGIN: table tests */
 
@@ -29,7 +33,7 @@ START_TEST (test_createValueTable)
 	ValueTable valueTable;
 	errorCode err = EXIP_UNEXPECTED_ERROR;
 
-	err = createValueTable(&valueTable);
+	err = createValueTable(&valueTable, NULL);
 
 	fail_unless (err == EXIP_OK, "createValueTable returns error code %d", err);
 	fail_unless (valueTable.count == 0,
@@ -47,7 +51,7 @@ START_TEST (test_createPfxTable)
 	PfxTable* pfxTable;
 	errorCode err = EXIP_UNEXPECTED_ERROR;
 
-	err = createPfxTable(&pfxTable);
+	err = createPfxTable(&pfxTable, NULL);
 
 	fail_unless (err == EXIP_OK, "createPfxTable returns error code %d", err);
 	fail_unless (pfxTable->count == 0,
@@ -66,8 +70,11 @@ START_TEST (test_addUriEntry)
 	String test_uri = {"test_uri_string", 15};
 
 	// Create the URI table
-	err = createDynArray(&uriTable.dynArray, sizeof(UriEntry), DEFAULT_URI_ENTRIES_NUMBER);
+	err = createDynArray(&uriTable.dynArray, sizeof(UriEntry), DEFAULT_URI_ENTRIES_NUMBER, NULL);
 	fail_if(err != EXIP_OK);
+#if HASH_TABLE_USE
+	uriTable.hashTbl = NULL;
+#endif
 
 	err = addUriEntry(&uriTable, test_uri, &entryId);
 
@@ -110,8 +117,11 @@ START_TEST (test_addLnEntry)
 	Index entryId = 55;
 	String test_ln = {"test_ln_string", 14};
 
-	err = createDynArray(&lnTable.dynArray, sizeof(LnEntry), DEFAULT_LN_ENTRIES_NUMBER);
+	err = createDynArray(&lnTable.dynArray, sizeof(LnEntry), DEFAULT_LN_ENTRIES_NUMBER, NULL);
 	fail_if(err != EXIP_OK);
+#if HASH_TABLE_USE
+	lnTable.hashTbl = NULL;
+#endif
 
 	err = addLnEntry(&lnTable, test_ln, &entryId);
 
@@ -157,16 +167,20 @@ START_TEST (test_addValueEntry)
 
 	// IV: Initialize the stream
 	{
-		tmp_err_code = initAllocList(&(testStrm.memList));
+		testStrm.allocator = NULL;
+		tmp_err_code = initAllocList(&(testStrm.memList), NULL);
 
 		testStrm.context.bitPointer = 0;
 		testStrm.buffer.bufLen = 0;
 		testStrm.buffer.bufContent = 0;
-		tmp_err_code += createValueTable(&testStrm.valueTable);
+		tmp_err_code += createValueTable(&testStrm.valueTable, NULL);
 		testStrm.schema = memManagedAllocate(&testStrm.memList, sizeof(EXIPSchema));
 		fail_unless (testStrm.schema != NULL, "Memory alloc error");
 		/* Create and initialize initial string table entries */
-		tmp_err_code += createDynArray(&testStrm.schema->uriTable.dynArray, sizeof(UriEntry), DEFAULT_URI_ENTRIES_NUMBER);
+		tmp_err_code += createDynArray(&testStrm.schema->uriTable.dynArray, sizeof(UriEntry), DEFAULT_URI_ENTRIES_NUMBER, NULL);
+#if HASH_TABLE_USE
+		testStrm.schema->uriTable.hashTbl = NULL;
+#endif
 		tmp_err_code += createUriTableEntries(&testStrm.schema->uriTable, FALSE);
 	}
 	fail_unless (tmp_err_code == EXIP_OK, "initStream returns an error code %d", tmp_err_code);
@@ -189,6 +203,380 @@ START_TEST (test_addValueEntry)
 }
 END_TEST
 
+#define LOOKUP_TEST_ENTRIES (3*STRING_TABLE_INDEX_THRESHOLD + 10)
+
+/* Both the full scan and the hash search are used for the look-ups */
+START_TEST (test_lookupLnUri)
+{
+	errorCode err = EXIP_UNEXPECTED_ERROR;
+	UriTable uriTable;
+	char names[LOOKUP_TEST_ENTRIES][16];
+	String str;
+	SmallIndex uriId;
+	Index lnId;
+	Index i;
+	boolean found;
+
+	err = createDynArray(&uriTable.dynArray, sizeof(UriEntry), DEFAULT_URI_ENTRIES_NUMBER, NULL);
+	fail_if(err != EXIP_OK);
+#if HASH_TABLE_USE
+	uriTable.hashTbl = NULL;
+#endif
+
+	for(i = 0; i < LOOKUP_TEST_ENTRIES; i++)
+	{
+		str.length = sprintf(names[i], "name_%u", (unsigned int) i);
+		str.str = names[i];
+
+		// Look-ups of absent strings in between the additions
+		err = lookupUri(&uriTable, str, &uriId, &found);
+		fail_unless(err == EXIP_OK, "lookupUri returns error code %d", err);
+		fail_if(found, "lookupUri finds absent %s", names[i]);
+
+		err = addUriEntry(&uriTable, str, &uriId);
+		fail_unless(err == EXIP_OK, "addUriEntry returns error code %d", err);
+		err = lookupLn(&uriTable.uri[0].lnTable, str, &lnId, &found);
+		fail_unless(err == EXIP_OK, "lookupLn returns error code %d", err);
+		fail_if(found, "lookupLn finds absent %s", names[i]);
+		err = addLnEntry(&uriTable.uri[0].lnTable, str, &lnId);
+		fail_unless(err == EXIP_OK, "addLnEntry returns error code %d", err);
+	}
+
+	for(i = 0; i < LOOKUP_TEST_ENTRIES; i++)
+	{
+		str.length = strlen(names[i]);
+		str.str = names[i];
+
+		err = lookupUri(&uriTable, str, &uriId, &found);
+		fail_unless(err == EXIP_OK && found, "lookupUri does not find %s", names[i]);
+		fail_unless(uriId == i, "lookupUri returns %u for %s", (unsigned int) uriId, names[i]);
+		err = lookupLn(&uriTable.uri[0].lnTable, str, &lnId, &found);
+		fail_unless(err == EXIP_OK && found, "lookupLn does not find %s", names[i]);
+		fail_unless(lnId == i, "lookupLn returns %u for %s", (unsigned int) lnId, names[i]);
+	}
+
+#if HASH_TABLE_USE
+	fail_if(uriTable.hashTbl == NULL, "the URI table is not indexed");
+	fail_if(uriTable.uri[0].lnTable.hashTbl == NULL, "the local names table is not indexed");
+	fail_unless(uriTable.uri[1].lnTable.hashTbl == NULL, "an empty local names table is indexed");
+	destroyStringTableIndex(&uriTable);
+	fail_unless(uriTable.uri[0].lnTable.hashTbl == NULL);
+#endif
+
+	for(i = 0; i < uriTable.count; i++)
+		destroyDynArray(&uriTable.uri[i].lnTable.dynArray);
+	destroyDynArray(&uriTable.dynArray);
+}
+END_TEST
+
+#if VALUE_CROSSTABLE_USE
+/* The evicted values are removed from the local value partitions */
+START_TEST (test_lookupVx)
+{
+	EXIStream testStrm;
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	QNameID qnameID = {1, 2}; // xml:lang
+	VxTable* vxTable;
+	String value;
+	char str[16];
+	Index vxEntryId;
+	Index i;
+	boolean found;
+
+	testStrm.allocator = NULL;
+	tmp_err_code = initAllocList(&testStrm.memList, NULL);
+	tmp_err_code += createValueTable(&testStrm.valueTable, NULL);
+	testStrm.header.opts.valuePartitionCapacity = 2*LOOKUP_TEST_ENTRIES;
+	testStrm.header.opts.valueMaxLength = INDEX_MAX;
+	testStrm.schema = memManagedAllocate(&testStrm.memList, sizeof(EXIPSchema));
+	fail_unless (testStrm.schema != NULL, "Memory alloc error");
+	tmp_err_code += createDynArray(&testStrm.schema->uriTable.dynArray, sizeof(UriEntry), DEFAULT_URI_ENTRIES_NUMBER, NULL);
+#if HASH_TABLE_USE
+	testStrm.schema->uriTable.hashTbl = NULL;
+#endif
+	tmp_err_code += createUriTableEntries(&testStrm.schema->uriTable, FALSE);
+	fail_unless (tmp_err_code == EXIP_OK, "initStream returns an error code %d", tmp_err_code);
+
+	// The first half of the values is evicted by the last
+	for(i = 0; i < 3*LOOKUP_TEST_ENTRIES; i++)
+	{
+		value.length = sprintf(str, "value_%u", (unsigned int) i);
+		tmp_err_code = allocateValueString(&testStrm, value.length, &value.str);
+		fail_unless (tmp_err_code == EXIP_OK, "allocateValueString returns an error code %d", tmp_err_code);
+		memcpy(value.str, str, value.length);
+
+		tmp_err_code = addValueEntry(&testStrm, value, qnameID);
+		fail_unless (tmp_err_code == EXIP_OK, "addValueEntry returns an error code %d", tmp_err_code);
+	}
+
+	vxTable = GET_LN_URI_QNAME(testStrm.schema->uriTable, qnameID).vxTable;
+	fail_unless (vxTable != NULL && vxTable->count == 3*LOOKUP_TEST_ENTRIES);
+
+	for(i = 0; i < 3*LOOKUP_TEST_ENTRIES; i++)
+	{
+		value.length = sprintf(str, "value_%u", (unsigned int) i);
+		value.str = str;
+
+		tmp_err_code = lookupVx(&testStrm.valueTable, vxTable, value, &vxEntryId, &found);
+		fail_unless (tmp_err_code == EXIP_OK, "lookupVx returns an error code %d", tmp_err_code);
+		if(i < LOOKUP_TEST_ENTRIES)
+			fail_if (found, "lookupVx finds evicted %s", str);
+		else
+		{
+			fail_unless (found, "lookupVx does not find %s", str);
+			fail_unless (vxEntryId == i, "lookupVx returns %u for %s", (unsigned int) vxEntryId, str);
+		}
+	}
+
+#if HASH_TABLE_USE
+	fail_if (vxTable->hashTbl == NULL, "the local value partition is not indexed");
+	// Sized for the entries that are not evicted
+	fail_unless (vxTable->hashTbl->tablelength < 2*vxTable->count, "the index has %u slots", vxTable->hashTbl->tablelength);
+#endif
+
+	// Evict the next value after the index is built
+	value.length = sprintf(str, "value_%u", (unsigned int) 0);
+	tmp_err_code = allocateValueString(&testStrm, value.length, &value.str);
+	fail_unless (tmp_err_code == EXIP_OK);
+	memcpy(value.str, str, value.length);
+	tmp_err_code = addValueEntry(&testStrm, value, qnameID);
+	fail_unless (tmp_err_code == EXIP_OK, "addValueEntry returns an error code %d", tmp_err_code);
+
+	value.str = str;
+	tmp_err_code = lookupVx(&testStrm.valueTable, vxTable, value, &vxEntryId, &found);
+	fail_unless (tmp_err_code == EXIP_OK && found, "lookupVx does not find %s", str);
+	fail_unless (vxEntryId == 3*LOOKUP_TEST_ENTRIES);
+	value.length = sprintf(str, "value_%u", (unsigned int) LOOKUP_TEST_ENTRIES);
+	tmp_err_code = lookupVx(&testStrm.valueTable, vxTable, value, &vxEntryId, &found);
+	fail_unless (tmp_err_code == EXIP_OK, "lookupVx returns an error code %d", tmp_err_code);
+	fail_if (found, "lookupVx finds evicted %s", str);
+
+	destroyVxTable(vxTable);
+	destroyValueTable(&testStrm.valueTable);
+	for(i = 0; i < testStrm.schema->uriTable.count; i++)
+	{
+		if(testStrm.schema->uriTable.uri[i].pfxTable != NULL)
+			EXIP_MFREE(testStrm.schema->uriTable.uri[i].pfxTable);
+		destroyDynArray(&testStrm.schema->uriTable.uri[i].lnTable.dynArray);
+	}
+	destroyDynArray(&testStrm.schema->uriTable.dynArray);
+	freeAllocList(&testStrm.memList);
+}
+END_TEST
+#endif
+
+/* All keys collide so the Robin Hood probing and the back shifts are exercised */
+static uint32_t collidingHash(String key)
+{
+	return key.length % 3;
+}
+
+START_TEST (test_hashtable)
+{
+	char keys[LOOKUP_TEST_ENTRIES][16];
+	String key;
+	struct hashtable* h;
+	int pass;
+	Index i;
+
+	for(pass = 0; pass < 2; pass++)
+	{
+		h = create_hashtable(16, pass == 0 ? stringHash : collidingHash, stringEqual, NULL);
+		fail_if(h == NULL);
+
+		for(i = 0; i < LOOKUP_TEST_ENTRIES; i++)
+		{
+			key.length = sprintf(keys[i], "key%u", (unsigned int) i);
+			key.str = keys[i];
+			fail_unless(hashtable_insert(h, key, i) == EXIP_OK, "hashtable_insert fails for %s", keys[i]);
+		}
+		fail_unless(hashtable_count(h) == LOOKUP_TEST_ENTRIES);
+
+		// Remove every other key
+		for(i = 0; i < LOOKUP_TEST_ENTRIES; i += 2)
+		{
+			key.length = strlen(keys[i]);
+			key.str = keys[i];
+			fail_unless(hashtable_remove(h, key) == i, "hashtable_remove does not find %s", keys[i]);
+			fail_unless(hashtable_remove(h, key) == INDEX_MAX, "hashtable_remove finds removed %s", keys[i]);
+		}
+		fail_unless(hashtable_count(h) == LOOKUP_TEST_ENTRIES/2);
+
+		for(i = 0; i < LOOKUP_TEST_ENTRIES; i++)
+		{
+			key.length = strlen(keys[i]);
+			key.str = keys[i];
+			if(i % 2 == 0)
+				fail_unless(hashtable_search(h, key) == INDEX_MAX, "hashtable_search finds removed %s", keys[i]);
+			else
+				fail_unless(hashtable_search(h, key) == i, "hashtable_search does not find %s", keys[i]);
+		}
+
+		key.length = 7;
+		key.str = "missing";
+		fail_unless(hashtable_search(h, key) == INDEX_MAX);
+		fail_unless(hashtable_insert(h, key, INDEX_MAX) != EXIP_OK, "INDEX_MAX is inserted as a value");
+
+		hashtable_destroy(h);
+	}
+}
+END_TEST
+
+#define VALUE_TEST_CAPACITY   4
+#define VALUE_TEST_MAX_LENGTH 8
+#define VALUE_TEST_COUNT      100
+
+/* The memory of the evicted values is reused for the new ones */
+START_TEST (test_valueStrings)
+{
+	EXIStream testStrm;
+	errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;
+	QNameID qnameID = {1, 2}; // xml:lang
+	ValueChunk* chunk;
+	String value;
+	char str[16];
+	Index valueEntryId;
+	Index chunks;
+	Index i;
+
+	testStrm.allocator = NULL;
+	tmp_err_code = initAllocList(&testStrm.memList, NULL);
+	tmp_err_code += createValueTable(&testStrm.valueTable, NULL);
+	testStrm.header.opts.valuePartitionCapacity = VALUE_TEST_CAPACITY;
+	testStrm.header.opts.valueMaxLength = VALUE_TEST_MAX_LENGTH;
+	testStrm.schema = memManagedAllocate(&testStrm.memList, sizeof(EXIPSchema));
+	fail_unless (testStrm.schema != NULL, "Memory alloc error");
+	tmp_err_code += createDynArray(&testStrm.schema->uriTable.dynArray, sizeof(UriEntry), DEFAULT_URI_ENTRIES_NUMBER, NULL);
+#if HASH_TABLE_USE
+	testStrm.schema->uriTable.hashTbl = NULL;
+#endif
+	tmp_err_code += createUriTableEntries(&testStrm.schema->uriTable, FALSE);
+	fail_unless (tmp_err_code == EXIP_OK, "initStream returns an error code %d", tmp_err_code);
+
+	for(i = 0; i < VALUE_TEST_COUNT; i++)
+	{
+		// Allocated as by the decoder that only knows the number of characters
+		tmp_err_code = allocateValueString(&testStrm, VALUE_TEST_MAX_LENGTH*CHAR_TYPE_MAX_UNITS, &value.str);
+		fail_unless (tmp_err_code == EXIP_OK, "allocateValueString returns an error code %d", tmp_err_code);
+		value.length = sprintf(str, "v%u", (unsigned int) i);
+		memcpy(value.str, str, value.length);
+
+		tmp_err_code = addValueEntry(&testStrm, value, qnameID);
+		fail_unless (tmp_err_code == EXIP_OK, "addValueEntry returns an error code %d", tmp_err_code);
+
+		chunks = 0;
+		for(chunk = testStrm.valueTable.oldestChunk; chunk != NULL; chunk = chunk->next)
+			chunks++;
+		for(chunk = testStrm.valueTable.freeChunks; chunk != NULL; chunk = chunk->next)
+			chunks++;
+#if VALUE_STRING_CHUNK_SIZE >= VALUE_TEST_CAPACITY*VALUE_TEST_MAX_LENGTH*CHAR_TYPE_MAX_UNITS
+		fail_unless (chunks <= 2, "%u chunks are used for %u values", (unsigned int) chunks, (unsigned int) i + 1);
+#endif
+	}
+#if VALUE_STRING_CHUNK_SIZE >= VALUE_TEST_CAPACITY*VALUE_TEST_MAX_LENGTH*CHAR_TYPE_MAX_UNITS
+	fail_unless (testStrm.valueTable.chunkSize == sizeof(CharType)*CHAR_TYPE_MAX_UNITS*VALUE_TEST_CAPACITY*VALUE_TEST_MAX_LENGTH,
+			"the chunks are not sized from the options");
+#endif
+
+	for(i = 0; i < VALUE_TEST_COUNT; i++)
+	{
+		value.length = sprintf(str, "v%u", (unsigned int) i);
+		value.str = str;
+
+		if(i < VALUE_TEST_COUNT - VALUE_TEST_CAPACITY)
+			fail_if (lookupValue(&testStrm.valueTable, value, &valueEntryId), "lookupValue finds evicted %s", str);
+		else
+		{
+			fail_unless (lookupValue(&testStrm.valueTable, value, &valueEntryId), "lookupValue does not find %s", str);
+			fail_unless (valueEntryId == i % VALUE_TEST_CAPACITY, "lookupValue returns %u for %s", (unsigned int) valueEntryId, str);
+		}
+	}
+
+#if VALUE_CROSSTABLE_USE
+	destroyVxTable(GET_LN_URI_QNAME(testStrm.schema->uriTable, qnameID).vxTable);
+#endif
+	destroyValueTable(&testStrm.valueTable);
+	for(i = 0; i < testStrm.schema->uriTable.count; i++)
+	{
+		if(testStrm.schema->uriTable.uri[i].pfxTable != NULL)
+			EXIP_MFREE(testStrm.schema->uriTable.uri[i].pfxTable);
+		destroyDynArray(&testStrm.schema->uriTable.uri[i].lnTable.dynArray);
+	}
+	destroyDynArray(&testStrm.schema->uriTable.dynArray);
+	freeAllocList(&testStrm.memList);
+}
+END_TEST
+
+START_TEST (test_dynArray)
+{
+	errorCode err = EXIP_UNEXPECTED_ERROR;
+	struct
+	{
+		DynArray dynArray;
+		uint32_t* entry;
+		Index count;
+	} testArray;
+	uint32_t value;
+	Index entryId;
+	Index expansions = 0;
+	Index lastEntries;
+	Index i;
+
+	err = createDynArray(&testArray.dynArray, sizeof(uint32_t), 4, NULL);
+	fail_if(err != EXIP_OK);
+	testArray.count = 0;
+	lastEntries = testArray.dynArray.arrayEntries;
+
+	for(i = 0; i < 1000; i++)
+	{
+		value = (uint32_t) i;
+		err = addDynEntry(&testArray.dynArray, &value, &entryId);
+		fail_unless (err == EXIP_OK, "addDynEntry returns error code %d", err);
+		fail_unless (entryId == i);
+		if(testArray.dynArray.arrayEntries != lastEntries)
+		{
+			expansions++;
+			lastEntries = testArray.dynArray.arrayEntries;
+		}
+	}
+	fail_unless (testArray.count == 1000);
+#if DYN_ARRAY_GEOMETRIC_GROWTH == ON && DYN_ARRAY_MAX_GROWTH == 0
+	fail_unless (expansions == 8, "The dynamic array is extended %d times", (int) expansions);
+#elif DYN_ARRAY_GEOMETRIC_GROWTH == OFF
+	fail_unless (testArray.dynArray.arrayEntries == 1000, "The dynamic array does not grow by its chunk");
+#endif
+
+	// The entries after the deleted one are moved down
+	err = delDynEntry(&testArray.dynArray, 10);
+	fail_unless (err == EXIP_OK, "delDynEntry returns error code %d", err);
+	fail_unless (testArray.count == 999);
+	for(i = 0; i < testArray.count; i++)
+		fail_unless (testArray.entry[i] == (i < 10 ? i : i + 1), "Wrong entry %d after delDynEntry", (int) i);
+
+	err = delDynEntry(&testArray.dynArray, testArray.count);
+	fail_unless (err == EXIP_OUT_OF_BOUND_BUFFER, "delDynEntry deletes an entry out of the array");
+
+	err = shrinkDynArray(&testArray.dynArray);
+	fail_unless (err == EXIP_OK, "shrinkDynArray returns error code %d", err);
+	fail_unless (testArray.dynArray.arrayEntries == testArray.count);
+	fail_unless (testArray.entry[998] == 999);
+
+	err = reserveDynArray(&testArray.dynArray, 5000);
+	fail_unless (err == EXIP_OK, "reserveDynArray returns error code %d", err);
+	fail_unless (testArray.dynArray.arrayEntries == 5000);
+	lastEntries = testArray.dynArray.arrayEntries;
+	for(i = testArray.count; i < 5000; i++)
+	{
+		value = (uint32_t) i;
+		err = addDynEntry(&testArray.dynArray, &value, &entryId);
+		fail_if(err != EXIP_OK);
+	}
+	fail_unless (testArray.dynArray.arrayEntries == lastEntries, "The reserved dynamic array is extended");
+
+	destroyDynArray(&testArray.dynArray);
+}
+END_TEST
+
 /* END: table tests */
 
 Suite * tables_suite (void)
@@ -203,6 +591,13 @@ Suite * tables_suite (void)
 	  tcase_add_test (tc_tables, test_addUriEntry);
 	  tcase_add_test (tc_tables, test_addLnEntry);
 	  tcase_add_test (tc_tables, test_addValueEntry);
+	  tcase_add_test (tc_tables, test_lookupLnUri);
+#if VALUE_CROSSTABLE_USE
+	  tcase_add_test (tc_tables, test_lookupVx);
+#endif
+	  tcase_add_test (tc_tables, test_hashtable);
+	  tcase_add_test (tc_tables, test_valueStrings);
+	  tcase_add_test (tc_tables, test_dynArray);
 	  suite_add_tcase (s, tc_tables);
   }
 
@@ -0,0 +1,288 @@
+/*==================================================================*\
+|                EXIP - Embeddable EXI Processor in C                |
+|--------------------------------------------------------------------|
+|          This work is licensed under BSD 3-Clause License          |
+|  The full license terms and conditions are located in LICENSE.txt  |
+\===================================================================*/
+
+/**
+ * @file hashBench.c
+ * @brief Microbenchmark of the hash tables of EXIP against the chained
+ * hash table with prime sizes and djbHash that they replaced.
+ * The workloads are the ones of the value table of the encoder:
+ * insertions, hits, misses and the remove/insert of the evicted values
+ * when valuePartitionCapacity wraps.
+ *
+ * Usage: hashBench [entries] [rounds]
+ *
+ * @date Oct 17, 2026
+ * @author agent
+ * @version 0.5
+ * @par[Revision] $Id$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "procTypes.h"
+#include "hashtable.h"
+#include "stringManipulate.h"
+
+/********* BEGIN: The chained hash table ***************/
+
+struct chainEntry
+{
+	String key;
+	Index value;
+	uint32_t hash;
+	struct chainEntry* next;
+};
+
+struct chainTable
+{
+	unsigned int length;
+	struct chainEntry** table;
+	unsigned int count;
+	unsigned int loadlimit;
+	unsigned int primeindex;
+};
+
+static const uint32_t primes[] = {
+53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593, 49157, 98317,
+196613, 393241, 786433, 1572869, 3145739, 6291469, 12582917, 25165843
+};
+
+static struct chainTable* chainCreate(unsigned int minsize)
+{
+	struct chainTable* h = malloc(sizeof(struct chainTable));
+	unsigned int p = 0;
+
+	while(p < sizeof(primes)/sizeof(primes[0]) - 1 && primes[p] < minsize)
+		p++;
+	h->length = primes[p];
+	h->primeindex = p;
+	h->table = calloc(h->length, sizeof(struct chainEntry*));
+	h->count = 0;
+	h->loadlimit = (unsigned int) (h->length*0.65F) + 1;
+	return h;
+}
+
+static void chainExpand(struct chainTable* h)
+{
+	struct chainEntry** newtable;
+	struct chainEntry* e;
+	unsigned int newsize;
+	unsigned int i;
+
+	if(h->primeindex == sizeof(primes)/sizeof(primes[0]) - 1)
+		return;
+	newsize = primes[++h->primeindex];
+	newtable = calloc(newsize, sizeof(struct chainEntry*));
+	for(i = 0; i < h->length; i++)
+	{
+		while((e = h->table[i]) != NULL)
+		{
+			h->table[i] = e->next;
+			e->next = newtable[e->hash % newsize];
+			newtable[e->hash % newsize] = e;
+		}
+	}
+	free(h->table);
+	h->table = newtable;
+	h->length = newsize;
+	h->loadlimit = (unsigned int) (newsize*0.65F) + 1;
+}
+
+static void chainInsert(struct chainTable* h, String key, Index value)
+{
+	struct chainEntry* e;
+
+	if(++h->count > h->loadlimit)
+		chainExpand(h);
+	e = malloc(sizeof(struct chainEntry));
+	e->hash = djbHash(key);
+	e->key = key;
+	e->value = value;
+	e->next = h->table[e->hash % h->length];
+	h->table[e->hash % h->length] = e;
+}
+
+static Index chainSearch(struct chainTable* h, String key)
+{
+	uint32_t hash = djbHash(key);
+	struct chainEntry* e = h->table[hash % h->length];
+
+	for(; e != NULL; e = e->next)
+	{
+		if(e->hash == hash && stringEqual(key, e->key))
+			return e->value;
+	}
+	return INDEX_MAX;
+}
+
+static Index chainRemove(struct chainTable* h, String key)
+{
+	uint32_t hash = djbHash(key);
+	struct chainEntry** pE = &h->table[hash % h->length];
+	struct chainEntry* e;
+	Index value;
+
+	for(e = *pE; e != NULL; pE = &e->next, e = e->next)
+	{
+		if(e->hash == hash && stringEqual(key, e->key))
+		{
+			*pE = e->next;
+			value = e->value;
+			free(e);
+			h->count--;
+			return value;
+		}
+	}
+	return INDEX_MAX;
+}
+
+static void chainDestroy(struct chainTable* h)
+{
+	struct chainEntry* e;
+	unsigned int i;
+
+	for(i = 0; i < h->length; i++)
+	{
+		while((e = h->table[i]) != NULL)
+		{
+			h->table[i] = e->next;
+			free(e);
+		}
+	}
+	free(h->table);
+	free(h);
+}
+
+/********* END: The chained hash table ***************/
+
+#define TIME_MS(start) ((double) (clock() - (start))*1000.0/CLOCKS_PER_SEC)
+
+/**
+ * The values of the stream: strings of different length with scattered
+ * numbers; sequential ones make djbHash look collision free
+ */
+static String* createKeys(unsigned int count, unsigned int offset)
+{
+	String* keys = malloc(sizeof(String)*count);
+	char buf[64];
+	unsigned int i;
+
+	for(i = 0; i < count; i++)
+	{
+		keys[i].length = sprintf(buf, "%s-%u", (i % 3 == 0) ? "urn:example:sensor:temperature" :
+				(i % 3 == 1) ? "status" : "value", (i + offset)*2654435761U);
+		keys[i].str = malloc(keys[i].length);
+		memcpy(keys[i].str, buf, keys[i].length);
+	}
+	return keys;
+}
+
+static void freeKeys(String* keys, unsigned int count)
+{
+	unsigned int i;
+
+	for(i = 0; i < count; i++)
+		free(keys[i].str);
+	free(keys);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int count = argc > 1 ? (unsigned int) strtoul(argv[1], NULL, 10) : 100000;
+	unsigned int rounds = argc > 2 ? (unsigned int) strtoul(argv[2], NULL, 10) : 10;
+	String* keys;
+	String* misses;
+	double t[2][4] = {{0}};
+	Index found = 0;
+	unsigned int r, i;
+	clock_t start;
+
+	if(count == 0 || rounds == 0)
+	{
+		printf("Usage: hashBench [entries] [rounds]\n");
+		return 1;
+	}
+
+	keys = createKeys(count, 0);
+	misses = createKeys(count, count);
+
+	for(r = 0; r < rounds; r++)
+	{
+		struct hashtable* h;
+		struct chainTable* c;
+
+		start = clock();
+		h = create_hashtable(INITIAL_HASH_TABLE_SIZE, stringHash, stringEqual, NULL);
+		for(i = 0; i < count; i++)
+		{
+			if(hashtable_insert(h, keys[i], i) != EXIP_OK)
+			{
+				printf("hashtable_insert failed\n");
+				return 1;
+			}
+		}
+		t[0][0] += TIME_MS(start);
+
+		start = clock();
+		for(i = 0; i < count; i++)
+			found += hashtable_search(h, keys[i]);
+		t[0][1] += TIME_MS(start);
+
+		start = clock();
+		for(i = 0; i < count; i++)
+			found += hashtable_search(h, misses[i]) == INDEX_MAX;
+		t[0][2] += TIME_MS(start);
+
+		// The evicted values are replaced with new ones
+		start = clock();
+		for(i = 0; i < count; i++)
+		{
+			hashtable_remove(h, keys[i]);
+			hashtable_insert(h, misses[i], i);
+		}
+		hashtable_destroy(h);
+		t[0][3] += TIME_MS(start);
+
+		start = clock();
+		c = chainCreate(6151);
+		for(i = 0; i < count; i++)
+			chainInsert(c, keys[i], i);
+		t[1][0] += TIME_MS(start);
+
+		start = clock();
+		for(i = 0; i < count; i++)
+			found += chainSearch(c, keys[i]);
+		t[1][1] += TIME_MS(start);
+
+		start = clock();
+		for(i = 0; i < count; i++)
+			found += chainSearch(c, misses[i]) == INDEX_MAX;
+		t[1][2] += TIME_MS(start);
+
+		start = clock();
+		for(i = 0; i < count; i++)
+		{
+			chainRemove(c, keys[i]);
+			chainInsert(c, misses[i], i);
+		}
+		chainDestroy(c);
+		t[1][3] += TIME_MS(start);
+	}
+
+	printf("%u entries, %u rounds (checksum %lu)\n", count, rounds, (unsigned long) found);
+	printf("%-28s %10s %10s %10s %10s\n", "ms per round", "insert", "hit", "miss", "evict");
+	printf("%-28s %10.2f %10.2f %10.2f %10.2f\n", "open addressing, stringHash",
+			t[0][0]/rounds, t[0][1]/rounds, t[0][2]/rounds, t[0][3]/rounds);
+	printf("%-28s %10.2f %10.2f %10.2f %10.2f\n", "chained, djbHash",
+			t[1][0]/rounds, t[1][1]/rounds, t[1][2]/rounds, t[1][3]/rounds);
+
+	freeKeys(keys, count);
+	freeKeys(misses, count);
+	return 0;
+}
@@ -150,7 +150,7 @@ errorCode toStaticSrc(EXIPSchema* schemaPtr, char* prefix, FILE *outfile)
             prefix);
 
 
-	fprintf(outfile, "    {NULL, NULL},\n");
+	fprintf(outfile, "    {NULL, 0},\n");
 
     count = schemaPtr->uriTable.count;
 	fprintf(outfile,
@@ -36,7 +36,7 @@ errorCode dynExipSchemaOutput(EXIPSchema* schema, char* prefix, unsigned char ma
 	unsigned int tgCount = 0;
 	QNameID typeGrammars[MAX_GRAMMARS_COUNT];
 
-	typeGrammarsHash = create_hashtable(1000, djbHash, stringEqual);
+	typeGrammarsHash = create_hashtable(1000, djbHash, stringEqual, NULL);
 
 	// TODO: needs to be fixed
 
@@ -44,7 +44,7 @@ errorCode dynExipSchemaOutput(EXIPSchema* schema, char* prefix, unsigned char ma
 	fprintf(out, "errorCode get_%sSchema(EXIPSchema* schema)\n{\n\t errorCode tmp_err_code = EXIP_UNEXPECTED_ERROR;\n\t\n\t", prefix);
 	fprintf(out, "if(schema == NULL)\n\t return EXIP_NULL_POINTER_REF;\n\t");
 
-	fprintf(out, "tmp_err_code = initAllocList(&schema->memList);\n\t");
+	fprintf(out, "tmp_err_code = initAllocList(&schema->memList, NULL);\n\t");
 	fprintf(out, "if(tmp_err_code != EXIP_OK)\n\t return tmp_err_code;\n\t");
 
 	for(uriIter = 0; uriIter < schema->uriTable.count; uriIter++)